@@ -2,6 +2,7 @@
 
 #include <windows.h>
 #include "ImageLib.h"
+#include "PixelConvert.h"
 #include "png\png.h"
 #include <math.h>
 #include <tchar.h>
@@ -1167,12 +1168,8 @@ Image* GetJPEGImage(const std::string& theFileName)
 		{
 			jpeg_read_scanlines(&cinfo, buffer, 1);
 
-			unsigned char* p = *buffer;
-			for (int i = 0; i < cinfo.output_width; i++)
-			{
-				int r = *p++;
-				*q++ = 0xFF000000 | (r << 16) | (r << 8) | (r);
-			}
+			Gray8ToARGB(*buffer, q, cinfo.output_width);
+			q += cinfo.output_width;
 		}
 	}
 	else
@@ -1181,15 +1178,8 @@ Image* GetJPEGImage(const std::string& theFileName)
 		{
 			jpeg_read_scanlines(&cinfo, buffer, 1);
 
-			unsigned char* p = *buffer;
-			for (int i = 0; i < cinfo.output_width; i++)
-			{
-				int r = *p++;
-				int g = *p++;
-				int b = *p++;
-
-				*q++ = 0xFF000000 | (r << 16) | (g << 8) | (b);
-			}
+			RGB24ToARGB(*buffer, q, cinfo.output_width);
+			q += cinfo.output_width;
 		}
 	}
 
@@ -1613,46 +1603,15 @@ Image* ImageLib::GetImage(const std::string& theFilename, bool lookForAlphaImage
 			if ((anImage->mWidth == anAlphaImage->mWidth) &&
 				(anImage->mHeight == anAlphaImage->mHeight))
 			{
-				unsigned long* aBits1 = anImage->mBits;
-				unsigned long* aBits2 = anAlphaImage->mBits;
-				int aSize = anImage->mWidth*anImage->mHeight;
-
-				for (int i = 0; i < aSize; i++)
-				{
-					*aBits1 = (*aBits1 & 0x00FFFFFF) | ((*aBits2 & 0xFF) << 24);
-					++aBits1;
-					++aBits2;
-				}
+				MergeAlphaChannel(anImage->mBits, anAlphaImage->mBits, anImage->mWidth*anImage->mHeight);
 			}
 
 			delete anAlphaImage;
 		}
-		else if (gAlphaComposeColor==0xFFFFFF)
-		{
-			anImage = anAlphaImage;
-
-			unsigned long* aBits1 = anImage->mBits;
-
-			int aSize = anImage->mWidth*anImage->mHeight;
-			for (int i = 0; i < aSize; i++)
-			{
-				*aBits1 = (0x00FFFFFF) | ((*aBits1 & 0xFF) << 24);
-				++aBits1;
-			}
-		}
 		else
 		{
-			const int aColor = gAlphaComposeColor;
 			anImage = anAlphaImage;
-
-			unsigned long* aBits1 = anImage->mBits;
-
-			int aSize = anImage->mWidth*anImage->mHeight;
-			for (int i = 0; i < aSize; i++)
-			{
-				*aBits1 = aColor | ((*aBits1 & 0xFF) << 24);
-				++aBits1;
-			}
+			AlphaFromChannel(anImage->mBits, anImage->mWidth*anImage->mHeight, gAlphaComposeColor);
 		}
 	}
 
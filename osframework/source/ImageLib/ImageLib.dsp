@@ -88,6 +88,10 @@ LIB32=link.exe -lib
 
 SOURCE=.\ImageLib.cpp
 # End Source File
+# Begin Source File
+
+SOURCE=.\PixelConvert.cpp
+# End Source File
 # End Group
 # Begin Group "Header Files"
 
@@ -96,6 +100,10 @@ SOURCE=.\ImageLib.cpp
 
 SOURCE=.\ImageLib.h
 # End Source File
+# Begin Source File
+
+SOURCE=.\PixelConvert.h
+# End Source File
 # End Group
 # Begin Group "PNG"
 
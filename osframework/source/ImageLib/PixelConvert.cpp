@@ -0,0 +1,542 @@
+#include "PixelConvert.h"
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define IMAGELIB_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace ImageLib;
+
+bool ImageLib::gUseSSE2PixelConvert = true;
+
+unsigned long ImageLib::gUnpremultiplyRecip[256];
+
+static struct UnpremultiplyRecipInit
+{
+	UnpremultiplyRecipInit()
+	{
+		gUnpremultiplyRecip[0] = 0;
+		for (int a = 1; a < 256; a++)
+			gUnpremultiplyRecip[a] = (255*65536 + a/2) / a;
+	}
+} gUnpremultiplyRecipInit;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ImageLib::CPUHasSSE2()
+{
+#if defined(_M_IX86)
+	static int aHasSSE2 = -1;
+	if (aHasSSE2 == -1)
+	{
+		unsigned long aFeatures = 0;
+		_asm
+		{
+			mov eax, 1
+			cpuid
+			mov aFeatures, edx
+		}
+		aHasSSE2 = (aFeatures & (1 << 26)) ? 1 : 0;
+	}
+	return aHasSSE2 != 0;
+#elif defined(IMAGELIB_SSE2)
+	return true;
+#else
+	return false;
+#endif
+}
+
+static inline bool UseSSE2(int theCount)
+{
+#ifdef IMAGELIB_SSE2
+	return gUseSSE2PixelConvert && (theCount >= 4) && CPUHasSSE2();
+#else
+	return false;
+#endif
+}
+
+#ifdef IMAGELIB_SSE2
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Premultiplies 4 pixels: c' = (c*(a+1))>>8, alpha untouched
+static inline __m128i PremultiplySSE2(__m128i thePixels)
+{
+	const __m128i aZero = _mm_setzero_si128();
+	const __m128i anOne = _mm_set1_epi16(1);
+	const __m128i anAlphaMask = _mm_set1_epi32(0xFF000000);
+
+	__m128i aLo = _mm_unpacklo_epi8(thePixels, aZero);
+	__m128i aHi = _mm_unpackhi_epi8(thePixels, aZero);
+
+	__m128i anAlphaLo = _mm_add_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(aLo, 0xFF), 0xFF), anOne);
+	__m128i anAlphaHi = _mm_add_epi16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(aHi, 0xFF), 0xFF), anOne);
+
+	aLo = _mm_srli_epi16(_mm_mullo_epi16(aLo, anAlphaLo), 8);
+	aHi = _mm_srli_epi16(_mm_mullo_epi16(aHi, anAlphaHi), 8);
+
+	__m128i aResult = _mm_packus_epi16(aLo, aHi);
+	return _mm_or_si128(_mm_andnot_si128(anAlphaMask, aResult), _mm_and_si128(anAlphaMask, thePixels));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Packs 8 ARGB pixels into 8 16-bit pixels given per-channel right shifts and masks
+static inline __m128i PackTo16SSE2(__m128i theA, __m128i theB, int theRShift, int theGShift, int theBShift, const __m128i& theRMask, const __m128i& theGMask, const __m128i& theBMask)
+{
+	const __m128i aBias = _mm_set1_epi32(0x8000);
+	const __m128i aBias16 = _mm_set1_epi16((short)0x8000);
+
+	__m128i aPackA = _mm_or_si128(_mm_or_si128(
+		_mm_and_si128(_mm_srli_epi32(theA, theRShift), theRMask),
+		_mm_and_si128(_mm_srli_epi32(theA, theGShift), theGMask)),
+		_mm_and_si128(_mm_srli_epi32(theA, theBShift), theBMask));
+	__m128i aPackB = _mm_or_si128(_mm_or_si128(
+		_mm_and_si128(_mm_srli_epi32(theB, theRShift), theRMask),
+		_mm_and_si128(_mm_srli_epi32(theB, theGShift), theGMask)),
+		_mm_and_si128(_mm_srli_epi32(theB, theBShift), theBMask));
+
+	// packs is signed, so bias into range and back
+	__m128i aResult = _mm_packs_epi32(_mm_sub_epi32(aPackA, aBias), _mm_sub_epi32(aPackB, aBias));
+	return _mm_add_epi16(aResult, aBias16);
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::PremultiplyAlpha(const unsigned long* theSrc, unsigned long* theDest, int theCount)
+{
+	int i = 0;
+
+#ifdef IMAGELIB_SSE2
+	if (UseSSE2(theCount))
+	{
+		for (; i + 4 <= theCount; i += 4)
+			_mm_storeu_si128((__m128i*)(theDest + i), PremultiplySSE2(_mm_loadu_si128((const __m128i*)(theSrc + i))));
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		unsigned long val = theSrc[i];
+		unsigned long anAlpha = val >> 24;
+
+		unsigned long r = (((val & 0xFF0000) * (anAlpha+1)) >> 8) & 0xFF0000;
+		unsigned long g = (((val & 0x00FF00) * (anAlpha+1)) >> 8) & 0x00FF00;
+		unsigned long b = (((val & 0x0000FF) * (anAlpha+1)) >> 8) & 0x0000FF;
+
+		theDest[i] = (anAlpha << 24) | r | g | b;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::UnpremultiplyAlpha(const unsigned long* theSrc, unsigned long* theDest, int theCount)
+{
+	for (int i = 0; i < theCount; i++)
+	{
+		unsigned long val = theSrc[i];
+		unsigned long anAlpha = val >> 24;
+		unsigned long aRecip = gUnpremultiplyRecip[anAlpha];
+
+		unsigned long r = ((((val >> 16) & 0xFF) * aRecip) + 0x8000) >> 16;
+		unsigned long g = ((((val >> 8 ) & 0xFF) * aRecip) + 0x8000) >> 16;
+		unsigned long b = ((((val      ) & 0xFF) * aRecip) + 0x8000) >> 16;
+
+		if (r > 255) r = 255;
+		if (g > 255) g = 255;
+		if (b > 255) b = 255;
+
+		theDest[i] = (anAlpha << 24) | (r << 16) | (g << 8) | b;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::PremultiplyToNative(const unsigned long* theSrc, unsigned long* theDest, int theCount, const PixelPackFormat& theFormat)
+{
+	if ((theFormat.mRedMask == 0xFF0000) && (theFormat.mGreenMask == 0x00FF00) && (theFormat.mBlueMask == 0x0000FF) &&
+		(theFormat.mRedShift == 16) && (theFormat.mGreenShift == 8) && (theFormat.mBlueShift == 0))
+	{
+		PremultiplyAlpha(theSrc, theDest, theCount);
+		return;
+	}
+
+	const int rRightShift = 16 + (8-theFormat.mRedBits);
+	const int gRightShift = 8 + (8-theFormat.mGreenBits);
+	const int bRightShift = 0 + (8-theFormat.mBlueBits);
+
+	const int rLeftShift = theFormat.mRedShift;
+	const int gLeftShift = theFormat.mGreenShift;
+	const int bLeftShift = theFormat.mBlueShift;
+
+	const unsigned long rMask = theFormat.mRedMask;
+	const unsigned long gMask = theFormat.mGreenMask;
+	const unsigned long bMask = theFormat.mBlueMask;
+
+	int i = 0;
+
+#ifdef IMAGELIB_SSE2
+	if (UseSSE2(theCount))
+	{
+		const __m128i aRChanMask = _mm_set1_epi32((1 << theFormat.mRedBits) - 1);
+		const __m128i aGChanMask = _mm_set1_epi32((1 << theFormat.mGreenBits) - 1);
+		const __m128i aBChanMask = _mm_set1_epi32((1 << theFormat.mBlueBits) - 1);
+		const __m128i aRMask = _mm_set1_epi32(rMask);
+		const __m128i aGMask = _mm_set1_epi32(gMask);
+		const __m128i aBMask = _mm_set1_epi32(bMask);
+		const __m128i anAlphaMask = _mm_set1_epi32(0xFF000000);
+
+		const __m128i aRRight = _mm_cvtsi32_si128(rRightShift);
+		const __m128i aGRight = _mm_cvtsi32_si128(gRightShift);
+		const __m128i aBRight = _mm_cvtsi32_si128(bRightShift);
+		const __m128i aRLeft = _mm_cvtsi32_si128(rLeftShift);
+		const __m128i aGLeft = _mm_cvtsi32_si128(gLeftShift);
+		const __m128i aBLeft = _mm_cvtsi32_si128(bLeftShift);
+
+		for (; i + 4 <= theCount; i += 4)
+		{
+			__m128i aPixels = PremultiplySSE2(_mm_loadu_si128((const __m128i*)(theSrc + i)));
+
+			__m128i r = _mm_and_si128(_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(aPixels, aRRight), aRChanMask), aRLeft), aRMask);
+			__m128i g = _mm_and_si128(_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(aPixels, aGRight), aGChanMask), aGLeft), aGMask);
+			__m128i b = _mm_and_si128(_mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(aPixels, aBRight), aBChanMask), aBLeft), aBMask);
+
+			__m128i aResult = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, _mm_and_si128(aPixels, anAlphaMask)));
+			_mm_storeu_si128((__m128i*)(theDest + i), aResult);
+		}
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		unsigned long val = theSrc[i];
+
+		int anAlpha = val >> 24;
+
+		unsigned long r = ((val & 0xFF0000) * (anAlpha+1)) >> 8;
+		unsigned long g = ((val & 0x00FF00) * (anAlpha+1)) >> 8;
+		unsigned long b = ((val & 0x0000FF) * (anAlpha+1)) >> 8;
+
+		theDest[i] =
+			(((r >> rRightShift) << rLeftShift) & rMask) |
+			(((g >> gRightShift) << gLeftShift) & gMask) |
+			(((b >> bRightShift) << bLeftShift) & bMask) |
+			(anAlpha << 24);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::PackToNative(const unsigned long* theSrc, unsigned long* theDest, int theCount, const PixelPackFormat& theFormat)
+{
+	if ((theFormat.mRedMask == 0xFF0000) && (theFormat.mGreenMask == 0x00FF00) && (theFormat.mBlueMask == 0x0000FF) &&
+		(theFormat.mRedShift == 16) && (theFormat.mGreenShift == 8) && (theFormat.mBlueShift == 0))
+	{
+		if (theSrc != theDest)
+			memcpy(theDest, theSrc, theCount*sizeof(unsigned long));
+		return;
+	}
+
+	const int rRightShift = 16 + (8-theFormat.mRedBits);
+	const int gRightShift = 8 + (8-theFormat.mGreenBits);
+	const int bRightShift = 0 + (8-theFormat.mBlueBits);
+
+	for (int i = 0; i < theCount; i++)
+	{
+		unsigned long val = theSrc[i];
+
+		theDest[i] =
+			((((val & 0xFF0000) >> rRightShift) << theFormat.mRedShift) & theFormat.mRedMask) |
+			((((val & 0x00FF00) >> gRightShift) << theFormat.mGreenShift) & theFormat.mGreenMask) |
+			((((val & 0x0000FF) >> bRightShift) << theFormat.mBlueShift) & theFormat.mBlueMask) |
+			(val & 0xFF000000);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::ARGBToRGB565(const unsigned long* theSrc, unsigned short* theDest, int theCount)
+{
+	int i = 0;
+
+#ifdef IMAGELIB_SSE2
+	if (UseSSE2(theCount))
+	{
+		const __m128i aRMask = _mm_set1_epi32(0xF800);
+		const __m128i aGMask = _mm_set1_epi32(0x07E0);
+		const __m128i aBMask = _mm_set1_epi32(0x001F);
+
+		for (; i + 8 <= theCount; i += 8)
+		{
+			__m128i aPixA = _mm_loadu_si128((const __m128i*)(theSrc + i));
+			__m128i aPixB = _mm_loadu_si128((const __m128i*)(theSrc + i + 4));
+			_mm_storeu_si128((__m128i*)(theDest + i), PackTo16SSE2(aPixA, aPixB, 8, 5, 3, aRMask, aGMask, aBMask));
+		}
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		unsigned long aPixel = theSrc[i];
+		theDest[i] = (unsigned short)(((aPixel>>8)&0xF800) | ((aPixel>>5)&0x07E0) | ((aPixel>>3)&0x001F));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::RGB565ToARGB(const unsigned short* theSrc, unsigned long* theDest, int theCount)
+{
+	for (int i = 0; i < theCount; i++)
+	{
+		unsigned long aPixel = theSrc[i];
+		theDest[i] = 0xFF000000 | ((aPixel & 0xF800) << 8) | ((aPixel & 0x07E0) << 5) | ((aPixel & 0x001F) << 3);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::ARGBToRGB555(const unsigned long* theSrc, unsigned short* theDest, int theCount)
+{
+	int i = 0;
+
+#ifdef IMAGELIB_SSE2
+	if (UseSSE2(theCount))
+	{
+		const __m128i aRMask = _mm_set1_epi32(0x7C00);
+		const __m128i aGMask = _mm_set1_epi32(0x03E0);
+		const __m128i aBMask = _mm_set1_epi32(0x001F);
+
+		for (; i + 8 <= theCount; i += 8)
+		{
+			__m128i aPixA = _mm_loadu_si128((const __m128i*)(theSrc + i));
+			__m128i aPixB = _mm_loadu_si128((const __m128i*)(theSrc + i + 4));
+			_mm_storeu_si128((__m128i*)(theDest + i), PackTo16SSE2(aPixA, aPixB, 9, 6, 3, aRMask, aGMask, aBMask));
+		}
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		unsigned long aPixel = theSrc[i];
+		theDest[i] = (unsigned short)(((aPixel>>9)&0x7C00) | ((aPixel>>6)&0x03E0) | ((aPixel>>3)&0x001F));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::RGB555ToARGB(const unsigned short* theSrc, unsigned long* theDest, int theCount)
+{
+	for (int i = 0; i < theCount; i++)
+	{
+		unsigned long aPixel = theSrc[i];
+		theDest[i] = 0xFF000000 | ((aPixel & 0x7C00) << 9) | ((aPixel & 0x03E0) << 6) | ((aPixel & 0x001F) << 3);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::RGB24ToARGB(const unsigned char* theSrc, unsigned long* theDest, int theCount)
+{
+	const unsigned char* p = theSrc;
+	unsigned long* q = theDest;
+
+	int i = 0;
+	for (; i + 4 <= theCount; i += 4)
+	{
+		q[0] = 0xFF000000 | (p[0] << 16) | (p[1] << 8) | p[2];
+		q[1] = 0xFF000000 | (p[3] << 16) | (p[4] << 8) | p[5];
+		q[2] = 0xFF000000 | (p[6] << 16) | (p[7] << 8) | p[8];
+		q[3] = 0xFF000000 | (p[9] << 16) | (p[10] << 8) | p[11];
+		p += 12;
+		q += 4;
+	}
+
+	for (; i < theCount; i++)
+	{
+		*q++ = 0xFF000000 | (p[0] << 16) | (p[1] << 8) | p[2];
+		p += 3;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::Gray8ToARGB(const unsigned char* theSrc, unsigned long* theDest, int theCount)
+{
+	int i = 0;
+
+#ifdef IMAGELIB_SSE2
+	if (UseSSE2(theCount))
+	{
+		const __m128i anOpaque = _mm_set1_epi8((char)0xFF);
+
+		for (; i + 16 <= theCount; i += 16)
+		{
+			__m128i aGray = _mm_loadu_si128((const __m128i*)(theSrc + i));
+
+			__m128i aGGLo = _mm_unpacklo_epi8(aGray, aGray);
+			__m128i aGGHi = _mm_unpackhi_epi8(aGray, aGray);
+			__m128i aGALo = _mm_unpacklo_epi8(aGray, anOpaque);
+			__m128i aGAHi = _mm_unpackhi_epi8(aGray, anOpaque);
+
+			_mm_storeu_si128((__m128i*)(theDest + i), _mm_unpacklo_epi16(aGGLo, aGALo));
+			_mm_storeu_si128((__m128i*)(theDest + i + 4), _mm_unpackhi_epi16(aGGLo, aGALo));
+			_mm_storeu_si128((__m128i*)(theDest + i + 8), _mm_unpacklo_epi16(aGGHi, aGAHi));
+			_mm_storeu_si128((__m128i*)(theDest + i + 12), _mm_unpackhi_epi16(aGGHi, aGAHi));
+		}
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		unsigned long r = theSrc[i];
+		theDest[i] = 0xFF000000 | (r << 16) | (r << 8) | (r);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::MergeAlphaChannel(unsigned long* theBits, const unsigned long* theAlphaSrc, int theCount)
+{
+	int i = 0;
+
+#ifdef IMAGELIB_SSE2
+	if (UseSSE2(theCount))
+	{
+		const __m128i aColorMask = _mm_set1_epi32(0x00FFFFFF);
+
+		for (; i + 4 <= theCount; i += 4)
+		{
+			__m128i aColor = _mm_and_si128(_mm_loadu_si128((const __m128i*)(theBits + i)), aColorMask);
+			__m128i anAlpha = _mm_slli_epi32(_mm_loadu_si128((const __m128i*)(theAlphaSrc + i)), 24);
+			_mm_storeu_si128((__m128i*)(theBits + i), _mm_or_si128(aColor, anAlpha));
+		}
+	}
+#endif
+
+	for (; i < theCount; i++)
+		theBits[i] = (theBits[i] & 0x00FFFFFF) | ((theAlphaSrc[i] & 0xFF) << 24);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::AlphaFromChannel(unsigned long* theBits, int theCount, unsigned long theColor)
+{
+	theColor &= 0x00FFFFFF;
+
+	int i = 0;
+
+#ifdef IMAGELIB_SSE2
+	if (UseSSE2(theCount))
+	{
+		const __m128i aColor = _mm_set1_epi32(theColor);
+
+		for (; i + 4 <= theCount; i += 4)
+		{
+			__m128i anAlpha = _mm_slli_epi32(_mm_loadu_si128((const __m128i*)(theBits + i)), 24);
+			_mm_storeu_si128((__m128i*)(theBits + i), _mm_or_si128(aColor, anAlpha));
+		}
+	}
+#endif
+
+	for (; i < theCount; i++)
+		theBits[i] = theColor | ((theBits[i] & 0xFF) << 24);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ImageLib::ApplyColorKey(unsigned long* theBits, int theCount, unsigned long theKeyColor)
+{
+	theKeyColor &= 0x00FFFFFF;
+
+	int i = 0;
+
+#ifdef IMAGELIB_SSE2
+	if (UseSSE2(theCount))
+	{
+		const __m128i aKey = _mm_set1_epi32(theKeyColor);
+		const __m128i aColorMask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i anAlphaMask = _mm_set1_epi32(0xFF000000);
+
+		for (; i + 4 <= theCount; i += 4)
+		{
+			__m128i aPixels = _mm_loadu_si128((const __m128i*)(theBits + i));
+			__m128i aMatch = _mm_cmpeq_epi32(_mm_and_si128(aPixels, aColorMask), aKey);
+			_mm_storeu_si128((__m128i*)(theBits + i), _mm_andnot_si128(_mm_and_si128(aMatch, anAlphaMask), aPixels));
+		}
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		if ((theBits[i] & 0x00FFFFFF) == theKeyColor)
+			theBits[i] &= 0x00FFFFFF;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int ImageLib::ScanAlpha(const unsigned long* theSrc, int theCount, int& theFirst, int& theLast)
+{
+	int aFlags = 0;
+	theFirst = -1;
+	theLast = -1;
+
+	int i = 0;
+
+#ifdef IMAGELIB_SSE2
+	if (UseSSE2(theCount))
+	{
+		// Lowest and highest set bit of a 4 bit movemask
+		static const int aLowBit[16] = {-1, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
+		static const int aHighBit[16] = {-1, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3};
+
+		const __m128i aZero = _mm_setzero_si128();
+		const __m128i anOpaque = _mm_set1_epi32(0xFF);
+		__m128i aTransAcc = aZero;
+		__m128i aSolidAcc = _mm_cmpeq_epi32(aZero, aZero); // 0 or 255 so far
+
+		for (; i + 4 <= theCount; i += 4)
+		{
+			__m128i anAlpha = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(theSrc + i)), 24);
+			__m128i aTrans = _mm_cmpeq_epi32(anAlpha, aZero);
+
+			aTransAcc = _mm_or_si128(aTransAcc, aTrans);
+			aSolidAcc = _mm_and_si128(aSolidAcc, _mm_or_si128(aTrans, _mm_cmpeq_epi32(anAlpha, anOpaque)));
+
+			int aVisible = ~_mm_movemask_ps(_mm_castsi128_ps(aTrans)) & 0xF;
+			if (aVisible != 0)
+			{
+				if (theFirst < 0)
+					theFirst = i + aLowBit[aVisible];
+				theLast = i + aHighBit[aVisible];
+			}
+		}
+
+		if (_mm_movemask_epi8(aTransAcc) != 0)
+			aFlags |= AlphaScan_HasTrans;
+		if (_mm_movemask_epi8(aSolidAcc) != 0xFFFF)
+			aFlags |= AlphaScan_HasPartial;
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		unsigned long anAlpha = theSrc[i] >> 24;
+
+		if (anAlpha == 0)
+		{
+			aFlags |= AlphaScan_HasTrans;
+			continue;
+		}
+
+		if (anAlpha != 255)
+			aFlags |= AlphaScan_HasPartial;
+
+		if (theFirst < 0)
+			theFirst = i;
+		theLast = i;
+	}
+
+	return aFlags;
+}
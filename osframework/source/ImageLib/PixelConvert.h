@@ -0,0 +1,91 @@
+#ifndef __PIXELCONVERT_H__
+#define __PIXELCONVERT_H__
+
+namespace ImageLib
+{
+
+// Describes a packed native RGB layout (as reported by the display) that
+// premultiplied pixels get repacked into.  Alpha always ends up in the top 8 bits.
+struct PixelPackFormat
+{
+	unsigned long			mRedMask;
+	unsigned long			mGreenMask;
+	unsigned long			mBlueMask;
+	int						mRedBits;
+	int						mGreenBits;
+	int						mBlueBits;
+	int						mRedShift;
+	int						mGreenShift;
+	int						mBlueShift;
+};
+
+extern bool gUseSSE2PixelConvert; // set to false to force the scalar paths
+
+bool CPUHasSSE2();
+
+// ARGB8888 <-> premultiplied ARGB8888
+void PremultiplyAlpha(const unsigned long* theSrc, unsigned long* theDest, int theCount);
+void UnpremultiplyAlpha(const unsigned long* theSrc, unsigned long* theDest, int theCount);
+void PremultiplyToNative(const unsigned long* theSrc, unsigned long* theDest, int theCount, const PixelPackFormat& theFormat);
+void PackToNative(const unsigned long* theSrc, unsigned long* theDest, int theCount, const PixelPackFormat& theFormat); // theSrc is already premultiplied
+
+// Single pixel versions, for loops reading an image that's stored the other way
+extern unsigned long gUnpremultiplyRecip[256]; // 255*65536/a
+
+inline unsigned long PremultiplyPixel(unsigned long thePixel)
+{
+	unsigned long anAlpha = thePixel >> 24;
+
+	return (thePixel & 0xFF000000) |
+		((((thePixel & 0xFF00FF) * (anAlpha+1)) >> 8) & 0xFF00FF) |
+		((((thePixel & 0x00FF00) * (anAlpha+1)) >> 8) & 0x00FF00);
+}
+
+inline unsigned long UnpremultiplyPixel(unsigned long thePixel)
+{
+	unsigned long anAlpha = thePixel >> 24;
+	if (anAlpha == 0xFF)
+		return thePixel;
+
+	unsigned long aRecip = gUnpremultiplyRecip[anAlpha];
+
+	unsigned long r = ((((thePixel >> 16) & 0xFF) * aRecip) + 0x8000) >> 16;
+	unsigned long g = ((((thePixel >> 8 ) & 0xFF) * aRecip) + 0x8000) >> 16;
+	unsigned long b = ((((thePixel      ) & 0xFF) * aRecip) + 0x8000) >> 16;
+
+	if (r > 255) r = 255;
+	if (g > 255) g = 255;
+	if (b > 255) b = 255;
+
+	return (anAlpha << 24) | (r << 16) | (g << 8) | b;
+}
+
+// ARGB8888 <-> 16 bit (alpha is dropped/forced to 0xFF)
+void ARGBToRGB565(const unsigned long* theSrc, unsigned short* theDest, int theCount);
+void RGB565ToARGB(const unsigned short* theSrc, unsigned long* theDest, int theCount);
+void ARGBToRGB555(const unsigned long* theSrc, unsigned short* theDest, int theCount);
+void RGB555ToARGB(const unsigned short* theSrc, unsigned long* theDest, int theCount);
+
+// Byte streams from decoders -> opaque ARGB8888
+void RGB24ToARGB(const unsigned char* theSrc, unsigned long* theDest, int theCount);
+void Gray8ToARGB(const unsigned char* theSrc, unsigned long* theDest, int theCount);
+
+// Alpha channel helpers.  The alpha source is the low (blue) byte of theAlphaSrc.
+void MergeAlphaChannel(unsigned long* theBits, const unsigned long* theAlphaSrc, int theCount);
+void AlphaFromChannel(unsigned long* theBits, int theCount, unsigned long theColor);
+void ApplyColorKey(unsigned long* theBits, int theCount, unsigned long theKeyColor);
+
+// Alpha coverage of a run of ARGB8888 pixels, for classifying images at load time.
+// Returns AlphaScan_ flags, theFirst/theLast get the first and last pixel with
+// non-zero alpha (both -1 when the whole run is transparent).
+enum
+{
+	AlphaScan_HasTrans		= 1,	// some alpha is 0
+	AlphaScan_HasPartial	= 2		// some alpha is between 0 and 255
+};
+
+int ScanAlpha(const unsigned long* theSrc, int theCount, int& theFirst, int& theLast);
+
+}
+
+#endif //__PIXELCONVERT_H__
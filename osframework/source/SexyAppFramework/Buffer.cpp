@@ -4,7 +4,7 @@
 #define POLYNOMIAL 0x04c11db7L
 
 static BOOL 	     bCrcTableGenerated = FALSE;
-static unsigned long crc_table[256];
+static unsigned long crc_table[8][256];	// crc_table[k][i] is the CRC of byte i followed by k zero bytes
 
 using namespace Sexy;
 using namespace std;
@@ -45,12 +45,20 @@ static void GenerateCRCTable(void)
 			else
 				crc_accum = (crc_accum << 1);
 		}
-		crc_table[i] = crc_accum;
+		crc_table[0][i] = crc_accum;
+	}
+
+	for (i = 0; i < 256; i++)
+	{
+		for (j = 1; j < 8; j++)
+			crc_table[j][i] = (crc_table[j-1][i] << 8) ^ crc_table[0][crc_table[j-1][i] >> 24];
 	}
 }
 
 //----------------------------------------------------------------------------
-// Update the CRC on the data block one byte at a time.
+// Update the CRC on the data block eight bytes at a time (slice-by-8), with
+// the leftovers done a byte at a time.  Gives the same result as the plain
+// bytewise loop.
 //----------------------------------------------------------------------------
 static unsigned long UpdateCRC(unsigned long crc_accum,
 						const char *data_blk_ptr,
@@ -59,12 +67,20 @@ static unsigned long UpdateCRC(unsigned long crc_accum,
 	if (!bCrcTableGenerated)
 		GenerateCRCTable();
 	
-	register int i, j;
-	for (j = 0; j < data_blk_size; j++)
+	const unsigned char* p = (const unsigned char*) data_blk_ptr;
+	while (data_blk_size >= 8)
 	{
-		i = ((int) (crc_accum >> 24) ^ *data_blk_ptr++) & 0xff;
-		crc_accum = (crc_accum << 8) ^ crc_table[i];
+		unsigned long hi = crc_accum ^ (((unsigned long) p[0] << 24) | ((unsigned long) p[1] << 16) | ((unsigned long) p[2] << 8) | p[3]);
+		unsigned long lo = ((unsigned long) p[4] << 24) | ((unsigned long) p[5] << 16) | ((unsigned long) p[6] << 8) | p[7];
+		crc_accum = crc_table[7][hi >> 24] ^ crc_table[6][(hi >> 16) & 0xff] ^ crc_table[5][(hi >> 8) & 0xff] ^ crc_table[4][hi & 0xff] ^
+					crc_table[3][lo >> 24] ^ crc_table[2][(lo >> 16) & 0xff] ^ crc_table[1][(lo >> 8) & 0xff] ^ crc_table[0][lo & 0xff];
+		p += 8;
+		data_blk_size -= 8;
 	}
+
+	while (data_blk_size-- > 0)
+		crc_accum = (crc_accum << 8) ^ crc_table[0][((crc_accum >> 24) ^ *p++) & 0xff];
+
 	return crc_accum;
 }
 
@@ -264,6 +280,11 @@ void Buffer::Clear()
 	mData.clear();
 }
 
+void Buffer::Reserve(int theByteCount)
+{
+	mData.reserve(theByteCount);
+}
+
 void Buffer::WriteByte(uchar theByte)
 {	
 	if (mWriteBitPos % 8 == 0)
@@ -282,15 +303,25 @@ void Buffer::WriteByte(uchar theByte)
 
 void Buffer::WriteNumBits(int theNum, int theBits)
 {
-	for (int aBitNum = 0; aBitNum < theBits; aBitNum++)
+	if (theBits <= 0)
+		return;
+
+	int aNeededBytes = (mWriteBitPos + theBits + 7) / 8;
+	if ((int) mData.size() < aNeededBytes)
+		mData.resize(aNeededBytes, 0);
+
+	// Shift the whole value into place at once rather than setting bit by bit
+	ulong aBits = (theBits >= 32) ? (ulong) theNum : ((ulong) theNum & ((1UL << theBits) - 1));
+	unsigned __int64 aVal = ((unsigned __int64) aBits) << (mWriteBitPos % 8);
+
+	uchar* aDest = &mData[mWriteBitPos / 8];
+	while (aVal != 0)
 	{
-		if (mWriteBitPos % 8 == 0)
-			mData.push_back(0);
-		if ((theNum & (1<<aBitNum)) != 0)
-			mData[mWriteBitPos/8] |= 1 << (mWriteBitPos  % 8);
-		mWriteBitPos++;
+		*aDest++ |= (uchar) aVal;
+		aVal >>= 8;
 	}
 
+	mWriteBitPos += theBits;
 	if (mWriteBitPos > mDataBitSize)
 		mDataBitSize = mWriteBitPos;
 }
@@ -317,23 +348,40 @@ void Buffer::WriteBoolean(bool theBool)
 
 void Buffer::WriteShort(short theShort)
 {
-	WriteByte((uchar)theShort);
-	WriteByte((uchar)(theShort >> 8));
+	uchar aBytes[2] = { (uchar) theShort, (uchar) (theShort >> 8) };
+	WriteBytes(aBytes, 2);
 }
 
 void Buffer::WriteLong(long theLong)
 {
-	WriteByte((uchar)theLong);
-	WriteByte((uchar)(theLong >> 8));
-	WriteByte((uchar)(theLong >> 16));
-	WriteByte((uchar)(theLong >> 24));
+	uchar aBytes[4] = { (uchar) theLong, (uchar) (theLong >> 8), (uchar) (theLong >> 16), (uchar) (theLong >> 24) };
+	WriteBytes(aBytes, 4);
+}
+
+void Buffer::WriteVarInt(ulong theNum)
+{
+	// 7 bits per byte, high bit set on all but the last
+	uchar aBytes[5];
+	int aCount = 0;
+	while (theNum >= 0x80)
+	{
+		aBytes[aCount++] = (uchar) (theNum | 0x80);
+		theNum >>= 7;
+	}
+	aBytes[aCount++] = (uchar) theNum;
+	WriteBytes(aBytes, aCount);
+}
+
+void Buffer::WriteSignedVarInt(long theNum)
+{
+	// Zig-zag so small negative numbers stay small: 0, -1, 1, -2... -> 0, 1, 2, 3...
+	WriteVarInt(((ulong) theNum << 1) ^ (ulong) (theNum >> 31));
 }
 
 void Buffer::WriteString(const std::string& theString)
 {
 	WriteShort((short) theString.length());
-	for (int i = 0; i < (int)theString.length(); i++)
-		WriteByte(theString[i]);
+	WriteBytes((const uchar*) theString.c_str(), (int) theString.length());
 }
 
 void Buffer::WriteUTF8String(const std::wstring& theString)
@@ -377,15 +425,39 @@ void Buffer::WriteLine(const std::string& theString)
 
 void Buffer::WriteBuffer(const ByteVector& theBuffer)
 {
-	WriteLong((short) theBuffer.size());
-	for (int i = 0; i < (int)theBuffer.size(); i++)
-		WriteByte(theBuffer[i]);
+	WriteLong((long) theBuffer.size());
+	if (!theBuffer.empty())
+		WriteBytes(&theBuffer[0], (int) theBuffer.size());
 }
 
 void Buffer::WriteBytes(const uchar* theByte, int theCount)
 {
-	for (int i = 0; i < theCount; i++)
-		WriteByte(theByte[i]);
+	if (theCount <= 0)
+		return;
+
+	int anOfs = mWriteBitPos % 8;
+	if (anOfs == 0)
+	{
+		mData.insert(mData.end(), theByte, theByte + theCount);
+	}
+	else
+	{
+		// The partial byte at the end gets the low bits of the first byte, same as WriteByte
+		int aBytePos = mWriteBitPos / 8;
+		if ((int) mData.size() < aBytePos + theCount + 1)
+			mData.resize(aBytePos + theCount + 1, 0);
+
+		uchar* aDest = &mData[aBytePos];
+		for (int i = 0; i < theCount; i++)
+		{
+			aDest[i] |= theByte[i] << anOfs;
+			aDest[i+1] = theByte[i] >> (8 - anOfs);
+		}
+	}
+
+	mWriteBitPos += theCount * 8;
+	if (mWriteBitPos > mDataBitSize)
+		mDataBitSize = mWriteBitPos;
 }
 
 void Buffer::SetData(const ByteVector& theBuffer)
@@ -433,6 +505,31 @@ int Buffer::ReadNumBits(int theBits, bool isSigned) const
 {	
 	int aByteLength = (int) mData.size();
 
+	if ((theBits > 0) && (theBits <= 32) && (mReadBitPos + theBits <= aByteLength*8))
+	{
+		// Everything's there, so gather the bytes it spans and shift once
+		int anOfs = mReadBitPos % 8;
+		int aNumBytes = (anOfs + theBits + 7) / 8;
+		const uchar* aSrc = &mData[mReadBitPos / 8];
+
+		unsigned __int64 aVal = 0;
+		for (int i = 0; i < aNumBytes; i++)
+			aVal |= ((unsigned __int64) aSrc[i]) << (i*8);
+		aVal >>= anOfs;
+
+		mReadBitPos += theBits;
+
+		ulong aNum = (ulong) aVal;
+		if (theBits < 32)
+		{
+			aNum &= (1UL << theBits) - 1;
+			if ((isSigned) && ((aNum & (1UL << (theBits - 1))) != 0)) // sign extend
+				aNum |= ~((1UL << theBits) - 1);
+		}
+
+		return (int) aNum;
+	}
+
 	int theNum = 0;
 	bool bset = false;
 	for (int aBitNum = 0; aBitNum < theBits; aBitNum++)
@@ -462,19 +559,36 @@ bool Buffer::ReadBoolean() const
 
 short Buffer::ReadShort() const
 {
-	short aShort = ReadByte();
-	aShort |= ((short) ReadByte() << 8);
-	return aShort;	
+	uchar aBytes[2];
+	ReadBytes(aBytes, 2);
+	return (short) (aBytes[0] | (aBytes[1] << 8));
 }
 
 long Buffer::ReadLong() const
 {
-	long aLong = ReadByte();
-	aLong |= ((long) ReadByte()) << 8;
-	aLong |= ((long) ReadByte()) << 16;
-	aLong |= ((long) ReadByte()) << 24;
+	uchar aBytes[4];
+	ReadBytes(aBytes, 4);
+	return (long) (aBytes[0] | (aBytes[1] << 8) | (aBytes[2] << 16) | ((ulong) aBytes[3] << 24));
+}
 
-	return aLong;
+ulong Buffer::ReadVarInt() const
+{
+	ulong aNum = 0;
+	for (int aShift = 0; aShift < 35; aShift += 7)
+	{
+		uchar aByte = ReadByte();
+		aNum |= (ulong) (aByte & 0x7F) << aShift;
+		if ((aByte & 0x80) == 0)
+			break;
+	}
+
+	return aNum;
+}
+
+long Buffer::ReadSignedVarInt() const
+{
+	ulong aNum = ReadVarInt();
+	return (long) (aNum >> 1) ^ -(long) (aNum & 1);
 }
 
 std::string	Buffer::ReadString() const
@@ -482,8 +596,11 @@ std::string	Buffer::ReadString() const
 	std::string aString;
 	int aLen = ReadShort();
 
-	for (int i = 0; i < aLen; i++)
-		aString += (char) ReadByte();
+	if (aLen > 0)
+	{
+		aString.resize(aLen);
+		ReadBytes((uchar*) &aString[0], aLen);
+	}
 
 	return aString;
 }
@@ -535,6 +652,14 @@ std::string Buffer::ReadLine() const
 
 void Buffer::ReadBytes(uchar* theData, int theLen) const
 {
+	if ((theLen > 0) && (mReadBitPos % 8 == 0) && (mReadBitPos/8 + theLen <= (int) mData.size()))
+	{
+		memcpy(theData, &mData[mReadBitPos/8], theLen);
+		mReadBitPos += theLen * 8;
+		return;
+	}
+
+	// Unaligned, or running off the end where ReadByte returns zeros
 	for (int i = 0; i < theLen; i++)
 		theData[i] = ReadByte();
 }
@@ -572,6 +697,11 @@ ulong Buffer::GetCRC32(ulong theSeed) const
 	return aCRC;
 }
 
+ulong Buffer::GetCRC32(const void* theData, int theDataLen, ulong theSeed)
+{
+	return UpdateCRC(theSeed, (const char*) theData, theDataLen);
+}
+
 bool Buffer::AtEnd() const
 { 
 	//return mReadBitPos >= (int)mData.size()*8;
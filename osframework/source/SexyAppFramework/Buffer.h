@@ -23,6 +23,7 @@ public:
 			
 	void					SeekFront() const;
 	void					Clear();
+	void					Reserve(int theByteCount);
 
 	void					FromWebString(const std::string& theString);
 	void					WriteByte(uchar theByte);
@@ -31,6 +32,8 @@ public:
 	void					WriteBoolean(bool theBool);
 	void					WriteShort(short theShort);
 	void					WriteLong(long theLong);
+	void					WriteVarInt(ulong theNum);
+	void					WriteSignedVarInt(long theNum);
 	void					WriteString(const std::string& theString);
 	void					WriteUTF8String(const std::wstring& theString);
 	void					WriteLine(const std::string& theString);	
@@ -46,6 +49,8 @@ public:
 	bool					ReadBoolean() const;
 	short					ReadShort() const;
 	long					ReadLong() const;
+	ulong					ReadVarInt() const;
+	long					ReadSignedVarInt() const;
 	std::string				ReadString() const;	
 	std::wstring			ReadUTF8String() const;
 	std::string				ReadLine() const;
@@ -55,7 +60,9 @@ public:
 	const uchar*			GetDataPtr() const;
 	int						GetDataLen() const;	
 	int						GetDataLenBits() const;
+	// Pass the previous result as theSeed to CRC data that arrives in pieces
 	ulong					GetCRC32(ulong theSeed = 0) const;
+	static ulong			GetCRC32(const void* theData, int theDataLen, ulong theSeed = 0);
 
 	bool					AtEnd() const;
 	bool					PastEnd() const;
@@ -38,6 +38,64 @@ void Sexy::SRand(ulong theSeed)
 	gMTRand.SRand(theSeed);
 }
 
+void Sexy::SRand(const std::string& theSerialData)
+{
+	gMTRand.SRand(theSerialData);
+}
+
+std::string Sexy::SerializeRand()
+{
+	return gMTRand.Serialize();
+}
+
+uint64 Sexy::HashData64(const void* theData, int theLen, uint64 theSeed)
+{
+	// MurmurHash64A: eight bytes per step, then the leftovers
+	const uint64 aMul = 0xc6a4a7935bd1e995ui64;
+	const int aShift = 47;
+
+	uint64 aHash = theSeed ^ (theLen * aMul);
+
+	const uchar* aData = (const uchar*) theData;
+	const uchar* anEnd = aData + (theLen & ~7);
+	while (aData != anEnd)
+	{
+		uint64 aWord;
+		memcpy(&aWord, aData, 8);
+		aData += 8;
+
+		aWord *= aMul;
+		aWord ^= aWord >> aShift;
+		aWord *= aMul;
+
+		aHash ^= aWord;
+		aHash *= aMul;
+	}
+
+	switch (theLen & 7)
+	{
+	case 7: aHash ^= (uint64) aData[6] << 48;
+	case 6: aHash ^= (uint64) aData[5] << 40;
+	case 5: aHash ^= (uint64) aData[4] << 32;
+	case 4: aHash ^= (uint64) aData[3] << 24;
+	case 3: aHash ^= (uint64) aData[2] << 16;
+	case 2: aHash ^= (uint64) aData[1] << 8;
+	case 1: aHash ^= (uint64) aData[0];
+		aHash *= aMul;
+	}
+
+	aHash ^= aHash >> aShift;
+	aHash *= aMul;
+	aHash ^= aHash >> aShift;
+
+	return aHash;
+}
+
+uint64 Sexy::HashString64(const std::string& theString, uint64 theSeed)
+{
+	return HashData64(theString.c_str(), (int) theString.length(), theSeed);
+}
+
 bool Sexy::CheckFor98Mill()
 {
 	static bool needOsCheck = true;
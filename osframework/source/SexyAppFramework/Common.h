@@ -99,6 +99,7 @@ typedef unsigned short ushort;
 typedef unsigned int uint;
 typedef unsigned long ulong;
 typedef __int64 int64;
+typedef unsigned __int64 uint64;
 
 typedef std::map<std::string, std::string>		DefinesMap;
 typedef std::map<std::wstring, std::wstring>	WStringWStringMap;
@@ -117,6 +118,10 @@ int					Rand();
 int					Rand(int range);
 float				Rand(float range);
 void				SRand(ulong theSeed);
+void				SRand(const std::string& theSerialData);
+std::string			SerializeRand();
+uint64				HashData64(const void* theData, int theLen, uint64 theSeed = 0); // fast, not cryptographic
+uint64				HashString64(const std::string& theString, uint64 theSeed = 0);
 extern std::string	vformat(const char* fmt, va_list argPtr);
 extern std::wstring	vformat(const wchar_t* fmt, va_list argPtr);
 extern std::string	StrFormat(const char* fmt ...);
@@ -5,6 +5,7 @@
 #include "SexyMatrix.h"
 #include "SexyAppBase.h"
 #include "TriVertex.h"
+#include "../ImageLib/PixelConvert.h"
 #include <assert.h>
 #include <algorithm>
 
@@ -447,19 +448,29 @@ static LPDIRECTDRAWSURFACE7 CreateTextureSurface(LPDIRECT3DDEVICE7 theDevice, LP
 ///////////////////////////////////////////////////////////////////////////////
 static void CopyImageToTexture8888(void *theDest, DWORD theDestPitch, MemoryImage *theImage, int offx, int offy, int theWidth, int theHeight, bool rightPad)
 {
+	// Textures are always straight alpha, the blend states expect it
+	bool premultiplied = theImage->mPremultipliedAlpha;
 
 	if (theImage->mColorTable == NULL)
 	{
-		DWORD *srcRow = theImage->GetBits() + offy * theImage->GetWidth() + offx;
+		DWORD *srcRow = theImage->GetRawBits() + offy * theImage->GetWidth() + offx;
 		char *dstRow = (char*)theDest;
 
 		for(int y=0; y<theHeight; y++)
 		{
 			DWORD *src = srcRow;
 			DWORD *dst = (DWORD*)dstRow;
-			for(int x=0; x<theWidth; x++)
+			if (premultiplied)
+			{
+				for(int x=0; x<theWidth; x++)
+					*dst++ = ImageLib::UnpremultiplyPixel(*src++);
+			}
+			else
 			{
-				*dst++ = *src++;
+				for(int x=0; x<theWidth; x++)
+				{
+					*dst++ = *src++;
+				}
 			}
 
 			if (rightPad) 
@@ -473,7 +484,14 @@ static void CopyImageToTexture8888(void *theDest, DWORD theDestPitch, MemoryImag
 	{
 		uchar *srcRow = (uchar*)theImage->mColorIndices + offy * theImage->GetWidth() + offx;
 		uchar *dstRow = (uchar*)theDest;
+		DWORD aStraightTable[256];
 		DWORD *palette = theImage->mColorTable;
+		if (premultiplied)
+		{
+			for (int i = 0; i < 256; i++)
+				aStraightTable[i] = ImageLib::UnpremultiplyPixel(palette[i]);
+			palette = aStraightTable;
+		}
 
 		for(int y=0; y<theHeight; y++)
 		{
@@ -496,15 +514,24 @@ static void CopyImageToTexture8888(void *theDest, DWORD theDestPitch, MemoryImag
 static void CopyTexture8888ToImage(void *theDest, DWORD theDestPitch, MemoryImage *theImage, int offx, int offy, int theWidth, int theHeight)
 {		
 	char *srcRow = (char*)theDest;
-	DWORD *dstRow = theImage->GetBits() + offy * theImage->GetWidth() + offx;
+	DWORD *dstRow = theImage->GetRawBits() + offy * theImage->GetWidth() + offx;
+	bool premultiplied = theImage->mPremultipliedAlpha;
 
 	for(int y=0; y<theHeight; y++)
 	{
 		DWORD *src = (DWORD*)srcRow;
 		DWORD *dst = dstRow;
 		
-		for(int x=0; x<theWidth; x++)
-			*dst++ = *src++;		
+		if (premultiplied)
+		{
+			for(int x=0; x<theWidth; x++)
+				*dst++ = ImageLib::PremultiplyPixel(*src++);
+		}
+		else
+		{
+			for(int x=0; x<theWidth; x++)
+				*dst++ = *src++;		
+		}
 
 		dstRow += theImage->GetWidth();
 		srcRow += theDestPitch;
@@ -515,9 +542,11 @@ static void CopyTexture8888ToImage(void *theDest, DWORD theDestPitch, MemoryImag
 ///////////////////////////////////////////////////////////////////////////////
 static void CopyImageToTexture4444(void *theDest, DWORD theDestPitch, MemoryImage *theImage, int offx, int offy, int theWidth, int theHeight, bool rightPad)
 {
+	bool premultiplied = theImage->mPremultipliedAlpha;
+
 	if (theImage->mColorTable == NULL)
 	{
-		DWORD *srcRow = theImage->GetBits() + offy * theImage->GetWidth() + offx;
+		DWORD *srcRow = theImage->GetRawBits() + offy * theImage->GetWidth() + offx;
 		char *dstRow = (char*)theDest;
 
 		for(int y=0; y<theHeight; y++)
@@ -527,6 +556,8 @@ static void CopyImageToTexture4444(void *theDest, DWORD theDestPitch, MemoryImag
 			for(int x=0; x<theWidth; x++)
 			{
 				DWORD aPixel = *src++;
+				if (premultiplied)
+					aPixel = ImageLib::UnpremultiplyPixel(aPixel);
 				*dst++ = ((aPixel>>16)&0xF000) | ((aPixel>>12)&0x0F00) | ((aPixel>>8)&0x00F0) | ((aPixel>>4)&0x000F);
 			}
 
@@ -541,7 +572,14 @@ static void CopyImageToTexture4444(void *theDest, DWORD theDestPitch, MemoryImag
 	{
 		uchar *srcRow = (uchar*)theImage->mColorIndices + offy * theImage->GetWidth() + offx;
 		uchar *dstRow = (uchar*)theDest;
+		DWORD aStraightTable[256];
 		DWORD *palette = theImage->mColorTable;
+		if (premultiplied)
+		{
+			for (int i = 0; i < 256; i++)
+				aStraightTable[i] = ImageLib::UnpremultiplyPixel(palette[i]);
+			palette = aStraightTable;
+		}
 
 		for(int y=0; y<theHeight; y++)
 		{
@@ -568,7 +606,7 @@ static void CopyImageToTexture4444(void *theDest, DWORD theDestPitch, MemoryImag
 static void CopyTexture4444ToImage(void *theDest, DWORD theDestPitch, MemoryImage *theImage, int offx, int offy, int theWidth, int theHeight)
 {		
 	char *srcRow = (char*)theDest;
-	DWORD *dstRow = theImage->GetBits() + offy * theImage->GetWidth() + offx;
+	DWORD *dstRow = theImage->GetRawBits() + offy * theImage->GetWidth() + offx;
 
 	for(int y=0; y<theHeight; y++)
 	{
@@ -592,18 +630,14 @@ static void CopyImageToTexture565(void *theDest, DWORD theDestPitch, MemoryImage
 {
 	if (theImage->mColorTable == NULL)
 	{
-		DWORD *srcRow = theImage->GetBits() + offy * theImage->GetWidth() + offx;
+		DWORD *srcRow = theImage->GetRawBits() + offy * theImage->GetWidth() + offx;
 		char *dstRow = (char*)theDest;
 
 		for(int y=0; y<theHeight; y++)
 		{
-			DWORD *src = srcRow;
 			ushort *dst = (ushort*)dstRow;
-			for(int x=0; x<theWidth; x++)
-			{
-				DWORD aPixel = *src++;
-				*dst++ = ((aPixel>>8)&0xF800) | ((aPixel>>5)&0x07E0) | ((aPixel>>3)&0x001F);
-			}
+			ImageLib::ARGBToRGB565(srcRow, dst, theWidth);
+			dst += theWidth;
 
 			if (rightPad) 
 				*dst = *(dst-1);
@@ -643,18 +677,11 @@ static void CopyImageToTexture565(void *theDest, DWORD theDestPitch, MemoryImage
 static void CopyTexture565ToImage(void *theDest, DWORD theDestPitch, MemoryImage *theImage, int offx, int offy, int theWidth, int theHeight)
 {		
 	char *srcRow = (char*)theDest;
-	DWORD *dstRow = theImage->GetBits() + offy * theImage->GetWidth() + offx;
+	DWORD *dstRow = theImage->GetRawBits() + offy * theImage->GetWidth() + offx;
 
 	for(int y=0; y<theHeight; y++)
 	{
-		ushort *src = (ushort*)srcRow;
-		DWORD *dst = dstRow;
-		
-		for(int x=0; x<theWidth; x++)
-		{
-			ushort aPixel = *src++;			
-			*dst++ = 0xFF000000 | ((aPixel & 0xF800) << 8) | ((aPixel & 0x07E0) << 5) | ((aPixel & 0x001F) << 3);
-		}
+		ImageLib::RGB565ToARGB((ushort*)srcRow, dstRow, theWidth);
 
 		dstRow += theImage->GetWidth();
 		srcRow += theDestPitch;
@@ -689,7 +716,7 @@ static void CopyImageToTexturePalette8(void *theDest, DWORD theDestPitch, Memory
 static void CopyTexturePalette8ToImage(void *theDest, DWORD theDestPitch, MemoryImage *theImage, int offx, int offy, int theWidth, int theHeight, LPDIRECTDRAWPALETTE thePalette)
 {
 	char *srcRow = (char*)theDest;
-	DWORD *dstRow = theImage->GetBits() + offy * theImage->GetWidth() + offx;
+	DWORD *dstRow = theImage->GetRawBits() + offy * theImage->GetWidth() + offx;
 
 	PALETTEENTRY aPaletteEntries[256];
 	thePalette->GetEntries(0, 0, 256, aPaletteEntries); 
@@ -1004,6 +1031,8 @@ void TextureData::CreateTextures(MemoryImage *theImage, LPDIRECT3DDEVICE7 theDev
 		for (int i=0; i<256; i++)
 		{
 			DWORD aPixel = theImage->mColorTable[i];
+			if (theImage->mPremultipliedAlpha)
+				aPixel = ImageLib::UnpremultiplyPixel(aPixel);
 			*(DWORD*)(aPalette+i) = (aPixel&0xFF00FF00) | ((aPixel>>16)&0xFF) | ((aPixel<<16)&0xFF0000);
 		}
 		HRESULT aResult = theDraw->CreatePalette(DDPCAPS_8BIT | DDPCAPS_ALPHA | DDPCAPS_ALLOW256,aPalette, &aDDPalette, NULL);
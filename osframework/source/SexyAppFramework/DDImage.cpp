@@ -7,6 +7,7 @@
 #include "SexyAppBase.h"
 #include "Debug.h"
 #include "PerfTimer.h"
+#include "../ImageLib/PixelConvert.h"
 
 #pragma warning(disable:4005) // macro redefinition
 #pragma warning(disable:4244) // conversion possible loss of data
@@ -31,6 +32,8 @@ DDImage::DDImage() :
 
 DDImage::~DDImage()
 {
+	mApp->WaitForRenderThread();
+
 	if (mSurface != NULL)
 		mSurface->Release();
 	mDDInterface->RemoveDDImage(this);
@@ -74,6 +77,9 @@ bool DDImage::LockSurface()
 
 	if (mLockCount == 0)
 	{
+		// Drawing onto a surface the frame in flight reads from
+		mApp->WaitForRenderThread(this);
+
 		memset(&mLockedSurfaceDesc, 0, sizeof(mLockedSurfaceDesc));
 		mLockedSurfaceDesc.dwSize = sizeof(mLockedSurfaceDesc);
 		int aResult = GetSurface()->Lock(NULL, &mLockedSurfaceDesc, DDLOCK_SURFACEMEMORYPTR | DDLOCK_WAIT, NULL);
@@ -139,7 +145,7 @@ bool DDImage::GenerateDDSurface()
 
 	// Force into non-palletized mode for this
 	if (mColorTable != NULL)
-		GetBits();
+		GetRawBits();
 
 	HRESULT aResult;
 //	TDDSurfaceDesc aDesc;
@@ -528,7 +534,7 @@ void DDImage::DeleteDDSurface()
 	if (mSurface != NULL)
 	{
 		if ((mColorTable == NULL) && (mBits == NULL) && (mD3DData == NULL))
-			GetBits();
+			GetRawBits();
 
 		mSurface->Release();
 		mSurface = NULL;
@@ -572,7 +578,7 @@ void DDImage::PurgeBits()
 	{
 		if (mSurface != NULL)
 		{
-			GetBits();
+			GetRawBits();
 			DeleteDDSurface();
 		}
 	}
@@ -599,6 +605,13 @@ void DDImage::DeleteAllNonSurfaceData()
 
 	delete [] mColorIndices;
 	mColorIndices = NULL;
+
+	// The surface is being drawn to
+	mCelAlphaInfo.clear();
+
+	delete mTrimImage;
+	mTrimImage = NULL;
+	mTrimCels.clear();
 }
 
 void DDImage::DeleteNativeData()
@@ -626,7 +639,7 @@ void DDImage::SetVideoMemory(bool wantVideoMemory)
 		mVideoMemory = wantVideoMemory;
 
 		// Make sure that we have the bits
-		GetBits();
+		GetRawBits();
 
 		DeleteDDSurface();
 	}
@@ -687,7 +700,10 @@ LPDIRECTDRAWSURFACE DDImage::GetSurface()
 	//TODO: Log if generate surface fails
 
 	if (mSurface == NULL)
+	{
+		mApp->WaitForRenderThread(this);
 		GenerateDDSurface();
+	}
 
 	return mSurface;
 }
@@ -1997,12 +2013,14 @@ void DDImage::BitsChanged()
 	mSurface = NULL;
 }
 
-ulong* DDImage::GetBits()
+ulong* DDImage::GetRawBits()
 {
+	mApp->WaitForRenderThread(this);
+
 	if (mBits == NULL)
 	{
 		if (mSurface == NULL)
-			return MemoryImage::GetBits();
+			return MemoryImage::GetRawBits();
 
 		if (mNoLock)
 			return NULL;
@@ -2280,7 +2298,7 @@ void DDImage::AdditiveFillRect(const Rect& theRect, const Color& theColor)
 	UnlockSurface();
 }
 
-void DDImage::NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcRect, const Color& theColor)
+void DDImage::NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcRectOrig, const Color& theColor)
 {
 	theImage->mDrawn = true;
 
@@ -2291,6 +2309,14 @@ void DDImage::NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcR
 	{
 		aMemoryImage->CommitBits();		
 
+		Rect theSrcRect = theSrcRectOrig;
+		int aSrcAlphaType;
+		if (!aMemoryImage->TrimToContent(theX, theY, theSrcRect, aSrcAlphaType))
+			return;
+
+		// An opaque or 1-bit cel of an image with alpha elsewhere can still take the fast path
+		bool aSrcHasTrans = aSrcAlphaType != CelAlpha_Opaque;
+
 		RECT aDestRect = {theX, theY, theX + theSrcRect.mWidth, theY + theSrcRect.mHeight};
 		RECT aSrcRect = {theSrcRect.mX, theSrcRect.mY, theSrcRect.mX + theSrcRect.mWidth, theSrcRect.mY + theSrcRect.mHeight};	
 
@@ -2298,9 +2324,20 @@ void DDImage::NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcR
 		if ((aMemoryImage->mIsVolatile) && ((aDDImage == NULL) || (aDDImage->mSurface == NULL)) && 
 			(!mNoLock) && (theColor == Color::White))
 		{
-			if (aMemoryImage->mColorTable == NULL)
+			// The surface holds straight colors, so premultiplied sources get converted as they're read
+			if ((aMemoryImage->mColorTable == NULL) && (aMemoryImage->mPremultipliedAlpha))
 			{
-				ulong* aSrcBits = aMemoryImage->GetBits();			
+				ulong* aSrcBits = aMemoryImage->GetRawBits();			
+
+				#define SRC_TYPE ulong
+				#define NEXT_SRC_COLOR (ImageLib::UnpremultiplyPixel(*(aSrcPixels++)))
+				#include "DDI_NormalBlt_Volatile.inc"
+				#undef	SRC_TYPE
+				#undef NEXT_SRC_COLOR
+			}
+			else if (aMemoryImage->mColorTable == NULL)
+			{
+				ulong* aSrcBits = aMemoryImage->GetRawBits();			
 
 				#define SRC_TYPE ulong
 				#define NEXT_SRC_COLOR (*(aSrcPixels++))
@@ -2313,6 +2350,13 @@ void DDImage::NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcR
 				ulong* aColorTable = aMemoryImage->mColorTable;
 				uchar* aSrcBits = aMemoryImage->mColorIndices;
 
+				ulong aStraightTable[256];
+				if (aMemoryImage->mPremultipliedAlpha)
+				{
+					ImageLib::UnpremultiplyAlpha(aColorTable, aStraightTable, 256);
+					aColorTable = aStraightTable;
+				}
+
 				#define SRC_TYPE uchar
 				#define NEXT_SRC_COLOR (aColorTable[*(aSrcPixels++)])
 				
@@ -2322,7 +2366,7 @@ void DDImage::NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcR
 				#undef NEXT_SRC_COLOR
 			}
 		}
-		else if ((aMemoryImage->mHasAlpha) || (theColor != Color::White))
+		else if ((aSrcAlphaType == CelAlpha_Full) || (theColor != Color::White))
 		{
 			if (mNoLock)
 				return;			
@@ -2386,7 +2430,21 @@ void DDImage::NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcR
 
 			void* aNativeAlphaData = aMemoryImage->GetNativeAlphaData(mDDInterface);
 
-			if (aMemoryImage->mColorTable == NULL)
+			if ((aMemoryImage->mColorTable == NULL) && (!aSrcHasTrans) && (mLockedSurfaceDesc.ddpfPixelFormat.dwRGBBitCount == 32))
+			{
+				// The 32 bit native data is already in the surface's format
+				ulong* aSrcPixelsRow = ((ulong*) aNativeAlphaData) + (theSrcRect.mY * theImage->mWidth) + theSrcRect.mX;
+				ulong* aDestPixelsRow = ((ulong*) mLockedSurfaceDesc.lpSurface) + (theY * mLockedSurfaceDesc.lPitch/4) + theX;
+
+				for (int y = 0; y < theSrcRect.mHeight; y++)
+				{
+					memcpy(aDestPixelsRow, aSrcPixelsRow, theSrcRect.mWidth*sizeof(ulong));
+
+					aDestPixelsRow += mLockedSurfaceDesc.lPitch/4;
+					aSrcPixelsRow += theImage->mWidth;
+				}
+			}
+			else if (aMemoryImage->mColorTable == NULL)
 			{
 				ulong* aSrcPixelsRow = ((ulong*) aNativeAlphaData) + (theSrcRect.mY * theImage->mWidth) + theSrcRect.mX;
 				ulong* aSrcPixels;
@@ -2781,9 +2839,22 @@ void DDImage::BltRotated(Image* theImage, float theX, float theY, const Rect &th
 
 		if (theDrawMode == Graphics::DRAWMODE_NORMAL)
 		{
-			if (aMemoryImage->mColorTable == NULL)
+			if ((aMemoryImage->mColorTable == NULL) && (aMemoryImage->mPremultipliedAlpha))
+			{
+				ulong* aSrcBits = aMemoryImage->GetRawBits() + theSrcRect.mX + theSrcRect.mY*aMemoryImage->GetWidth();			
+
+				#define SRC_TYPE ulong
+				#define READ_COLOR(ptr) (ImageLib::UnpremultiplyPixel(*(ptr)))
+
+				#include "DDI_BltRotated.inc"
+
+				#undef SRC_TYPE
+				#undef READ_COLOR
+
+			}
+			else if (aMemoryImage->mColorTable == NULL)
 			{
-				ulong* aSrcBits = aMemoryImage->GetBits() + theSrcRect.mX + theSrcRect.mY*aMemoryImage->GetWidth();			
+				ulong* aSrcBits = aMemoryImage->GetRawBits() + theSrcRect.mX + theSrcRect.mY*aMemoryImage->GetWidth();			
 
 				#define SRC_TYPE ulong
 				#define READ_COLOR(ptr) (*(ptr))
@@ -2799,6 +2870,13 @@ void DDImage::BltRotated(Image* theImage, float theX, float theY, const Rect &th
 				ulong* aColorTable = aMemoryImage->mColorTable;
 				uchar* aSrcBits = aMemoryImage->mColorIndices + theSrcRect.mX + theSrcRect.mY*aMemoryImage->GetWidth();
 
+				ulong aStraightTable[256];
+				if (aMemoryImage->mPremultipliedAlpha)
+				{
+					ImageLib::UnpremultiplyAlpha(aColorTable, aStraightTable, 256);
+					aColorTable = aStraightTable;
+				}
+
 				#define SRC_TYPE uchar
 				#define READ_COLOR(ptr) (aColorTable[*(ptr)])
 
@@ -2810,9 +2888,22 @@ void DDImage::BltRotated(Image* theImage, float theX, float theY, const Rect &th
 		}
 		else
 		{
-			if (aMemoryImage->mColorTable == NULL)
+			if ((aMemoryImage->mColorTable == NULL) && (aMemoryImage->mPremultipliedAlpha))
+			{
+				ulong* aSrcBits = aMemoryImage->GetRawBits() + theSrcRect.mX + theSrcRect.mY*aMemoryImage->GetWidth();			
+
+				#define SRC_TYPE ulong
+				#define READ_COLOR(ptr) (ImageLib::UnpremultiplyPixel(*(ptr)))
+
+				#include "DDI_BltRotated_Additive.inc"
+
+				#undef SRC_TYPE
+				#undef READ_COLOR
+
+			}
+			else if (aMemoryImage->mColorTable == NULL)
 			{
-				ulong* aSrcBits = aMemoryImage->GetBits() + theSrcRect.mX + theSrcRect.mY*aMemoryImage->GetWidth();			
+				ulong* aSrcBits = aMemoryImage->GetRawBits() + theSrcRect.mX + theSrcRect.mY*aMemoryImage->GetWidth();			
 
 				#define SRC_TYPE ulong
 				#define READ_COLOR(ptr) (*(ptr))
@@ -2828,6 +2919,13 @@ void DDImage::BltRotated(Image* theImage, float theX, float theY, const Rect &th
 				ulong* aColorTable = aMemoryImage->mColorTable;
 				uchar* aSrcBits = aMemoryImage->mColorIndices + theSrcRect.mX + theSrcRect.mY*aMemoryImage->GetWidth();
 
+				ulong aStraightTable[256];
+				if (aMemoryImage->mPremultipliedAlpha)
+				{
+					ImageLib::UnpremultiplyAlpha(aColorTable, aStraightTable, 256);
+					aColorTable = aStraightTable;
+				}
+
 				#define SRC_TYPE uchar
 				#define READ_COLOR(ptr) (aColorTable[*(ptr)])
 
@@ -72,7 +72,7 @@ public:
 	virtual void			SetSurface(LPDIRECTDRAWSURFACE theSurface);
 
 	virtual void			Create(int theWidth, int theHeight);
-	virtual ulong*			GetBits();
+	virtual ulong*			GetRawBits();
 	
 	virtual bool			PolyFill3D(const Point theVertices[], int theNumVertices, const Rect *theClipRect, const Color &theColor, int theDrawMode, int tx, int ty, bool comvex);
 	virtual void			FillRect(const Rect& theRect, const Color& theColor, int theDrawMode);
@@ -3,8 +3,12 @@
 #include <fcntl.h>
 #include "debug.h"
 #include "DSoundInstance.h"
+#include "DSoundStreamInstance.h"
+#include "OggStream.h"
+#include "AutoCrit.h"
 #include "FModLoader.h"
 #include <math.h>
+#include <process.h>
 #include "..\PakLib\PakInterface.h"
 
 using namespace Sexy;
@@ -12,23 +16,22 @@ using namespace Sexy;
 #define USE_OGG_LIB
 
 
-#ifdef USE_OGG_LIB
-#include "ogg/ivorbiscodec.h"
-#include "ogg/ivorbisfile.h"
-#endif
-
 #define SOUND_FLAGS (DSBCAPS_CTRLPAN | DSBCAPS_CTRLVOLUME |  DSBCAPS_STATIC | DSBCAPS_LOCSOFTWARE | DSBCAPS_GLOBALFOCUS | DSBCAPS_CTRLFREQUENCY)
 DSoundManager::DSoundManager(HWND theHWnd, bool haveFMod)
 {
 	mHaveFMod = haveFMod;
 	mLastReleaseTick = 0;
 	mPrimaryBuffer = NULL;
+	mStreamThreshold = 1024*1024;
+	mStreamThreadRunning = false;
+	mStreamThreadExit = false;
 
 	int i;
 
 	for (i = 0; i < MAX_SOURCE_SOUNDS; i++)
 	{
 		mSourceSounds[i] = NULL;
+		mSourceStreamed[i] = false;
 		mBaseVolumes[i] = 1;
 		mBasePans[i] = 0;
 	}
@@ -104,6 +107,7 @@ DSoundManager::DSoundManager(HWND theHWnd, bool haveFMod)
 
 DSoundManager::~DSoundManager()
 {
+	StopStreamThread();
 	ReleaseChannels();
 	ReleaseSounds();
 
@@ -447,57 +451,36 @@ exit(0);
 }
 
 #ifdef USE_OGG_LIB
-
-static int p_fseek64_wrap(PFILE *f,ogg_int64_t off,int whence){
-	if(f==NULL)return(-1);
-	return p_fseek(f,(long)off,whence);
-}
-
-int ov_pak_open(PFILE *f,OggVorbis_File *vf,char *initial,long ibytes){
-	ov_callbacks callbacks = {
-		(size_t (*)(void *, size_t, size_t, void *))  p_fread,
-		(int (*)(void *, ogg_int64_t, int))             p_fseek64_wrap,
-		(int (*)(void *))                             p_fclose,
-		(long (*)(void *))                            p_ftell
-	};
-
-	return ov_open_callbacks((void *)f, vf, initial, ibytes, callbacks);
-}
-
 bool DSoundManager::LoadOGGSound(unsigned int theSfxID, const std::string& theFilename)
 {
-	OggVorbis_File vf;
-	int current_section;
-
-	PFILE *aFile = p_fopen(theFilename.c_str(),"rb");
-	if (aFile==NULL)
+	OggStream aStream;
+	if (!aStream.Open(theFilename))
 		return false;
 
-	if(ov_pak_open(aFile, &vf, NULL, 0) < 0) 
+	int aLenBytes = aStream.mTotalBytes;
+	mSourceDataSizes[theSfxID] = aLenBytes;
+
+	// Long sounds are decoded as they play by DSoundStreamInstance
+	if ((mStreamThreshold > 0) && (aLenBytes > mStreamThreshold))
 	{
-		p_fclose(aFile);
-		return false;
+		mSourceStreamed[theSfxID] = true;
+		return true;
 	}
-  
-	vorbis_info *anInfo = ov_info(&vf,-1);
-	
+
 	PCMWAVEFORMAT aWaveFormat;
 	DSBUFFERDESC aBufferDesc;    			
 
 	// Set up wave format structure.
 	memset(&aWaveFormat, 0, sizeof(PCMWAVEFORMAT));
 	aWaveFormat.wf.wFormatTag = WAVE_FORMAT_PCM;
-	aWaveFormat.wf.nChannels = anInfo->channels;
-	aWaveFormat.wf.nSamplesPerSec = anInfo->rate;
+	aWaveFormat.wf.nChannels = aStream.mChannels;
+	aWaveFormat.wf.nSamplesPerSec = aStream.mSampleRate;
 	aWaveFormat.wBitsPerSample = 16;
 	aWaveFormat.wf.nBlockAlign = aWaveFormat.wf.nChannels*aWaveFormat.wBitsPerSample/8;
 	aWaveFormat.wf.nAvgBytesPerSec = aWaveFormat.wf.nSamplesPerSec * aWaveFormat.wf.nBlockAlign;	
 
-	int aLenBytes = (int) (ov_pcm_total(&vf,-1) * aWaveFormat.wf.nBlockAlign);	
 	memset(&aBufferDesc, 0, sizeof(DSBUFFERDESC)); // Zero it out.
 
-	mSourceDataSizes[theSfxID] = aLenBytes;
-	
 	//FUNK
 	aBufferDesc.dwSize = sizeof(DSBUFFERDESC);
 	aBufferDesc.dwFlags = SOUND_FLAGS;
@@ -505,38 +488,17 @@ bool DSoundManager::LoadOGGSound(unsigned int theSfxID, const std::string& theFi
 	aBufferDesc.lpwfxFormat =(LPWAVEFORMATEX)&aWaveFormat;	
 
 	if (mDirectSound->CreateSoundBuffer(&aBufferDesc, &mSourceSounds[theSfxID], NULL) != DS_OK)
-	{
-		ov_clear(&vf);
 		return false;
-	}
 
 	char* aBuf;
 	DWORD dwBytes;
 	if (mSourceSounds[theSfxID]->Lock(0, aLenBytes, (LPVOID*)&aBuf, &dwBytes, NULL, NULL, 0) != DS_OK)
-	{
-		ov_clear(&vf);
 		return false;
-	}
 
-	char *aPtr = aBuf;
-	int aNumBytes = dwBytes;
-	while(aNumBytes > 0)
-	{		
-		long ret=ov_read(&vf,aPtr,aNumBytes,&current_section);
-		if (ret == 0)
-			break;
-		else if (ret < 0) 
-			break;
-		else 
-		{
-			aPtr += ret;
-			aNumBytes -= ret;
-		}
-	}
+	int aReadBytes = aStream.Read(aBuf, dwBytes, false);
 
 	mSourceSounds[theSfxID]->Unlock(aBuf, dwBytes, NULL, 0);
-	ov_clear(&vf);
-	return aNumBytes==0;  
+	return aReadBytes==(int)dwBytes;  
 }
 #else
 bool DSoundManager::LoadOGGSound(unsigned int theSfxID, const std::string& theFilename)
@@ -752,7 +714,8 @@ bool DSoundManager::LoadSound(unsigned int theSfxID, const std::string& theFilen
 #ifdef USE_OGG_LIB
 	if (LoadOGGSound(theSfxID, aFilename + ".ogg"))
 	{		
-		WriteWAV(theSfxID, aCachedName, aFilename + ".ogg");
+		if (!mSourceStreamed[theSfxID])
+			WriteWAV(theSfxID, aCachedName, aFilename + ".ogg");
 		return true;
 	}
 #endif
@@ -775,7 +738,7 @@ int DSoundManager::LoadSound(const std::string& theFilename)
 
 	for (i = MAX_SOURCE_SOUNDS-1; i >= 0; i--)
 	{		
-		if (mSourceSounds[i] == NULL)
+		if ((mSourceSounds[i] == NULL) && (!mSourceStreamed[i]))
 		{
 			if (!LoadSound(i, theFilename))
 				return -1;
@@ -795,13 +758,19 @@ void DSoundManager::ReleaseSound(unsigned int theSfxID)
 		mSourceSounds[theSfxID] = NULL;
 		mSourceFileNames[theSfxID] = "";
 	}
+
+	if (mSourceStreamed[theSfxID])
+	{
+		mSourceStreamed[theSfxID] = false;
+		mSourceFileNames[theSfxID] = "";
+	}
 }
 
 int DSoundManager::GetFreeSoundId()
 {
 	for (int i=0; i<MAX_SOURCE_SOUNDS; i++)
 	{
-		if (mSourceSounds[i]==NULL)
+		if ((mSourceSounds[i]==NULL) && (!mSourceStreamed[i]))
 			return i;
 	}
 
@@ -813,7 +782,7 @@ int DSoundManager::GetNumSounds()
 	int aCount = 0;
 	for (int i=0; i<MAX_SOURCE_SOUNDS; i++)
 	{
-		if (mSourceSounds[i]!=NULL)
+		if ((mSourceSounds[i]!=NULL) || (mSourceStreamed[i]))
 			aCount++;
 	}
 
@@ -953,6 +922,10 @@ SoundInstance* DSoundManager::GetSoundInstance(unsigned int theSfxID)
 	{
 		mPlayingSounds[aFreeChannel] = new DSoundInstance(this, NULL);
 	}
+	else if (mSourceStreamed[theSfxID])
+	{
+		mPlayingSounds[aFreeChannel] = new DSoundStreamInstance(this, mSourceFileNames[theSfxID] + ".ogg");
+	}
 	else
 	{
 		if (mSourceSounds[theSfxID] == NULL)
@@ -970,11 +943,15 @@ SoundInstance* DSoundManager::GetSoundInstance(unsigned int theSfxID)
 void DSoundManager::ReleaseSounds()
 {
 	for (int i = 0; i < MAX_SOURCE_SOUNDS; i++)
+	{
 		if (mSourceSounds[i] != NULL)
 		{
 			mSourceSounds[i]->Release();
 			mSourceSounds[i] = NULL;
 		}
+
+		mSourceStreamed[i] = false;
+	}
 }
 
 void DSoundManager::ReleaseChannels()
@@ -997,6 +974,45 @@ void DSoundManager::ReleaseFreeChannels()
 		}
 }
 
+void DSoundManager::StartStreamThread()
+{
+	if (mStreamThreadRunning)
+		return;
+
+	mStreamThreadExit = false;
+	mStreamThreadRunning = true;
+	_beginthread(StreamThreadProcStub, 0, this);
+}
+
+void DSoundManager::StopStreamThread()
+{
+	mStreamThreadExit = true;
+	while (mStreamThreadRunning)
+		Sleep(10);
+}
+
+void DSoundManager::StreamThreadProc()
+{
+	while (!mStreamThreadExit)
+	{
+		{
+			AutoCrit anAutoCrit(mStreamCritSect);
+			for (StreamInstanceList::iterator anItr = mStreamInstances.begin(); anItr != mStreamInstances.end(); ++anItr)
+				(*anItr)->Update();
+		}
+
+		// Well under a chunk, so the ring buffer never runs dry
+		Sleep(50);
+	}
+
+	mStreamThreadRunning = false;
+}
+
+void DSoundManager::StreamThreadProcStub(void *theArg)
+{
+	((DSoundManager*) theArg)->StreamThreadProc();
+}
+
 void DSoundManager::StopAllSounds()
 {
 	for (int i = 0; i < MAX_CHANNELS; i++)
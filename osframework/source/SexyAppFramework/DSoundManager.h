@@ -3,16 +3,21 @@
 
 #include "dsoundversion.h"
 #include "SoundManager.h"
+#include "CritSect.h"
 
 namespace Sexy
 {
 
 class DSoundInstance;
+class DSoundStreamInstance;
 
 class DSoundManager : public SoundManager
 {
 	friend class DSoundInstance;
 	friend class DSoundMusicInterface;
+	friend class DSoundStreamInstance;
+
+	typedef std::list<DSoundStreamInstance*> StreamInstanceList;
 
 protected:
 	LPDIRECTSOUNDBUFFER		mSourceSounds[MAX_SOURCE_SOUNDS];
@@ -25,6 +30,12 @@ protected:
 	double					mMasterVolume;
 	DWORD					mLastReleaseTick;
 
+	bool					mSourceStreamed[MAX_SOURCE_SOUNDS];
+	CritSect				mStreamCritSect;
+	StreamInstanceList		mStreamInstances;
+	bool					mStreamThreadRunning;
+	bool					mStreamThreadExit;
+
 protected:
 	int						FindFreeChannel();
 	int						VolumeToDB(double theVolume);
@@ -36,9 +47,15 @@ protected:
 	bool					GetTheFileTime(const std::string& theDepFile, FILETIME* theFileTime);
 	void					ReleaseFreeChannels();
 
+	void					StartStreamThread();
+	void					StopStreamThread();
+	void					StreamThreadProc();
+	static void				StreamThreadProcStub(void *theArg);
+
 public:
 	LPDIRECTSOUND			mDirectSound;
 	bool					mHaveFMod;
+	int						mStreamThreshold; // OGG sounds that decode to more bytes than this are streamed, 0 to preload everything
 
 	DSoundManager(HWND theHWnd, bool haveFMod);
 	virtual ~DSoundManager();
@@ -0,0 +1,184 @@
+#include "DSoundStreamInstance.h"
+#include "DSoundManager.h"
+#include "AutoCrit.h"
+
+using namespace Sexy;
+
+#define STREAM_SOUND_FLAGS (DSBCAPS_CTRLPAN | DSBCAPS_CTRLVOLUME | DSBCAPS_LOCSOFTWARE | DSBCAPS_GLOBALFOCUS | DSBCAPS_CTRLFREQUENCY | DSBCAPS_GETCURRENTPOSITION2)
+
+// The ring buffer holds one second of sound in quarter second chunks
+#define STREAM_NUM_CHUNKS			4
+#define STREAM_CHUNKS_PER_SECOND	4
+
+DSoundStreamInstance::DSoundStreamInstance(DSoundManager* theSoundManager, const std::string& theFilename) :
+	DSoundInstance(theSoundManager, NULL)
+{
+	mChunkSize = 0;
+	mBufferSize = 0;
+	mWritePos = 0;
+	mLastPlayPos = 0;
+	mQueuedBytes = 0;
+	mRemainingBytes = -1;
+	mLooping = false;
+	mStreaming = false;
+
+	if ((mSoundManagerP->mDirectSound == NULL) || (!mStream.Open(theFilename)))
+		return;
+
+	mChunkSize = (mStream.mSampleRate / STREAM_CHUNKS_PER_SECOND) * mStream.mBlockAlign;
+	mBufferSize = mChunkSize * STREAM_NUM_CHUNKS;
+
+	PCMWAVEFORMAT aWaveFormat;
+	DSBUFFERDESC aBufferDesc;
+
+	// Set up wave format structure.
+	memset(&aWaveFormat, 0, sizeof(PCMWAVEFORMAT));
+	aWaveFormat.wf.wFormatTag = WAVE_FORMAT_PCM;
+	aWaveFormat.wf.nChannels = mStream.mChannels;
+	aWaveFormat.wf.nSamplesPerSec = mStream.mSampleRate;
+	aWaveFormat.wBitsPerSample = 16;
+	aWaveFormat.wf.nBlockAlign = mStream.mBlockAlign;
+	aWaveFormat.wf.nAvgBytesPerSec = aWaveFormat.wf.nSamplesPerSec * aWaveFormat.wf.nBlockAlign;
+
+	memset(&aBufferDesc, 0, sizeof(DSBUFFERDESC));
+	aBufferDesc.dwSize = sizeof(DSBUFFERDESC);
+	aBufferDesc.dwFlags = STREAM_SOUND_FLAGS;
+	aBufferDesc.dwBufferBytes = mBufferSize;
+	aBufferDesc.lpwfxFormat = (LPWAVEFORMATEX)&aWaveFormat;
+
+	if (mSoundManagerP->mDirectSound->CreateSoundBuffer(&aBufferDesc, &mSoundBuffer, NULL) != DS_OK)
+	{
+		mSoundBuffer = NULL;
+		mStream.Close();
+		return;
+	}
+
+	mSoundBuffer->GetFrequency(&mDefaultFrequency);
+	RehupVolume();
+	RehupPan();
+
+	AutoCrit anAutoCrit(mSoundManagerP->mStreamCritSect);
+	mSoundManagerP->mStreamInstances.push_back(this);
+}
+
+DSoundStreamInstance::~DSoundStreamInstance()
+{
+	AutoCrit anAutoCrit(mSoundManagerP->mStreamCritSect);
+	mSoundManagerP->mStreamInstances.remove(this);
+	mStreaming = false;
+}
+
+bool DSoundStreamInstance::FillChunk()
+{
+	void* aPtr;
+	DWORD aBytes;
+	if (mSoundBuffer->Lock(mWritePos, mChunkSize, &aPtr, &aBytes, NULL, NULL, 0) != DS_OK)
+		return false;
+
+	int aRead = 0;
+	if (mRemainingBytes < 0)
+	{
+		aRead = mStream.Read(aPtr, aBytes, mLooping);
+		if (aRead < (int) aBytes)
+			mRemainingBytes = mQueuedBytes + aRead;
+	}
+
+	// Pad the end of the sound with silence until the play cursor gets there
+	if (aRead < (int) aBytes)
+		memset((char*) aPtr + aRead, 0, aBytes - aRead);
+
+	mSoundBuffer->Unlock(aPtr, aBytes, NULL, 0);
+
+	mWritePos = (mWritePos + mChunkSize) % mBufferSize;
+	mQueuedBytes += mChunkSize;
+	return true;
+}
+
+void DSoundStreamInstance::Update()
+{
+	if ((!mStreaming) || (mSoundBuffer == NULL))
+		return;
+
+	DWORD aPlayPos;
+	if (mSoundBuffer->GetCurrentPosition(&aPlayPos, NULL) != DS_OK)
+		return;
+
+	int aPlayed = (int) ((aPlayPos + mBufferSize - mLastPlayPos) % mBufferSize);
+	mLastPlayPos = aPlayPos;
+	mQueuedBytes -= aPlayed;
+
+	if (mRemainingBytes >= 0)
+	{
+		mRemainingBytes -= aPlayed;
+		if (mRemainingBytes <= 0)
+		{
+			mSoundBuffer->Stop();
+			mStreaming = false;
+			return;
+		}
+	}
+
+	if (mQueuedBytes < 0)
+	{
+		// Underrun, start filling again just ahead of the play cursor
+		mWritePos = ((aPlayPos / mChunkSize + 1) * mChunkSize) % mBufferSize;
+		mQueuedBytes = (mWritePos + mBufferSize - aPlayPos) % mBufferSize;
+	}
+
+	while (mBufferSize - mQueuedBytes >= mChunkSize)
+	{
+		if (!FillChunk())
+			break;
+	}
+}
+
+bool DSoundStreamInstance::Play(bool looping, bool autoRelease)
+{
+	Stop();
+
+	mHasPlayed = true;
+	mAutoRelease = autoRelease;
+
+	if (mSoundBuffer == NULL)
+		return false;
+
+	AutoCrit anAutoCrit(mSoundManagerP->mStreamCritSect);
+
+	if (!mStream.Rewind())
+		return false;
+
+	mLooping = looping;
+	mWritePos = 0;
+	mLastPlayPos = 0;
+	mQueuedBytes = 0;
+	mRemainingBytes = -1;
+
+	for (int i = 0; i < STREAM_NUM_CHUNKS; i++)
+	{
+		if (!FillChunk())
+			return false;
+	}
+
+	// The buffer always loops, the stream thread stops it at the end of the sound
+	if (mSoundBuffer->Play(0, 0, DSBPLAY_LOOPING) != DS_OK)
+		return false;
+
+	mStreaming = true;
+	mSoundManagerP->StartStreamThread();
+	return true;
+}
+
+void DSoundStreamInstance::Stop()
+{
+	AutoCrit anAutoCrit(mSoundManagerP->mStreamCritSect);
+
+	DSoundInstance::Stop();
+	mStreaming = false;
+}
+
+bool DSoundStreamInstance::IsPlaying()
+{
+	return (mHasPlayed) && (mStreaming);
+}
+
+#undef STREAM_SOUND_FLAGS
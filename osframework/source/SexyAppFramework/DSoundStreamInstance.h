@@ -0,0 +1,42 @@
+#ifndef __DSOUNDSTREAMINSTANCE_H__
+#define __DSOUNDSTREAMINSTANCE_H__
+
+#include "DSoundInstance.h"
+#include "OggStream.h"
+
+namespace Sexy
+{
+
+// Plays a long OGG sound through a small looping DirectSound buffer that the
+//  DSoundManager stream thread keeps filled one chunk at a time
+class DSoundStreamInstance : public DSoundInstance
+{
+	friend class DSoundManager;
+
+protected:
+	OggStream				mStream;
+	int						mChunkSize;
+	int						mBufferSize;
+	int						mWritePos;		// next chunk to fill
+	DWORD					mLastPlayPos;
+	int						mQueuedBytes;	// written ahead of the play cursor, including trailing silence
+	int						mRemainingBytes; // sound left to play once decoding is done, -1 while decoding
+	bool					mLooping;
+	bool					mStreaming;
+
+protected:
+	bool					FillChunk();
+	void					Update(); // called from the stream thread
+
+public:
+	DSoundStreamInstance(DSoundManager* theSoundManager, const std::string& theFilename);
+	virtual ~DSoundStreamInstance();
+
+	virtual bool			Play(bool looping, bool autoRelease);
+	virtual void			Stop();
+	virtual bool			IsPlaying();
+};
+
+}
+
+#endif //__DSOUNDSTREAMINSTANCE_H__
@@ -0,0 +1,244 @@
+#include "DemoReplayer.h"
+#include "SexyAppBase.h"
+#include "WidgetManager.h"
+#include "MemoryImage.h"
+#include "MTRand.h"
+#include "Buffer.h"
+#include <math.h>
+
+using namespace Sexy;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+DemoReplayer::DemoReplayer(SexyAppBase* theApp)
+{
+	mApp = theApp;
+	mScreen = NULL;
+
+	mDrawInterval = 0;
+	mChecksumMarkers = false;
+
+	mNumUpdates = 0;
+	mUpdateTime = 0;
+	mMinUpdateTime = 0;
+	mMaxUpdateTime = 0;
+	mMaxUpdateNum = 0;
+	memset(mBuckets, 0, sizeof(mBuckets));
+	mNumDraws = 0;
+	mDrawTime = 0;
+	mLoadWaitTime = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+DemoReplayer::~DemoReplayer()
+{
+	if ((mScreen != NULL) && (mApp->mWidgetManager != NULL) && (mApp->mWidgetManager->mImage == mScreen))
+		mApp->mWidgetManager->mImage = NULL;
+
+	delete mScreen;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DemoReplayer::Start()
+{
+	mTotalTimer.Start();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DemoReplayer::BeginUpdate()
+{
+	mUpdateTimer.Start();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DemoReplayer::EndUpdate()
+{
+	mUpdateTimer.Stop();
+	double aTime = mUpdateTimer.GetDuration();
+
+	if ((mNumUpdates == 0) || (aTime < mMinUpdateTime))
+		mMinUpdateTime = aTime;
+	if ((mNumUpdates == 0) || (aTime > mMaxUpdateTime))
+	{
+		mMaxUpdateTime = aTime;
+		mMaxUpdateNum = mApp->mUpdateCount;
+	}
+
+	mNumUpdates++;
+	mUpdateTime += aTime;
+
+	int aMicroseconds = (int) (aTime * 1000);
+	int aBucket = 0;
+	while ((aMicroseconds >= 2) && (aBucket < NUM_BUCKETS - 1))
+	{
+		aMicroseconds >>= 1;
+		aBucket++;
+	}
+	mBuckets[aBucket]++;
+
+	if ((mDrawInterval > 0) && (mApp->mUpdateCount % mDrawInterval == 0))
+		Draw();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DemoReplayer::AddLoadWait(double theTime)
+{
+	mLoadWaitTime += theTime;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool DemoReplayer::Draw(bool fullScreen)
+{
+	MTAutoDisallowRand aDisallowRand;
+
+	WidgetManager* aWidgetManager = mApp->mWidgetManager;
+	if (mScreen == NULL)
+	{
+		mScreen = new MemoryImage(mApp);
+		mScreen->Create(mApp->mWidth, mApp->mHeight);
+		mScreen->mPurgeBits = false;
+		aWidgetManager->mImage = mScreen;
+		fullScreen = true;
+	}
+
+	if (fullScreen)
+		aWidgetManager->MarkAllDirty();
+
+	PerfTimer aTimer;
+	aTimer.Start();
+
+	mApp->mIsDrawing = true;
+	bool drewScreen = aWidgetManager->DrawScreen();
+	mApp->mIsDrawing = false;
+
+	aTimer.Stop();
+	mDrawTime += aTimer.GetDuration();
+	mNumDraws++;
+
+	if (drewScreen)
+		mScreen->BitsChanged();
+
+	return drewScreen;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+ulong DemoReplayer::GetScreenChecksum()
+{
+	if (mScreen == NULL)
+		return 0;
+
+	return Buffer::GetCRC32(mScreen->GetRawBits(), mScreen->mWidth * mScreen->mHeight * 4);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DemoReplayer::AddMarker(const std::string& theName)
+{
+	MarkerInfo aMarker;
+	aMarker.mName = theName;
+	aMarker.mUpdateCount = mApp->mUpdateCount;
+	aMarker.mChecksum = 0;
+
+	if (mChecksumMarkers)
+	{
+		Draw(true);
+		aMarker.mChecksum = GetScreenChecksum();
+	}
+
+	mMarkers.push_back(aMarker);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+double DemoReplayer::GetPercentile(double thePercent)
+{
+	// Only as exact as the histogram, returns the upper bound of the bucket
+	int aWanted = (int) ceil(mNumUpdates * thePercent / 100.0);
+	int aCount = 0;
+	for (int i = 0; i < NUM_BUCKETS; i++)
+	{
+		aCount += mBuckets[i];
+		if (aCount >= aWanted)
+			return (2 << i) / 1000.0;
+	}
+
+	return mMaxUpdateTime;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+std::string DemoReplayer::GetReport()
+{
+	double aTotalTime = mTotalTimer.GetDuration();
+	double aRunTime = max(aTotalTime - mLoadWaitTime, 0.001);
+
+	std::string aReport;
+	aReport += StrFormat("Demo          = %s\r\n", mApp->mDemoFileName.c_str());
+	aReport += StrFormat("Updates       = %d of %d\r\n", mNumUpdates, mApp->mDemoLength);
+	aReport += StrFormat("Total Time    = %.1f ms (%.1f ms waiting for loading thread)\r\n", aTotalTime, mLoadWaitTime);
+	aReport += StrFormat("Updates/Sec   = %.1f\r\n", mNumUpdates * 1000.0 / aRunTime);
+	if (mUpdateTime > 0)
+		aReport += StrFormat("Logic Only    = %.1f updates/sec\r\n", mNumUpdates * 1000.0 / mUpdateTime);
+
+	if (mNumUpdates > 0)
+	{
+		aReport += StrFormat("Update Time   = %.3f ms avg, %.3f ms min, %.3f ms max (update %d)\r\n",
+			mUpdateTime / mNumUpdates, mMinUpdateTime, mMaxUpdateTime, mMaxUpdateNum);
+		aReport += StrFormat("Percentiles   = 50%%: <%.3f ms, 90%%: <%.3f ms, 99%%: <%.3f ms\r\n",
+			GetPercentile(50), GetPercentile(90), GetPercentile(99));
+	}
+
+	if (mNumDraws > 0)
+		aReport += StrFormat("Draws         = %d, %.3f ms avg\r\n", mNumDraws, mDrawTime / mNumDraws);
+
+	aReport += "\r\nUpdate Time Histogram\r\n";
+	int aLastBucket = NUM_BUCKETS - 1;
+	while ((aLastBucket > 0) && (mBuckets[aLastBucket] == 0))
+		aLastBucket--;
+	for (int i = 0; i <= aLastBucket; i++)
+	{
+		aReport += StrFormat("  <%10.3f ms: %8d (%5.1f%%)\r\n", (2 << i) / 1000.0, mBuckets[i],
+			(mNumUpdates > 0) ? mBuckets[i] * 100.0 / mNumUpdates : 0.0);
+	}
+
+	if (!mMarkers.empty())
+	{
+		aReport += "\r\nMarkers\r\n";
+		for (int i = 0; i < (int) mMarkers.size(); i++)
+		{
+			const MarkerInfo& aMarker = mMarkers[i];
+			if (mChecksumMarkers)
+				aReport += StrFormat("  %8d  %08X  %s\r\n", aMarker.mUpdateCount, aMarker.mChecksum, aMarker.mName.c_str());
+			else
+				aReport += StrFormat("  %8d  %s\r\n", aMarker.mUpdateCount, aMarker.mName.c_str());
+		}
+	}
+
+	return aReport;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool DemoReplayer::WriteReport()
+{
+	std::string aReport = GetReport();
+	OutputDebugStringA(aReport.c_str());
+
+	if (mReportFileName.empty())
+		return true;
+
+	FILE* aFP = fopen(mReportFileName.c_str(), "wb");
+	if (aFP == NULL)
+		return false;
+
+	fwrite(aReport.c_str(), 1, aReport.length(), aFP);
+	fclose(aFP);
+	return true;
+}
@@ -0,0 +1,79 @@
+#ifndef __DEMOREPLAYER_H__
+#define __DEMOREPLAYER_H__
+
+#include "Common.h"
+#include "PerfTimer.h"
+
+namespace Sexy
+{
+
+class SexyAppBase;
+class MemoryImage;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Runs a recorded demo with no window and no DirectDraw, as fast as the game
+//  logic allows.  Enabled with -replay on the command line (see
+//  SexyAppBase::HandleCmdLineParam).  Times every update and, if wanted,
+//  renders into a MemoryImage so the screen can be checksummed at each
+//  DemoAddMarker.  The results are written out as a text report when the
+//  demo ends.
+class DemoReplayer
+{
+public:
+	enum
+	{
+		NUM_BUCKETS = 24	// bucket i counts updates taking [2^i, 2^(i+1)) microseconds
+	};
+
+	struct MarkerInfo
+	{
+		std::string			mName;
+		int					mUpdateCount;
+		ulong				mChecksum;
+	};
+	typedef std::vector<MarkerInfo> MarkerVector;
+
+	SexyAppBase*			mApp;
+	MemoryImage*			mScreen;
+
+	int						mDrawInterval;			// draw every N updates, 0 to only draw for checksums
+	bool					mChecksumMarkers;
+	std::string				mReportFileName;
+
+	PerfTimer				mTotalTimer;
+	PerfTimer				mUpdateTimer;
+	int						mNumUpdates;
+	double					mUpdateTime;			// ms
+	double					mMinUpdateTime;
+	double					mMaxUpdateTime;
+	int						mMaxUpdateNum;
+	int						mBuckets[NUM_BUCKETS];
+	int						mNumDraws;
+	double					mDrawTime;
+	double					mLoadWaitTime;
+	MarkerVector			mMarkers;
+
+protected:
+	double					GetPercentile(double thePercent);
+
+public:
+	DemoReplayer(SexyAppBase* theApp);
+	virtual ~DemoReplayer();
+
+	void					Start();
+	void					BeginUpdate();
+	void					EndUpdate();
+	void					AddLoadWait(double theTime);
+
+	bool					Draw(bool fullScreen = false);
+	ulong					GetScreenChecksum();
+	void					AddMarker(const std::string& theName);
+
+	std::string				GetReport();
+	bool					WriteReport();
+};
+
+}
+
+#endif //__DEMOREPLAYER_H__
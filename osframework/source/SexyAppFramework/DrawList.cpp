@@ -0,0 +1,337 @@
+#include "DrawList.h"
+
+using namespace Sexy;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+DrawList::DrawList()
+{
+	mListIdx = 0;
+	mFrameId = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+DrawList::~DrawList()
+{
+	Reset(0, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::Reset(int theWidth, int theHeight)
+{
+	mWidth = theWidth;
+	mHeight = theHeight;
+
+	// clear() keeps the capacity, so after the first few frames recording doesn't allocate
+	mCommands.clear();
+	mSpans.clear();
+	mVertices.clear();
+	mMatrices.clear();
+	mCoverage.clear();
+
+	for (int i = 0; i < (int) mAdoptedImages.size(); i++)
+		delete mAdoptedImages[i];
+	mAdoptedImages.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::AdoptImage(Image* theImage)
+{
+	mAdoptedImages.push_back(theImage);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+DrawListCommand& DrawList::AddCommand(int theType, Image* theImage, const Color& theColor, int theDrawMode)
+{
+	mCommands.push_back(DrawListCommand());
+	DrawListCommand& aCommand = mCommands.back();
+	aCommand.mType = theType;
+	aCommand.mImage = theImage;
+	aCommand.mColor = theColor;
+	aCommand.mDrawMode = theDrawMode;
+	aCommand.mDataIdx = 0;
+	aCommand.mDataCount = 0;
+	aCommand.mFlag = false;
+
+	if (theImage != NULL)
+		PrepareImage(theImage, theType);
+
+	return aCommand;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::PrepareImage(Image* theImage, int theType)
+{
+	theImage->mDrawListFrame[mListIdx] = mFrameId;
+
+	MemoryImage* aMemoryImage = dynamic_cast<MemoryImage*>(theImage);
+	if (aMemoryImage == NULL)
+		return;
+
+	// The flags, palette expansion and restoring trimmed, atlased or surface bits all
+	//  change the image in place, so do them here as an immediate draw would have
+	aMemoryImage->CommitBits();
+
+	bool needBits;
+	switch (theType)
+	{
+	case CMD_BLT_MATRIX:
+	case CMD_BLT_TRIANGLES_TEX:
+		needBits = true;
+		break;
+	case CMD_BLT_F:
+	case CMD_BLT_ROTATED:
+		needBits = aMemoryImage->mColorTable == NULL;
+		break;
+	default:
+		needBits = (aMemoryImage->mIsVolatile) && (aMemoryImage->mColorTable == NULL);
+		break;
+	}
+
+	// GetRawBits waits on the render thread if it still draws this image from the last
+	//  frame, so only call it when there's something to resolve
+	if ((needBits) && (aMemoryImage->mBits == NULL))
+		aMemoryImage->GetRawBits();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::Execute(Image* theDestImage)
+{
+	for (int i = 0; i < (int) mCommands.size(); i++)
+	{
+		const DrawListCommand& aCommand = mCommands[i];
+		const double* anArgs = aCommand.mArgs;
+
+		switch (aCommand.mType)
+		{
+		case CMD_FILL_RECT:
+			theDestImage->FillRect(aCommand.mRect, aCommand.mColor, aCommand.mDrawMode);
+			break;
+		case CMD_DRAW_RECT:
+			theDestImage->DrawRect(aCommand.mRect, aCommand.mColor, aCommand.mDrawMode);
+			break;
+		case CMD_CLEAR_RECT:
+			theDestImage->ClearRect(aCommand.mRect);
+			break;
+		case CMD_DRAW_LINE:
+			theDestImage->DrawLine(anArgs[0], anArgs[1], anArgs[2], anArgs[3], aCommand.mColor, aCommand.mDrawMode);
+			break;
+		case CMD_DRAW_LINE_AA:
+			theDestImage->DrawLineAA(anArgs[0], anArgs[1], anArgs[2], anArgs[3], aCommand.mColor, aCommand.mDrawMode);
+			break;
+		case CMD_FILL_SCAN_LINES:
+			theDestImage->FillScanLines(&mSpans[aCommand.mDataIdx], aCommand.mDataCount, aCommand.mColor, aCommand.mDrawMode);
+			break;
+		case CMD_FILL_SCAN_LINES_COVERAGE:
+			theDestImage->FillScanLinesWithCoverage(&mSpans[aCommand.mDataIdx], aCommand.mDataCount, aCommand.mColor, aCommand.mDrawMode,
+				&mCoverage[(int) anArgs[0]], aCommand.mRect.mX, aCommand.mRect.mY, aCommand.mRect.mWidth, aCommand.mRect.mHeight);
+			break;
+		case CMD_BLT:
+			theDestImage->Blt(aCommand.mImage, (int) anArgs[0], (int) anArgs[1], aCommand.mSrcRect, aCommand.mColor, aCommand.mDrawMode);
+			break;
+		case CMD_BLT_F:
+			theDestImage->BltF(aCommand.mImage, (float) anArgs[0], (float) anArgs[1], aCommand.mSrcRect, aCommand.mClipRect, aCommand.mColor, aCommand.mDrawMode);
+			break;
+		case CMD_BLT_ROTATED:
+			theDestImage->BltRotated(aCommand.mImage, (float) anArgs[0], (float) anArgs[1], aCommand.mSrcRect, aCommand.mClipRect, aCommand.mColor, aCommand.mDrawMode,
+				anArgs[2], (float) anArgs[3], (float) anArgs[4]);
+			break;
+		case CMD_STRETCH_BLT:
+			theDestImage->StretchBlt(aCommand.mImage, aCommand.mRect, aCommand.mSrcRect, aCommand.mClipRect, aCommand.mColor, aCommand.mDrawMode, aCommand.mFlag);
+			break;
+		case CMD_BLT_MATRIX:
+			theDestImage->BltMatrix(aCommand.mImage, (float) anArgs[0], (float) anArgs[1], mMatrices[aCommand.mDataIdx], aCommand.mClipRect, aCommand.mColor, aCommand.mDrawMode,
+				aCommand.mSrcRect, aCommand.mFlag);
+			break;
+		case CMD_BLT_TRIANGLES_TEX:
+			theDestImage->BltTrianglesTex(aCommand.mImage, (const TriVertex (*)[3]) &mVertices[aCommand.mDataIdx], aCommand.mDataCount, aCommand.mClipRect, aCommand.mColor,
+				aCommand.mDrawMode, (float) anArgs[0], (float) anArgs[1], aCommand.mFlag);
+			break;
+		case CMD_BLT_MIRROR:
+			theDestImage->BltMirror(aCommand.mImage, (int) anArgs[0], (int) anArgs[1], aCommand.mSrcRect, aCommand.mColor, aCommand.mDrawMode);
+			break;
+		case CMD_STRETCH_BLT_MIRROR:
+			theDestImage->StretchBltMirror(aCommand.mImage, aCommand.mRect, aCommand.mSrcRect, aCommand.mClipRect, aCommand.mColor, aCommand.mDrawMode, aCommand.mFlag);
+			break;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool DrawList::PolyFill3D(const Point theVertices[], int theNumVertices, const Rect *theClipRect, const Color &theColor, int theDrawMode, int tx, int ty, bool convex)
+{
+	// Graphics scan converts it for us and sends FillScanLines instead
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::FillRect(const Rect& theRect, const Color& theColor, int theDrawMode)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_FILL_RECT, NULL, theColor, theDrawMode);
+	aCommand.mRect = theRect;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::DrawRect(const Rect& theRect, const Color& theColor, int theDrawMode)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_DRAW_RECT, NULL, theColor, theDrawMode);
+	aCommand.mRect = theRect;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::ClearRect(const Rect& theRect)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_CLEAR_RECT, NULL, Color::Black, 0);
+	aCommand.mRect = theRect;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::DrawLine(double theStartX, double theStartY, double theEndX, double theEndY, const Color& theColor, int theDrawMode)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_DRAW_LINE, NULL, theColor, theDrawMode);
+	aCommand.mArgs[0] = theStartX;
+	aCommand.mArgs[1] = theStartY;
+	aCommand.mArgs[2] = theEndX;
+	aCommand.mArgs[3] = theEndY;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::DrawLineAA(double theStartX, double theStartY, double theEndX, double theEndY, const Color& theColor, int theDrawMode)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_DRAW_LINE_AA, NULL, theColor, theDrawMode);
+	aCommand.mArgs[0] = theStartX;
+	aCommand.mArgs[1] = theStartY;
+	aCommand.mArgs[2] = theEndX;
+	aCommand.mArgs[3] = theEndY;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::FillScanLines(Span* theSpans, int theSpanCount, const Color& theColor, int theDrawMode)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_FILL_SCAN_LINES, NULL, theColor, theDrawMode);
+	aCommand.mDataIdx = mSpans.size();
+	aCommand.mDataCount = theSpanCount;
+	mSpans.insert(mSpans.end(), theSpans, theSpans + theSpanCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::FillScanLinesWithCoverage(Span* theSpans, int theSpanCount, const Color& theColor, int theDrawMode, const BYTE* theCoverage, int theCoverX, int theCoverY, int theCoverWidth, int theCoverHeight)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_FILL_SCAN_LINES_COVERAGE, NULL, theColor, theDrawMode);
+	aCommand.mDataIdx = mSpans.size();
+	aCommand.mDataCount = theSpanCount;
+	mSpans.insert(mSpans.end(), theSpans, theSpans + theSpanCount);
+
+	aCommand.mRect = Rect(theCoverX, theCoverY, theCoverWidth, theCoverHeight);
+	aCommand.mArgs[0] = mCoverage.size();
+	mCoverage.insert(mCoverage.end(), theCoverage, theCoverage + theCoverWidth*theCoverHeight);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::Blt(Image* theImage, int theX, int theY, const Rect& theSrcRect, const Color& theColor, int theDrawMode)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_BLT, theImage, theColor, theDrawMode);
+	aCommand.mArgs[0] = theX;
+	aCommand.mArgs[1] = theY;
+	aCommand.mSrcRect = theSrcRect;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::BltF(Image* theImage, float theX, float theY, const Rect& theSrcRect, const Rect &theClipRect, const Color& theColor, int theDrawMode)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_BLT_F, theImage, theColor, theDrawMode);
+	aCommand.mArgs[0] = theX;
+	aCommand.mArgs[1] = theY;
+	aCommand.mSrcRect = theSrcRect;
+	aCommand.mClipRect = theClipRect;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::BltRotated(Image* theImage, float theX, float theY, const Rect &theSrcRect, const Rect& theClipRect, const Color& theColor, int theDrawMode, double theRot, float theRotCenterX, float theRotCenterY)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_BLT_ROTATED, theImage, theColor, theDrawMode);
+	aCommand.mArgs[0] = theX;
+	aCommand.mArgs[1] = theY;
+	aCommand.mArgs[2] = theRot;
+	aCommand.mArgs[3] = theRotCenterX;
+	aCommand.mArgs[4] = theRotCenterY;
+	aCommand.mSrcRect = theSrcRect;
+	aCommand.mClipRect = theClipRect;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::StretchBlt(Image* theImage, const Rect& theDestRect, const Rect& theSrcRect, const Rect& theClipRect, const Color& theColor, int theDrawMode, bool fastStretch)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_STRETCH_BLT, theImage, theColor, theDrawMode);
+	aCommand.mRect = theDestRect;
+	aCommand.mSrcRect = theSrcRect;
+	aCommand.mClipRect = theClipRect;
+	aCommand.mFlag = fastStretch;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::BltMatrix(Image* theImage, float x, float y, const SexyMatrix3 &theMatrix, const Rect& theClipRect, const Color& theColor, int theDrawMode, const Rect &theSrcRect, bool blend)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_BLT_MATRIX, theImage, theColor, theDrawMode);
+	aCommand.mArgs[0] = x;
+	aCommand.mArgs[1] = y;
+	aCommand.mSrcRect = theSrcRect;
+	aCommand.mClipRect = theClipRect;
+	aCommand.mFlag = blend;
+	aCommand.mDataIdx = mMatrices.size();
+	mMatrices.push_back(theMatrix);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::BltTrianglesTex(Image *theTexture, const TriVertex theVertices[][3], int theNumTriangles, const Rect& theClipRect, const Color &theColor, int theDrawMode, float tx, float ty, bool blend)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_BLT_TRIANGLES_TEX, theTexture, theColor, theDrawMode);
+	aCommand.mArgs[0] = tx;
+	aCommand.mArgs[1] = ty;
+	aCommand.mClipRect = theClipRect;
+	aCommand.mFlag = blend;
+	aCommand.mDataIdx = mVertices.size();
+	aCommand.mDataCount = theNumTriangles;
+	mVertices.insert(mVertices.end(), &theVertices[0][0], &theVertices[0][0] + theNumTriangles*3);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::BltMirror(Image* theImage, int theX, int theY, const Rect& theSrcRect, const Color& theColor, int theDrawMode)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_BLT_MIRROR, theImage, theColor, theDrawMode);
+	aCommand.mArgs[0] = theX;
+	aCommand.mArgs[1] = theY;
+	aCommand.mSrcRect = theSrcRect;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void DrawList::StretchBltMirror(Image* theImage, const Rect& theDestRect, const Rect& theSrcRect, const Rect& theClipRect, const Color& theColor, int theDrawMode, bool fastStretch)
+{
+	DrawListCommand& aCommand = AddCommand(CMD_STRETCH_BLT_MIRROR, theImage, theColor, theDrawMode);
+	aCommand.mRect = theDestRect;
+	aCommand.mSrcRect = theSrcRect;
+	aCommand.mClipRect = theClipRect;
+	aCommand.mFlag = fastStretch;
+}
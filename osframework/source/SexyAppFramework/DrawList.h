@@ -0,0 +1,102 @@
+#ifndef __DRAWLIST_H__
+#define __DRAWLIST_H__
+
+#include "MemoryImage.h"
+#include "SexyMatrix.h"
+#include "TriVertex.h"
+
+namespace Sexy
+{
+
+struct DrawListCommand
+{
+	int						mType;
+	Image*					mImage;
+	Color					mColor;
+	int						mDrawMode;
+	Rect					mRect;			// dest rect, or the coverage rect for FillScanLinesWithCoverage
+	Rect					mSrcRect;
+	Rect					mClipRect;
+	double					mArgs[5];		// positions, line ends, rotation and its center
+	int						mDataIdx;		// first entry in the span/vertex/matrix/coverage vector
+	int						mDataCount;
+	bool					mFlag;			// fastStretch or blend
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Records everything drawn onto it instead of drawing it, so the list can be
+//  played back onto the real destination later, possibly from another thread
+//  (see RenderPipeline).  Source images are only referenced, so they have to
+//  stay alive and unchanged until the list is executed; temporary sources can
+//  be handed over with AdoptImage.  Each source is stamped with the list's
+//  frame and has the lazy state the draw is going to need resolved while it's
+//  recorded, so executing the list only builds caches the main thread fences on.
+class DrawList : public MemoryImage
+{
+public:
+	enum
+	{
+		CMD_FILL_RECT,
+		CMD_DRAW_RECT,
+		CMD_CLEAR_RECT,
+		CMD_DRAW_LINE,
+		CMD_DRAW_LINE_AA,
+		CMD_FILL_SCAN_LINES,
+		CMD_FILL_SCAN_LINES_COVERAGE,
+		CMD_BLT,
+		CMD_BLT_F,
+		CMD_BLT_ROTATED,
+		CMD_STRETCH_BLT,
+		CMD_BLT_MATRIX,
+		CMD_BLT_TRIANGLES_TEX,
+		CMD_BLT_MIRROR,
+		CMD_STRETCH_BLT_MIRROR
+	};
+
+	typedef std::vector<DrawListCommand> CommandVector;
+
+	CommandVector			mCommands;
+	std::vector<Span>		mSpans;
+	std::vector<TriVertex>	mVertices;
+	std::vector<SexyMatrix3> mMatrices;
+	std::vector<uchar>		mCoverage;
+	std::vector<Image*>		mAdoptedImages;
+	int						mListIdx;		// which of RenderPipeline's lists this is
+	ulong					mFrameId;		// stamped into Image::mDrawListFrame[mListIdx]
+
+protected:
+	DrawListCommand&		AddCommand(int theType, Image* theImage, const Color& theColor, int theDrawMode);
+	void					PrepareImage(Image* theImage, int theType);
+
+public:
+	DrawList();
+	virtual ~DrawList();
+
+	void					Reset(int theWidth, int theHeight);
+	void					AdoptImage(Image* theImage);	// deleted on the next Reset
+	bool					IsEmpty() { return mCommands.empty(); }
+	void					Execute(Image* theDestImage);
+
+	virtual bool			PolyFill3D(const Point theVertices[], int theNumVertices, const Rect *theClipRect, const Color &theColor, int theDrawMode, int tx, int ty, bool convex);
+
+	virtual void			FillRect(const Rect& theRect, const Color& theColor, int theDrawMode);
+	virtual void			DrawRect(const Rect& theRect, const Color& theColor, int theDrawMode);
+	virtual void			ClearRect(const Rect& theRect);
+	virtual void			DrawLine(double theStartX, double theStartY, double theEndX, double theEndY, const Color& theColor, int theDrawMode);
+	virtual void			DrawLineAA(double theStartX, double theStartY, double theEndX, double theEndY, const Color& theColor, int theDrawMode);
+	virtual void			FillScanLines(Span* theSpans, int theSpanCount, const Color& theColor, int theDrawMode);
+	virtual void			FillScanLinesWithCoverage(Span* theSpans, int theSpanCount, const Color& theColor, int theDrawMode, const BYTE* theCoverage, int theCoverX, int theCoverY, int theCoverWidth, int theCoverHeight);
+	virtual void			Blt(Image* theImage, int theX, int theY, const Rect& theSrcRect, const Color& theColor, int theDrawMode);
+	virtual void			BltF(Image* theImage, float theX, float theY, const Rect& theSrcRect, const Rect &theClipRect, const Color& theColor, int theDrawMode);
+	virtual void			BltRotated(Image* theImage, float theX, float theY, const Rect &theSrcRect, const Rect& theClipRect, const Color& theColor, int theDrawMode, double theRot, float theRotCenterX, float theRotCenterY);
+	virtual void			StretchBlt(Image* theImage, const Rect& theDestRect, const Rect& theSrcRect, const Rect& theClipRect, const Color& theColor, int theDrawMode, bool fastStretch);
+	virtual void			BltMatrix(Image* theImage, float x, float y, const SexyMatrix3 &theMatrix, const Rect& theClipRect, const Color& theColor, int theDrawMode, const Rect &theSrcRect, bool blend);
+	virtual void			BltTrianglesTex(Image *theTexture, const TriVertex theVertices[][3], int theNumTriangles, const Rect& theClipRect, const Color &theColor, int theDrawMode, float tx, float ty, bool blend);
+	virtual void			BltMirror(Image* theImage, int theX, int theY, const Rect& theSrcRect, const Color& theColor, int theDrawMode);
+	virtual void			StretchBltMirror(Image* theImage, const Rect& theDestRect, const Rect& theSrcRect, const Rect& theClipRect, const Color& theColor, int theDrawMode, bool fastStretch);
+};
+
+}
+
+#endif //__DRAWLIST_H__
@@ -0,0 +1,110 @@
+#include "FrameStats.h"
+#include "PerfTimer.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace Sexy;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+FrameStats::FrameStats()
+{
+	Clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void FrameStats::Clear()
+{
+	memset(mFrames, 0, sizeof(mFrames));
+	memset(&mCurFrame, 0, sizeof(mCurFrame));
+	mFrameIdx = 0;
+	mNumFrames = 0;
+	mLastFrameTime = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void FrameStats::EndFrame()
+{
+	__int64 aTime = PerfTimer::GetTimeNS();
+	if (mLastFrameTime != 0)
+		mCurFrame.mFrameTime = (aTime - mLastFrameTime) / 1000000.0;
+	mLastFrameTime = aTime;
+
+	mFrames[mFrameIdx] = mCurFrame;
+	mFrameIdx = (mFrameIdx + 1) % NUM_FRAMES;
+	if (mNumFrames < NUM_FRAMES)
+		mNumFrames++;
+
+	memset(&mCurFrame, 0, sizeof(mCurFrame));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+const FrameStat& FrameStats::GetFrame(int theAge)
+{
+	return mFrames[(mFrameIdx - 1 - theAge + NUM_FRAMES) % NUM_FRAMES];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+double FrameStats::GetStat(const FrameStat& theFrame, int theStat)
+{
+	switch (theStat)
+	{
+	case STAT_FRAME:	return theFrame.mFrameTime;
+	case STAT_UPDATE:	return theFrame.mUpdateTime;
+	case STAT_DRAW:		return theFrame.mDrawTime;
+	case STAT_SLEEP:	return theFrame.mSleepTime;
+	}
+
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+double FrameStats::GetAverage(int theStat)
+{
+	if (mNumFrames == 0)
+		return 0;
+
+	double aTotal = 0;
+	for (int i = 0; i < mNumFrames; i++)
+		aTotal += GetStat(mFrames[i], theStat);
+
+	return aTotal / mNumFrames;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+double FrameStats::GetPercentile(int theStat, double thePercent)
+{
+	if (mNumFrames == 0)
+		return 0;
+
+	double aValues[NUM_FRAMES];
+	for (int i = 0; i < mNumFrames; i++)
+		aValues[i] = GetStat(mFrames[i], theStat);
+	std::sort(aValues, aValues + mNumFrames);
+
+	int anIdx = (int) ceil(mNumFrames * thePercent / 100.0) - 1;
+	anIdx = max(0, min(anIdx, mNumFrames - 1));
+	return aValues[anIdx];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+std::string FrameStats::GetReport()
+{
+	static const char* aNames[] = { "Frame", "Update", "Draw", "Sleep" };
+
+	std::string aReport = StrFormat("Last %d frames (ms)        avg      50%%      90%%      99%%       max\r\n", mNumFrames);
+	for (int aStat = STAT_FRAME; aStat <= STAT_SLEEP; aStat++)
+	{
+		aReport += StrFormat("  %-20s %8.3f %8.3f %8.3f %8.3f %9.3f\r\n", aNames[aStat], GetAverage(aStat),
+			GetPercentile(aStat, 50), GetPercentile(aStat, 90), GetPercentile(aStat, 99), GetPercentile(aStat, 100));
+	}
+
+	return aReport;
+}
@@ -0,0 +1,66 @@
+#ifndef __FRAMESTATS_H__
+#define __FRAMESTATS_H__
+
+#include "Common.h"
+
+namespace Sexy
+{
+
+struct FrameStat
+{
+	double					mFrameTime;		// ms since the previous frame was presented
+	double					mUpdateTime;
+	double					mDrawTime;
+	double					mSleepTime;
+	int						mNumUpdates;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Ring buffer of per frame timings kept by SexyAppBase::Process.  Update, draw
+//  and sleep times are added as they happen and EndFrame closes off the frame
+//  when the screen is presented.  Everything is in milliseconds.
+class FrameStats
+{
+public:
+	enum
+	{
+		NUM_FRAMES = 512
+	};
+
+	enum
+	{
+		STAT_FRAME,
+		STAT_UPDATE,
+		STAT_DRAW,
+		STAT_SLEEP
+	};
+
+	FrameStat				mFrames[NUM_FRAMES];
+	int						mFrameIdx;		// where the next frame goes
+	int						mNumFrames;
+	FrameStat				mCurFrame;
+	__int64					mLastFrameTime;	// ns, from PerfTimer::GetTimeNS
+
+protected:
+	double					GetStat(const FrameStat& theFrame, int theStat);
+
+public:
+	FrameStats();
+
+	void					Clear();
+	void					AddUpdate(double theTime) { mCurFrame.mUpdateTime += theTime; mCurFrame.mNumUpdates++; }
+	void					AddDraw(double theTime) { mCurFrame.mDrawTime += theTime; }
+	void					AddSleep(double theTime) { mCurFrame.mSleepTime += theTime; }
+	void					EndFrame();
+
+	int						GetNumFrames() { return mNumFrames; }
+	const FrameStat&		GetFrame(int theAge);	// 0 is the most recent frame
+	double					GetAverage(int theStat);
+	double					GetPercentile(int theStat, double thePercent);
+	std::string				GetReport();
+};
+
+}
+
+#endif //__FRAMESTATS_H__
@@ -15,6 +15,77 @@ const Point* Graphics::mPFPoints;
 
 //////////////////////////////////////////////////////////////////////////
 
+// Images packed into a TextureAtlas are drawn straight from their page
+static inline Image* AtlasRemap(Image* theImage, Rect& theSrcRect)
+{
+	if (theImage->mAtlasImage == NULL)
+		return theImage;
+
+	theSrcRect.mX += theImage->mAtlasX;
+	theSrcRect.mY += theImage->mAtlasY;
+	return theImage->mAtlasImage;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+// Unscaled blits of trimmed images draw each cel's visible piece from mTrimImage.  Returns
+//  false when the image has to be drawn whole, which rebuilds its full size bits.
+bool Graphics::TrimmedBlt(Image* theImage, int theX, int theY, const Rect& theSrcRect, bool mirror)
+{
+	MemoryImage* aTrimImage = theImage->mTrimImage;
+	if (aTrimImage == NULL)
+		return false;
+
+	// The cel grid has to be the one the pieces were cut with
+	if ((int) theImage->mTrimCels.size() != theImage->mNumCols*theImage->mNumRows)
+		return false;
+
+	// Additive blits of images without partial alpha add in the cropped pixels' color too
+	if ((mDrawMode != DRAWMODE_NORMAL) && (!aTrimImage->mHasAlpha) && ((theImage->mTrimFill & 0xFFFFFF) != 0))
+		return false;
+
+	theImage->mDrawn = true;
+
+	int aCelWidth = theImage->GetCelWidth();
+	int aCelHeight = theImage->GetCelHeight();
+	int aColLeft = max(theSrcRect.mX / aCelWidth, 0);
+	int aRowTop = max(theSrcRect.mY / aCelHeight, 0);
+	int aColRight = min((theSrcRect.mX + theSrcRect.mWidth - 1) / aCelWidth, theImage->mNumCols - 1);
+	int aRowBottom = min((theSrcRect.mY + theSrcRect.mHeight - 1) / aCelHeight, theImage->mNumRows - 1);
+
+	Color aColor = mColorizeImages ? mColor : Color::White;
+
+	for (int aRow = aRowTop; aRow <= aRowBottom; aRow++)
+	{
+		for (int aCol = aColLeft; aCol <= aColRight; aCol++)
+		{
+			const TrimCel& aCel = theImage->mTrimCels[aRow*theImage->mNumCols + aCol];
+
+			Rect aPiece = theSrcRect.Intersection(aCel.mRect);
+			if ((aPiece.mWidth <= 0) || (aPiece.mHeight <= 0))
+				continue;
+
+			Rect aTrimRect(aCel.mTrimX + aPiece.mX - aCel.mRect.mX, aCel.mTrimY + aPiece.mY - aCel.mRect.mY, aPiece.mWidth, aPiece.mHeight);
+			int aDestY = theY + aPiece.mY - theSrcRect.mY;
+
+			if (mirror)
+			{
+				int aDestX = theX + (theSrcRect.mX + theSrcRect.mWidth) - (aPiece.mX + aPiece.mWidth);
+				mDestImage->BltMirror(aTrimImage, aDestX, aDestY, aTrimRect, aColor, mDrawMode);
+			}
+			else
+			{
+				int aDestX = theX + aPiece.mX - theSrcRect.mX;
+				mDestImage->Blt(aTrimImage, aDestX, aDestY, aTrimRect, aColor, mDrawMode);
+			}
+		}
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 void GraphicsState::CopyStateFrom(const GraphicsState* theState)
 {
 	mDestImage = theState->mDestImage;
@@ -660,8 +731,11 @@ void Graphics::DrawImage(Sexy::Image* theImage, int theX, int theY)
 	Rect aDestRect = Rect(theX, theY, theImage->GetWidth(), theImage->GetHeight()).Intersection(mClipRect);
 	Rect aSrcRect(aDestRect.mX - theX, aDestRect.mY - theY, aDestRect.mWidth, aDestRect.mHeight);
 
-	if ((aSrcRect.mWidth > 0) && (aSrcRect.mHeight > 0))
-		mDestImage->Blt(theImage, aDestRect.mX, aDestRect.mY, aSrcRect, mColorizeImages ? mColor : Color::White, mDrawMode);
+	if ((aSrcRect.mWidth > 0) && (aSrcRect.mHeight > 0) && (!TrimmedBlt(theImage, aDestRect.mX, aDestRect.mY, aSrcRect, false)))
+	{
+		Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+		mDestImage->Blt(aSrcImage, aDestRect.mX, aDestRect.mY, aSrcRect, mColorizeImages ? mColor : Color::White, mDrawMode);
+	}
 }
 
 void Graphics::DrawImage(Image* theImage, int theX, int theY, const Rect& theSrcRect)
@@ -679,15 +753,20 @@ void Graphics::DrawImage(Image* theImage, int theX, int theY, const Rect& theSrc
 	if (mScaleX!=1 || mScaleY!=1)
 	{
 		Rect aDestRect(mScaleOrigX+floor((theX-mScaleOrigX)*mScaleX),mScaleOrigY+floor((theY-mScaleOrigY)*mScaleY),ceil(theSrcRect.mWidth*mScaleX),ceil(theSrcRect.mHeight*mScaleY));
-		mDestImage->StretchBlt(theImage, aDestRect, theSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, mFastStretch);
+		Rect aSrcRect = theSrcRect;
+		Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+		mDestImage->StretchBlt(aSrcImage, aDestRect, aSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, mFastStretch);
 		return;
 	}
 
 	Rect aDestRect = Rect(theX, theY, theSrcRect.mWidth, theSrcRect.mHeight).Intersection(mClipRect);
 	Rect aSrcRect(theSrcRect.mX + aDestRect.mX - theX, theSrcRect.mY + aDestRect.mY - theY, aDestRect.mWidth, aDestRect.mHeight);
 
-	if ((aSrcRect.mWidth > 0) && (aSrcRect.mHeight > 0))
-		mDestImage->Blt(theImage, aDestRect.mX, aDestRect.mY, aSrcRect, mColorizeImages ? mColor : Color::White, mDrawMode);
+	if ((aSrcRect.mWidth > 0) && (aSrcRect.mHeight > 0) && (!TrimmedBlt(theImage, aDestRect.mX, aDestRect.mY, aSrcRect, false)))
+	{
+		Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+		mDestImage->Blt(aSrcImage, aDestRect.mX, aDestRect.mY, aSrcRect, mColorizeImages ? mColor : Color::White, mDrawMode);
+	}
 }
 
 void Graphics::DrawImageMirror(Image* theImage, int theX, int theY, bool mirror)
@@ -721,8 +800,11 @@ void Graphics::DrawImageMirror(Image* theImage, int theX, int theY, const Rect&
 
 	Rect aSrcRect(theSrcRect.mX + aRightClip, theSrcRect.mY + aDestRect.mY - theY, aDestRect.mWidth, aDestRect.mHeight);
 
-	if ((aSrcRect.mWidth > 0) && (aSrcRect.mHeight > 0))
-		mDestImage->BltMirror(theImage, aDestRect.mX, aDestRect.mY, aSrcRect, mColorizeImages ? mColor : Color::White, mDrawMode);
+	if ((aSrcRect.mWidth > 0) && (aSrcRect.mHeight > 0) && (!TrimmedBlt(theImage, aDestRect.mX, aDestRect.mY, aSrcRect, true)))
+	{
+		Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+		mDestImage->BltMirror(aSrcImage, aDestRect.mX, aDestRect.mY, aSrcRect, mColorizeImages ? mColor : Color::White, mDrawMode);
+	}
 }
 
 void Graphics::DrawImageMirror(Image* theImage, const Rect& theDestRect, const Rect& theSrcRect, bool mirror)
@@ -735,7 +817,9 @@ void Graphics::DrawImageMirror(Image* theImage, const Rect& theDestRect, const R
 
 	Rect aDestRect = Rect(theDestRect.mX + mTransX, theDestRect.mY + mTransY, theDestRect.mWidth, theDestRect.mHeight);
 
-	mDestImage->StretchBltMirror(theImage, aDestRect, theSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, mFastStretch);
+	Rect aSrcRect = theSrcRect;
+	Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+	mDestImage->StretchBltMirror(aSrcImage, aDestRect, aSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, mFastStretch);
 }
 
 
@@ -744,14 +828,17 @@ void Graphics::DrawImage(Image* theImage, int theX, int theY, int theStretchedWi
 	Rect aDestRect = Rect(theX + mTransX, theY + mTransY, theStretchedWidth, theStretchedHeight);
 	Rect aSrcRect = Rect(0, 0, theImage->mWidth, theImage->mHeight);
 
-	mDestImage->StretchBlt(theImage, aDestRect, aSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, mFastStretch);
+	Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+	mDestImage->StretchBlt(aSrcImage, aDestRect, aSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, mFastStretch);
 }
 
 void Graphics::DrawImage(Image* theImage, const Rect& theDestRect, const Rect& theSrcRect)
 {	
 	Rect aDestRect = Rect(theDestRect.mX + mTransX, theDestRect.mY + mTransY, theDestRect.mWidth, theDestRect.mHeight);
+	Rect aSrcRect = theSrcRect;
 
-	mDestImage->StretchBlt(theImage, aDestRect, theSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, mFastStretch);
+	Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+	mDestImage->StretchBlt(aSrcImage, aDestRect, aSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, mFastStretch);
 }
 
 void Graphics::DrawImageF(Image* theImage, float theX, float theY)
@@ -760,7 +847,8 @@ void Graphics::DrawImageF(Image* theImage, float theX, float theY)
 	theY += mTransY;	
 
 	Rect aSrcRect(0, 0, theImage->mWidth, theImage->mHeight);
-	mDestImage->BltF(theImage, theX, theY, aSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode);
+	Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+	mDestImage->BltF(aSrcImage, theX, theY, aSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode);
 }
 
 void Graphics::DrawImageF(Image* theImage, float theX, float theY, const Rect& theSrcRect)
@@ -771,7 +859,9 @@ void Graphics::DrawImageF(Image* theImage, float theX, float theY, const Rect& t
 	theX += mTransX;
 	theY += mTransY;
 	
-	mDestImage->BltF(theImage, theX, theY, theSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode);
+	Rect aSrcRect = theSrcRect;
+	Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+	mDestImage->BltF(aSrcImage, theX, theY, aSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode);
 }
 
 void Graphics::DrawImageRotated(Image* theImage, int theX, int theY, double theRot, const Rect *theSrcRect)
@@ -820,24 +910,28 @@ void Graphics::DrawImageRotatedF(Image* theImage, float theX, float theY, double
 	theX += mTransX;
 	theY += mTransY;	
 
+	Rect aSrcRect;
 	if (theSrcRect==NULL)
-	{
-		Rect aSrcRect(0,0,theImage->mWidth,theImage->mHeight);
-		mDestImage->BltRotated(theImage, theX, theY, aSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, theRot, theRotCenterX, theRotCenterY);
-	}
+		aSrcRect = Rect(0,0,theImage->mWidth,theImage->mHeight);
 	else
-		mDestImage->BltRotated(theImage, theX, theY, *theSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, theRot, theRotCenterX, theRotCenterY);
+		aSrcRect = *theSrcRect;
+
+	Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+	mDestImage->BltRotated(aSrcImage, theX, theY, aSrcRect, mClipRect, mColorizeImages ? mColor : Color::White, mDrawMode, theRot, theRotCenterX, theRotCenterY);
 }
 
 void Graphics::DrawImageMatrix(Image* theImage, const SexyMatrix3 &theMatrix, float x, float y)
 {	
 	Rect aSrcRect(0,0,theImage->mWidth,theImage->mHeight);
-	mDestImage->BltMatrix(theImage,x+mTransX,y+mTransY,theMatrix,mClipRect,mColorizeImages?mColor:Color::White,mDrawMode,aSrcRect,mLinearBlend);
+	Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+	mDestImage->BltMatrix(aSrcImage,x+mTransX,y+mTransY,theMatrix,mClipRect,mColorizeImages?mColor:Color::White,mDrawMode,aSrcRect,mLinearBlend);
 }
 
 void Graphics::DrawImageMatrix(Image* theImage, const SexyMatrix3 &theMatrix, const Rect &theSrcRect, float x, float y)
 {
-	mDestImage->BltMatrix(theImage,x+mTransX,y+mTransY,theMatrix,mClipRect,mColorizeImages?mColor:Color::White,mDrawMode,theSrcRect,mLinearBlend);
+	Rect aSrcRect = theSrcRect;
+	Image* aSrcImage = AtlasRemap(theImage, aSrcRect);
+	mDestImage->BltMatrix(aSrcImage,x+mTransX,y+mTransY,theMatrix,mClipRect,mColorizeImages?mColor:Color::White,mDrawMode,aSrcRect,mLinearBlend);
 }
 
 void Graphics::DrawImageTransformHelper(Image* theImage, const Transform &theTransform, const Rect &theSrcRect, float x, float y, bool useFloat)
@@ -921,14 +1015,53 @@ void Graphics::DrawImageTransformF(Image* theImage, const Transform &theTransfor
 	DrawImageTransformHelper(theImage,theTransform,theSrcRect,x,y,true);
 }
 
+// Texture coordinates are normalized to the image, so atlased textures need
+//  them rescaled into the page.  Coordinates outside 0..1 (tiling) will pick
+//  up neighbouring images.
+static void AtlasRemapUV(Image* theTexture, TriVertex theVertices[][3], int theNumTriangles)
+{
+	Image* aPage = theTexture->mAtlasImage;
+
+	float aScaleU = (float) theTexture->mWidth / aPage->mWidth;
+	float aScaleV = (float) theTexture->mHeight / aPage->mHeight;
+	float anOffsetU = (float) theTexture->mAtlasX / aPage->mWidth;
+	float anOffsetV = (float) theTexture->mAtlasY / aPage->mHeight;
+
+	for (int i = 0; i < theNumTriangles; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			theVertices[i][j].u = theVertices[i][j].u*aScaleU + anOffsetU;
+			theVertices[i][j].v = theVertices[i][j].v*aScaleV + anOffsetV;
+		}
+	}
+}
+
 void Graphics::DrawTriangleTex(Image *theTexture, const TriVertex &v1, const TriVertex &v2, const TriVertex &v3)
 {
 	TriVertex v[1][3] = {{v1,v2,v3}};
+	if (theTexture->mAtlasImage != NULL)
+	{
+		AtlasRemapUV(theTexture,v,1);
+		theTexture = theTexture->mAtlasImage;
+	}
+
 	mDestImage->BltTrianglesTex(theTexture,v,1,mClipRect,mColorizeImages?mColor:Color::White,mDrawMode,mTransX,mTransY,mLinearBlend);
 }
 
 void Graphics::DrawTrianglesTex(Image *theTexture, const TriVertex theVertices[][3], int theNumTriangles)
 {
+	if (theTexture->mAtlasImage != NULL)
+	{
+		typedef TriVertex TriVertexTriple[3];
+		std::vector<TriVertex> aVertices(theVertices[0], theVertices[0] + theNumTriangles*3);
+		TriVertexTriple* aTriangles = (TriVertexTriple*) &aVertices[0];
+
+		AtlasRemapUV(theTexture,aTriangles,theNumTriangles);
+		mDestImage->BltTrianglesTex(theTexture->mAtlasImage,aTriangles,theNumTriangles,mClipRect,mColorizeImages?mColor:Color::White,mDrawMode,mTransX,mTransY,mLinearBlend);
+		return;
+	}
+
 	mDestImage->BltTrianglesTex(theTexture,theVertices,theNumTriangles,mClipRect,mColorizeImages?mColor:Color::White,mDrawMode,mTransX,mTransY,mLinearBlend);
 }
 
@@ -76,6 +76,7 @@ protected:
 	void					PFInsert(int i, int y);
 
 	void					DrawImageTransformHelper(Image* theImage, const Transform &theTransform, const Rect &theSrcRect, float x, float y, bool useFloat);
+	bool					TrimmedBlt(Image* theImage, int theX, int theY, const Rect& theSrcRect, bool mirror);
 
 public:
 	Graphics(const Graphics& theGraphics);
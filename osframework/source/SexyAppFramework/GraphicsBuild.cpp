@@ -12,7 +12,11 @@
 #include "MemoryImage.cpp"
 #include "SysFont.cpp"
 #include "Quantize.cpp"
+#include "TextureAtlas.cpp"
 #include "SharedImage.cpp"
+#include "DrawList.cpp"
+#include "RenderPipeline.cpp"
+#include "ParticleSystem.cpp"
 
 // Leave this at the bottom because it undefs DIRECT3D_VERSION
 #include "D3D8Helper.cpp"
@@ -0,0 +1,746 @@
+#include "HTTPClient.h"
+#include "HTTPTransfer.h"
+#include "AutoCrit.h"
+#include <process.h>
+#include <limits.h>
+
+using namespace Sexy;
+
+static HTTPClient* gHTTPClient = NULL;
+
+// Content-Length comes from the server, so only trust it this far up front
+static const int MAX_CONTENT_RESERVE = 1024*1024;
+
+// Finds theStr in [theStart, theEnd) without needing the data to be terminated
+static const char* HTTPFind(const char* theStart, const char* theEnd, const char* theStr)
+{
+	int aLen = strlen(theStr);
+	for (const char* aPtr = theStart; aPtr + aLen <= theEnd; aPtr++)
+	{
+		if ((*aPtr == *theStr) && (memcmp(aPtr, theStr, aLen) == 0))
+			return aPtr;
+	}
+
+	return NULL;
+}
+
+// Reads an unsigned number at the start of [theStart, theEnd) and returns the end of
+//  its digits.  Returns NULL on a sign, no digits, or a value that doesn't fit in an int.
+static const char* HTTPParseLength(const char* theStart, const char* theEnd, int theBase, int* theLength)
+{
+	int aLength = 0;
+	const char* aPtr = theStart;
+	for (; aPtr < theEnd; aPtr++)
+	{
+		int aDigit;
+		if ((*aPtr >= '0') && (*aPtr <= '9'))
+			aDigit = *aPtr - '0';
+		else if ((theBase == 16) && (*aPtr >= 'a') && (*aPtr <= 'f'))
+			aDigit = *aPtr - 'a' + 10;
+		else if ((theBase == 16) && (*aPtr >= 'A') && (*aPtr <= 'F'))
+			aDigit = *aPtr - 'A' + 10;
+		else
+			break;
+
+		if (aLength > (INT_MAX - aDigit) / theBase)
+			return NULL;
+		aLength = aLength*theBase + aDigit;
+	}
+
+	if (aPtr == theStart)
+		return NULL;
+
+	*theLength = aLength;
+	return aPtr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+HTTPConnection::HTTPConnection()
+{
+	mSocket = INVALID_SOCKET;
+	mState = STATE_IDLE;
+	mTransfer = NULL;
+	mReused = false;
+	mGotData = false;
+	mIdleTick = 0;
+	mSendPos = 0;
+	mRecvPos = 0;
+	mRecvLen = 0;
+	mBodyLeft = 0;
+	mKeepAlive = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+HTTPClient::HTTPClient()
+{
+	WSADATA aDat;
+	WSAStartup(MAKEWORD(1,1),&aDat);
+
+	mMaxConnections = 8;
+	mMaxHostConnections = 4;
+
+	mWakeEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+	mRunning = true;
+	mThreadRunning = true;
+	_beginthread(IOThreadProcStub, 0, this);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+HTTPClient::~HTTPClient()
+{
+	mRunning = false;
+	::SetEvent(mWakeEvent);
+	while (mThreadRunning)
+		Sleep(10);
+
+	::CloseHandle(mWakeEvent);
+	WSACleanup();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+HTTPClient* HTTPClient::GetClient()
+{
+	if (gHTTPClient == NULL)
+		gHTTPClient = new HTTPClient();
+
+	return gHTTPClient;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::Shutdown()
+{
+	delete gHTTPClient;
+	gHTTPClient = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::AddTransfer(HTTPTransfer* theTransfer)
+{
+	AutoCrit aCrit(mCritSect);
+	mPending.push_back(theTransfer);
+	::SetEvent(mWakeEvent);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+ulong HTTPClient::LookupHost(const std::string& theHost)
+{
+	ulong anAddr = inet_addr(theHost.c_str());
+	if (anAddr != INADDR_NONE)
+		return anAddr;
+
+	DWORD aTick = GetTickCount();
+	HTTPHostAddrMap::iterator anItr = mHostAddrs.find(theHost);
+	if ((anItr != mHostAddrs.end()) && (aTick - anItr->second.mTick < HOST_CACHE_TIME))
+		return anItr->second.mAddr;
+
+	// Failed lookups aren't cached so the next transfer tries again
+	HOSTENT *aHostEnt = gethostbyname(theHost.c_str());
+	if (aHostEnt == NULL)
+		return INADDR_NONE;
+
+	memcpy(&anAddr, aHostEnt->h_addr_list[0], 4);
+
+	HTTPHostAddr& aHostAddr = mHostAddrs[theHost];
+	aHostAddr.mAddr = anAddr;
+	aHostAddr.mTick = aTick;
+	return anAddr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+HTTPConnection* HTTPClient::GetConnection(HTTPTransfer* theTransfer, int* theResult)
+{
+	std::string aHostKey = StrFormat("%s:%d", theTransfer->mHost.c_str(), theTransfer->mPort);
+
+	int aHostCount = 0;
+	HTTPConnection* anIdleConnection = NULL;
+
+	HTTPConnectionList::iterator anItr;
+	for (anItr = mConnections.begin(); anItr != mConnections.end(); ++anItr)
+	{
+		HTTPConnection* aConnection = *anItr;
+		if (aConnection->mHostKey == aHostKey)
+		{
+			if (aConnection->mTransfer == NULL)
+				return aConnection;
+			aHostCount++;
+		}
+		else if (aConnection->mTransfer == NULL)
+			anIdleConnection = aConnection;
+	}
+
+	// Over a limit, the transfer stays queued
+	if (aHostCount >= mMaxHostConnections)
+		return NULL;
+
+	if ((int) mConnections.size() >= mMaxConnections)
+	{
+		if (anIdleConnection == NULL)
+			return NULL;
+
+		// Make room by dropping a kept-alive connection to some other host
+		CloseConnection(anIdleConnection);
+	}
+
+	ulong anAddr = LookupHost(theTransfer->mHost);
+	if (anAddr == INADDR_NONE)
+	{
+		*theResult = HTTPTransfer::RESULT_INVALID_ADDR;
+		return NULL;
+	}
+
+	SOCKET aSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (aSocket == INVALID_SOCKET)
+	{
+		*theResult = HTTPTransfer::RESULT_SOCKET_ERROR;
+		return NULL;
+	}
+
+	// Set non-blocking
+	ulong anIoctlVal = 1;
+	ioctlsocket(aSocket, FIONBIO, &anIoctlVal);
+
+	SOCKADDR_IN aSockAddrIn;
+	memset((char*) &aSockAddrIn, 0, sizeof(aSockAddrIn));
+	aSockAddrIn.sin_family      = AF_INET;
+	aSockAddrIn.sin_addr.s_addr = anAddr;
+	aSockAddrIn.sin_port        = htons(theTransfer->mPort);
+
+	if ((::connect(aSocket, (sockaddr*) &aSockAddrIn, sizeof(SOCKADDR_IN)) != 0) && (WSAGetLastError() != WSAEWOULDBLOCK))
+	{
+		closesocket(aSocket);
+		*theResult = HTTPTransfer::RESULT_CONNECT_FAIL;
+		return NULL;
+	}
+
+	HTTPConnection* aConnection = new HTTPConnection();
+	aConnection->mSocket = aSocket;
+	aConnection->mHostKey = aHostKey;
+	aConnection->mState = HTTPConnection::STATE_CONNECTING;
+	aConnection->mRecvBuf.resize(RECV_BUFFER_SIZE);
+	mConnections.push_back(aConnection);
+	return aConnection;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::StartPending()
+{
+	// Host lookups can block, so work on a copy rather than holding the lock
+	HTTPTransferList aPending;
+	{
+		AutoCrit aCrit(mCritSect);
+		aPending.swap(mPending);
+	}
+
+	if (aPending.empty())
+		return;
+
+	HTTPTransferList aWaiting;
+	HTTPTransferList::iterator anItr;
+	for (anItr = aPending.begin(); anItr != aPending.end(); ++anItr)
+	{
+		HTTPTransfer* aTransfer = *anItr;
+		if (aTransfer->mExiting)
+		{
+			CompleteTransfer(aTransfer, HTTPTransfer::RESULT_ABORTED);
+			continue;
+		}
+
+		int aResult = HTTPTransfer::RESULT_NOT_COMPLETED;
+		HTTPConnection* aConnection = GetConnection(aTransfer, &aResult);
+		if (aConnection == NULL)
+		{
+			if (aResult == HTTPTransfer::RESULT_NOT_COMPLETED)
+				aWaiting.push_back(aTransfer);
+			else
+				CompleteTransfer(aTransfer, aResult);
+			continue;
+		}
+
+		aConnection->mTransfer = aTransfer;
+		aConnection->mGotData = false;
+		aConnection->mSendPos = 0;
+		aConnection->mRecvPos = 0;
+		aConnection->mRecvLen = 0;
+		aConnection->mKeepAlive = false;
+		if (aConnection->mState == HTTPConnection::STATE_IDLE)
+			aConnection->mState = HTTPConnection::STATE_SENDING;
+	}
+
+	// Anything still waiting goes back in front of transfers added meanwhile
+	AutoCrit aCrit(mCritSect);
+	mPending.splice(mPending.begin(), aWaiting);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::CompleteTransfer(HTTPTransfer* theTransfer, int theResult)
+{
+	if (theTransfer->mAborted)
+		theResult = HTTPTransfer::RESULT_ABORTED;
+	else if (theTransfer->mResult != HTTPTransfer::RESULT_NOT_COMPLETED)
+		theResult = theTransfer->mResult;
+
+	theTransfer->mResult = theResult;
+	theTransfer->mTransferPending = false;
+
+	// The transfer may be deleted as soon as this is cleared
+	theTransfer->mThreadRunning = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::CloseConnection(HTTPConnection* theConnection)
+{
+	closesocket(theConnection->mSocket);
+	mConnections.remove(theConnection);
+	delete theConnection;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::FinishTransfer(HTTPConnection* theConnection, int theResult, bool keepAlive)
+{
+	HTTPTransfer* aTransfer = theConnection->mTransfer;
+	theConnection->mTransfer = NULL;
+	CompleteTransfer(aTransfer, theResult);
+
+	// Anything left over past the response means we lost track of the stream
+	if ((keepAlive) && (theConnection->mRecvPos == theConnection->mRecvLen))
+	{
+		theConnection->mState = HTTPConnection::STATE_IDLE;
+		theConnection->mReused = true;
+		theConnection->mIdleTick = GetTickCount();
+	}
+	else
+		CloseConnection(theConnection);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::RetryTransfer(HTTPConnection* theConnection)
+{
+	// A kept-alive connection the server closed before answering.  The
+	//  request never got anywhere, so send it again on a fresh connection.
+	HTTPTransfer* aTransfer = theConnection->mTransfer;
+	theConnection->mTransfer = NULL;
+	CloseConnection(theConnection);
+
+	AutoCrit aCrit(mCritSect);
+	mPending.push_front(aTransfer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool HTTPClient::ParseHeader(HTTPConnection* theConnection, const char* theStart, const char* theEnd)
+{
+	HTTPTransfer* aTransfer = theConnection->mTransfer;
+
+	bool chunked = false;
+	bool hasLength = false;
+	int aStatus = 0;
+	bool http11 = false;
+	bool keepAlive = false;
+	bool close = false;
+
+	const char* aLineStart = theStart;
+	while (aLineStart < theEnd)
+	{
+		const char* aLineEnd = HTTPFind(aLineStart, theEnd, "\r\n");
+		if (aLineEnd == NULL)
+			aLineEnd = theEnd;
+
+		std::string aLine(aLineStart, aLineEnd);
+		aLineStart = aLineEnd + 2;
+
+		if (aLine.substr(0, 7) == "HTTP/1.")
+		{
+			http11 = aLine.substr(0, 8) == "HTTP/1.1";
+			aStatus = atoi(aLine.c_str() + 9);
+			continue;
+		}
+
+		int aColonPos = aLine.find(':');
+		if (aColonPos == -1)
+			continue;
+
+		std::string aName = aLine.substr(0, aColonPos);
+		std::string aValue = Trim(aLine.substr(aColonPos + 1));
+
+		if (stricmp(aName.c_str(), "Transfer-Encoding") == 0)
+		{
+			if (stricmp(aValue.c_str(), "identity") != 0)
+				chunked = true;
+		}
+		else if (stricmp(aName.c_str(), "Content-Length") == 0)
+		{
+			// A length we can't use is ignored, the body then runs until the server closes
+			int aLength;
+			const char* aValueEnd = aValue.c_str() + aValue.length();
+			if (HTTPParseLength(aValue.c_str(), aValueEnd, 10, &aLength) == aValueEnd)
+			{
+				hasLength = true;
+				aTransfer->mContentLength = aLength;
+			}
+		}
+		else if (stricmp(aName.c_str(), "Connection") == 0)
+		{
+			if (stricmp(aValue.c_str(), "close") == 0)
+				close = true;
+			else if (stricmp(aValue.c_str(), "keep-alive") == 0)
+				keepAlive = true;
+		}
+	}
+
+	if (aStatus == 404)
+	{
+		FinishTransfer(theConnection, HTTPTransfer::RESULT_NOT_FOUND, false);
+		return false;
+	}
+	else if (aStatus != 200)
+	{
+		FinishTransfer(theConnection, HTTPTransfer::RESULT_HTTP_ERROR, false);
+		return false;
+	}
+
+	theConnection->mKeepAlive = !close && (http11 || keepAlive);
+
+	if (chunked)
+	{
+		theConnection->mState = HTTPConnection::STATE_CHUNK_SIZE;
+	}
+	else if (hasLength)
+	{
+		theConnection->mBodyLeft = aTransfer->mContentLength;
+		theConnection->mState = HTTPConnection::STATE_BODY;
+		if (theConnection->mBodyLeft <= 0)
+		{
+			FinishTransfer(theConnection, HTTPTransfer::RESULT_DONE, theConnection->mKeepAlive);
+			return false;
+		}
+
+		aTransfer->mContent.reserve(min(aTransfer->mContentLength, MAX_CONTENT_RESERVE));
+	}
+	else
+	{
+		// No length specified, we will just read until the server closes
+		theConnection->mKeepAlive = false;
+		theConnection->mBodyLeft = -1;
+		theConnection->mState = HTTPConnection::STATE_BODY;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::ParseResponse(HTTPConnection* theConnection)
+{
+	// Everything is parsed in place in the receive buffer and body data is
+	//  appended straight from it to mContent
+	for (;;)
+	{
+		HTTPTransfer* aTransfer = theConnection->mTransfer;
+		const char* aData = &theConnection->mRecvBuf[0];
+		const char* aPtr = aData + theConnection->mRecvPos;
+		const char* anEnd = aData + theConnection->mRecvLen;
+
+		switch (theConnection->mState)
+		{
+		case HTTPConnection::STATE_HEADER:
+			{
+				const char* aHeaderEnd = HTTPFind(aPtr, anEnd, "\r\n\r\n");
+				if (aHeaderEnd == NULL)
+					return;
+
+				theConnection->mRecvPos = aHeaderEnd + 4 - aData;
+				if (!ParseHeader(theConnection, aPtr, aHeaderEnd))
+					return;
+			}
+			break;
+
+		case HTTPConnection::STATE_BODY:
+			{
+				int aCopyLen = anEnd - aPtr;
+				if (theConnection->mBodyLeft >= 0)
+					aCopyLen = min(aCopyLen, theConnection->mBodyLeft);
+
+				aTransfer->mContent.append(aPtr, aCopyLen);
+				theConnection->mRecvPos += aCopyLen;
+
+				if (theConnection->mBodyLeft >= 0)
+				{
+					theConnection->mBodyLeft -= aCopyLen;
+					if (theConnection->mBodyLeft == 0)
+						FinishTransfer(theConnection, HTTPTransfer::RESULT_DONE, theConnection->mKeepAlive);
+				}
+			}
+			return;
+
+		case HTTPConnection::STATE_CHUNK_SIZE:
+			{
+				const char* aLineEnd = HTTPFind(aPtr, anEnd, "\r\n");
+				if (aLineEnd == NULL)
+					return;
+
+				// Hex length, possibly followed by ";extension"
+				int aChunkLen = 0;
+				const char* aNumEnd = HTTPParseLength(aPtr, aLineEnd, 16, &aChunkLen);
+				if ((aNumEnd == NULL) ||
+					((aNumEnd != aLineEnd) && (*aNumEnd != ';') && (*aNumEnd != ' ') && (*aNumEnd != '\t')))
+				{
+					// End transfer on conversion error
+					FinishTransfer(theConnection, HTTPTransfer::RESULT_DONE, false);
+					return;
+				}
+
+				theConnection->mRecvPos = aLineEnd + 2 - aData;
+				if (aChunkLen == 0)
+				{
+					// Zero-size chunk marks end of chunked transfer
+					theConnection->mState = HTTPConnection::STATE_TRAILER;
+				}
+				else
+				{
+					theConnection->mBodyLeft = aChunkLen;
+					theConnection->mState = HTTPConnection::STATE_CHUNK_DATA;
+				}
+			}
+			break;
+
+		case HTTPConnection::STATE_CHUNK_DATA:
+			{
+				int aCopyLen = min((int) (anEnd - aPtr), theConnection->mBodyLeft);
+				if (aCopyLen == 0)
+					return;
+
+				aTransfer->mContent.append(aPtr, aCopyLen);
+				theConnection->mRecvPos += aCopyLen;
+				theConnection->mBodyLeft -= aCopyLen;
+
+				if (theConnection->mBodyLeft == 0)
+					theConnection->mState = HTTPConnection::STATE_CHUNK_END;
+			}
+			break;
+
+		case HTTPConnection::STATE_CHUNK_END:
+			// There is always a CRLF at the end of the chunk data
+			if (anEnd - aPtr < 2)
+				return;
+
+			theConnection->mRecvPos += 2;
+			theConnection->mState = HTTPConnection::STATE_CHUNK_SIZE;
+			break;
+
+		case HTTPConnection::STATE_TRAILER:
+			{
+				// Trailer headers are skipped up to the blank line that ends the response
+				const char* aLineEnd = HTTPFind(aPtr, anEnd, "\r\n");
+				if (aLineEnd == NULL)
+					return;
+
+				theConnection->mRecvPos = aLineEnd + 2 - aData;
+				if (aLineEnd == aPtr)
+				{
+					FinishTransfer(theConnection, HTTPTransfer::RESULT_DONE, theConnection->mKeepAlive);
+					return;
+				}
+			}
+			break;
+
+		default:
+			return;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::ProcessConnection(HTTPConnection* theConnection, bool canRead, bool canWrite, bool hasError)
+{
+	HTTPTransfer* aTransfer = theConnection->mTransfer;
+	if (aTransfer == NULL)
+	{
+		// An idle connection only becomes readable when the server closes it
+		if ((canRead) || (hasError) || (GetTickCount() - theConnection->mIdleTick > IDLE_TIMEOUT))
+			CloseConnection(theConnection);
+		return;
+	}
+
+	if (aTransfer->mExiting)
+	{
+		FinishTransfer(theConnection, HTTPTransfer::RESULT_ABORTED, false);
+		return;
+	}
+
+	if (hasError)
+	{
+		if (theConnection->mState == HTTPConnection::STATE_CONNECTING)
+			FinishTransfer(theConnection, HTTPTransfer::RESULT_CONNECT_FAIL, false);
+		else
+			FinishTransfer(theConnection, HTTPTransfer::RESULT_SOCKET_ERROR, false);
+		return;
+	}
+
+	if (theConnection->mState == HTTPConnection::STATE_CONNECTING)
+	{
+		// Writable means we connected
+		if (!canWrite)
+			return;
+
+		theConnection->mState = HTTPConnection::STATE_SENDING;
+	}
+
+	if (theConnection->mState == HTTPConnection::STATE_SENDING)
+	{
+		if (!canWrite)
+			return;
+
+		const std::string& aSendStr = aTransfer->mSendStr;
+		int aResult = send(theConnection->mSocket, aSendStr.c_str() + theConnection->mSendPos, aSendStr.length() - theConnection->mSendPos, 0);
+		if (aResult > 0)
+		{
+			theConnection->mSendPos += aResult;
+			if (theConnection->mSendPos >= (int) aSendStr.length())
+				theConnection->mState = HTTPConnection::STATE_HEADER;
+		}
+		else if (WSAGetLastError() != WSAEWOULDBLOCK)
+		{
+			if (theConnection->mReused)
+				RetryTransfer(theConnection);
+			else
+				FinishTransfer(theConnection, HTTPTransfer::RESULT_DISCONNECTED, false);
+		}
+		return;
+	}
+
+	if (!canRead)
+		return;
+
+	// Slide unparsed data to the front, and only grow the buffer if a single
+	//  header is bigger than it
+	std::vector<char>& aBuf = theConnection->mRecvBuf;
+	if (theConnection->mRecvPos > 0)
+	{
+		int aLeft = theConnection->mRecvLen - theConnection->mRecvPos;
+		if (aLeft > 0)
+			memmove(&aBuf[0], &aBuf[theConnection->mRecvPos], aLeft);
+		theConnection->mRecvPos = 0;
+		theConnection->mRecvLen = aLeft;
+	}
+
+	if (theConnection->mRecvLen == (int) aBuf.size())
+		aBuf.resize(aBuf.size() * 2);
+
+	int aResult = recv(theConnection->mSocket, &aBuf[theConnection->mRecvLen], aBuf.size() - theConnection->mRecvLen, 0);
+	if (aResult > 0)
+	{
+		theConnection->mGotData = true;
+		theConnection->mRecvLen += aResult;
+		ParseResponse(theConnection);
+	}
+	else if ((aResult == 0) || (WSAGetLastError() != WSAEWOULDBLOCK))
+	{
+		if ((!theConnection->mGotData) && (theConnection->mReused))
+			RetryTransfer(theConnection);
+		else if (theConnection->mState == HTTPConnection::STATE_HEADER)
+			FinishTransfer(theConnection, HTTPTransfer::RESULT_DISCONNECTED, false);
+		else
+			FinishTransfer(theConnection, HTTPTransfer::RESULT_DONE, false);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::IOThreadProc()
+{
+	while (mRunning)
+	{
+		StartPending();
+
+		if (mConnections.empty())
+		{
+			// Nothing to select on, sleep until a transfer is added.  The
+			//  timeout picks up transfers that were waiting on a limit.
+			::WaitForSingleObject(mWakeEvent, 100);
+			continue;
+		}
+
+		fd_set aReadSet;
+		fd_set aWriteSet;
+		fd_set anExceptSet;
+
+		FD_ZERO(&aReadSet);
+		FD_ZERO(&aWriteSet);
+		FD_ZERO(&anExceptSet);
+
+		HTTPConnectionList::iterator anItr;
+		for (anItr = mConnections.begin(); anItr != mConnections.end(); ++anItr)
+		{
+			HTTPConnection* aConnection = *anItr;
+			if ((aConnection->mState == HTTPConnection::STATE_CONNECTING) || (aConnection->mState == HTTPConnection::STATE_SENDING))
+				FD_SET(aConnection->mSocket, &aWriteSet);
+			else
+				FD_SET(aConnection->mSocket, &aReadSet);
+
+			FD_SET(aConnection->mSocket, &anExceptSet);
+		}
+
+		// Short timeout so aborts and new transfers are noticed promptly
+		TIMEVAL aTimeout;
+		aTimeout.tv_sec = 0;
+		aTimeout.tv_usec = 10*1000;
+
+		if (select(FD_SETSIZE, &aReadSet, &aWriteSet, &anExceptSet, &aTimeout) == SOCKET_ERROR)
+		{
+			FD_ZERO(&aReadSet);
+			FD_ZERO(&aWriteSet);
+			FD_ZERO(&anExceptSet);
+		}
+
+		anItr = mConnections.begin();
+		while (anItr != mConnections.end())
+		{
+			// Processing can close the connection, so step past it first
+			HTTPConnection* aConnection = *anItr++;
+			ProcessConnection(aConnection, FD_ISSET(aConnection->mSocket, &aReadSet) != 0,
+				FD_ISSET(aConnection->mSocket, &aWriteSet) != 0, FD_ISSET(aConnection->mSocket, &anExceptSet) != 0);
+		}
+	}
+
+	while (!mConnections.empty())
+	{
+		HTTPConnection* aConnection = mConnections.front();
+		if (aConnection->mTransfer != NULL)
+			FinishTransfer(aConnection, HTTPTransfer::RESULT_ABORTED, false);
+		else
+			CloseConnection(aConnection);
+	}
+
+	{
+		AutoCrit aCrit(mCritSect);
+		while (!mPending.empty())
+		{
+			CompleteTransfer(mPending.front(), HTTPTransfer::RESULT_ABORTED);
+			mPending.pop_front();
+		}
+	}
+
+	// The destructor is waiting on this, so mCritSect must already be released
+	mThreadRunning = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void HTTPClient::IOThreadProcStub(void *theArg)
+{
+	((HTTPClient*) theArg)->IOThreadProc();
+}
@@ -0,0 +1,119 @@
+#ifndef __HTTPCLIENT_H__
+#define __HTTPCLIENT_H__
+
+#include "Common.h"
+#include "CritSect.h"
+#include <winsock.h>
+
+namespace Sexy
+{
+
+class HTTPTransfer;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// One socket to one host:port.  Between transfers a kept-alive connection
+//  sits in STATE_IDLE with no mTransfer until the next request to the same
+//  host picks it up.
+class HTTPConnection
+{
+public:
+	enum
+	{
+		STATE_CONNECTING,
+		STATE_SENDING,
+		STATE_HEADER,
+		STATE_BODY,
+		STATE_CHUNK_SIZE,
+		STATE_CHUNK_DATA,
+		STATE_CHUNK_END,
+		STATE_TRAILER,
+		STATE_IDLE
+	};
+
+	SOCKET					mSocket;
+	std::string				mHostKey;		// "host:port"
+	int						mState;
+	HTTPTransfer*			mTransfer;
+	bool					mReused;		// has finished a transfer before, so the server may have closed it since
+	bool					mGotData;		// received anything for the current transfer
+	DWORD					mIdleTick;
+
+	int						mSendPos;
+	std::vector<char>		mRecvBuf;		// recv() writes straight in here and the parser works in place
+	int						mRecvPos;		// parse position
+	int						mRecvLen;		// bytes received
+	int						mBodyLeft;		// bytes left in the body or chunk, -1 to read until the server closes
+	bool					mKeepAlive;
+
+public:
+	HTTPConnection();
+};
+
+typedef std::list<HTTPTransfer*> HTTPTransferList;
+typedef std::list<HTTPConnection*> HTTPConnectionList;
+
+struct HTTPHostAddr
+{
+	ulong					mAddr;
+	DWORD					mTick;
+};
+
+typedef std::map<std::string, HTTPHostAddr> HTTPHostAddrMap;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Runs every HTTPTransfer from a single I/O thread.  Sockets are multiplexed
+//  with select, connections are kept alive and reused per host, host lookups
+//  are cached, and at most mMaxConnections sockets (mMaxHostConnections to
+//  any one host) are open at once; transfers past that wait in mPending.
+//  HTTPTransfer keeps its polling API, this thread fills in its fields.
+class HTTPClient
+{
+public:
+	enum
+	{
+		RECV_BUFFER_SIZE	= 65536,
+		IDLE_TIMEOUT		= 30000,	// ms before an unused kept-alive connection is closed
+		HOST_CACHE_TIME		= 300000	// ms a host lookup is trusted for
+	};
+
+	CritSect				mCritSect;		// guards mPending
+	HTTPTransferList		mPending;
+	HTTPConnectionList		mConnections;	// I/O thread only
+	HTTPHostAddrMap			mHostAddrs;		// I/O thread only
+	int						mMaxConnections;
+	int						mMaxHostConnections;
+
+	HANDLE					mWakeEvent;
+	volatile bool			mRunning;
+	volatile bool			mThreadRunning;
+
+protected:
+	ulong					LookupHost(const std::string& theHost);
+	void					StartPending();
+	HTTPConnection*			GetConnection(HTTPTransfer* theTransfer, int* theResult);
+	void					ProcessConnection(HTTPConnection* theConnection, bool canRead, bool canWrite, bool hasError);
+	void					ParseResponse(HTTPConnection* theConnection);
+	bool					ParseHeader(HTTPConnection* theConnection, const char* theStart, const char* theEnd);
+	void					RetryTransfer(HTTPConnection* theConnection);
+	void					FinishTransfer(HTTPConnection* theConnection, int theResult, bool keepAlive);
+	void					CompleteTransfer(HTTPTransfer* theTransfer, int theResult);
+	void					CloseConnection(HTTPConnection* theConnection);
+
+	void					IOThreadProc();
+	static void				IOThreadProcStub(void *theArg);
+
+public:
+	HTTPClient();
+	virtual ~HTTPClient();
+
+	static HTTPClient*		GetClient();
+	static void				Shutdown();
+
+	void					AddTransfer(HTTPTransfer* theTransfer);
+};
+
+}
+
+#endif //__HTTPCLIENT_H__
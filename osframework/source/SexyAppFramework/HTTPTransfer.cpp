@@ -1,7 +1,6 @@
 #include "HTTPTransfer.h"
+#include "HTTPClient.h"
 #include "SexyAppBase.h"
-#include <process.h>
-#include <winsock.h>
 
 using namespace Sexy;
 
@@ -67,275 +66,6 @@ void HTTPTransfer::Fail(int theResult)
 	mExiting = true;
 }
 
-bool HTTPTransfer::SocketWait(bool checkRead, bool checkWrite)
-{
-	while (!mExiting)
-	{
-		fd_set aReadSet;
-		fd_set aWriteSet;
-		fd_set anExceptSet;
-
-		FD_ZERO(&aReadSet);
-		FD_ZERO(&aWriteSet);
-		FD_ZERO(&anExceptSet);
-
-		if (checkRead)
-			FD_SET(mSocket, &aReadSet);
-
-		if (checkWrite)
-			FD_SET(mSocket, &aWriteSet);
-
-		FD_SET(mSocket, &anExceptSet);
-
-		// Check every 100ms
-		int aReadTime = 100;
-
-		TIMEVAL aTimeout;
-		aTimeout.tv_sec = aReadTime/1000;
-		aTimeout.tv_usec = (aReadTime%1000)*1000;
-
-		int aVal = select(FD_SETSIZE, &aReadSet, &aWriteSet, &anExceptSet, &aTimeout);
-		
-		if (aVal == SOCKET_ERROR)
-		{
-			Fail(RESULT_SOCKET_ERROR);
-			return false;
-		}
-
-		if (FD_ISSET(mSocket, &anExceptSet))
-		{
-			Fail(RESULT_SOCKET_ERROR);
-			return false;
-		}
-
-		if (FD_ISSET(mSocket, &aReadSet))
-			return true;
-
-		if (FD_ISSET(mSocket, &aWriteSet))
-			return true;	
-	}
-
-	// Return true on abort
-	return true;
-}
-
-void HTTPTransfer::GetThreadProc()
-{
-	WSADATA aDat;
-	WSAStartup(MAKEWORD(1,1),&aDat);
-	
-	mSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-	if (mSocket == 0)	
-		Fail(RESULT_SOCKET_ERROR);
-
-	// Set non-blocking
-	ulong anIoctlVal = 1;
-	ioctlsocket(mSocket, FIONBIO, &anIoctlVal);
-
-	if (!mExiting)
-	{
-		unsigned long anAddr = inet_addr(mHost.c_str());
-		if (anAddr == INADDR_NONE)
-		{		
-			HOSTENT *aHostEnt = gethostbyname(mHost.c_str());
-			if (aHostEnt != NULL) 
-				memcpy(&anAddr, aHostEnt->h_addr_list[0], 4);
-		}
-
-		if (anAddr == INADDR_NONE)
-		{
-			Fail(RESULT_INVALID_ADDR);
-		}
-		else 
-		{
-			SOCKADDR_IN aSockAddrIn;		
-			memset((char*) &aSockAddrIn, 0, sizeof(aSockAddrIn));
-			aSockAddrIn.sin_family      = AF_INET;
-			aSockAddrIn.sin_addr.s_addr = anAddr;
-			aSockAddrIn.sin_port        = htons(mPort);
-			
-			if (::connect(mSocket, (sockaddr*) &aSockAddrIn, sizeof(SOCKADDR_IN)) != 0)
-			{
-				if (WSAGetLastError() != WSAEWOULDBLOCK)
-					Fail(RESULT_CONNECT_FAIL);
-
-				// Wait for socket to become writable to know we connected
-				if (!SocketWait(false, true))
-					Fail(RESULT_CONNECT_FAIL);
-			}		
-
-			while ((mSendStr.length() > 0) && (!mExiting))
-			{
-				SocketWait(false, true);
-				int aResult = send(mSocket, mSendStr.c_str(), mSendStr.length(), 0);
-
-				if (aResult > 0)
-				{
-					mSendStr = mSendStr.substr(aResult);
-				}
-				else 
-				{
-					int anError = WSAGetLastError();					
-					Fail(RESULT_DISCONNECTED);
-				}
-			}			
-
-			bool chunked = false;
-			bool gotHeader = false;
-			int aPos = 0;
-			int aLastPos = 0;
-			int aChunkLengthLeft = 0; 
-			int aContentLengthLeft = 0;
-			std::string aRecvStr;
-
-			while (!mExiting)
-			{
-				// Wait for more characters if we couldn't do any processing with the 
-				//  current ones
-				if (aLastPos == aPos)
-				{
-					char aBuffer[257];
-					SocketWait(true, false);					
-					int aResult = recv(mSocket, aBuffer, 256, 0);
-					if (aResult > 0)
-					{
-						aRecvStr.insert(aRecvStr.end(), aBuffer, aBuffer+aResult);
-
-						aBuffer[aResult] = 0;						
-					}
-					else
-					{
-						int anError = WSAGetLastError();						
-						break;
-					}
-				}				
-
-				aLastPos = aPos;
-
-				if (!gotHeader)
-				{
-					// Still reading header...
-					int anEndLPos = aRecvStr.find("\r\n", aPos);
-					if (anEndLPos == -1)
-						continue; // Not enough for a full line yet
-					std::string aLine = aRecvStr.substr(aPos, anEndLPos-aPos);
-					aPos = anEndLPos+2;
-
-					if (aLine.substr(0, 7) == "HTTP/1.")
-					{
-						std::string aResult = aLine.substr(9, 3);
-						if (aResult == "404")
-						{
-							Fail(RESULT_NOT_FOUND);
-						}
-						else if (aResult != "200")
-						{
-							Fail(RESULT_HTTP_ERROR);
-						}
-					}
-
-					if (aLine == "Transfer-Encoding: chunked")
-					{
-						chunked = true;
-					}
-
-					char* aCheckStr = "Transfer-Encoding: ";
-					if (strncmp(aLine.c_str(), aCheckStr, strlen(aCheckStr)) == 0)
-					{
-						if (strcmp(aLine.c_str() + strlen(aCheckStr), "identity") != 0)
-							chunked = true;
-					}
-
-					aCheckStr = "Content-Length: ";
-					if (strncmp(aLine.c_str(), aCheckStr, strlen(aCheckStr)) == 0)
-					{
-						aContentLengthLeft = atoi(aLine.c_str() + strlen(aCheckStr));
-						mContentLength = aContentLengthLeft;
-					}
-
-					// Header is complete when we get a blank line
-					if (aLine.length() == 0)
-						gotHeader = true;
-				}
-				else
-				{
-					if (chunked)
-					{
-						// If it is zero, we need to get the next chunk length
-						if (aChunkLengthLeft == 0)
-						{
-							// Get a hex length
-							int anEndLPos = aRecvStr.find("\r\n", aPos);
-							if (anEndLPos == -1)
-								continue; // Not enough for a full line yet
-
-							std::string aLine = aRecvStr.substr(aPos, anEndLPos-aPos);
-							if (!StringToInt("0x" + Trim(aLine), &aChunkLengthLeft))
-								break; // End transfer on conversion error
-							if (aChunkLengthLeft == 0)
-								break; // Zero-size chunk marks end of chunked transfer
-														
-							aPos = anEndLPos+2;
-						}
-
-						// Chunk it in
-						int aCopyLen = min(aChunkLengthLeft, (int)aRecvStr.length() - aPos);
-						if (aCopyLen > 0)
-						{
-							mContent += aRecvStr.substr(aPos, aCopyLen);
-							aPos += aCopyLen;
-							aChunkLengthLeft -= aCopyLen;
-
-							// There is always a CRLF at the end of the chunk data
-							if (aChunkLengthLeft == 0)
-								aPos += 2;
-						}
-					}
-					else
-					{
-						if (aContentLengthLeft > 0)
-						{
-							int aCopyLen = min(aContentLengthLeft, (int)aRecvStr.length() - aPos);
-							mContent += aRecvStr.substr(aPos, aCopyLen);
-							aPos += aCopyLen;
-							aContentLengthLeft -= aCopyLen;
-							if (aContentLengthLeft == 0)
-							{
-								// We have reached the end at this point
-								break;
-							}
-						}
-						else
-						{
-							// No length specified, we will just read until we close
-							int aCopyLen = aRecvStr.length() - aPos;
-							mContent += aRecvStr.substr(aPos, aCopyLen);
-							aPos += aCopyLen;
-						}
-					}
-				}
-			}			
-		}
-	}
-
-	closesocket(mSocket);
-	mSocket = NULL;
-	WSACleanup();
-
-	if (mAborted)
-		Fail(RESULT_ABORTED);
-	else if (mResult == RESULT_NOT_COMPLETED)
-		mResult = RESULT_DONE;
-
-	mThreadRunning = false;
-	mTransferPending = false;
-}
-
-void HTTPTransfer::GetThreadProcStub(void *theArg)
-{
-	((HTTPTransfer*) theArg)->GetThreadProc();
-}
-
 void HTTPTransfer::PrepareTransfer(const std::string& theURL)
 {
 	Reset();	
@@ -387,8 +117,9 @@ void HTTPTransfer::StartTransfer()
 	if ((gSexyAppBase != NULL) && (gSexyAppBase->mPlayingDemoBuffer))
 		return;
 
+	// The client's I/O thread clears mThreadRunning once it is done with us
 	mThreadRunning = true;
-	_beginthread(GetThreadProcStub, 0, this);
+	HTTPClient::GetClient()->AddTransfer(this);
 }
 
 void HTTPTransfer::GetHelper(const std::string& theURL)
@@ -396,10 +127,10 @@ void HTTPTransfer::GetHelper(const std::string& theURL)
 	PrepareTransfer(theURL);
 
 	mSendStr = 
-		"GET " + mPath + " HTTP/1.0\r\n" 
+		"GET " + mPath + " HTTP/1.1\r\n" 
 		"User-Agent: Mozilla/4.0 (compatible; popcap)\r\n"
 		"Host: " + mHost + "\r\n"
-		"Connection: close\r\n" +
+		"Connection: keep-alive\r\n" +
 		"\r\n";
 
 	StartTransfer();
@@ -410,12 +141,12 @@ void HTTPTransfer::PostHelper(const std::string& theURL, const std::string& theP
 	PrepareTransfer(theURL);
 
 	mSendStr = 
-		"POST " + mPath + " HTTP/1.0\r\n" 
+		"POST " + mPath + " HTTP/1.1\r\n" 
 		"Content-Type: application/x-www-form-urlencoded\r\n" + 
 		"User-Agent: Mozilla/4.0 (compatible; popcap)\r\n"
 		"Host: " + mHost + "\r\n"
 		"Content-Length: " + StrFormat("%d", theParams.length()) + "\r\n" +
-		"Connection: close\r\n" +
+		"Connection: keep-alive\r\n" +
 		"\r\n" + theParams;
 
 	StartTransfer();
@@ -24,7 +24,6 @@ public:
 	};
 
 	int						mTransferId;
-	int						mSocket;
 	std::string				mSendStr;
 	std::string				mSpecifiedBaseURL;
 	std::string				mSpecifiedRelURL;
@@ -53,12 +52,9 @@ protected:
 	void					PostHelper(const std::string& theURL, const std::string& theParams);
 
 	void					Fail(int theResult);
-	void					GetThreadProc();
-	static void				GetThreadProcStub(void *theArg);
 	static std::string		GetAbsURL(const std::string& theBaseURL, const std::string& theRelURL);
 
 	void					UpdateStatus();
-	bool					SocketWait(bool checkRead, bool checkWrite);
 
 public:
 	HTTPTransfer();
@@ -1,5 +1,6 @@
 #include "Image.h"
 #include "Graphics.h"
+#include "TextureAtlas.h"
 
 using namespace Sexy;
 
@@ -13,6 +14,17 @@ Image::Image()
 
 	mAnimInfo = NULL;
 	mDrawn = false;
+
+	mAtlas = NULL;
+	mAtlasImage = NULL;
+	mAtlasX = 0;
+	mAtlasY = 0;
+
+	mTrimImage = NULL;
+	mTrimFill = 0;
+
+	mDrawListFrame[0] = 0;
+	mDrawListFrame[1] = 0;
 }
 
 Image::Image(const Image& theImage) :
@@ -26,10 +38,25 @@ Image::Image(const Image& theImage) :
 		mAnimInfo = new AnimInfo(*theImage.mAnimInfo);
 	else
 		mAnimInfo = NULL;
+
+	// Copies get their own bits rather than sharing the atlas page or trimmed pieces
+	mAtlas = NULL;
+	mAtlasImage = NULL;
+	mAtlasX = 0;
+	mAtlasY = 0;
+
+	mTrimImage = NULL;
+	mTrimFill = 0;
+
+	mDrawListFrame[0] = 0;
+	mDrawListFrame[1] = 0;
 }
 
 Image::~Image()
 {
+	if (mAtlas != NULL)
+		mAtlas->RemoveImage(this);
+
 	delete mAnimInfo;
 }
 
@@ -41,10 +41,22 @@ struct AnimInfo
 	int GetCel(int theTime);
 };
 
+// One cel of a trimmed image, see Image::mTrimImage
+struct TrimCel
+{
+	Rect					mRect;		// the cel's visible pixels in image coordinates, empty if none
+	int						mTrimX;		// where they're stored in mTrimImage
+	int						mTrimY;
+};
+
+typedef std::vector<TrimCel> TrimCelVector;
+
 class Graphics;
 class SexyMatrix3;
 class SysFont;
 class TriVertex;
+class TextureAtlas;
+class MemoryImage;
 
 class Image
 {
@@ -63,6 +75,21 @@ public:
 	// for animations
 	AnimInfo				*mAnimInfo;
 
+	// for images packed into a TextureAtlas, Graphics draws from mAtlasImage instead
+	TextureAtlas*			mAtlas;
+	Image*					mAtlasImage;
+	int						mAtlasX;
+	int						mAtlasY;
+
+	// for images cropped to the visible pixels of each cel (MemoryImage::TrimCels), unscaled
+	//  blits draw the cels' pieces from mTrimImage instead
+	MemoryImage*			mTrimImage;
+	TrimCelVector			mTrimCels;
+	ulong					mTrimFill;	// what every cropped pixel held
+
+	// the frame each of RenderPipeline's two DrawLists last recorded this image in
+	ulong					mDrawListFrame[2];
+
 public:
 	Image();
 	Image(const Image& theImage);
@@ -1297,10 +1297,19 @@ void ImageFont::GenerateActiveFontLayers()
 					if (mForceScaledImagesWhite)
 					{
 						int aCount = aMemoryImage->mWidth*aMemoryImage->mHeight;
-						ulong* aBits = aMemoryImage->GetBits();
+						ulong* aBits = aMemoryImage->GetRawBits();
 
-						for (int i = 0; i < aCount; i++)
-							*(aBits++) = *aBits | 0x00FFFFFF;
+						// White premultiplied by its alpha is the alpha in every channel
+						if (aMemoryImage->mPremultipliedAlpha)
+						{
+							for (int i = 0; i < aCount; i++, aBits++)
+								*aBits = (*aBits & 0xFF000000) | ((*aBits >> 24) * 0x010101);
+						}
+						else
+						{
+							for (int i = 0; i < aCount; i++, aBits++)
+								*aBits |= 0x00FFFFFF;
+						}
 					}
 
 					aMemoryImage->Palletize();
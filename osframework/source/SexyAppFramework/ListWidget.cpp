@@ -9,6 +9,87 @@ using namespace Sexy;
 
 static int gInitialListWidgetColors[][3] = {{255, 255, 255}, {255, 255, 255}, {0, 0, 0}, {0, 192, 0}, {0, 0, 128}, {255, 255, 255}};
 
+struct ListLineLess
+{
+	bool operator()(const SexyString& theLeft, const SexyString& theRight) const
+	{
+		return sexystrcmp(theLeft.c_str(), theRight.c_str()) < 0;
+	}
+};
+
+// Walks one row's sort key a character at a time: each column's line padded
+//  with leading zeros out to its mMaxNumericPlaces, the columns one after
+//  another.  That's the string GetSortKey builds, without building it.
+struct ListSortKeyCursor
+{
+	const std::vector<ListWidget*>* mColumns;
+	int mRow;
+	int mColumn;
+	int mPos;
+
+	ListSortKeyCursor(const std::vector<ListWidget*>* theColumns, int theRow) :
+		mColumns(theColumns), mRow(theRow), mColumn(0), mPos(0)
+	{
+	}
+
+	bool Next(SexyChar& theChar)
+	{
+		while (mColumn < (int) mColumns->size())
+		{
+			ListWidget* aColumn = (*mColumns)[mColumn];
+			const SexyString& aLine = aColumn->mLines[mRow];
+			int aPad = max(0, aColumn->mMaxNumericPlaces - (int) aLine.length());
+
+			if (mPos < aPad + (int) aLine.length())
+			{
+				theChar = (mPos < aPad) ? _S('0') : aLine[mPos - aPad];
+				mPos++;
+				return true;
+			}
+
+			mColumn++;
+			mPos = 0;
+		}
+
+		return false;
+	}
+};
+
+// Orders row indices the way comparing their GetSortKey strings would.  A
+//  column that's a prefix of the other row's runs on into the next column,
+//  so ("a","z") sorts after ("ab","a") just like "az" after "aba".
+struct ListSortCompare
+{
+	const std::vector<ListWidget*>* mColumns;
+	bool mAscending;
+
+	bool operator()(int theLeft, int theRight) const
+	{
+		ListSortKeyCursor aLeftCursor(mColumns, theLeft);
+		ListSortKeyCursor aRightCursor(mColumns, theRight);
+
+		for (;;)
+		{
+			SexyChar aLeftChar;
+			SexyChar aRightChar;
+			bool haveLeft = aLeftCursor.Next(aLeftChar);
+			bool haveRight = aRightCursor.Next(aRightChar);
+
+			int aComp;
+			if ((!haveLeft) || (!haveRight))
+				aComp = (haveLeft ? 1 : 0) - (haveRight ? 1 : 0);
+			else if (SexyString::traits_type::lt(aLeftChar, aRightChar))
+				aComp = -1;
+			else if (SexyString::traits_type::lt(aRightChar, aLeftChar))
+				aComp = 1;
+			else
+				continue;
+
+			return mAscending ? (aComp < 0) : (aComp > 0);
+		}
+	}
+};
+
 ListWidget::ListWidget(int theId, Font *theFont, ListListener *theListListener) 
 {
 	mJustify = JUSTIFY_LEFT;
@@ -35,6 +116,8 @@ ListWidget::ListWidget(int theId, Font *theFont, ListListener *theListListener)
 	mMaxNumericPlaces = 0;	
 	mDrawSelectWhenHilited = false;
 	mDoFingerWhenHilited = true;
+	mLinesSorted = true;
+	mLineIndexDirty = true;
 }
 	
 ListWidget::~ListWidget() 
@@ -68,34 +151,37 @@ SexyString ListWidget::GetSortKey(int theIdx)
 	return _S("");
 }
 	
+void ListWidget::GetSortColumns(std::vector<ListWidget*>& theColumns)
+{
+	if ((mSortFromChild) && (mChild != NULL))
+	{
+		mChild->GetSortColumns(theColumns);
+		theColumns.push_back(this);
+	}
+	else
+	{
+		theColumns.push_back(this);
+		if (mChild != NULL)
+			mChild->GetSortColumns(theColumns);
+	}
+}
+	
 void ListWidget::Sort(bool ascending) 
 {
 	int aCount = mLines.size();
-	int* aMap = new int[aCount];
-	SexyString* aKeys = new SexyString[aCount];
+	std::vector<int> aMap(aCount);
 
 	int i;
 	for (i = 0; i < aCount; i++) 
-	{
 		aMap[i] = i;
-		aKeys[i] = GetSortKey(i);		
-	}
-		
-	for (i = 1; i < aCount; i++) 
-		for (int j = 0; j < aCount - i; j++) 
-		{
-			int aComp = aKeys[j].compare(aKeys[j+1]);
-			if ((ascending && (aComp > 0)) || (!ascending && (aComp < 0)))
-			{
-				int aSwapInt = aMap[j];
-				aMap[j] = aMap[j+1];
-				aMap[j+1] = aSwapInt;
-						
-				SexyString aSwapKey = aKeys[j];
-				aKeys[j] = aKeys[j+1];
-				aKeys[j+1] = aSwapKey;
-			}
-		}
+
+	std::vector<ListWidget*> aColumns;
+	GetSortColumns(aColumns);
+
+	ListSortCompare aCompare;
+	aCompare.mColumns = &aColumns;
+	aCompare.mAscending = ascending;
+	std::stable_sort(aMap.begin(), aMap.end(), aCompare);
 		
 	ListWidget *aListWidget = this;
 	while (aListWidget->mParent != NULL)	
@@ -114,14 +200,12 @@ void ListWidget::Sort(bool ascending)
 		
 		aListWidget->mLines = aNewLines;
 		aListWidget->mLineColors = aNewLineColors;
+		aListWidget->CheckLinesSorted();
 		
 		aListWidget->MarkDirty();
 						
 		aListWidget = aListWidget->mChild;
 	}
-
-	delete aMap;
-	delete aKeys;
 }
 	
 SexyString ListWidget::GetStringAt(int theIdx) 
@@ -146,6 +230,54 @@ void ListWidget::Resize(int theX, int theY, int theWidth, int theHeight)
 		mScrollbar->SetPageSize(aPageSize);
 }
 	
+void ListWidget::LinesChanged(int theIdx)
+{
+	mLineIndexDirty = true;
+	if (!mLinesSorted)
+		return;
+
+	// Only the neighbours of a new or changed line can be out of order
+	ListLineLess aLess;
+	if (((theIdx > 0) && (aLess(mLines[theIdx], mLines[theIdx-1]))) ||
+		((theIdx + 1 < (int) mLines.size()) && (aLess(mLines[theIdx+1], mLines[theIdx]))))
+		mLinesSorted = false;
+}
+
+void ListWidget::CheckLinesSorted()
+{
+	mLineIndexDirty = true;
+	mLinesSorted = true;
+
+	ListLineLess aLess;
+	for (int i = 1; i < (int) mLines.size(); i++)
+	{
+		if (aLess(mLines[i], mLines[i-1]))
+		{
+			mLinesSorted = false;
+			break;
+		}
+	}
+}
+
+int ListWidget::FindInsertIdx(const SexyString& theLine)
+{
+	// First line that theLine sorts before
+	if (mLinesSorted)
+	{
+		SexyStringVector::iterator anItr = std::upper_bound(mLines.begin(), mLines.end(), theLine, ListLineLess());
+		if (anItr == mLines.end())
+			return -1;
+
+		return anItr - mLines.begin();
+	}
+
+	for (int i = 0;	i < (int) mLines.size(); i++) 		
+		if (sexystrcmp(theLine.c_str(), mLines[i].c_str()) < 0) 
+			return i;
+
+	return -1;
+}
+	
 int ListWidget::AddLine(const SexyString& theLine, bool alphabetical) 
 {	
 	int anIdx = -1;
@@ -153,32 +285,32 @@ int ListWidget::AddLine(const SexyString& theLine, bool alphabetical)
 
 	if (alphabetical) 
 	{	
-		for (int i = 0;	i < (int) mLines.size(); i++) 		
-			if (sexystrcmp(theLine.c_str(), mLines[i].c_str()) < 0) 
-			{
-				anIdx = i;
-						
-				ListWidget *aListWidget = this;
+		int i = FindInsertIdx(theLine);
+		if (i != -1)
+		{
+			anIdx = i;
+					
+			ListWidget *aListWidget = this;
 
-				while (aListWidget->mParent != NULL) 
-					aListWidget = aListWidget->mParent;
+			while (aListWidget->mParent != NULL) 
+				aListWidget = aListWidget->mParent;
 
-				while (aListWidget != NULL) 
-				{
-					if (aListWidget == this)
-						aListWidget->mLines.insert(aListWidget->mLines.begin() + i, theLine);
-					else 
-						aListWidget->mLines.insert(aListWidget->mLines.begin() + i, _S("-"));
-					
-					aListWidget->mLineColors.insert(aListWidget->mLineColors.begin() + i, mColors[COLOR_TEXT]);
-					aListWidget->MarkDirty();
-					
-					aListWidget = aListWidget->mChild;
-				}
-						
-				inserted = true;
-				break;
+			while (aListWidget != NULL) 
+			{
+				if (aListWidget == this)
+					aListWidget->mLines.insert(aListWidget->mLines.begin() + i, theLine);
+				else 
+					aListWidget->mLines.insert(aListWidget->mLines.begin() + i, _S("-"));
+				
+				aListWidget->mLineColors.insert(aListWidget->mLineColors.begin() + i, mColors[COLOR_TEXT]);
+				aListWidget->LinesChanged(i);
+				aListWidget->MarkDirty();
+				
+				aListWidget = aListWidget->mChild;
 			}
+					
+			inserted = true;
+		}
 	}
 		
 	if (!inserted) 
@@ -198,6 +330,7 @@ int ListWidget::AddLine(const SexyString& theLine, bool alphabetical)
 				aListWidget->mLines.push_back(_S("-"));
 						
 			aListWidget->mLineColors.push_back(mColors[COLOR_TEXT]);
+			aListWidget->LinesChanged(anIdx);
 			aListWidget->MarkDirty();
 				
 			aListWidget = aListWidget->mChild;
@@ -214,6 +347,7 @@ int ListWidget::AddLine(const SexyString& theLine, bool alphabetical)
 void ListWidget::SetLine(int theIdx, const SexyString& theString) 
 {
 	mLines[theIdx] = theString;	
+	LinesChanged(theIdx);
 	MarkDirty();
 }
 	
@@ -224,9 +358,27 @@ int ListWidget::GetLineCount()
 	
 int ListWidget::GetLineIdx(const SexyString& theLine) 
 {	
-	for (ulong i = 0; i < mLines.size(); i++)	
-		if (sexystrcmp(mLines[i].c_str(), theLine.c_str()) == 0)
-			return i;
+	if (mLinesSorted)
+	{
+		SexyStringVector::iterator anItr = std::lower_bound(mLines.begin(), mLines.end(), theLine, ListLineLess());
+		if ((anItr != mLines.end()) && (sexystrcmp(anItr->c_str(), theLine.c_str()) == 0))
+			return anItr - mLines.begin();
+
+		return -1;
+	}
+
+	if (mLineIndexDirty)
+	{
+		// insert() won't replace an existing key, so duplicates map to their first index
+		mLineIndex.clear();
+		for (int i = 0; i < (int) mLines.size(); i++)
+			mLineIndex.insert(SexyStringToIntMap::value_type(mLines[i], i));
+		mLineIndexDirty = false;
+	}
+
+	SexyStringToIntMap::iterator anItr = mLineIndex.find(theLine);
+	if (anItr != mLineIndex.end())
+		return anItr->second;
 	
 	return -1;
 }
@@ -274,6 +426,7 @@ void ListWidget::RemoveLine(int theIdx)
 		{
 			aListWidget->mLines.erase(aListWidget->mLines.begin() + theIdx);
 			aListWidget->mLineColors.erase(aListWidget->mLineColors.begin() + theIdx);
+			aListWidget->mLineIndexDirty = true;
 				
 			aListWidget->MarkDirty();
 			aListWidget = aListWidget->mChild;	
@@ -295,6 +448,9 @@ void ListWidget::RemoveAll()
 	{
 		aListWidget->mLines.clear();
 		aListWidget->mLineColors.clear();
+		aListWidget->mLineIndex.clear();
+		aListWidget->mLinesSorted = true;
+		aListWidget->mLineIndexDirty = true;
 		aListWidget->mSelectIdx = -1;
 		aListWidget->mHiliteIdx = -1;
 				
@@ -346,7 +502,8 @@ void ListWidget::Draw(Graphics *g)
 				
 	aClipG.SetFont(mFont);
 		
-	int aFirstLine = (int) mPosition;
+	// Only the rows in view are touched, however long the list is
+	int aFirstLine = max(0, (int) mPosition);
 	int aLastLine = min((int) mLines.size()-1, (int) mPosition + (int) mPageSize + 1);
 		
 	int anItemHeight, anItemOffset;
@@ -378,7 +535,7 @@ void ListWidget::Draw(Graphics *g)
 		else
 			aClipG.SetColor(mLineColors[i]);
 
-		SexyString aString = mLines[i];
+		const SexyString& aString = mLines[i];
 		int aFontX;
 		switch (mJustify) 
 		{
@@ -9,6 +9,7 @@ namespace Sexy
 
 typedef std::vector<SexyString> SexyStringVector;
 typedef std::vector<Color> ColorVector;
+typedef std::map<SexyString, int> SexyStringToIntMap;
 
 class ScrollbarWidget;
 class ListListener;
@@ -57,7 +58,18 @@ public:
 	bool						mDrawSelectWhenHilited;
 	bool						mDoFingerWhenHilited;
 
+	// While mLines is in sexystrcmp order, alphabetical inserts and lookups
+	//  binary search it.  Otherwise lookups go through mLineIndex, which is
+	//  rebuilt the first time it's needed after the lines change.
+	bool						mLinesSorted;
+	SexyStringToIntMap			mLineIndex;
+	bool						mLineIndexDirty;
+
 	void						SetHilite(int theHiliteIdx, bool notifyListener = false);
+	void						LinesChanged(int theIdx);
+	void						CheckLinesSorted();
+	int							FindInsertIdx(const SexyString& theLine);
+	void						GetSortColumns(std::vector<ListWidget*>& theColumns);
 
 public:
 	ListWidget(int theId, Font *theFont, ListListener *theListListener);
@@ -60,7 +60,6 @@ using namespace Sexy;
 MTRand::MTRand(const std::string& theSerialData)
 {
 	SRand(theSerialData);
-	mti=MTRAND_N+1; /* mti==MTRAND_N+1 means mt[MTRAND_N] is not initialized */
 }
 
 MTRand::MTRand(unsigned long seed)    
@@ -89,9 +88,19 @@ void MTRand::SetRandAllowed(bool allowed)
 
 void MTRand::SRand(const std::string& theSerialData)
 {
-	if (theSerialData.size() == MTRAND_N*4)
+	if (theSerialData.size() == MTRAND_N*4 + 4)
 	{
+		// Exact state, including our position in mt
 		memcpy(mt, theSerialData.c_str(), MTRAND_N*4);
+		memcpy(&mti, theSerialData.c_str() + MTRAND_N*4, 4);
+		if ((mti < 0) || (mti > MTRAND_N))
+			mti = MTRAND_N;
+	}
+	else if (theSerialData.size() == MTRAND_N*4)
+	{
+		// Older data without mti, start on a fresh block
+		memcpy(mt, theSerialData.c_str(), MTRAND_N*4);
+		mti = MTRAND_N;
 	}
 	else
 		SRand(4357);
@@ -190,8 +199,9 @@ std::string MTRand::Serialize()
 {
 	std::string aString;
 
-	aString.resize(MTRAND_N*4);
+	aString.resize(MTRAND_N*4 + 4);
 	memcpy((char*) aString.c_str(), mt, MTRAND_N*4);
+	memcpy((char*) aString.c_str() + MTRAND_N*4, &mti, 4);
 
 	return aString;
 }
@@ -27,7 +27,7 @@ public:
 	float NextNoAssert(float range);
 	float Next( float range );
 
-	std::string Serialize();
+	std::string Serialize(); // mt and mti, so SRand on the result continues the same sequence
 
 	static void SetRandAllowed(bool allowed);
 };
@@ -7,6 +7,8 @@
 #include "Quantize.h"
 #include "PerfTimer.h"
 #include "SWTri.h"
+#include "TextureAtlas.h"
+#include "../ImageLib/PixelConvert.h"
 
 #include <math.h>
 
@@ -42,8 +44,13 @@ MemoryImage::MemoryImage(const MemoryImage& theMemoryImage) :
 	mIsVolatile(theMemoryImage.mIsVolatile),
 	mPurgeBits(theMemoryImage.mPurgeBits),
 	mWantPal(theMemoryImage.mWantPal),
+	mPremultipliedAlpha(theMemoryImage.mPremultipliedAlpha),
 	mD3DFlags(theMemoryImage.mD3DFlags),
+	mQuantizeFlags(theMemoryImage.mQuantizeFlags),
 	mBitsChangedCount(theMemoryImage.mBitsChangedCount),
+	mCelAlphaInfo(theMemoryImage.mCelAlphaInfo),
+	mCelAlphaCols(theMemoryImage.mCelAlphaCols),
+	mCelAlphaRows(theMemoryImage.mCelAlphaRows),
 	mD3DData(NULL)
 {
 	bool deleteBits = false;
@@ -53,7 +60,7 @@ MemoryImage::MemoryImage(const MemoryImage& theMemoryImage) :
 	if ((theMemoryImage.mBits == NULL) && (theMemoryImage.mColorTable == NULL))
 	{
 		// Must be a DDImage with only a DDSurface
-		aNonConstMemoryImage->GetBits();
+		aNonConstMemoryImage->GetRawBits();
 		deleteBits = true;
 	}
 
@@ -121,19 +128,26 @@ MemoryImage::MemoryImage(const MemoryImage& theMemoryImage) :
 	else
 		mRLAdditiveData = NULL;	
 
+	// Rebuilt from mBits when needed
+	mTiledBits = NULL;
+
 	mApp->AddMemoryImage(this);
 }
 
 MemoryImage::~MemoryImage()
 {	
+	// A pipelined frame may still be drawing from us
+	mApp->WaitForRenderThread();
 	mApp->RemoveMemoryImage(this);
 	
 	delete [] mBits;
 	delete [] mNativeAlphaData;	
 	delete [] mRLAlphaData;
 	delete [] mRLAdditiveData;
+	delete [] mTiledBits;
 	delete [] mColorIndices;
 	delete [] mColorTable;
+	delete mTrimImage;
 }
 
 void MemoryImage::Init()
@@ -145,6 +159,9 @@ void MemoryImage::Init()
 	mNativeAlphaData = NULL;
 	mRLAlphaData = NULL;
 	mRLAdditiveData = NULL;
+	mTiledBits = NULL;
+	mCelAlphaCols = 0;
+	mCelAlphaRows = 0;
 	mHasTrans = false;
 	mHasAlpha = false;	
 	mBitsChanged = false;
@@ -153,19 +170,33 @@ void MemoryImage::Init()
 
 	mD3DData = NULL;
 	mD3DFlags = 0;
+	mQuantizeFlags = 0;
 	mBitsChangedCount = 0;
 
 	mPurgeBits = false;
 	mWantPal = false;
+	mPremultipliedAlpha = false;
 
 	mApp->AddMemoryImage(this);
 }
 
 void MemoryImage::BitsChanged()
 {
+	mApp->WaitForRenderThread();
+
 	mBitsChanged = true;
 	mBitsChangedCount++;
 
+	// Our pixels no longer match the atlas page copy
+	if (mAtlas != NULL)
+		mAtlas->RemoveImage(this);
+
+	// Nor do the trimmed pieces.  Changed pixels went through GetBits, so mBits has
+	//  everything, and without mBits the image was just recreated
+	delete mTrimImage;
+	mTrimImage = NULL;
+	mTrimCels.clear();
+
 	delete [] mNativeAlphaData;
 	mNativeAlphaData = NULL;
 
@@ -175,6 +206,11 @@ void MemoryImage::BitsChanged()
 	delete [] mRLAdditiveData;
 	mRLAdditiveData = NULL;
 
+	delete [] mTiledBits;
+	mTiledBits = NULL;
+
+	mCelAlphaInfo.clear();
+
 	// Verify secret value at end to protect against overwrite
 	if (mBits != NULL)
 	{
@@ -196,7 +232,7 @@ void MemoryImage::NormalDrawLine(double theStartX, double theStartY, double theE
 	ulong aGRoundAdd = aGMask >> 1;
 	ulong aBRoundAdd = aBMask >> 1;
 	
-	DWORD *aSurface = GetBits();
+	DWORD *aSurface = GetRawBits();
 
 	if (true)//(mLockedSurfaceDesc.ddpfPixelFormat.dwRGBBitCount == 32)
 	{
@@ -491,7 +527,7 @@ void MemoryImage::AdditiveDrawLine(double theStartX, double theStartY, double th
 	ulong aBRoundAdd = aBMask >> 1;
 
 	uchar* aMaxTable = mApp->mAdd8BitMaxTable;
-	DWORD *aSurface = GetBits();
+	DWORD *aSurface = GetRawBits();
 	
 	if (true)//(mLockedSurfaceDesc.ddpfPixelFormat.dwRGBBitCount == 32)
 	{
@@ -692,7 +728,7 @@ void MemoryImage::DrawLine(double theStartX, double theStartY, double theEndX, d
 
 void MemoryImage::NormalDrawLineAA(double theStartX, double theStartY, double theEndX, double theEndY, const Color& theColor)
 {
-	ulong* aBits = GetBits();
+	ulong* aBits = GetRawBits();
 	ulong color = theColor.ToInt();
 
 	int aX0 = (int)theStartX, aX1 = (int)theEndX;
@@ -719,7 +755,27 @@ void MemoryImage::NormalDrawLineAA(double theStartX, double theStartY, double th
 		dxd = -dxd;
 	}
 
-	if (theColor.mAlpha != 255)
+	if (mPremultipliedAlpha)
+	{
+		// Coverage times the opaque color, plus dest times the rest, on all four channels
+		color |= 0xFF000000;
+
+		#define PIXEL_TYPE				ulong
+		#define CALC_WEIGHT_A(w)		(((w) * (theColor.mAlpha+1)) >> 8)
+		#define BLEND_PIXEL(p) \
+		{\
+			*(p) = ((((color & 0xFF00FF) * a + (dest & 0xFF00FF) * oma) >> 8) & 0xFF00FF) |\
+					((((color >> 8) & 0xFF00FF) * a + ((dest >> 8) & 0xFF00FF) * oma) & 0xFF00FF00);\
+		}
+		const int STRIDE = mWidth;
+
+		#include "GENERIC_DrawLineAA.inc"
+
+		#undef PIXEL_TYPE
+		#undef CALC_WEIGHT_A
+		#undef BLEND_PIXEL
+	}
+	else if (theColor.mAlpha != 255)
 	{
 		#define PIXEL_TYPE				ulong
 		#define CALC_WEIGHT_A(w)		(((w) * (theColor.mAlpha+1)) >> 8)
@@ -814,24 +870,17 @@ void MemoryImage::CommitBits()
 	
 	if ((mBitsChanged) && (!mForcedMode))
 	{			
+		mApp->WaitForRenderThread(this);
+
 		// Analyze 
 		if (mBits != NULL)
 		{
-			mHasTrans = false;
-			mHasAlpha = false;
-			
-			int aSize = mWidth*mHeight;
-			ulong* ptr = mBits;
-			
-			for (int i = 0; i < aSize; i++)
-			{
-				uchar anAlpha = (uchar) (*ptr++ >> 24);
+			int aFirst;
+			int aLast;
+			int aFlags = ImageLib::ScanAlpha(mBits, mWidth*mHeight, aFirst, aLast);
 
-				if (anAlpha == 0)
-					mHasTrans = true;
-				else if (anAlpha != 255)
-					mHasAlpha = true;
-			}
+			mHasTrans = (aFlags & ImageLib::AlphaScan_HasTrans) != 0;
+			mHasAlpha = (aFlags & ImageLib::AlphaScan_HasPartial) != 0;
 		}
 		else if (mColorTable != NULL)
 		{
@@ -876,76 +925,89 @@ void MemoryImage::SetVolatile(bool isVolatile)
 	mIsVolatile = isVolatile;
 }
 
+void MemoryImage::SetPremultipliedAlpha(bool premultiplied)
+{
+	if (premultiplied == mPremultipliedAlpha)
+		return;
+
+	// The pixels are converted in place
+	mApp->WaitForRenderThread(this);
+
+	if ((mBits == NULL) && (mColorTable == NULL))
+		GetRawBits(); // Recover while we can still tell how the native data is stored
+
+	if (mBits != NULL)
+	{
+		if (premultiplied)
+			ImageLib::PremultiplyAlpha(mBits, mBits, mWidth*mHeight);
+		else
+			ImageLib::UnpremultiplyAlpha(mBits, mBits, mWidth*mHeight);
+	}
+
+	if (mColorTable != NULL)
+	{
+		if (premultiplied)
+			ImageLib::PremultiplyAlpha(mColorTable, mColorTable, 256);
+		else
+			ImageLib::UnpremultiplyAlpha(mColorTable, mColorTable, 256);
+	}
+
+	mPremultipliedAlpha = premultiplied;
+
+	BitsChanged();
+}
+
+static bool IsARGB8888(const ImageLib::PixelPackFormat& theFormat)
+{
+	return (theFormat.mRedMask == 0xFF0000) && (theFormat.mGreenMask == 0x00FF00) && (theFormat.mBlueMask == 0x0000FF) &&
+		(theFormat.mRedShift == 16) && (theFormat.mGreenShift == 8) && (theFormat.mBlueShift == 0);
+}
+
 void* MemoryImage::GetNativeAlphaData(NativeDisplay *theDisplay)
 {
+	// The render thread may be building this very cache for the frame in flight
+	mApp->WaitForRenderThread(this);
+
 	if (mNativeAlphaData != NULL)
 		return mNativeAlphaData;
 
 	CommitBits();
 
-	const int rRightShift = 16 + (8-theDisplay->mRedBits);
-	const int gRightShift = 8 + (8-theDisplay->mGreenBits);
-	const int bRightShift = 0 + (8-theDisplay->mBlueBits);
-
-	const int rLeftShift = theDisplay->mRedShift;
-	const int gLeftShift = theDisplay->mGreenShift;
-	const int bLeftShift = theDisplay->mBlueShift;
-
-	const int rMask = theDisplay->mRedMask;
-	const int gMask = theDisplay->mGreenMask;
-	const int bMask = theDisplay->mBlueMask;
+	ImageLib::PixelPackFormat aFormat;
+	aFormat.mRedMask = theDisplay->mRedMask;
+	aFormat.mGreenMask = theDisplay->mGreenMask;
+	aFormat.mBlueMask = theDisplay->mBlueMask;
+	aFormat.mRedBits = theDisplay->mRedBits;
+	aFormat.mGreenBits = theDisplay->mGreenBits;
+	aFormat.mBlueBits = theDisplay->mBlueBits;
+	aFormat.mRedShift = theDisplay->mRedShift;
+	aFormat.mGreenShift = theDisplay->mGreenShift;
+	aFormat.mBlueShift = theDisplay->mBlueShift;
 
 	if (mColorTable == NULL)
 	{
-		ulong* aSrcPtr = GetBits();
-
-		ulong* anAlphaData = new ulong[mWidth*mHeight];	
+		// Premultiplied bits are already what a 32 bit display wants, so don't copy them.
+		//  PurgeBits hands the buffer over to mNativeAlphaData.
+		if ((mPremultipliedAlpha) && (IsARGB8888(aFormat)))
+			return GetRawBits();
 
-		ulong* aDestPtr = anAlphaData;
 		int aSize = mWidth*mHeight;
-		for (int i = 0; i < aSize; i++)
-		{
-			ulong val = *(aSrcPtr++);
-
-			int anAlpha = val >> 24;			
+		ulong* anAlphaData = new ulong[aSize];
 
-			ulong r = ((val & 0xFF0000) * (anAlpha+1)) >> 8;
-			ulong g = ((val & 0x00FF00) * (anAlpha+1)) >> 8;
-			ulong b = ((val & 0x0000FF) * (anAlpha+1)) >> 8;
-
-			*(aDestPtr++) =
-				(((r >> rRightShift) << rLeftShift) & rMask) |
-				(((g >> gRightShift) << gLeftShift) & gMask) |
-				(((b >> bRightShift) << bLeftShift) & bMask) |
-				(anAlpha << 24);
-		}
-		
+		if (mPremultipliedAlpha)
+			ImageLib::PackToNative(GetRawBits(), anAlphaData, aSize, aFormat);
+		else
+			ImageLib::PremultiplyToNative(GetRawBits(), anAlphaData, aSize, aFormat);
 		mNativeAlphaData = anAlphaData;	
 	}
 	else
 	{
-		ulong* aSrcPtr = mColorTable;		
-
 		ulong* anAlphaData = new ulong[256];
-		
-		for (int i = 0; i < 256; i++)
-		{
-			ulong val = *(aSrcPtr++);
-
-			int anAlpha = val >> 24;
-
-			ulong r = ((val & 0xFF0000) * (anAlpha+1)) >> 8;
-			ulong g = ((val & 0x00FF00) * (anAlpha+1)) >> 8;
-			ulong b = ((val & 0x0000FF) * (anAlpha+1)) >> 8;
 
-			anAlphaData[i] =
-				(((r >> rRightShift) << rLeftShift) & rMask) |
-				(((g >> gRightShift) << gLeftShift) & gMask) |
-				(((b >> bRightShift) << bLeftShift) & bMask) |
-				(anAlpha << 24);
-		}
-		
-		
+		if (mPremultipliedAlpha)
+			ImageLib::PackToNative(mColorTable, anAlphaData, 256, aFormat);
+		else
+			ImageLib::PremultiplyToNative(mColorTable, anAlphaData, 256, aFormat);
 		mNativeAlphaData = anAlphaData;	
 	}
 
@@ -953,8 +1015,42 @@ void* MemoryImage::GetNativeAlphaData(NativeDisplay *theDisplay)
 }
 
 
+// The same pixels as GetRawBits(), stored as 4x4 tiles of 16 consecutive pixels so a tile
+//  is one 64 byte cache line.  Pixel x,y is at (y>>2)*GetTiledPitch() + (x>>2)*16 +
+//  (y&3)*4 + (x&3).  Each row of tiles has one spare tile at the end, which keeps the row
+//  stride from being a power of two that maps every row to the same cache sets.  The
+//  software triangle rasterizer samples from it when a rotated texture would hit a new
+//  row every few pixels.
+ulong* MemoryImage::GetTiledBits()
+{
+	mApp->WaitForRenderThread(this);
+
+	if (mTiledBits == NULL)
+	{
+		ulong* aBits = GetRawBits();
+
+		int aTileRows = (mHeight+3)>>2;
+		int aPitch = GetTiledPitch();
+		mTiledBits = new ulong[aTileRows*aPitch + 16];
+
+		ulong* aTiles = (ulong*) (((size_t) mTiledBits + 63) & ~(size_t) 63);
+		memset(aTiles, 0, aTileRows*aPitch*sizeof(ulong));
+
+		for (int y = 0; y < mHeight; y++)
+		{
+			ulong* aDestRow = aTiles + (y>>2)*aPitch + (y&3)*4;
+			ulong* aSrcPtr = aBits + y*mWidth;
+			for (int x = 0; x < mWidth; x++)
+				aDestRow[(x>>2)*16 + (x&3)] = *(aSrcPtr++);
+		}
+	}
+
+	return (ulong*) (((size_t) mTiledBits + 63) & ~(size_t) 63);
+}
+
 uchar* MemoryImage::GetRLAlphaData()
 {
+	mApp->WaitForRenderThread(this);
 	CommitBits();
 
 	if (mRLAlphaData == NULL)
@@ -967,7 +1063,7 @@ uchar* MemoryImage::GetRLAlphaData()
 			if (mNativeAlphaData != NULL)
 				aSrcPtr = (ulong*) mNativeAlphaData;
 			else
-				aSrcPtr = GetBits();
+				aSrcPtr = GetRawBits();
 
 			#define NEXT_SRC_COLOR (*(aSrcPtr++))
 
@@ -993,6 +1089,8 @@ uchar* MemoryImage::GetRLAlphaData()
 
 uchar* MemoryImage::GetRLAdditiveData(NativeDisplay *theNative)
 {
+	mApp->WaitForRenderThread(this);
+
 	if (mRLAdditiveData == NULL)
 	{
 		if (mColorTable == NULL)
@@ -1112,8 +1210,26 @@ uchar* MemoryImage::GetRLAdditiveData(NativeDisplay *theNative)
 
 void MemoryImage::PurgeBits()
 {
+	mApp->WaitForRenderThread();
+
 	mPurgeBits = true;
 
+	if (mAtlasImage != NULL)
+	{
+		// Draws come from the atlas page, so there's nothing else to build
+		delete [] mBits;
+		mBits = NULL;
+		return;
+	}
+
+	if (mTrimImage != NULL)
+	{
+		// Unscaled draws come from the pieces, anything else rebuilds the bits on demand
+		delete [] mBits;
+		mBits = NULL;
+		return;
+	}
+
 	if (mApp->Is3DAccelerated())
 	{
 		// Due to potential D3D threading issues we have to defer the texture creation
@@ -1127,10 +1243,20 @@ void MemoryImage::PurgeBits()
 			return;
 		
 		GetNativeAlphaData(gSexyAppBase->mDDInterface);		
+
+		if ((mNativeAlphaData == NULL) && (mBits != NULL))
+		{
+			// Premultiplied bits served as the native data directly, keep them under that name
+			mNativeAlphaData = mBits;
+			mBits = NULL;
+		}
 	}		
 	
 	delete [] mBits;
 	mBits = NULL;
+
+	delete [] mTiledBits;
+	mTiledBits = NULL;
 	
 	if (mD3DData != NULL)
 	{
@@ -1145,7 +1271,7 @@ void MemoryImage::PurgeBits()
 void MemoryImage::DeleteSWBuffers()
 {
 	if ((mBits == NULL) && (mColorIndices == NULL))
-		GetBits();
+		GetRawBits();
 	
 	delete [] mNativeAlphaData;
 	mNativeAlphaData = NULL;
@@ -1155,6 +1281,9 @@ void MemoryImage::DeleteSWBuffers()
 
 	delete [] mRLAlphaData;
 	mRLAlphaData = NULL;
+
+	delete [] mTiledBits;
+	mTiledBits = NULL;
 }
 
 void MemoryImage::Delete3DBuffers()
@@ -1181,7 +1310,7 @@ void MemoryImage::ReInit()
 void MemoryImage::DeleteNativeData()
 {
 	if ((mBits == NULL) && (mColorIndices == NULL))
-		GetBits(); // We need to keep the bits around
+		GetRawBits(); // We need to keep the bits around
 	
 	delete [] mNativeAlphaData;
 	mNativeAlphaData = NULL;
@@ -1210,6 +1339,9 @@ void MemoryImage::SetBits(ulong* theBits, int theWidth, int theHeight, bool comm
 		memcpy(mBits, theBits, mWidth*mHeight*sizeof(ulong));
 		mBits[mWidth*mHeight] = MEMORYCHECK_ID;
 
+		if (mPremultipliedAlpha)
+			ImageLib::PremultiplyAlpha(mBits, mBits, mWidth*mHeight);
+
 		BitsChanged();
 		if (commitBits)
 			CommitBits();
@@ -1233,6 +1365,24 @@ void MemoryImage::Create(int theWidth, int theHeight)
 
 ulong* MemoryImage::GetBits()
 {
+	// Callers expect straight ARGB, so hand the pixels out in that mode
+	if (mPremultipliedAlpha)
+		SetPremultipliedAlpha(false);
+
+	return GetRawBits();
+}
+
+ulong* MemoryImage::GetRawBits()
+{
+	// Whoever asks may be about to write, or to expand or restore the bits in place
+	mApp->WaitForRenderThread(this);
+
+	if ((mBits == NULL) && (mAtlas != NULL))
+		mAtlas->RestoreBits(this);
+
+	if ((mBits == NULL) && (mTrimImage != NULL))
+		RestoreTrimmedBits();
+
 	if (mBits == NULL)
 	{
 		int aSize = mWidth*mHeight;
@@ -1254,6 +1404,33 @@ ulong* MemoryImage::GetBits()
 			delete [] mNativeAlphaData;
 			mNativeAlphaData = NULL;
 		}
+		else if ((mNativeAlphaData != NULL) && (mPremultipliedAlpha))
+		{
+			NativeDisplay* aDisplay = gSexyAppBase->mDDInterface;
+
+			const int rMask = aDisplay->mRedMask;
+			const int gMask = aDisplay->mGreenMask;
+			const int bMask = aDisplay->mBlueMask;
+
+			const int rLeftShift = aDisplay->mRedShift + (aDisplay->mRedBits);
+			const int gLeftShift = aDisplay->mGreenShift + (aDisplay->mGreenBits);
+			const int bLeftShift = aDisplay->mBlueShift + (aDisplay->mBlueBits);			
+
+			ulong* aDestPtr = mBits;
+			ulong* aSrcPtr = mNativeAlphaData;
+
+			// Only a repack, the native data is premultiplied just like mBits
+			for (int i = 0; i < aSize; i++)
+			{
+				ulong val = *(aSrcPtr++);
+
+				ulong r = ((val & rMask) << 8) >> rLeftShift;
+				ulong g = ((val & gMask) << 8) >> gLeftShift;
+				ulong b = ((val & bMask) << 8) >> bLeftShift;
+
+				*(aDestPtr++) = (r << 16) | (g << 8) | (b) | (val & 0xFF000000);
+			}
+		}
 		else if (mNativeAlphaData != NULL)
 		{
 			NativeDisplay* aDisplay = gSexyAppBase->mDDInterface;
@@ -1296,11 +1473,30 @@ void MemoryImage::FillRect(const Rect& theRect, const Color& theColor, int theDr
 {
 	ulong src = theColor.ToInt();
 
-	ulong* aBits = GetBits();
+	ulong* aBits = GetRawBits();
 
 	int oldAlpha = src >> 24;
 
-	if (oldAlpha == 0xFF)
+	if ((mPremultipliedAlpha) && (oldAlpha != 0xFF))
+	{
+		src = ImageLib::PremultiplyPixel(src);
+		int oma = 256 - oldAlpha;
+
+		for (int aRow = theRect.mY; aRow < theRect.mY+theRect.mHeight; aRow++)
+		{
+			ulong* aDestPixels = &aBits[aRow*mWidth+theRect.mX];
+
+			for (int i = 0; i < theRect.mWidth; i++)
+			{
+				ulong dest = *aDestPixels;
+
+				*(aDestPixels++) = src +
+					((((dest & 0xFF00FF) * oma) >> 8) & 0xFF00FF) +
+					((((dest >> 8) & 0xFF00FF) * oma) & 0xFF00FF00);
+			}
+		}
+	}
+	else if (oldAlpha == 0xFF)
 	{
 		for (int aRow = theRect.mY; aRow < theRect.mY+theRect.mHeight; aRow++)
 		{
@@ -1346,7 +1542,7 @@ void MemoryImage::FillRect(const Rect& theRect, const Color& theColor, int theDr
 
 void MemoryImage::ClearRect(const Rect& theRect)
 {
-	ulong* aBits = GetBits();
+	ulong* aBits = GetRawBits();
 	
 	for (int aRow = theRect.mY; aRow < theRect.mY+theRect.mHeight; aRow++)
 	{
@@ -1361,7 +1557,7 @@ void MemoryImage::ClearRect(const Rect& theRect)
 
 void MemoryImage::Clear()
 {
-	ulong* ptr = GetBits();
+	ulong* ptr = GetRawBits();
 	if (ptr != NULL)
 	{
 		for (int i = 0; i < mWidth*mHeight; i++)
@@ -1383,7 +1579,7 @@ void MemoryImage::AdditiveBlt(Image* theImage, int theX, int theY, const Rect& t
 	{
 		if (aSrcMemoryImage->mColorTable == NULL)
 		{			
-			ulong* aSrcBits = aSrcMemoryImage->GetBits();
+			ulong* aSrcBits = aSrcMemoryImage->GetRawBits();
 
 			#define NEXT_SRC_COLOR		(*(aSrcPtr++))
 			#define SRC_TYPE			ulong			
@@ -1411,7 +1607,7 @@ void MemoryImage::AdditiveBlt(Image* theImage, int theX, int theY, const Rect& t
 	}	
 }
 
-void MemoryImage::NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcRect, const Color& theColor)
+void MemoryImage::NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcRectOrig, const Color& theColor)
 {
 	theImage->mDrawn = true;
 
@@ -1419,30 +1615,104 @@ void MemoryImage::NormalBlt(Image* theImage, int theX, int theY, const Rect& the
 
 	if (aSrcMemoryImage != NULL)
 	{
-		if (aSrcMemoryImage->mColorTable == NULL)
+		Rect theSrcRect = theSrcRectOrig;
+		int aSrcAlphaType;
+		if (!aSrcMemoryImage->TrimToContent(theX, theY, theSrcRect, aSrcAlphaType))
+			return;
+
+		bool convertSrc = aSrcMemoryImage->mPremultipliedAlpha != mPremultipliedAlpha;
+
+		if ((aSrcAlphaType == CelAlpha_Opaque) && (!aSrcMemoryImage->mForcedMode) && (theColor == Color::White) &&
+			(aSrcMemoryImage->mColorTable == NULL) && (aSrcMemoryImage != this))
+		{
+			// Opaque pixels are the same premultiplied or not, so the rows just get copied
+			ulong* aSrcPixelsRow = ((ulong*) aSrcMemoryImage->GetRawBits()) + (theSrcRect.mY * theImage->mWidth) + theSrcRect.mX;
+			ulong* aDestPixelsRow = ((ulong*) GetRawBits()) + (theY * mWidth) + theX;
+
+			for (int y = 0; y < theSrcRect.mHeight; y++)
+			{
+				memcpy(aDestPixelsRow, aSrcPixelsRow, theSrcRect.mWidth*sizeof(ulong));
+
+				aDestPixelsRow += mWidth;
+				aSrcPixelsRow += theImage->mWidth;
+			}
+		}
+		else if (aSrcMemoryImage->mColorTable == NULL)
 		{			
-			ulong* aSrcPixelsRow = ((ulong*) aSrcMemoryImage->GetBits()) + (theSrcRect.mY * theImage->mWidth) + theSrcRect.mX;
+			ulong* aSrcPixelsRow = ((ulong*) aSrcMemoryImage->GetRawBits()) + (theSrcRect.mY * theImage->mWidth) + theSrcRect.mX;
 
-			#define NEXT_SRC_COLOR		(*(aSrcPtr++))
-			#define READ_SRC_COLOR		(*(aSrcPtr))
-			#define EACH_ROW			ulong* aSrcPtr = aSrcPixelsRow
+			if (!convertSrc)
+			{
+				#define NEXT_SRC_COLOR		(*(aSrcPtr++))
+				#define READ_SRC_COLOR		(*(aSrcPtr))
+				#define EACH_ROW			ulong* aSrcPtr = aSrcPixelsRow
+
+				if (mPremultipliedAlpha)
+				{
+					#include "MI_NormalBlt_Premultiplied.inc"
+				}
+				else
+				{
+					#include "MI_NormalBlt.inc"
+				}
+
+				#undef NEXT_SRC_COLOR	
+				#undef READ_SRC_COLOR	
+				#undef EACH_ROW			
+			}
+			else if (mPremultipliedAlpha)
+			{
+				#define NEXT_SRC_COLOR		(ImageLib::PremultiplyPixel(*(aSrcPtr++)))
+				#define READ_SRC_COLOR		(ImageLib::PremultiplyPixel(*(aSrcPtr)))
+				#define EACH_ROW			ulong* aSrcPtr = aSrcPixelsRow
 
-			#include "MI_NormalBlt.inc"
+				#include "MI_NormalBlt_Premultiplied.inc"
 
-			#undef NEXT_SRC_COLOR	
-			#undef READ_SRC_COLOR	
-			#undef EACH_ROW			
+				#undef NEXT_SRC_COLOR	
+				#undef READ_SRC_COLOR	
+				#undef EACH_ROW			
+			}
+			else
+			{
+				#define NEXT_SRC_COLOR		(ImageLib::UnpremultiplyPixel(*(aSrcPtr++)))
+				#define READ_SRC_COLOR		(ImageLib::UnpremultiplyPixel(*(aSrcPtr)))
+				#define EACH_ROW			ulong* aSrcPtr = aSrcPixelsRow
+
+				#include "MI_NormalBlt.inc"
+
+				#undef NEXT_SRC_COLOR	
+				#undef READ_SRC_COLOR	
+				#undef EACH_ROW			
+			}
 		}
 		else
 		{			
 			ulong* aColorTable = aSrcMemoryImage->mColorTable;
 			uchar* aSrcPixelsRow = aSrcMemoryImage->mColorIndices + (theSrcRect.mY * theImage->mWidth) + theSrcRect.mX;
 
+			ulong aConvertedTable[256];
+			if (convertSrc)
+			{
+				// Cheaper to convert the palette once than every pixel
+				if (mPremultipliedAlpha)
+					ImageLib::PremultiplyAlpha(aColorTable, aConvertedTable, 256);
+				else
+					ImageLib::UnpremultiplyAlpha(aColorTable, aConvertedTable, 256);
+				aColorTable = aConvertedTable;
+			}
+
 			#define NEXT_SRC_COLOR		(aColorTable[*(aSrcPtr++)])
 			#define READ_SRC_COLOR		(aColorTable[*(aSrcPtr)])
 			#define EACH_ROW			uchar* aSrcPtr = aSrcPixelsRow
 
-			#include "MI_NormalBlt.inc"
+			if (mPremultipliedAlpha)
+			{
+				#include "MI_NormalBlt_Premultiplied.inc"
+			}
+			else
+			{
+				#include "MI_NormalBlt.inc"
+			}
 
 			#undef NEXT_SRC_COLOR	
 			#undef READ_SRC_COLOR	
@@ -1582,20 +1852,49 @@ void MemoryImage::BltRotated(Image* theImage, float theX, float theY, const Rect
 
 	if (aMemoryImage != NULL)
 	{	
-		if (aMemoryImage->mColorTable == NULL)
+		// The filter weights each texel by its own alpha, so it always reads straight
+		//  colors and produces premultiplied sums
+		if ((aMemoryImage->mColorTable == NULL) && (aMemoryImage->mPremultipliedAlpha))
+		{
+			ulong* aSrcBits = aMemoryImage->GetRawBits() + theSrcRect.mX + theSrcRect.mY*theSrcRect.mWidth;			
+
+			#define SRC_TYPE ulong
+			#define READ_COLOR(ptr) (ImageLib::UnpremultiplyPixel(*(ptr)))
+
+			if (theDrawMode != Graphics::DRAWMODE_NORMAL)
+			{
+				#include "MI_BltRotated_Additive.inc"
+			}
+			else if (mPremultipliedAlpha)
+			{
+				#include "MI_BltRotated_Premultiplied.inc"
+			}
+			else
+			{
+				#include "MI_BltRotated.inc"
+			}
+
+			#undef SRC_TYPE
+			#undef READ_COLOR
+		}
+		else if (aMemoryImage->mColorTable == NULL)
 		{			
-			ulong* aSrcBits = aMemoryImage->GetBits() + theSrcRect.mX + theSrcRect.mY*theSrcRect.mWidth;			
+			ulong* aSrcBits = aMemoryImage->GetRawBits() + theSrcRect.mX + theSrcRect.mY*theSrcRect.mWidth;			
 
 			#define SRC_TYPE ulong
 			#define READ_COLOR(ptr) (*(ptr))
 
-			if (theDrawMode == Graphics::DRAWMODE_NORMAL)
+			if (theDrawMode != Graphics::DRAWMODE_NORMAL)
 			{
-				#include "MI_BltRotated.inc"
+				#include "MI_BltRotated_Additive.inc"
+			}
+			else if (mPremultipliedAlpha)
+			{
+				#include "MI_BltRotated_Premultiplied.inc"
 			}
 			else
 			{
-				#include "MI_BltRotated_Additive.inc"
+				#include "MI_BltRotated.inc"
 			}
 
 			#undef SRC_TYPE
@@ -1606,16 +1905,27 @@ void MemoryImage::BltRotated(Image* theImage, float theX, float theY, const Rect
 			ulong* aColorTable = aMemoryImage->mColorTable;
 			uchar* aSrcBits = aMemoryImage->mColorIndices + theSrcRect.mX + theSrcRect.mY*theSrcRect.mWidth;
 
+			ulong aStraightTable[256];
+			if (aMemoryImage->mPremultipliedAlpha)
+			{
+				ImageLib::UnpremultiplyAlpha(aColorTable, aStraightTable, 256);
+				aColorTable = aStraightTable;
+			}
+
 			#define SRC_TYPE uchar
 			#define READ_COLOR(ptr) (aColorTable[*(ptr)])
 
-			if (theDrawMode == Graphics::DRAWMODE_NORMAL)
+			if (theDrawMode != Graphics::DRAWMODE_NORMAL)
 			{
-				#include "MI_BltRotated.inc"
+				#include "MI_BltRotated_Additive.inc"
+			}
+			else if (mPremultipliedAlpha)
+			{
+				#include "MI_BltRotated_Premultiplied.inc"
 			}
 			else
 			{
-				#include "MI_BltRotated_Additive.inc"
+				#include "MI_BltRotated.inc"
 			}
 
 			#undef SRC_TYPE
@@ -1633,15 +1943,42 @@ void MemoryImage::SlowStretchBlt(Image* theImage, const Rect& theDestRect, const
 	// This thing was a pain to write.  I bet i could have gotten something just as good
 	// from some Graphics Gems book.	
 	
-	ulong* aDestEnd = GetBits() + (mWidth * mHeight);
+	ulong* aDestEnd = GetRawBits() + (mWidth * mHeight);
 
 	MemoryImage* aSrcMemoryImage = dynamic_cast<MemoryImage*>(theImage);
 
 	if (aSrcMemoryImage != NULL)
 	{
-		if (aSrcMemoryImage->mColorTable == NULL)
+		// The filter works on whatever the dest stores, so read the source that way
+		bool convertSrc = aSrcMemoryImage->mPremultipliedAlpha != mPremultipliedAlpha;
+
+		if ((aSrcMemoryImage->mColorTable == NULL) && (convertSrc) && (mPremultipliedAlpha))
+		{
+			ulong* aSrcBits = aSrcMemoryImage->GetRawBits();
+
+			#define SRC_TYPE ulong
+			#define READ_COLOR(ptr) (ImageLib::PremultiplyPixel(*(ptr)))
+
+			#include "MI_SlowStretchBlt.inc"
+
+			#undef SRC_TYPE
+			#undef READ_COLOR
+		}
+		else if ((aSrcMemoryImage->mColorTable == NULL) && (convertSrc))
+		{
+			ulong* aSrcBits = aSrcMemoryImage->GetRawBits();
+
+			#define SRC_TYPE ulong
+			#define READ_COLOR(ptr) (ImageLib::UnpremultiplyPixel(*(ptr)))
+
+			#include "MI_SlowStretchBlt.inc"
+
+			#undef SRC_TYPE
+			#undef READ_COLOR
+		}
+		else if (aSrcMemoryImage->mColorTable == NULL)
 		{			
-			ulong* aSrcBits = aSrcMemoryImage->GetBits();
+			ulong* aSrcBits = aSrcMemoryImage->GetRawBits();
 
 			#define SRC_TYPE ulong
 			#define READ_COLOR(ptr) (*(ptr))
@@ -1656,6 +1993,16 @@ void MemoryImage::SlowStretchBlt(Image* theImage, const Rect& theDestRect, const
 			ulong* aColorTable = aSrcMemoryImage->mColorTable;
 			uchar* aSrcBits = aSrcMemoryImage->mColorIndices;
 
+			ulong aConvertedTable[256];
+			if (convertSrc)
+			{
+				if (mPremultipliedAlpha)
+					ImageLib::PremultiplyAlpha(aColorTable, aConvertedTable, 256);
+				else
+					ImageLib::UnpremultiplyAlpha(aColorTable, aConvertedTable, 256);
+				aColorTable = aConvertedTable;
+			}
+
 			#define SRC_TYPE uchar
 			#define READ_COLOR(ptr) (aColorTable[*(ptr)])
 
@@ -1678,8 +2025,8 @@ void MemoryImage::FastStretchBlt(Image* theImage, const Rect& theDestRect, const
 
 	if (aSrcMemoryImage != NULL)
 	{
-		ulong* aDestPixelsRow = ((ulong*) GetBits()) + (theDestRect.mY * mWidth) + theDestRect.mX;
-		ulong* aSrcPixelsRow = (ulong*) aSrcMemoryImage->GetBits();;
+		ulong* aDestPixelsRow = ((ulong*) GetRawBits()) + (theDestRect.mY * mWidth) + theDestRect.mX;
+		ulong* aSrcPixelsRow = (ulong*) aSrcMemoryImage->GetRawBits();;
 		
 		double aSrcY = theSrcRect.mY;
 
@@ -1705,8 +2052,22 @@ void MemoryImage::FastStretchBlt(Image* theImage, const Rect& theDestRect, const
 					
 					int a = src >> 24;	
 					
-					if (a != 0)
+					if ((a != 0) && (mPremultipliedAlpha))
+					{
+						if (!aSrcMemoryImage->mPremultipliedAlpha)
+							src = ImageLib::PremultiplyPixel(src);
+
+						int oma = 256 - a;
+
+						*(aDestPixels++) = src +
+							((((dest & 0xFF00FF) * oma) >> 8) & 0xFF00FF) +
+							((((dest >> 8) & 0xFF00FF) * oma) & 0xFF00FF00);
+					}
+					else if (a != 0)
 					{
+						if (aSrcMemoryImage->mPremultipliedAlpha)
+							src = ImageLib::UnpremultiplyPixel(src);
+
 						int aDestAlpha = dest >> 24;
 						int aNewDestAlpha = aDestAlpha + ((255 - aDestAlpha) * a) / 255;
 											
@@ -1751,7 +2112,7 @@ void MemoryImage::StretchBlt(Image* theImage, const Rect& theDestRect, const Rec
 		SlowStretchBlt(theImage, aDestRect, aSrcRect, theColor, theDrawMode);
 }
 
-void MemoryImage::BltMatrixHelper(Image* theImage, float x, float y, const SexyMatrix3 &theMatrix, const Rect& theClipRect, const Color& theColor, int theDrawMode, const Rect &theSrcRect, void *theSurface, int theBytePitch, int thePixelFormat, bool blend)
+void MemoryImage::BltMatrixHelper(Image* theImage, float x, float y, const SexyMatrix3 &theMatrix, const Rect& theClipRect, const Color& theColor, int theDrawMode, const Rect &theSrcRect, void *theSurface, int theBytePitch, int thePixelFormat, bool blend, bool premultipliedSurface)
 {
 	MemoryImage *anImage = dynamic_cast<MemoryImage*>(theImage);
 	if (anImage==NULL)
@@ -1781,24 +2142,24 @@ void MemoryImage::BltMatrixHelper(Image* theImage, float x, float y, const SexyM
 		aVerts[i].mY = v.y + y - 0.5f;
 	}
 
-	SWHelper::SWDrawShape(aVerts, 4, anImage, theColor, theDrawMode, theClipRect, theSurface, theBytePitch, thePixelFormat, blend,false);
+	SWHelper::SWDrawShape(aVerts, 4, anImage, theColor, theDrawMode, theClipRect, theSurface, theBytePitch, thePixelFormat, blend,false, premultipliedSurface);
 }
 
 void MemoryImage::BltMatrix(Image* theImage, float x, float y, const SexyMatrix3 &theMatrix, const Rect& theClipRect, const Color& theColor, int theDrawMode, const Rect &theSrcRect, bool blend)
 {
 	theImage->mDrawn = true;
 
-	DWORD *aSurface = GetBits();
+	DWORD *aSurface = GetRawBits();
 	int aPitch = mWidth*4;
 	int aFormat = 0x8888;
 	if (mForcedMode && !mHasAlpha && !mHasTrans)
 		aFormat = 0x888;
 
-	BltMatrixHelper(theImage,x,y,theMatrix,theClipRect,theColor,theDrawMode,theSrcRect,aSurface,aPitch,aFormat,blend);
+	BltMatrixHelper(theImage,x,y,theMatrix,theClipRect,theColor,theDrawMode,theSrcRect,aSurface,aPitch,aFormat,blend,mPremultipliedAlpha);
 	BitsChanged();
 }
 
-void MemoryImage::BltTrianglesTexHelper(Image *theTexture, const TriVertex theVertices[][3], int theNumTriangles, const Rect &theClipRect, const Color &theColor, int theDrawMode, void *theSurface, int theBytePitch, int thePixelFormat, float tx, float ty, bool blend)
+void MemoryImage::BltTrianglesTexHelper(Image *theTexture, const TriVertex theVertices[][3], int theNumTriangles, const Rect &theClipRect, const Color &theColor, int theDrawMode, void *theSurface, int theBytePitch, int thePixelFormat, float tx, float ty, bool blend, bool premultipliedSurface)
 {
 	MemoryImage *anImage = dynamic_cast<MemoryImage*>(theTexture);
 //	if (anImage==NULL)
@@ -1822,14 +2183,14 @@ void MemoryImage::BltTrianglesTexHelper(Image *theTexture, const TriVertex theVe
 				vertexColor = true;
 		}
 
-		SWHelper::SWDrawShape(aVerts, 3, anImage, theColor, theDrawMode, theClipRect, theSurface, theBytePitch, thePixelFormat, blend, vertexColor);
+		SWHelper::SWDrawShape(aVerts, 3, anImage, theColor, theDrawMode, theClipRect, theSurface, theBytePitch, thePixelFormat, blend, vertexColor, premultipliedSurface);
 	}
 
 }
 
 void MemoryImage::FillScanLinesWithCoverage(Span* theSpans, int theSpanCount, const Color& theColor, int theDrawMode, const BYTE* theCoverage, int theCoverX, int theCoverY, int theCoverWidth, int theCoverHeight)
 {
-	ulong* theBits = GetBits();
+	ulong* theBits = GetRawBits();
 	ulong src = theColor.ToInt();
 	for (int i = 0; i < theSpanCount; ++i)
 	{
@@ -1839,6 +2200,24 @@ void MemoryImage::FillScanLinesWithCoverage(Span* theSpans, int theSpanCount, co
 
 		ulong* aDestPixels = &theBits[aSpan->mY*mWidth + aSpan->mX];
 		const BYTE* aCoverBits = &theCoverage[y*theCoverWidth+x];
+
+		if (mPremultipliedAlpha)
+		{
+			ulong aColor = src | 0xFF000000;
+
+			for (int w = 0; w < aSpan->mWidth; ++w)
+			{
+				int cover = *aCoverBits++ + 1;
+				int a = (cover * theColor.mAlpha) >> 8;
+				int oma = 256 - a;
+				ulong dest = *aDestPixels;
+
+				*(aDestPixels++) = ((((aColor & 0xFF00FF) * a + (dest & 0xFF00FF) * oma) >> 8) & 0xFF00FF) |
+					((((aColor >> 8) & 0xFF00FF) * a + ((dest >> 8) & 0xFF00FF) * oma) & 0xFF00FF00);
+			}
+			continue;
+		}
+
 		for (int w = 0; w < aSpan->mWidth; ++w)
 		{
 			int cover = *aCoverBits++ + 1;
@@ -1867,17 +2246,366 @@ void MemoryImage::BltTrianglesTex(Image *theTexture, const TriVertex theVertices
 {
 	theTexture->mDrawn = true;
 
-	DWORD *aSurface = GetBits();
+	DWORD *aSurface = GetRawBits();
 
 	int aPitch = mWidth*4;
 	int aFormat = 0x8888;
 	if (mForcedMode && !mHasAlpha && !mHasTrans)
 		aFormat = 0x888;
 
-	BltTrianglesTexHelper(theTexture,theVertices,theNumTriangles,theClipRect,theColor,theDrawMode,aSurface,aPitch,aFormat,tx,ty,blend);
+	BltTrianglesTexHelper(theTexture,theVertices,theNumTriangles,theClipRect,theColor,theDrawMode,aSurface,aPitch,aFormat,tx,ty,blend,mPremultipliedAlpha);
 	BitsChanged();
 }
 
+void MemoryImage::AnalyzeCels()
+{
+	mCelAlphaInfo.clear();
+	mCelAlphaCols = 0;
+	mCelAlphaRows = 0;
+
+	int aCelWidth = GetCelWidth();
+	int aCelHeight = GetCelHeight();
+
+	if ((aCelWidth <= 0) || (aCelHeight <= 0))
+		return;
+
+	if ((mBits == NULL) && (mColorIndices == NULL))
+		return;
+
+	// Palletized images get each cel row looked up into here first
+	std::vector<ulong> aRowBuffer;
+	if (mBits == NULL)
+		aRowBuffer.resize(aCelWidth);
+
+	mCelAlphaInfo.resize(mNumCols*mNumRows);
+	mCelAlphaCols = mNumCols;
+	mCelAlphaRows = mNumRows;
+
+	for (int aRow = 0; aRow < mNumRows; aRow++)
+	{
+		for (int aCol = 0; aCol < mNumCols; aCol++)
+		{
+			int aFlags = 0;
+			int aLeft = aCelWidth;
+			int aRight = -1;
+			int aTop = -1;
+			int aBottom = -1;
+
+			for (int y = 0; y < aCelHeight; y++)
+			{
+				int anOffset = (aRow*aCelHeight + y)*mWidth + aCol*aCelWidth;
+
+				const ulong* aPixels;
+				if (mBits != NULL)
+					aPixels = mBits + anOffset;
+				else
+				{
+					const uchar* anIndices = mColorIndices + anOffset;
+					for (int x = 0; x < aCelWidth; x++)
+						aRowBuffer[x] = mColorTable[anIndices[x]];
+					aPixels = &aRowBuffer[0];
+				}
+
+				int aFirst;
+				int aLast;
+				aFlags |= ImageLib::ScanAlpha(aPixels, aCelWidth, aFirst, aLast);
+
+				if (aFirst >= 0)
+				{
+					if (aTop < 0)
+						aTop = y;
+					aBottom = y;
+					aLeft = min(aLeft, aFirst);
+					aRight = max(aRight, aLast);
+				}
+			}
+
+			CelAlphaInfo& anInfo = mCelAlphaInfo[aRow*mNumCols + aCol];
+
+			if (aFlags & ImageLib::AlphaScan_HasPartial)
+				anInfo.mAlphaType = CelAlpha_Full;
+			else if (aFlags & ImageLib::AlphaScan_HasTrans)
+				anInfo.mAlphaType = CelAlpha_Binary;
+			else
+				anInfo.mAlphaType = CelAlpha_Opaque;
+
+			if (aTop < 0)
+				anInfo.mContentRect = Rect(0, 0, 0, 0);
+			else
+				anInfo.mContentRect = Rect(aLeft, aTop, aRight - aLeft + 1, aBottom - aTop + 1);
+		}
+	}
+}
+
+const CelAlphaInfo* MemoryImage::GetCelAlphaInfo(int theCol, int theRow)
+{
+	// The analysis is only good for the grid it was done with
+	if ((mCelAlphaInfo.empty()) || (mCelAlphaCols != mNumCols) || (mCelAlphaRows != mNumRows))
+		return NULL;
+
+	if ((theCol < 0) || (theCol >= mCelAlphaCols) || (theRow < 0) || (theRow >= mCelAlphaRows))
+		return NULL;
+
+	return &mCelAlphaInfo[theRow*mCelAlphaCols + theCol];
+}
+
+// Narrows a blit of theSrcRect at theX, theY down to the visible pixels of the cel it reads
+//  from.  Returns false when there's nothing left to draw.  theAlphaType is what the source
+//  rect holds, falling back on mHasTrans/mHasAlpha when it isn't inside one analyzed cel.
+bool MemoryImage::TrimToContent(int& theX, int& theY, Rect& theSrcRect, int& theAlphaType)
+{
+	CommitBits();
+
+	if (mHasAlpha)
+		theAlphaType = CelAlpha_Full;
+	else if (mHasTrans)
+		theAlphaType = CelAlpha_Binary;
+	else
+		theAlphaType = CelAlpha_Opaque;
+
+	// A forced mode means the pixels shouldn't be looked at
+	if ((mForcedMode) || (theSrcRect.mWidth <= 0) || (theSrcRect.mHeight <= 0))
+		return true;
+
+	int aCelWidth = GetCelWidth();
+	int aCelHeight = GetCelHeight();
+	if ((aCelWidth <= 0) || (aCelHeight <= 0))
+		return true;
+
+	int aCol = theSrcRect.mX / aCelWidth;
+	int aRow = theSrcRect.mY / aCelHeight;
+	const CelAlphaInfo* anInfo = GetCelAlphaInfo(aCol, aRow);
+	if (anInfo == NULL)
+		return true;
+
+	// Source rects reaching into a neighboring cel keep the image wide flags
+	if ((theSrcRect.mX + theSrcRect.mWidth > (aCol+1)*aCelWidth) || (theSrcRect.mY + theSrcRect.mHeight > (aRow+1)*aCelHeight))
+		return true;
+
+	Rect aContentRect = anInfo->mContentRect;
+	aContentRect.Offset(aCol*aCelWidth, aRow*aCelHeight);
+
+	Rect aTrimmedRect = theSrcRect.Intersection(aContentRect);
+	if ((aTrimmedRect.mWidth <= 0) || (aTrimmedRect.mHeight <= 0))
+		return false;
+
+	theX += aTrimmedRect.mX - theSrcRect.mX;
+	theY += aTrimmedRect.mY - theSrcRect.mY;
+	theSrcRect = aTrimmedRect;
+	theAlphaType = anInfo->mAlphaType;
+
+	return true;
+}
+
+// Shelf packs the visible pixels of each cel (from AnalyzeCels) into mTrimImage, in cel
+//  order, keeping the logical size and grid so GetCelRect and every draw stay the same.
+bool MemoryImage::TrimCels()
+{
+	if ((mTrimImage != NULL) || (mAtlasImage != NULL) || (mIsVolatile) || (mForcedMode))
+		return false;
+
+	CommitBits();
+
+	// Pixels living only in a surface or in native data aren't looked at here
+	if ((mBits == NULL) && (mColorIndices == NULL))
+		return false;
+
+	if (GetCelAlphaInfo(0, 0) == NULL)
+		AnalyzeCels();
+	if (GetCelAlphaInfo(0, 0) == NULL)
+		return false;
+
+	int aCelWidth = GetCelWidth();
+	int aCelHeight = GetCelHeight();
+
+	TrimCelVector aTrimCels(mNumCols*mNumRows);
+	int aShelfX = 0;
+	int aShelfY = 0;
+	int aShelfHeight = 0;
+	int aTrimWidth = 1;
+
+	for (int aRow = 0; aRow < mNumRows; aRow++)
+	{
+		for (int aCol = 0; aCol < mNumCols; aCol++)
+		{
+			TrimCel& aCel = aTrimCels[aRow*mNumCols + aCol];
+			aCel.mRect = GetCelAlphaInfo(aCol, aRow)->mContentRect;
+			aCel.mRect.Offset(aCol*aCelWidth, aRow*aCelHeight);
+			aCel.mTrimX = 0;
+			aCel.mTrimY = 0;
+
+			if ((aCel.mRect.mWidth <= 0) || (aCel.mRect.mHeight <= 0))
+				continue;
+
+			if (aShelfX + aCel.mRect.mWidth > mWidth)
+			{
+				aShelfY += aShelfHeight;
+				aShelfX = 0;
+				aShelfHeight = 0;
+			}
+
+			aCel.mTrimX = aShelfX;
+			aCel.mTrimY = aShelfY;
+			aShelfX += aCel.mRect.mWidth;
+			aShelfHeight = max(aShelfHeight, aCel.mRect.mHeight);
+			aTrimWidth = max(aTrimWidth, aShelfX);
+		}
+	}
+
+	int aTrimHeight = max(aShelfY + aShelfHeight, 1);
+	if (aTrimWidth*aTrimHeight*4 > mWidth*mHeight*3)
+		return false;
+
+	// Everything cropped, including whatever lies outside the cel grid, has to come back
+	//  as the same invisible value
+	ulong aFill = 0;
+	bool haveFill = false;
+	for (int y = 0; y < mHeight; y++)
+	{
+		int aRow = y / aCelHeight;
+
+		for (int x = 0; x < mWidth; x++)
+		{
+			int aCol = x / aCelWidth;
+			if ((aRow < mNumRows) && (aCol < mNumCols))
+			{
+				const Rect& aRect = aTrimCels[aRow*mNumCols + aCol].mRect;
+				if (aRect.Contains(x, y))
+				{
+					x = aRect.mX + aRect.mWidth - 1;
+					continue;
+				}
+			}
+
+			int anOffset = y*mWidth + x;
+			ulong aPixel = (mBits != NULL) ? mBits[anOffset] : mColorTable[mColorIndices[anOffset]];
+
+			if (!haveFill)
+			{
+				if ((aPixel & 0xFF000000) != 0)
+					return false;
+				aFill = aPixel;
+				haveFill = true;
+			}
+			else if (aPixel != aFill)
+				return false;
+		}
+	}
+
+	MemoryImage* aTrimImage = new MemoryImage(mApp);
+	aTrimImage->Create(aTrimWidth, aTrimHeight);
+	ulong* aTrimBits = aTrimImage->GetRawBits();
+	memset(aTrimBits, 0, aTrimWidth*aTrimHeight*sizeof(ulong));
+
+	for (int i = 0; i < (int) aTrimCels.size(); i++)
+	{
+		const TrimCel& aCel = aTrimCels[i];
+
+		for (int y = 0; y < aCel.mRect.mHeight; y++)
+		{
+			ulong* aDest = aTrimBits + (aCel.mTrimY + y)*aTrimWidth + aCel.mTrimX;
+			int anOffset = (aCel.mRect.mY + y)*mWidth + aCel.mRect.mX;
+
+			if (mBits != NULL)
+				memcpy(aDest, mBits + anOffset, aCel.mRect.mWidth*sizeof(ulong));
+			else
+			{
+				for (int x = 0; x < aCel.mRect.mWidth; x++)
+					aDest[x] = mColorTable[mColorIndices[anOffset + x]];
+			}
+		}
+	}
+
+	// The pixels were copied as they're stored
+	aTrimImage->mPremultipliedAlpha = mPremultipliedAlpha;
+	aTrimImage->mD3DFlags = mD3DFlags;
+	aTrimImage->mQuantizeFlags = mQuantizeFlags;
+	aTrimImage->BitsChanged();
+	aTrimImage->CommitBits();
+
+	if (mColorTable != NULL)
+		aTrimImage->Palletize();
+
+	mTrimImage = aTrimImage;
+	mTrimCels.swap(aTrimCels);
+	mTrimFill = aFill;
+
+	// mHasTrans/mHasAlpha and the cel analysis still describe the full image
+	delete [] mBits;
+	mBits = NULL;
+
+	delete [] mColorIndices;
+	mColorIndices = NULL;
+
+	delete [] mColorTable;
+	mColorTable = NULL;
+
+	delete [] mNativeAlphaData;
+	mNativeAlphaData = NULL;
+
+	delete [] mRLAlphaData;
+	mRLAlphaData = NULL;
+
+	delete [] mRLAdditiveData;
+	mRLAdditiveData = NULL;
+
+	delete [] mTiledBits;
+	mTiledBits = NULL;
+
+	return true;
+}
+
+void MemoryImage::UntrimCels()
+{
+	if (mTrimImage == NULL)
+		return;
+
+	RestoreTrimmedBits();
+
+	delete mTrimImage;
+	mTrimImage = NULL;
+	mTrimCels.clear();
+}
+
+void MemoryImage::RestoreTrimmedBits()
+{
+	if ((mBits != NULL) || (mTrimImage == NULL))
+		return;
+
+	// Read the pieces as they're stored rather than expanding the trim image's palette
+	MemoryImage* aTrimImage = mTrimImage;
+	mApp->WaitForRenderThread(aTrimImage);
+	if ((aTrimImage->mBits == NULL) && (aTrimImage->mColorIndices == NULL))
+		aTrimImage->GetRawBits();
+
+	int aSize = mWidth*mHeight;
+
+	mBits = new ulong[aSize+1];
+	mBits[aSize] = MEMORYCHECK_ID;
+
+	for (int i = 0; i < aSize; i++)
+		mBits[i] = mTrimFill;
+
+	for (int i = 0; i < (int) mTrimCels.size(); i++)
+	{
+		const TrimCel& aCel = mTrimCels[i];
+
+		for (int y = 0; y < aCel.mRect.mHeight; y++)
+		{
+			ulong* aDest = mBits + (aCel.mRect.mY + y)*mWidth + aCel.mRect.mX;
+			int anOffset = (aCel.mTrimY + y)*aTrimImage->mWidth + aCel.mTrimX;
+
+			if (aTrimImage->mBits != NULL)
+				memcpy(aDest, aTrimImage->mBits + anOffset, aCel.mRect.mWidth*sizeof(ulong));
+			else
+			{
+				for (int x = 0; x < aCel.mRect.mWidth; x++)
+					aDest[x] = aTrimImage->mColorTable[aTrimImage->mColorIndices[anOffset + x]];
+			}
+		}
+	}
+}
+
 bool MemoryImage::Palletize()
 {
 	CommitBits();
@@ -1885,7 +2613,7 @@ bool MemoryImage::Palletize()
 	if (mColorTable != NULL)
 		return true;
 
-	GetBits();
+	GetRawBits();
 
 	if (mBits == NULL)
 		return false;
@@ -1895,15 +2623,23 @@ bool MemoryImage::Palletize()
 
 	if (!Quantize8Bit(mBits, mWidth, mHeight, mColorIndices, mColorTable))
 	{
-		delete [] mColorIndices;
-		mColorIndices = NULL;
+		if ((mQuantizeFlags & (QuantizeFlag_AllowLossy | QuantizeFlag_Dither)) == 0)
+		{
+			delete [] mColorIndices;
+			mColorIndices = NULL;
 
-		delete [] mColorTable;
-		mColorTable = NULL;
+			delete [] mColorTable;
+			mColorTable = NULL;
 
-		mWantPal = false;
+			mWantPal = false;
 
-		return false;
+			return false;
+		}
+
+		// Too many colors for an exact palette, so the image has opted in to a lossy one
+		SEXY_PERF_BEGIN("MemoryImage::Palletize MedianCut");
+		QuantizeMedianCut8Bit(mBits, mWidth, mHeight, mColorIndices, mColorTable, mQuantizeFlags);
+		SEXY_PERF_END("MemoryImage::Palletize MedianCut");
 	}
 	
 	delete [] mBits;
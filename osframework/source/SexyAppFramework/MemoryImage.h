@@ -16,6 +16,21 @@ const ulong MEMORYCHECK_ID = 0x4BEEFADE;
 class NativeDisplay;
 class SexyAppBase;
 
+enum CelAlphaType
+{
+	CelAlpha_Opaque,
+	CelAlpha_Binary,	// only fully opaque and fully transparent pixels
+	CelAlpha_Full
+};
+
+struct CelAlphaInfo
+{
+	int						mAlphaType;
+	Rect					mContentRect;	// relative to the cel, empty when it's all transparent
+};
+
+typedef std::vector<CelAlphaInfo> CelAlphaInfoVector;
+
 class MemoryImage : public Image
 {
 public:
@@ -23,6 +38,7 @@ public:
 	int						mBitsChangedCount;
 	void*					mD3DData;
 	DWORD					mD3DFlags;	// see D3DInterface.h for possible values
+	DWORD					mQuantizeFlags; // see Quantize.h for possible values
 
 	ulong*					mColorTable;	
 	uchar*					mColorIndices;
@@ -33,10 +49,16 @@ public:
 	bool					mIsVolatile;
 	bool					mPurgeBits;
 	bool					mWantPal;
+	bool					mPremultipliedAlpha; // mBits and mColorTable hold premultiplied ARGB, see SetPremultipliedAlpha
 	
 	ulong*					mNativeAlphaData;
 	uchar*					mRLAlphaData;
 	uchar*					mRLAdditiveData;	
+	ulong*					mTiledBits;		// allocation behind GetTiledBits
+
+	CelAlphaInfoVector		mCelAlphaInfo;	// from AnalyzeCels, cleared by BitsChanged
+	int						mCelAlphaCols;
+	int						mCelAlphaRows;
 
 	bool					mBitsChanged;
 	SexyAppBase*			mApp;
@@ -48,6 +70,8 @@ public:
 	virtual void*			GetNativeAlphaData(NativeDisplay *theNative);
 	virtual uchar*			GetRLAlphaData();
 	virtual uchar*			GetRLAdditiveData(NativeDisplay *theNative);
+	virtual ulong*			GetTiledBits();
+	int						GetTiledPitch()			{ return (((mWidth+3)>>2)+1)<<4; }
 	virtual void			PurgeBits();
 	virtual void			DeleteSWBuffers();
 	virtual void			Delete3DBuffers();	
@@ -59,7 +83,9 @@ public:
 	
 	virtual void			DeleteNativeData();	
 
-	void					NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcRect, const Color& theColor);
+	bool					TrimToContent(int& theX, int& theY, Rect& theSrcRect, int& theAlphaType);
+
+	void					NormalBlt(Image* theImage, int theX, int theY, const Rect& theSrcRectOrig, const Color& theColor);
 	void					AdditiveBlt(Image* theImage, int theX, int theY, const Rect& theSrcRect, const Color& theColor);
 
 	void					NormalDrawLine(double theStartX, double theStartY, double theEndX, double theEndY, const Color& theColor);
@@ -73,8 +99,8 @@ public:
 	bool					BltRotatedClipHelper(float &theX, float &theY, const Rect &theSrcRect, const Rect &theClipRect, double theRot, FRect &theDestRect, float theRotCenterX, float theRotCenterY);
 	bool					StretchBltClipHelper(const Rect &theSrcRect, const Rect &theClipRect, const Rect &theDestRect, FRect &theSrcRectOut, Rect &theDestRectOut);
 	bool					StretchBltMirrorClipHelper(const Rect &theSrcRect, const Rect &theClipRect, const Rect &theDestRect, FRect &theSrcRectOut, Rect &theDestRectOut);
-	void					BltMatrixHelper(Image* theImage, float x, float y, const SexyMatrix3 &theMatrix, const Rect& theClipRect, const Color& theColor, int theDrawMode, const Rect &theSrcRect, void *theSurface, int theBytePitch, int thePixelFormat, bool blend);
-	void					BltTrianglesTexHelper(Image *theTexture, const TriVertex theVertices[][3], int theNumTriangles, const Rect &theClipRect, const Color &theColor, int theDrawMode, void *theSurface, int theBytePitch, int thePixelFormat, float tx, float ty, bool blend);
+	void					BltMatrixHelper(Image* theImage, float x, float y, const SexyMatrix3 &theMatrix, const Rect& theClipRect, const Color& theColor, int theDrawMode, const Rect &theSrcRect, void *theSurface, int theBytePitch, int thePixelFormat, bool blend, bool premultipliedSurface = false);
+	void					BltTrianglesTexHelper(Image *theTexture, const TriVertex theVertices[][3], int theNumTriangles, const Rect &theClipRect, const Color &theColor, int theDrawMode, void *theSurface, int theBytePitch, int thePixelFormat, float tx, float ty, bool blend, bool premultipliedSurface = false);
 
 	void					FillScanLinesWithCoverage(Span* theSpans, int theSpanCount, const Color& theColor, int theDrawMode, const BYTE* theCoverage, int theCoverX, int theCoverY, int theCoverWidth, int theCoverHeight);
 
@@ -89,6 +115,7 @@ public:
 	virtual void			SetBits(ulong* theBits, int theWidth, int theHeight, bool commitBits = true);
 	virtual void			Create(int theWidth, int theHeight);
 	virtual ulong*			GetBits();	
+	virtual ulong*			GetRawBits();
 	
 	virtual void			FillRect(const Rect& theRect, const Color& theColor, int theDrawMode);
 	virtual void			ClearRect(const Rect& theRect);
@@ -105,7 +132,27 @@ public:
 	virtual void			SetImageMode(bool hasTrans, bool hasAlpha);
 	virtual void			SetVolatile(bool isVolatile);	
 
+	// Converts the stored pixels.  While premultiplied, source-over into this image is
+	//  a multiply-add and the bits double as the 32 bit native alpha data.  SetBits takes
+	//  and GetBits returns straight ARGB, GetBits by taking the image out of this mode.
+	//  Code that handles both modes reads the stored pixels with GetRawBits instead.
+	virtual void			SetPremultipliedAlpha(bool premultiplied);
+
 	virtual bool			Palletize();
+
+	// Classifies each cel of the current mNumCols x mNumRows grid and finds the bounds of
+	//  its visible pixels.  Normal blits of a single cel then skip the transparent border and
+	//  copy opaque cels row by row.  Meant to be called once the image is loaded.
+	virtual void			AnalyzeCels();
+	const CelAlphaInfo*		GetCelAlphaInfo(int theCol, int theRow);
+
+	// Moves the visible pixels of each cel into a packed mTrimImage and drops the full size
+	//  bits.  Only done when that saves at least a quarter of the pixels and all the cropped
+	//  pixels hold the same value.  GetBits rebuilds the full image when something needs it,
+	//  UntrimCels (also done by BitsChanged) goes back to plain storage.
+	virtual bool			TrimCels();
+	void					UntrimCels();
+	void					RestoreTrimmedBits();
 };
 
 }
@@ -4,9 +4,12 @@
 #include "SEHCatcher.cpp"
 #include "PropertiesParser.cpp"
 #include "PerfTimer.cpp"
+#include "FrameStats.cpp"
+#include "DemoReplayer.cpp"
 #include "MTRand.cpp"
 #include "KeyCodes.cpp"
 #include "HTTPTransfer.cpp"
+#include "HTTPClient.cpp"
 #include "DirectXErrorString.cpp"
 #include "Debug.cpp"
 #include "CritSect.cpp"
@@ -0,0 +1,101 @@
+#include "MixerOutput.h"
+
+using namespace Sexy;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+NullMixerOutput::NullMixerOutput(int theSampleRate, int theFramesPerUpdate)
+{
+	mSampleRate = theSampleRate;
+	mFramesPerUpdate = theFramesPerUpdate;
+	mFramesWritten = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int NullMixerOutput::GetFramesWanted()
+{
+	return mFramesPerUpdate;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void NullMixerOutput::Write(const short* theSamples, int theNumFrames)
+{
+	mFramesWritten += theNumFrames;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+WavMixerOutput::WavMixerOutput(const std::string& theFilename, int theSampleRate, int theFramesPerUpdate) :
+	NullMixerOutput(theSampleRate, theFramesPerUpdate)
+{
+	mDataSize = 0;
+	mFile = fopen(theFilename.c_str(), "wb");
+	if (mFile == NULL)
+		return;
+
+	// Sizes are filled in by Close
+	ulong aChunkSize = 0;
+	ushort aFormatTag = 1;
+	ushort aChannelCount = 2;
+	ulong aSampleRate = mSampleRate;
+	ushort aBlockAlign = 4;
+	ulong aBytesPerSec = aSampleRate * aBlockAlign;
+	ushort aBitCount = 16;
+
+	fwrite("RIFF", 1, 4, mFile);
+	fwrite(&aChunkSize, 4, 1, mFile);
+	fwrite("WAVE", 1, 4, mFile);
+
+	aChunkSize = 16;
+	fwrite("fmt ", 1, 4, mFile);
+	fwrite(&aChunkSize, 4, 1, mFile);
+	fwrite(&aFormatTag, 2, 1, mFile);
+	fwrite(&aChannelCount, 2, 1, mFile);
+	fwrite(&aSampleRate, 4, 1, mFile);
+	fwrite(&aBytesPerSec, 4, 1, mFile);
+	fwrite(&aBlockAlign, 2, 1, mFile);
+	fwrite(&aBitCount, 2, 1, mFile);
+
+	aChunkSize = 0;
+	fwrite("data", 1, 4, mFile);
+	fwrite(&aChunkSize, 4, 1, mFile);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+WavMixerOutput::~WavMixerOutput()
+{
+	Close();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void WavMixerOutput::Close()
+{
+	if (mFile == NULL)
+		return;
+
+	ulong aRiffSize = 4 + 8 + 16 + 8 + mDataSize;
+	fseek(mFile, 4, SEEK_SET);
+	fwrite(&aRiffSize, 4, 1, mFile);
+	fseek(mFile, 40, SEEK_SET);
+	fwrite(&mDataSize, 4, 1, mFile);
+
+	fclose(mFile);
+	mFile = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void WavMixerOutput::Write(const short* theSamples, int theNumFrames)
+{
+	NullMixerOutput::Write(theSamples, theNumFrames);
+
+	if (mFile == NULL)
+		return;
+
+	fwrite(theSamples, 4, theNumFrames, mFile);
+	mDataSize += theNumFrames*4;
+}
@@ -0,0 +1,66 @@
+#ifndef __MIXEROUTPUT_H__
+#define __MIXEROUTPUT_H__
+
+#include "Common.h"
+#include <stdio.h>
+
+namespace Sexy
+{
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Destination for MixerSoundManager.  Samples are always 16-bit interleaved
+//  stereo at mSampleRate.
+class MixerOutput
+{
+public:
+	int						mSampleRate;
+
+public:
+	MixerOutput() { mSampleRate = 44100; }
+	virtual ~MixerOutput() {}
+
+	// Number of frames the mixer should produce on this update
+	virtual int				GetFramesWanted() = NULL;
+	virtual void			Write(const short* theSamples, int theNumFrames) = NULL;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Discards everything.  Takes a fixed number of frames per update, so mixing
+//  stays in step with the app's fixed update rate without any audio device.
+class NullMixerOutput : public MixerOutput
+{
+public:
+	int						mFramesPerUpdate;
+	int64					mFramesWritten;
+
+public:
+	NullMixerOutput(int theSampleRate = 44100, int theFramesPerUpdate = 441);
+
+	virtual int				GetFramesWanted();
+	virtual void			Write(const short* theSamples, int theNumFrames);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Paced like NullMixerOutput, but records the mix to a WAV file
+class WavMixerOutput : public NullMixerOutput
+{
+protected:
+	FILE*					mFile;
+	ulong					mDataSize;
+
+public:
+	WavMixerOutput(const std::string& theFilename, int theSampleRate = 44100, int theFramesPerUpdate = 441);
+	virtual ~WavMixerOutput();
+
+	bool					IsOpen()	{ return mFile != NULL; }
+	void					Close();
+
+	virtual void			Write(const short* theSamples, int theNumFrames);
+};
+
+}
+
+#endif //__MIXEROUTPUT_H__
@@ -0,0 +1,159 @@
+#include "MixerSoundInstance.h"
+#include "MixerSoundManager.h"
+#include "MixerOutput.h"
+#include <math.h>
+
+using namespace Sexy;
+
+// Same curve as DSoundManager::VolumeToDB, so both managers sound alike
+static double VolumeToGain(double theVolume)
+{
+	double aDB = (log10(1 + theVolume*9) - 1.0) * 2333;
+	if (aDB < -2000)
+		return 0;
+
+	return pow(10.0, aDB / 2000);
+}
+
+MixerSoundInstance::MixerSoundInstance(MixerSoundManager* theSoundManager, unsigned int theSfxID, int theVoiceIdx)
+{
+	mSoundManagerP = theSoundManager;
+	mSfxID = theSfxID;
+	mVoiceIdx = theVoiceIdx;
+	mActiveIdx = -1;
+
+	mPos = 0;
+	mFrac = 0;
+	mStep = 0x10000;
+	mPitch = 1.0;
+
+	mBaseVolume = 1.0;
+	mBasePan = 0;
+	mVolume = 1.0;
+	mPan = 0;
+	mLeftGain = 0;
+	mRightGain = 0;
+	mPriority = 0;
+
+	mLooping = false;
+	mAutoRelease = false;
+	mHasPlayed = false;
+	mReleased = false;
+
+	RehupStep();
+	RehupGains();
+}
+
+MixerSoundInstance::~MixerSoundInstance()
+{
+}
+
+void MixerSoundInstance::RehupGains()
+{
+	double aGain = VolumeToGain(mBaseVolume * mVolume * mSoundManagerP->mVolume) * mSoundManagerP->mMasterVolume;
+	double aLeftGain = aGain;
+	double aRightGain = aGain;
+
+	// Pan is in hundredths of a dB of attenuation on the opposite side
+	int aPan = mBasePan + mPan;
+	if (aPan > 0)
+		aLeftGain *= pow(10.0, -aPan / 2000.0);
+	else if (aPan < 0)
+		aRightGain *= pow(10.0, aPan / 2000.0);
+
+	mLeftGain = (int) (min(aLeftGain, 1.0) * 32767);
+	mRightGain = (int) (min(aRightGain, 1.0) * 32767);
+}
+
+void MixerSoundInstance::RehupStep()
+{
+	const MixerSound& aSound = mSoundManagerP->mSourceSounds[mSfxID];
+	if ((aSound.mSamples == NULL) || (mSoundManagerP->mOutput == NULL))
+		return;
+
+	double aStep = mPitch * aSound.mSampleRate / mSoundManagerP->mOutput->mSampleRate;
+	mStep = (ulong) (aStep * 0x10000 + 0.5);
+	if (mStep == 0)
+		mStep = 1;
+}
+
+void MixerSoundInstance::Release()
+{
+	if (mReleased)
+		return;
+
+	Stop();
+	mReleased = true;
+	mSoundManagerP->FreeVoice(this);
+}
+
+void MixerSoundInstance::SetVolume(double theVolume)
+{
+	mVolume = theVolume;
+	RehupGains();
+}
+
+void MixerSoundInstance::SetPan(int thePosition)
+{
+	mPan = thePosition;
+	RehupGains();
+}
+
+void MixerSoundInstance::SetBaseVolume(double theBaseVolume)
+{
+	mBaseVolume = theBaseVolume;
+	RehupGains();
+}
+
+void MixerSoundInstance::SetBasePan(int theBasePan)
+{
+	mBasePan = theBasePan;
+	RehupGains();
+}
+
+void MixerSoundInstance::AdjustPitch(double theNumSteps)
+{
+	mPitch = pow(1.0594630943592952645618252949463, theNumSteps);
+	RehupStep();
+}
+
+bool MixerSoundInstance::Play(bool looping, bool autoRelease)
+{
+	Stop();
+
+	mHasPlayed = true;
+	mAutoRelease = autoRelease;
+	mLooping = looping;
+
+	if ((mReleased) || (mSoundManagerP->mSourceSounds[mSfxID].mSamples == NULL))
+		return false;
+
+	mPos = 0;
+	mFrac = 0;
+	RehupStep();
+	mSoundManagerP->ActivateVoice(this);
+	return true;
+}
+
+void MixerSoundInstance::Stop()
+{
+	mSoundManagerP->DeactivateVoice(this);
+	mPos = 0;
+	mFrac = 0;
+	mAutoRelease = false;
+}
+
+bool MixerSoundInstance::IsPlaying()
+{
+	return mActiveIdx != -1;
+}
+
+bool MixerSoundInstance::IsReleased()
+{
+	return mReleased;
+}
+
+double MixerSoundInstance::GetVolume()
+{
+	return mVolume;
+}
@@ -0,0 +1,68 @@
+#ifndef __MIXERSOUNDINSTANCE_H__
+#define __MIXERSOUNDINSTANCE_H__
+
+#include "SoundInstance.h"
+
+namespace Sexy
+{
+
+class MixerSoundManager;
+
+class MixerSoundInstance : public SoundInstance
+{
+	friend class MixerSoundManager;
+
+protected:
+	MixerSoundManager*		mSoundManagerP;
+	unsigned int			mSfxID;
+	int						mVoiceIdx;		// slot in MixerSoundManager::mVoices
+	int						mActiveIdx;		// slot in MixerSoundManager::mActiveVoices, -1 if not playing
+
+	int						mPos;			// current source frame
+	ulong					mFrac;			// 16-bit fraction of a source frame
+	ulong					mStep;			// 16.16 source frames per output frame
+	double					mPitch;
+
+	int						mBasePan;
+	double					mBaseVolume;
+	int						mPan;
+	double					mVolume;
+	int						mLeftGain;		// 1.15 fixed point
+	int						mRightGain;
+	int						mPriority;
+
+	bool					mLooping;
+	bool					mAutoRelease;
+	bool					mHasPlayed;
+	bool					mReleased;
+
+protected:
+	void					RehupGains();
+	void					RehupStep();
+
+public:
+	MixerSoundInstance(MixerSoundManager* theSoundManager, unsigned int theSfxID, int theVoiceIdx);
+	virtual ~MixerSoundInstance();
+	virtual void			Release();
+
+	virtual void			SetBaseVolume(double theBaseVolume);
+	virtual void			SetBasePan(int theBasePan);
+
+	virtual void			SetVolume(double theVolume);
+	virtual void			SetPan(int thePosition); //-hundredth db to +hundredth db = left to right
+	virtual void			AdjustPitch(double theNumSteps);
+
+	virtual bool			Play(bool looping, bool autoRelease);
+	virtual void			Stop();
+	virtual bool			IsPlaying();
+	virtual bool			IsReleased();
+	virtual double			GetVolume();
+
+	// Voices with a lower priority are stolen first when all voices are in use
+	void					SetPriority(int thePriority)	{ mPriority = thePriority; }
+	int						GetPriority()					{ return mPriority; }
+};
+
+}
+
+#endif //__MIXERSOUNDINSTANCE_H__
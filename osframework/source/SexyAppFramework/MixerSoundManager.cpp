@@ -0,0 +1,665 @@
+#include "MixerSoundManager.h"
+#include "MixerSoundInstance.h"
+#include "MixerOutput.h"
+#include "OggStream.h"
+#include "..\PakLib\PakInterface.h"
+#include "../ImageLib/PixelConvert.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define MIXER_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace Sexy;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Mixing kernels.  Gains are 1.15 fixed point and the destination holds
+//  interleaved stereo 32-bit sums.
+#ifdef MIXER_SSE2
+static inline void MixBlockSSE2(__m128i theSamples, __m128i theGains, int* theDest)
+{
+	__m128i aLo = _mm_mullo_epi16(theSamples, theGains);
+	__m128i aHi = _mm_mulhi_epi16(theSamples, theGains);
+	__m128i aProd0 = _mm_srai_epi32(_mm_unpacklo_epi16(aLo, aHi), 15);
+	__m128i aProd1 = _mm_srai_epi32(_mm_unpackhi_epi16(aLo, aHi), 15);
+
+	__m128i* aDest = (__m128i*) theDest;
+	_mm_storeu_si128(aDest, _mm_add_epi32(_mm_loadu_si128(aDest), aProd0));
+	_mm_storeu_si128(aDest+1, _mm_add_epi32(_mm_loadu_si128(aDest+1), aProd1));
+}
+#endif
+
+static void MixStereo(const short* theSrc, int* theDest, int theCount, int theLeftGain, int theRightGain, bool useSSE2)
+{
+	int i = 0;
+
+#ifdef MIXER_SSE2
+	if (useSSE2)
+	{
+		__m128i aGains = _mm_set_epi16(theRightGain, theLeftGain, theRightGain, theLeftGain, theRightGain, theLeftGain, theRightGain, theLeftGain);
+		for (; i + 4 <= theCount; i += 4)
+			MixBlockSSE2(_mm_loadu_si128((const __m128i*) (theSrc + i*2)), aGains, theDest + i*2);
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		theDest[i*2] += (theSrc[i*2] * theLeftGain) >> 15;
+		theDest[i*2+1] += (theSrc[i*2+1] * theRightGain) >> 15;
+	}
+}
+
+static void MixMono(const short* theSrc, int* theDest, int theCount, int theLeftGain, int theRightGain, bool useSSE2)
+{
+	int i = 0;
+
+#ifdef MIXER_SSE2
+	if (useSSE2)
+	{
+		__m128i aGains = _mm_set_epi16(theRightGain, theLeftGain, theRightGain, theLeftGain, theRightGain, theLeftGain, theRightGain, theLeftGain);
+		for (; i + 8 <= theCount; i += 8)
+		{
+			__m128i aSamples = _mm_loadu_si128((const __m128i*) (theSrc + i));
+			MixBlockSSE2(_mm_unpacklo_epi16(aSamples, aSamples), aGains, theDest + i*2);
+			MixBlockSSE2(_mm_unpackhi_epi16(aSamples, aSamples), aGains, theDest + i*2 + 8);
+		}
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		theDest[i*2] += (theSrc[i] * theLeftGain) >> 15;
+		theDest[i*2+1] += (theSrc[i] * theRightGain) >> 15;
+	}
+}
+
+static void ClampMix(const int* theSrc, short* theDest, int theCount, bool useSSE2)
+{
+	int i = 0;
+
+#ifdef MIXER_SSE2
+	if (useSSE2)
+	{
+		for (; i + 8 <= theCount; i += 8)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*) (theSrc + i));
+			__m128i b = _mm_loadu_si128((const __m128i*) (theSrc + i + 4));
+			_mm_storeu_si128((__m128i*) (theDest + i), _mm_packs_epi32(a, b));
+		}
+	}
+#endif
+
+	for (; i < theCount; i++)
+	{
+		int aVal = theSrc[i];
+		if (aVal > 32767)
+			aVal = 32767;
+		else if (aVal < -32768)
+			aVal = -32768;
+		theDest[i] = (short) aVal;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+MixerSoundManager::MixerSoundManager(MixerOutput* theOutput, int theNumVoices)
+{
+	mOutput = theOutput;
+	mVolume = 1.0;
+	mMasterVolume = 1.0;
+	mUseSSE2 = ImageLib::CPUHasSSE2();
+
+	for (int i = 0; i < MAX_SOURCE_SOUNDS; i++)
+	{
+		memset(&mSourceSounds[i], 0, sizeof(MixerSound));
+		mBaseVolumes[i] = 1;
+		mBasePans[i] = 0;
+		mBasePriorities[i] = 0;
+	}
+
+	mVoices.resize(theNumVoices, NULL);
+	for (int aVoiceIdx = theNumVoices - 1; aVoiceIdx >= 0; aVoiceIdx--)
+		mFreeVoices.push_back(aVoiceIdx);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+MixerSoundManager::~MixerSoundManager()
+{
+	ReleaseChannels();
+	ReleaseSounds();
+	delete mOutput;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool MixerSoundManager::Initialized()
+{
+	return mOutput != NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool MixerSoundManager::LoadWAVSound(unsigned int theSfxID, const std::string& theFilename)
+{
+	PFILE* fp = p_fopen(theFilename.c_str(), "rb");
+	if (fp == NULL)
+		return false;
+
+	char aChunkType[5];
+	aChunkType[4] = '\0';
+	ulong aChunkSize;
+
+	p_fread(aChunkType, 1, 4, fp);
+	p_fread(&aChunkSize, 4, 1, fp);
+	bool isWave = strcmp(aChunkType, "RIFF") == 0;
+	p_fread(aChunkType, 1, 4, fp);
+	isWave = isWave && (strcmp(aChunkType, "WAVE") == 0);
+
+	ushort aBitCount = 16;
+	ushort aChannelCount = 1;
+	ulong aSampleRate = 22050;
+	uchar anXor = 0;
+
+	while ((isWave) && (!p_feof(fp)))
+	{
+		p_fread(aChunkType, 1, 4, fp);
+		if (p_fread(&aChunkSize, 4, 1, fp) == 0)
+			break;
+
+		int aCurPos = p_ftell(fp);
+
+		if (strcmp(aChunkType, "fmt ") == 0)
+		{
+			ushort aFormatTag;
+			ulong aBytesPerSec;
+			ushort aBlockAlign;
+
+			p_fread(&aFormatTag, 2, 1, fp);
+			p_fread(&aChannelCount, 2, 1, fp);
+			p_fread(&aSampleRate, 4, 1, fp);
+			p_fread(&aBytesPerSec, 4, 1, fp);
+			p_fread(&aBlockAlign, 2, 1, fp);
+			p_fread(&aBitCount, 2, 1, fp);
+
+			if ((aFormatTag != 1) || ((aBitCount != 8) && (aBitCount != 16)) ||
+				((aChannelCount != 1) && (aChannelCount != 2)))
+				break;
+		}
+		else if (strcmp(aChunkType, "xor ") == 0)
+		{
+			p_fread(&anXor, 1, 1, fp);
+		}
+		else if (strcmp(aChunkType, "data") == 0)
+		{
+			uchar* aData = new uchar[aChunkSize];
+			int aReadSize = p_fread(aData, 1, aChunkSize, fp);
+			p_fclose(fp);
+
+			for (ulong i = 0; i < aChunkSize; i++)
+				aData[i] ^= anXor;
+
+			MixerSound& aSound = mSourceSounds[theSfxID];
+			aSound.mChannels = aChannelCount;
+			aSound.mSampleRate = aSampleRate;
+			aSound.mNumFrames = aChunkSize / (aChannelCount * aBitCount/8);
+
+			int aNumSamples = aSound.mNumFrames * aChannelCount;
+			aSound.mSamples = new short[aNumSamples];
+			if (aBitCount == 16)
+				memcpy(aSound.mSamples, aData, aNumSamples*2);
+			else
+			{
+				for (int i = 0; i < aNumSamples; i++)
+					aSound.mSamples[i] = (short) ((aData[i] - 128) << 8);
+			}
+
+			delete [] aData;
+			return aReadSize == (int) aChunkSize;
+		}
+
+		p_fseek(fp, aCurPos+aChunkSize, SEEK_SET);
+	}
+
+	p_fclose(fp);
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool MixerSoundManager::LoadOGGSound(unsigned int theSfxID, const std::string& theFilename)
+{
+	OggStream aStream;
+	if (!aStream.Open(theFilename))
+		return false;
+
+	MixerSound& aSound = mSourceSounds[theSfxID];
+	aSound.mChannels = aStream.mChannels;
+	aSound.mSampleRate = aStream.mSampleRate;
+	aSound.mNumFrames = aStream.mTotalBytes / aStream.mBlockAlign;
+	aSound.mSamples = new short[aSound.mNumFrames * aSound.mChannels];
+
+	return aStream.Read(aSound.mSamples, aStream.mTotalBytes, false) == aStream.mTotalBytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool MixerSoundManager::LoadSound(unsigned int theSfxID, const std::string& theFilename)
+{
+	if ((theSfxID < 0) || (theSfxID >= MAX_SOURCE_SOUNDS))
+		return false;
+
+	ReleaseSound(theSfxID);
+
+	mSourceFileNames[theSfxID] = theFilename;
+
+	if (LoadWAVSound(theSfxID, theFilename + ".wav"))
+		return true;
+	ReleaseSound(theSfxID);
+
+	if (LoadOGGSound(theSfxID, theFilename + ".ogg"))
+		return true;
+	ReleaseSound(theSfxID);
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int MixerSoundManager::LoadSound(const std::string& theFilename)
+{
+	int i;
+	for (i = 0; i < MAX_SOURCE_SOUNDS; i++)
+		if (mSourceFileNames[i] == theFilename)
+			return i;
+
+	for (i = MAX_SOURCE_SOUNDS-1; i >= 0; i--)
+	{
+		if (mSourceSounds[i].mSamples == NULL)
+		{
+			if (!LoadSound(i, theFilename))
+				return -1;
+			else
+				return i;
+		}
+	}
+
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::ReleaseSound(unsigned int theSfxID)
+{
+	if ((theSfxID < 0) || (theSfxID >= MAX_SOURCE_SOUNDS))
+		return;
+
+	// Nothing may keep mixing from the samples we're about to free
+	for (int i = mActiveVoices.size() - 1; i >= 0; i--)
+	{
+		MixerSoundInstance* aVoice = mActiveVoices[i];
+		if (aVoice->mSfxID != theSfxID)
+			continue;
+
+		if (aVoice->mAutoRelease)
+			aVoice->Release();
+		else
+			aVoice->Stop();
+	}
+
+	delete [] mSourceSounds[theSfxID].mSamples;
+	memset(&mSourceSounds[theSfxID], 0, sizeof(MixerSound));
+	mSourceFileNames[theSfxID] = "";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::SetVolume(double theVolume)
+{
+	mVolume = theVolume;
+
+	for (int i = 0; i < (int) mVoices.size(); i++)
+		if ((mVoices[i] != NULL) && (!mVoices[i]->mReleased))
+			mVoices[i]->RehupGains();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool MixerSoundManager::SetBaseVolume(unsigned int theSfxID, double theBaseVolume)
+{
+	if ((theSfxID < 0) || (theSfxID >= MAX_SOURCE_SOUNDS))
+		return false;
+
+	mBaseVolumes[theSfxID] = theBaseVolume;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool MixerSoundManager::SetBasePan(unsigned int theSfxID, int theBasePan)
+{
+	if ((theSfxID < 0) || (theSfxID >= MAX_SOURCE_SOUNDS))
+		return false;
+
+	mBasePans[theSfxID] = theBasePan;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool MixerSoundManager::SetBasePriority(unsigned int theSfxID, int thePriority)
+{
+	if ((theSfxID < 0) || (theSfxID >= MAX_SOURCE_SOUNDS))
+		return false;
+
+	mBasePriorities[theSfxID] = thePriority;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int MixerSoundManager::AllocVoice(int thePriority)
+{
+	if (mFreeVoices.empty())
+	{
+		// Steal the lowest priority fire-and-forget voice.  Voices the game
+		//  holds on to are never taken away from it.
+		MixerSoundInstance* aVictim = NULL;
+		for (int i = 0; i < (int) mActiveVoices.size(); i++)
+		{
+			MixerSoundInstance* aVoice = mActiveVoices[i];
+			if ((aVoice->mAutoRelease) && ((aVictim == NULL) || (aVoice->mPriority < aVictim->mPriority)))
+				aVictim = aVoice;
+		}
+
+		if ((aVictim == NULL) || (aVictim->mPriority > thePriority))
+			return -1;
+
+		aVictim->Release();
+	}
+
+	int aVoiceIdx = mFreeVoices.back();
+	mFreeVoices.pop_back();
+
+	delete mVoices[aVoiceIdx];
+	mVoices[aVoiceIdx] = NULL;
+	return aVoiceIdx;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::FreeVoice(MixerSoundInstance* theInstance)
+{
+	mFreeVoices.push_back(theInstance->mVoiceIdx);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::ActivateVoice(MixerSoundInstance* theInstance)
+{
+	if (theInstance->mActiveIdx != -1)
+		return;
+
+	theInstance->mActiveIdx = mActiveVoices.size();
+	mActiveVoices.push_back(theInstance);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::DeactivateVoice(MixerSoundInstance* theInstance)
+{
+	int anIdx = theInstance->mActiveIdx;
+	if (anIdx == -1)
+		return;
+
+	MixerSoundInstance* aLast = mActiveVoices.back();
+	mActiveVoices[anIdx] = aLast;
+	aLast->mActiveIdx = anIdx;
+	mActiveVoices.pop_back();
+
+	theInstance->mActiveIdx = -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+SoundInstance* MixerSoundManager::GetSoundInstance(unsigned int theSfxID)
+{
+	if ((theSfxID < 0) || (theSfxID >= MAX_SOURCE_SOUNDS))
+		return NULL;
+
+	if (mSourceSounds[theSfxID].mSamples == NULL)
+		return NULL;
+
+	int aVoiceIdx = AllocVoice(mBasePriorities[theSfxID]);
+	if (aVoiceIdx < 0)
+		return NULL;
+
+	MixerSoundInstance* anInstance = new MixerSoundInstance(this, theSfxID, aVoiceIdx);
+	mVoices[aVoiceIdx] = anInstance;
+
+	anInstance->SetPriority(mBasePriorities[theSfxID]);
+	anInstance->SetBasePan(mBasePans[theSfxID]);
+	anInstance->SetBaseVolume(mBaseVolumes[theSfxID]);
+
+	return anInstance;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::ReleaseSounds()
+{
+	for (int i = 0; i < MAX_SOURCE_SOUNDS; i++)
+		ReleaseSound(i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::ReleaseChannels()
+{
+	mActiveVoices.clear();
+	mFreeVoices.clear();
+
+	for (int aVoiceIdx = mVoices.size() - 1; aVoiceIdx >= 0; aVoiceIdx--)
+	{
+		delete mVoices[aVoiceIdx];
+		mVoices[aVoiceIdx] = NULL;
+		mFreeVoices.push_back(aVoiceIdx);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+double MixerSoundManager::GetMasterVolume()
+{
+	return mMasterVolume;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::SetMasterVolume(double theVolume)
+{
+	mMasterVolume = theVolume;
+	SetVolume(mVolume);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::Flush()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::SetCooperativeWindow(HWND theHWnd, bool isWindowed)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::StopAllSounds()
+{
+	for (int i = mActiveVoices.size() - 1; i >= 0; i--)
+	{
+		MixerSoundInstance* aVoice = mActiveVoices[i];
+		if (aVoice->mAutoRelease)
+			aVoice->Release();
+		else
+			aVoice->Stop();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int MixerSoundManager::GetFreeSoundId()
+{
+	for (int i=0; i<MAX_SOURCE_SOUNDS; i++)
+	{
+		if (mSourceSounds[i].mSamples==NULL)
+			return i;
+	}
+
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int MixerSoundManager::GetNumSounds()
+{
+	int aCount = 0;
+	for (int i=0; i<MAX_SOURCE_SOUNDS; i++)
+	{
+		if (mSourceSounds[i].mSamples!=NULL)
+			aCount++;
+	}
+
+	return aCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::MixVoice(MixerSoundInstance* theInstance, int* theDest, int theNumFrames)
+{
+	const MixerSound& aSound = mSourceSounds[theInstance->mSfxID];
+
+	int aLeftGain = theInstance->mLeftGain;
+	int aRightGain = theInstance->mRightGain;
+	bool isSilent = (aLeftGain == 0) && (aRightGain == 0);
+	bool isDone = false;
+
+	int* aDest = theDest;
+	int aFramesLeft = theNumFrames;
+	while (aFramesLeft > 0)
+	{
+		if (theInstance->mPos >= aSound.mNumFrames)
+		{
+			if ((!theInstance->mLooping) || (aSound.mNumFrames == 0))
+			{
+				isDone = true;
+				break;
+			}
+
+			theInstance->mPos %= aSound.mNumFrames;
+		}
+
+		int aCount;
+		if ((theInstance->mStep == 0x10000) && (theInstance->mFrac == 0))
+		{
+			// Straight copy at the source rate, the common case
+			aCount = min(aFramesLeft, aSound.mNumFrames - theInstance->mPos);
+			const short* aSrc = aSound.mSamples + theInstance->mPos*aSound.mChannels;
+
+			if (isSilent)
+				;
+			else if (aSound.mChannels == 2)
+				MixStereo(aSrc, aDest, aCount, aLeftGain, aRightGain, mUseSSE2);
+			else
+				MixMono(aSrc, aDest, aCount, aLeftGain, aRightGain, mUseSSE2);
+
+			theInstance->mPos += aCount;
+		}
+		else
+		{
+			// Linear interpolation for pitch shifts and other sample rates
+			const short* aSamples = aSound.mSamples;
+			int aNumFrames = aSound.mNumFrames;
+			int aChannels = aSound.mChannels;
+			int aPos = theInstance->mPos;
+			ulong aFrac = theInstance->mFrac;
+			ulong aStep = theInstance->mStep;
+
+			for (aCount = 0; (aCount < aFramesLeft) && (aPos < aNumFrames); aCount++)
+			{
+				if (!isSilent)
+				{
+					int aNext = aPos + 1;
+					if (aNext >= aNumFrames)
+						aNext = theInstance->mLooping ? 0 : aPos;
+
+					const short* aSrc0 = aSamples + aPos*aChannels;
+					const short* aSrc1 = aSamples + aNext*aChannels;
+					int aWeight = aFrac >> 1;
+
+					int aLeft = aSrc0[0] + (((aSrc1[0] - aSrc0[0]) * aWeight) >> 15);
+					int aRight = aLeft;
+					if (aChannels == 2)
+						aRight = aSrc0[1] + (((aSrc1[1] - aSrc0[1]) * aWeight) >> 15);
+
+					aDest[aCount*2] += (aLeft * aLeftGain) >> 15;
+					aDest[aCount*2+1] += (aRight * aRightGain) >> 15;
+				}
+
+				aFrac += aStep;
+				aPos += aFrac >> 16;
+				aFrac &= 0xFFFF;
+			}
+
+			theInstance->mPos = aPos;
+			theInstance->mFrac = aFrac;
+		}
+
+		aDest += aCount*2;
+		aFramesLeft -= aCount;
+	}
+
+	if (isDone)
+	{
+		bool isAutoRelease = theInstance->mAutoRelease;
+		theInstance->Stop();
+		if (isAutoRelease)
+			theInstance->Release();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::Mix(int theNumFrames)
+{
+	if ((mOutput == NULL) || (theNumFrames <= 0))
+		return;
+
+	int aNumSamples = theNumFrames*2;
+	if ((int) mMixBuffer.size() < aNumSamples)
+	{
+		mMixBuffer.resize(aNumSamples);
+		mOutBuffer.resize(aNumSamples);
+	}
+
+	memset(&mMixBuffer[0], 0, aNumSamples*sizeof(int));
+
+	// Finished voices swap the last active voice into their slot, which has
+	//  already been mixed when walking backwards
+	for (int i = mActiveVoices.size() - 1; i >= 0; i--)
+		MixVoice(mActiveVoices[i], &mMixBuffer[0], theNumFrames);
+
+	ClampMix(&mMixBuffer[0], &mOutBuffer[0], aNumSamples, mUseSSE2);
+	mOutput->Write(&mOutBuffer[0], theNumFrames);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void MixerSoundManager::Update()
+{
+	if (mOutput != NULL)
+		Mix(mOutput->GetFramesWanted());
+}
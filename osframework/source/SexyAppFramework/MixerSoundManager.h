@@ -0,0 +1,101 @@
+#ifndef __MIXERSOUNDMANAGER_H__
+#define __MIXERSOUNDMANAGER_H__
+
+#include "SoundManager.h"
+
+namespace Sexy
+{
+
+class MixerOutput;
+class MixerSoundInstance;
+
+// Decoded sound, always 16-bit
+struct MixerSound
+{
+	short*					mSamples;
+	int						mNumFrames;
+	int						mChannels;
+	int						mSampleRate;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Mixes all sounds itself and hands the result to a MixerOutput, so it works
+//  without DirectSound (for example with a NullMixerOutput on a server).
+//  Mixing happens on the main thread in Update().
+class MixerSoundManager : public SoundManager
+{
+	friend class MixerSoundInstance;
+
+protected:
+	typedef std::vector<MixerSoundInstance*> VoiceVector;
+
+	MixerOutput*			mOutput;
+	MixerSound				mSourceSounds[MAX_SOURCE_SOUNDS];
+	std::string				mSourceFileNames[MAX_SOURCE_SOUNDS];
+	double					mBaseVolumes[MAX_SOURCE_SOUNDS];
+	int						mBasePans[MAX_SOURCE_SOUNDS];
+	int						mBasePriorities[MAX_SOURCE_SOUNDS];
+
+	VoiceVector				mVoices;		// owned, released ones are deleted when their slot is reused
+	std::vector<int>		mFreeVoices;
+	VoiceVector				mActiveVoices;	// voices currently playing
+
+	std::vector<int>		mMixBuffer;
+	std::vector<short>		mOutBuffer;
+
+	double					mVolume;
+	double					mMasterVolume;
+
+protected:
+	bool					LoadWAVSound(unsigned int theSfxID, const std::string& theFilename);
+	bool					LoadOGGSound(unsigned int theSfxID, const std::string& theFilename);
+
+	int						AllocVoice(int thePriority);
+	void					FreeVoice(MixerSoundInstance* theInstance);
+	void					ActivateVoice(MixerSoundInstance* theInstance);
+	void					DeactivateVoice(MixerSoundInstance* theInstance);
+	void					MixVoice(MixerSoundInstance* theInstance, int* theDest, int theNumFrames);
+
+public:
+	bool					mUseSSE2;
+
+public:
+	MixerSoundManager(MixerOutput* theOutput, int theNumVoices = 64); // takes ownership of theOutput
+	virtual ~MixerSoundManager();
+
+	virtual bool			Initialized();
+
+	virtual bool			LoadSound(unsigned int theSfxID, const std::string& theFilename);
+	virtual int				LoadSound(const std::string& theFilename);
+	virtual void			ReleaseSound(unsigned int theSfxID);
+
+	virtual void			SetVolume(double theVolume);
+	virtual bool			SetBaseVolume(unsigned int theSfxID, double theBaseVolume);
+	virtual bool			SetBasePan(unsigned int theSfxID, int theBasePan);
+	bool					SetBasePriority(unsigned int theSfxID, int thePriority);
+
+	virtual SoundInstance*	GetSoundInstance(unsigned int theSfxID);
+
+	virtual void			ReleaseSounds();
+	virtual void			ReleaseChannels();
+
+	virtual double			GetMasterVolume();
+	virtual void			SetMasterVolume(double theVolume);
+
+	virtual void			Flush();
+	virtual void			SetCooperativeWindow(HWND theHWnd, bool isWindowed);
+	virtual void			StopAllSounds();
+	virtual int				GetFreeSoundId();
+	virtual int				GetNumSounds();
+
+	virtual void			Update();
+	void					Mix(int theNumFrames);
+
+	MixerOutput*			GetOutput()				{ return mOutput; }
+	int						GetNumActiveVoices()	{ return mActiveVoices.size(); }
+};
+
+}
+
+#endif //__MIXERSOUNDMANAGER_H__
@@ -1,40 +1,54 @@
 #include "ModVal.h"
 #include "Common.h"
+#include "CritSect.h"
+#include "AutoCrit.h"
 #include <fstream>
+#include <process.h>
 
-struct ModStorage
-{		
-	bool					mChanged;
-	int						mInt; 
-	double					mDouble;	
-	std::string				mString;
-};
+using namespace Sexy;
 
-struct ModPointer
+struct ModSite
 {
-	const char *mStrPtr;
-	int mLineNum;
+	int						mLineNum;
+	ModStorage*				mStorage;		// NULL until this M() has run
+	ModValue*				mValue;			// latest parsed value, handed to mStorage when it registers
 
-	ModPointer() : mStrPtr(NULL), mLineNum(0) {}
-	ModPointer(const char *theStrPtr, int theLineNum) : mStrPtr(theStrPtr), mLineNum(theLineNum) {}
+	ModSite() : mLineNum(0), mStorage(NULL), mValue(NULL) {}
 };
 
-typedef std::map<int,ModPointer> ModStorageMap; // stores counters
+typedef std::map<int,ModSite> ModStorageMap; // stores counters
 
 struct FileMod
 {
 	bool mHasMods;
+	time_t mWatchTime;
 	ModStorageMap mMap;
 
-	FileMod(bool hasMods = false) { mHasMods = hasMods; }
+	FileMod(bool hasMods = false) { mHasMods = hasMods; mWatchTime = 0; }
+};
+
+struct ModValLocation
+{
+	std::string				mFileName;
+	int						mCounter;
+	int						mLineNum;
 };
 
 typedef std::map<std::string, int> StringToIntMap;
 typedef std::map<std::string, FileMod> FileModMap;
+typedef std::list<ModValue*> ModValueList;
+typedef std::vector<ModValLocation> ModValLocationVector;
 
 static StringToIntMap gStringToIntMap;
 time_t gLastFileTime = 0;
-const char *gSampleString = NULL; // for finding the others
+static bool gFoundModVals = false;
+static volatile bool gModValWatching = false;
+static volatile bool gModValWatchRunning = false;
+static bool gModValAutoWatch = true;
+
+// Old values are never freed since a caller may still hold a string from one,
+//  so only values that actually changed get a new one
+static ModValueList gModValues;
 
 static FileModMap& GetFileModMap()
 {
@@ -42,6 +56,13 @@ static FileModMap& GetFileModMap()
 	return aMap;
 }
 
+// Guards the file map, taken by the watcher thread and the first run of each M()
+static CritSect& GetModValCritSect()
+{
+	static CritSect aCritSect;
+	return aCritSect;
+}
+
 static const char* FindFileInStringTable(const std::string &theSearch, const char *theMem, DWORD theLength, const char *theStartPos)
 {
 	const char *aFind = NULL;
@@ -92,12 +113,10 @@ static bool ParseModValString(std::string &theStr, int *theCounter = NULL, int *
 	return true;
 }
 
-static bool FindModValsInMemoryHelper(const char *theMem, DWORD theLength)
+static bool FindModValsInMemoryHelper(const char *theMem, DWORD theLength, ModValLocationVector& theLocations)
 {
 	std::string aSearchStr = "SEXYMODVAL";
 
-	FileModMap &aMap = GetFileModMap();
-
 	bool foundOne = false;
 	const char *aPtr = theMem;
 	while (true)
@@ -110,11 +129,11 @@ static bool FindModValsInMemoryHelper(const char *theMem, DWORD theLength)
 		std::string aFileName = aPtr+10; // skip SEXYMODVAL
 		if (ParseModValString(aFileName,&aCounter,&aLineNum))
 		{
-			if (aLineNum==4105)
-				_asm nop;
-
-			FileMod &aFileMod = aMap[aFileName];
-			aFileMod.mMap[aCounter] = ModPointer(aPtr-5,aLineNum);
+			ModValLocation aLocation;
+			aLocation.mFileName = aFileName;
+			aLocation.mCounter = aCounter;
+			aLocation.mLineNum = aLineNum;
+			theLocations.push_back(aLocation);
 			foundOne = true;
 		}
 		aPtr++;
@@ -123,7 +142,7 @@ static bool FindModValsInMemoryHelper(const char *theMem, DWORD theLength)
 	return foundOne;
 }
 
-static void FindModValsInMemory()
+static void FindModValsInMemory(ModValLocationVector& theLocations)
 {
 	MEMORY_BASIC_INFORMATION mbi; 
 	PVOID      pvAddress = 0; 
@@ -148,7 +167,7 @@ static void FindModValsInMemory()
 			
 			if (aMem!=NULL) // do find in old section
 			{
-				if (FindModValsInMemoryHelper(aMem,aMemLength))
+				if (FindModValsInMemoryHelper(aMem,aMemLength,theLocations))
 				{
 					aFound++;
 					return;
@@ -164,83 +183,54 @@ static void FindModValsInMemory()
 
 	if (aMem!=NULL)
 	{
-		if (FindModValsInMemoryHelper(aMem,aMemLength))
+		if (FindModValsInMemoryHelper(aMem,aMemLength,theLocations))
 			aFound++;
 	}
 }
 
-static ModStorage* CreateFileModsHelper(const char* theFileName)
+static void PublishModValue(ModSite& theSite, int theInt, double theDouble, const std::string& theString)
 {
-	ModStorage *aModStorage = new ModStorage;
-	aModStorage->mChanged = false;
-
-	// Change this thinggie
-	DWORD anOldProtect;
-	VirtualProtect((LPVOID) theFileName, 5, PAGE_READWRITE, &anOldProtect);
-	*((char*) theFileName) = 0;
-	*((ModStorage**) (theFileName+1)) = aModStorage;
-	VirtualProtect((LPVOID) theFileName, 5, anOldProtect, &anOldProtect);
-	
-	return aModStorage;	
+	// Every save reparses every M() in the file, most of them unchanged
+	ModValue* anOldValue = theSite.mValue;
+	if ((anOldValue != NULL) && (anOldValue->mInt == theInt) && (anOldValue->mDouble == theDouble) && (anOldValue->mString == theString))
+		return;
+
+	ModValue* aValue = new ModValue;
+	aValue->mInt = theInt;
+	aValue->mDouble = theDouble;
+	aValue->mString = theString;
+	gModValues.push_back(aValue);
+
+	// The value is filled in before anyone can see the pointer to it
+	theSite.mValue = aValue;
+	if (theSite.mStorage != NULL)
+		InterlockedExchangePointer((PVOID*) &theSite.mStorage->mValue, aValue);
 }
 
-
-static ModStorage* CreateFileMods(const char* theFileName)
-{	
-	if (gSampleString==NULL)
-		gSampleString = theFileName;
-
+void Sexy::RegisterModVal(ModStorage& theStorage, const char* theFileName)
+{
 	std::string aFileName = theFileName+15; // skip SEXY_SEXYMODVAL
-	ParseModValString(aFileName);
-
-	FileModMap &aMap = GetFileModMap();
-	aMap[aFileName].mHasMods = true; 
+	int aCounter = 0, aLineNum = 0;
+	ParseModValString(aFileName, &aCounter, &aLineNum);
 
-	return CreateFileModsHelper(theFileName);
-}
-
-int Sexy::ModVal(int theAreaNum, const char* theFileName, int theInt)
-{	
-	if (*theFileName != 0)
-		CreateFileMods(theFileName);	
-
-	ModStorage* aModStorage = *(ModStorage**)(theFileName+1);
-	if (aModStorage->mChanged)
-		return aModStorage->mInt;
-	else
-		return theInt;
-}
-
-double Sexy::ModVal(int theAreaNum, const char* theFileName, double theDouble)
-{
-	if (*theFileName != 0)
-		CreateFileMods(theFileName);	
-			
-	ModStorage* aModStorage = *(ModStorage**)(theFileName+1);
-	if (aModStorage->mChanged)
-		return aModStorage->mDouble;
-	else
-		return theDouble;
-}
+	{
+		AutoCrit aCrit(GetModValCritSect());
 
-float Sexy::ModVal(int theAreaNum, const char* theFileName, float theFloat)
-{
-	return (float) ModVal(theAreaNum, theFileName, (double) theFloat);
-}
+		FileMod &aFileMod = GetFileModMap()[aFileName];
+		aFileMod.mHasMods = true;
 
-const char*	Sexy::ModVal(int theAreaNum, const char* theFileName, const char *theStr)
-{
-	if (*theFileName != 0)
-		CreateFileMods(theFileName);	
+		// Pick up a value parsed before this M() first ran
+		ModSite &aSite = aFileMod.mMap[aCounter];
+		aSite.mLineNum = aLineNum;
+		aSite.mStorage = &theStorage;
+		theStorage.mValue = aSite.mValue;
+		theStorage.mRegistered = true;
+	}
 
-	ModStorage* aModStorage = *(ModStorage**)(theFileName+1);
-	if (aModStorage->mChanged)
-		return aModStorage->mString.c_str();
-	else
-		return theStr;
+	if (gModValAutoWatch)
+		StartModValWatcher();
 }
 
-
 void Sexy::AddModValEnum(const std::string &theEnumName, int theVal)
 {
 	gStringToIntMap[theEnumName] = theVal;
@@ -427,76 +417,73 @@ static bool ModStringToString(const char* theString, std::string &theStrVal)
 	return true;
 }
 
-bool Sexy::ReparseModValues()
+static bool ParseModFile(const std::string& theFileName, FileMod& theFileMod, std::string& theError)
 {
-	if (gLastFileTime == 0)
-	{
-		char anEXEName[256];
-		GetModuleFileNameA(NULL, anEXEName, 256);
-		gLastFileTime = GetFileDate(anEXEName);
-		
-		FindModValsInMemory();
-	}
-
-	bool hasNewFiles = false;
-	std::string aFileList;
+	ModStorageMap &aModMap = theFileMod.mMap;
 
-	// Process each file one at a time
-	FileModMap &aMap = GetFileModMap();
-	FileModMap::iterator aFileModItr;
-	for (aFileModItr = aMap.begin(); aFileModItr != aMap.end(); ++aFileModItr)
-	{
-		FileMod &aFileMod = aFileModItr->second;
-		if (!aFileMod.mHasMods)
-			continue;
+	int aLineNum = 1;
+	int aModNum = 0;
+	ModStorageMap::iterator aModMapItr = aModMap.begin();
 
-		ModStorageMap &aModMap = aFileMod.mMap;
-		std::string aFileName = aFileModItr->first;
+	std::fstream aStream(theFileName.c_str(), std::ios::in);
 
-		time_t aThisTime = GetFileDate(aFileName);
-		if (aThisTime > gLastFileTime)
+	if (aStream.is_open())
+	{
+		while (!aStream.eof())
 		{
-			gLastFileTime = aThisTime;
-			hasNewFiles = true;
-		}
-
-		if (aFileList.length() > 0)
-			aFileList += "\r\n  ";
-		aFileList += aFileName;
+			char aString[8192];
+			aStream.getline(aString, 8192);
 
-		int aLineNum = 1;
-		int aModNum = 0;
-		ModStorageMap::iterator aModMapItr = aModMap.begin();
-
-		std::fstream aStream(aFileName.c_str(), std::ios::in);
-
-		if (aStream.is_open())
-		{
-			while (!aStream.eof())
+			int aCharIdx = 0;
+			int aChar = 0;
+			int aLastChar = 0;
+			while (aString[aCharIdx] != 0)
 			{
-				char aString[8192];
-				aStream.getline(aString, 8192);
+				aLastChar = aChar;
+				aChar = aString[aCharIdx];
+				
+				if (aChar == '"')  // Skip strings
+				{
+					while (true)
+					{
+						aLastChar = aChar;
+						aChar = aString[++aCharIdx];
+
+						if (aChar=='\\' && aLastChar=='\\') // so we don't interpret \\" as an escaped quote
+							aChar = 0;
+						else if (aChar=='"' && aLastChar!='\\')
+							break;
+						else if (aChar==0)
+						{
+							if (aLastChar=='\\') // continuation
+							{
+								aCharIdx = -1;
+								aChar = 0;
+								aLastChar = 0;
+								aLineNum++;
+
+								aStream.getline(aString, 8192);
+								if (aString[0]!=0 || !aStream.eof()) // got valid new line
+									continue;
+							}
 
-				int aCharIdx = 0;
-				int aChar = 0;
-				int aLastChar = 0;
-				while (aString[aCharIdx] != 0)
+							char aStr[512];
+							sprintf(aStr, "ERROR in %s on line %d: Error parsing quotes", theFileName.c_str(), aLineNum);
+							theError = aStr;
+							return false;
+						}
+					}
+				}
+				else if (aChar=='/') // Skip C++ comments
 				{
-					aLastChar = aChar;
-					aChar = aString[aCharIdx];
-					
-					if (aChar == '"')  // Skip strings
+					if (aLastChar=='/') 
 					{
+
 						while (true)
 						{
 							aLastChar = aChar;
 							aChar = aString[++aCharIdx];
-
-							if (aChar=='\\' && aLastChar=='\\') // so we don't interpret \\" as an escaped quote
-								aChar = 0;
-							else if (aChar=='"' && aLastChar!='\\')
-								break;
-							else if (aChar==0)
+							if (aChar==0) // line continuation
 							{
 								if (aLastChar=='\\') // continuation
 								{
@@ -509,152 +496,193 @@ bool Sexy::ReparseModValues()
 									if (aString[0]!=0 || !aStream.eof()) // got valid new line
 										continue;
 								}
+								else
+								{
+									aCharIdx--;
+									break;
+								}
 
 								char aStr[512];
-								sprintf(aStr, "ERROR in %s on line %d: Error parsing quotes", aFileName.c_str(), aLineNum);
-								MessageBoxA(NULL, aStr, "MODVAL ERROR", MB_OK | MB_ICONERROR);
+								sprintf(aStr, "ERROR in %s on line %d: Error parsing c++ comment", theFileName.c_str(), aLineNum);
+								theError = aStr;
 								return false;
 							}
 						}
 					}
-					else if (aChar=='/') // Skip C++ comments
-					{
-						if (aLastChar=='/') 
-						{
-
-							while (true)
-							{
-								aLastChar = aChar;
-								aChar = aString[++aCharIdx];
-								if (aChar==0) // line continuation
-								{
-									if (aLastChar=='\\') // continuation
-									{
-										aCharIdx = -1;
-										aChar = 0;
-										aLastChar = 0;
-										aLineNum++;
-
-										aStream.getline(aString, 8192);
-										if (aString[0]!=0 || !aStream.eof()) // got valid new line
-											continue;
-									}
-									else
-									{
-										aCharIdx--;
-										break;
-									}
-
-									char aStr[512];
-									sprintf(aStr, "ERROR in %s on line %d: Error parsing c++ comment", aFileName.c_str(), aLineNum);
-									MessageBoxA(NULL, aStr, "MODVAL ERROR", MB_OK | MB_ICONERROR);
-									return false;
-								}
-							}
-						}
-					}
-					else if (aChar=='*') // skip C comments
+				}
+				else if (aChar=='*') // skip C comments
+				{
+					if (aLastChar=='/') 
 					{
-						if (aLastChar=='/') 
+						while (true)
 						{
-							while (true)
+							aLastChar = aChar;
+							aChar = aString[++aCharIdx];
+							if (aChar=='/' && aLastChar=='*')
+								break;
+							else if (aChar==0) // line continuation
 							{
-								aLastChar = aChar;
-								aChar = aString[++aCharIdx];
-								if (aChar=='/' && aLastChar=='*')
-									break;
-								else if (aChar==0) // line continuation
-								{
-									aCharIdx = -1;
-									aChar = 0;
-									aLastChar = 0;
-									aLineNum++;
+								aCharIdx = -1;
+								aChar = 0;
+								aLastChar = 0;
+								aLineNum++;
 
-									aStream.getline(aString, 8192);
-									if (aString[0]!=0 || !aStream.eof()) // got valid new line
-										continue;
+								aStream.getline(aString, 8192);
+								if (aString[0]!=0 || !aStream.eof()) // got valid new line
+									continue;
 
-									char aStr[512];
-									sprintf(aStr, "ERROR in %s on line %d: Error parsing c comment", aFileName.c_str(), aLineNum);
-									MessageBoxA(NULL, aStr, "MODVAL ERROR", MB_OK | MB_ICONERROR);
-									return false;
-								}
+								char aStr[512];
+								sprintf(aStr, "ERROR in %s on line %d: Error parsing c comment", theFileName.c_str(), aLineNum);
+								theError = aStr;
+								return false;
 							}
 						}
 					}
-					else if (aChar == '(')
+				}
+				else if (aChar == '(')
+				{
+					int theAreaNum = -1;
+					if ((aCharIdx >= 2) && (aString[aCharIdx-1] == 'M') &&
+						(!isalpha((unsigned char) aString[aCharIdx-2])))
 					{
-						int theAreaNum = -1;
-						if ((aCharIdx >= 2) && (aString[aCharIdx-1] == 'M') &&
-							(!isalpha((unsigned char) aString[aCharIdx-2])))
-						{
-							theAreaNum = 0;							
-						}
-						else if ((aCharIdx >= 3) && 
-							(aString[aCharIdx-1] >= '1') && (aString[aCharIdx-1] <= '9') &&
-							(aString[aCharIdx-2] == 'M') &&
-							(!isalpha((unsigned char) aString[aCharIdx-3])))
-						{
-							theAreaNum = aString[aCharIdx-1] - '0';
-						}
-
-						if (theAreaNum != -1)
-						{
-							while (aModMapItr!=aModMap.end() && aModMapItr->second.mLineNum<aLineNum)
-								++aModMapItr;
+						theAreaNum = 0;							
+					}
+					else if ((aCharIdx >= 3) && 
+						(aString[aCharIdx-1] >= '1') && (aString[aCharIdx-1] <= '9') &&
+						(aString[aCharIdx-2] == 'M') &&
+						(!isalpha((unsigned char) aString[aCharIdx-3])))
+					{
+						theAreaNum = aString[aCharIdx-1] - '0';
+					}
 
-							if (aModMapItr!=aModMap.end() && aModMapItr->second.mLineNum==aLineNum)
-							{
-								const char *aPtr = aModMapItr->second.mStrPtr;
-								aModMapItr++;
-
-								int anIntVal = 0;
-								double aDoubleVal = 0.0;
-								std::string aStrVal;
-
-								// Try to parse out a number
-								if ((ModStringToString(aString + aCharIdx + 1, aStrVal)) ||
-									(ModStringToInteger(aString + aCharIdx + 1, &anIntVal)) ||
-									(ModStringToDouble(aString + aCharIdx + 1, &aDoubleVal)))
-								{						
-									// We found a mod value!
-
-									if (*aPtr!=0) // have stored something here
-										CreateFileMods(aPtr);
-
-									ModStorage* aModStorage = *(ModStorage**)(aPtr+1);
-									aModStorage->mInt = anIntVal;
-									aModStorage->mDouble = aDoubleVal;
-									aModStorage->mString = aStrVal;
-									aModStorage->mChanged = true;
-								}
-								else
-								{
-									char aStr[512];
-									sprintf(aStr, "ERROR in %s on line %d.  Parsing Error.", aFileName.c_str(), aLineNum);
-									MessageBoxA(NULL, aStr, "MODVAL ERROR", MB_OK | MB_ICONERROR);
+					if (theAreaNum != -1)
+					{
+						while (aModMapItr!=aModMap.end() && aModMapItr->second.mLineNum<aLineNum)
+							++aModMapItr;
 
-									return false;
-								}
+						if (aModMapItr!=aModMap.end() && aModMapItr->second.mLineNum==aLineNum)
+						{
+							ModSite &aSite = aModMapItr->second;
+							aModMapItr++;
+
+							int anIntVal = 0;
+							double aDoubleVal = 0.0;
+							std::string aStrVal;
+
+							// Try to parse out a number
+							if ((ModStringToString(aString + aCharIdx + 1, aStrVal)) ||
+								(ModStringToInteger(aString + aCharIdx + 1, &anIntVal)) ||
+								(ModStringToDouble(aString + aCharIdx + 1, &aDoubleVal)))
+							{						
+								// We found a mod value!
+								PublishModValue(aSite, anIntVal, aDoubleVal, aStrVal);
 							}
 							else
 							{
-								// Functions can be optimized out
+								char aStr[512];
+								sprintf(aStr, "ERROR in %s on line %d.  Parsing Error.", theFileName.c_str(), aLineNum);
+								theError = aStr;
+								return false;
 							}
 						}
+						else
+						{
+							// Functions can be optimized out
+						}
 					}
-
-					aCharIdx++;
 				}
 
-				aLineNum++;
+				aCharIdx++;
 			}
+
+			aLineNum++;
 		}
-		else
+	}
+	else
+	{
+		theError = "ERROR: Unable to open " + theFileName + " for reparsing.";
+		return false;
+	}		
+
+	return true;
+}
+
+// Walking every loaded module is slow, so it's done without holding the lock
+//  that each M()'s first run waits on
+static void FindModVals()
+{
+	{
+		AutoCrit aCrit(GetModValCritSect());
+		if (gFoundModVals)
+			return;
+	}
+
+	char anEXEName[256];
+	GetModuleFileNameA(NULL, anEXEName, 256);
+	time_t anEXETime = GetFileDate(anEXEName);
+
+	ModValLocationVector aLocations;
+	FindModValsInMemory(aLocations);
+
+	AutoCrit aCrit(GetModValCritSect());
+	if (gFoundModVals)
+		return;
+
+	gFoundModVals = true;
+	gLastFileTime = anEXETime;
+
+	FileModMap &aMap = GetFileModMap();
+	for (int i = 0; i < (int) aLocations.size(); i++)
+	{
+		const ModValLocation& aLocation = aLocations[i];
+		aMap[aLocation.mFileName].mMap[aLocation.mCounter].mLineNum = aLocation.mLineNum;
+	}
+}
+
+bool Sexy::ReparseModValues()
+{
+	bool hasNewFiles = false;
+	std::string aFileList;
+	std::string anError;
+
+	FindModVals();
+
+	{
+		AutoCrit aCrit(GetModValCritSect());
+
+		// Process each file one at a time
+		FileModMap &aMap = GetFileModMap();
+		FileModMap::iterator aFileModItr;
+		for (aFileModItr = aMap.begin(); aFileModItr != aMap.end(); ++aFileModItr)
 		{
-			MessageBoxA(NULL, (std::string("ERROR: Unable to open ") + aFileName + " for reparsing.").c_str(), "MODVAL ERROR!", MB_OK | MB_ICONERROR);
-			return false;
-		}		
+			FileMod &aFileMod = aFileModItr->second;
+			if (!aFileMod.mHasMods)
+				continue;
+
+			std::string aFileName = aFileModItr->first;
+
+			time_t aThisTime = GetFileDate(aFileName);
+			if (aThisTime > gLastFileTime)
+			{
+				gLastFileTime = aThisTime;
+				hasNewFiles = true;
+			}
+
+			if (aFileList.length() > 0)
+				aFileList += "\r\n  ";
+			aFileList += aFileName;
+
+			if (!ParseModFile(aFileName, aFileMod, anError))
+				break;
+
+			aFileMod.mWatchTime = max(aFileMod.mWatchTime, aThisTime);
+		}
+	}
+
+	if (anError.length() > 0)
+	{
+		MessageBoxA(NULL, anError.c_str(), "MODVAL ERROR", MB_OK | MB_ICONERROR);
+		return false;
 	}
 
 	if (!hasNewFiles)
@@ -667,3 +695,106 @@ bool Sexy::ReparseModValues()
 
 	return true;
 }
+
+typedef std::map<std::string, HANDLE> ModWatchMap;
+
+static void ModValWatchThreadProc(void* theArg)
+{
+	ModWatchMap aWatchMap; // directory -> change notification
+
+	while (gModValWatching)
+	{
+		FindModVals();
+
+		{
+			AutoCrit aCrit(GetModValCritSect());
+
+			FileModMap &aMap = GetFileModMap();
+			FileModMap::iterator aFileModItr;
+			for (aFileModItr = aMap.begin(); aFileModItr != aMap.end(); ++aFileModItr)
+			{
+				FileMod &aFileMod = aFileModItr->second;
+				if (!aFileMod.mHasMods)
+					continue;
+
+				const std::string& aFileName = aFileModItr->first;
+				time_t aThisTime = GetFileDate(aFileName);
+
+				// First look at a file, or a file that has been saved since
+				if (aFileMod.mWatchTime == 0)
+					aFileMod.mWatchTime = aThisTime;
+				else if (aThisTime > aFileMod.mWatchTime)
+				{
+					aFileMod.mWatchTime = aThisTime;
+
+					std::string anError;
+					if (ParseModFile(aFileName, aFileMod, anError))
+						OutputDebugStringA(("MODVAL: Reparsed " + aFileName + "\r\n").c_str());
+					else
+						OutputDebugStringA(("MODVAL " + anError + "\r\n").c_str());
+				}
+
+				std::string aDir = GetFileDir(aFileName);
+				if (aDir.length() == 0)
+					aDir = ".";
+
+				if (aWatchMap.find(aDir) == aWatchMap.end())
+					aWatchMap[aDir] = FindFirstChangeNotificationA(aDir.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE);
+			}
+		}
+
+		std::vector<HANDLE> aHandles;
+		ModWatchMap::iterator aWatchItr;
+		for (aWatchItr = aWatchMap.begin(); aWatchItr != aWatchMap.end(); ++aWatchItr)
+		{
+			if (aWatchItr->second != INVALID_HANDLE_VALUE)
+				aHandles.push_back(aWatchItr->second);
+		}
+
+		// Wake up now and then to pick up newly registered files and to exit
+		if (aHandles.empty())
+		{
+			Sleep(500);
+			continue;
+		}
+
+		DWORD aResult = WaitForMultipleObjects(min((int) aHandles.size(), MAXIMUM_WAIT_OBJECTS), &aHandles[0], FALSE, 500);
+		if ((aResult >= WAIT_OBJECT_0) && (aResult < WAIT_OBJECT_0 + aHandles.size()))
+		{
+			FindNextChangeNotification(aHandles[aResult - WAIT_OBJECT_0]);
+
+			// Give the editor a moment to finish writing
+			Sleep(100);
+		}
+	}
+
+	ModWatchMap::iterator aWatchItr;
+	for (aWatchItr = aWatchMap.begin(); aWatchItr != aWatchMap.end(); ++aWatchItr)
+	{
+		if (aWatchItr->second != INVALID_HANDLE_VALUE)
+			FindCloseChangeNotification(aWatchItr->second);
+	}
+
+	gModValWatchRunning = false;
+}
+
+void Sexy::StartModValWatcher()
+{
+	AutoCrit aCrit(GetModValCritSect());
+	gModValAutoWatch = true;
+	if (gModValWatching)
+		return;
+
+	gModValWatching = true;
+	gModValWatchRunning = true;
+	_beginthread(ModValWatchThreadProc, 0, NULL);
+}
+
+void Sexy::StopModValWatcher()
+{
+	// Stays stopped until StartModValWatcher is called again
+	gModValAutoWatch = false;
+	gModValWatching = false;
+	while (gModValWatchRunning)
+		Sleep(10);
+}
@@ -17,6 +17,10 @@
  Example:
 	x = x + M(2.1);
 
+ Once a M() has run, a background thread also watches its source file and
+ reparses it as soon as it is saved, so ReparseModValues() is only needed
+ to force a full reparse.
+
  Caveats:
 	This module determines which files to parse through (during
 	ReparseModValues()) at run-time, so if a M() macro has not yet been
@@ -24,9 +28,10 @@
 	updated.
 
  Performance:
-	There a small setup cost the first time each M() value is accessed
-	after program startup and reparsing, but after that there is just the 
-	tiny overhead of a function call and a few vector dereferences.
+	Each M() has its own function-local static slot.  The first time it
+	runs it registers the slot, after that it is an inlined flag test and
+	a pointer load.  Reparsing swaps in a new ModValue for the slot rather
+	than modifying the old one, so readers never see a half written value.
 
  */
 
@@ -45,10 +50,10 @@ namespace Sexy
 #define M8(val) (val)
 #define M9(val) (val)
 #else
-#define MODVAL_STR_COUNTER2(x,y,z) x#y","#z
-#define MODVAL_STR_COUNTER1(x,y,z) MODVAL_STR_COUNTER2(x,y,z)
-#define MODVAL_STR_COUNTER(x) MODVAL_STR_COUNTER1(x,__COUNTER__,__LINE__)
-#define M(val) ModVal(0, MODVAL_STR_COUNTER("SEXY_SEXYMODVAL"__FILE__), (val))
+// The counter is expanded once so the slot and the string agree on it
+#define MODVAL_SITE2(x,y,z,val) Sexy::ModVal(Sexy::ModValSite<y>(), x#y","#z, (val))
+#define MODVAL_SITE1(x,y,z,val) MODVAL_SITE2(x,y,z,val)
+#define M(val) MODVAL_SITE1("SEXY_SEXYMODVAL"__FILE__, __COUNTER__, __LINE__, val)
 #define M1(val) M(val)
 #define M2(val) M(val)
 #define M3(val) M(val)
@@ -60,13 +65,71 @@ namespace Sexy
 #define M9(val) M(val)
 #endif
 
-int				ModVal(int theAreaNum, const char* theFileName, int theInt);
-double			ModVal(int theAreaNum, const char* theFileName, double theDouble);
-float			ModVal(int theAreaNum, const char* theFileName, float theFloat);
-const char*		ModVal(int theAreaNum, const char* theFileName, const char *theStr);
+struct ModValue
+{
+	int						mInt;
+	double					mDouble;
+	std::string				mString;
+};
+
+// Zero initialized, so a static one needs no construction guard
+struct ModStorage
+{
+	volatile bool			mRegistered;
+	ModValue* volatile		mValue;			// NULL until the source value is changed
+};
+
+namespace
+{
+	// __COUNTER__ is only unique within a translation unit, so each one gets
+	//  its own copies of these
+	template <int theCounter> inline ModStorage& ModValSite()
+	{
+		static ModStorage aStorage;
+		return aStorage;
+	}
+}
+
+void			RegisterModVal(ModStorage& theStorage, const char* theFileName);
+
+inline const ModValue* GetModValue(ModStorage& theStorage, const char* theFileName)
+{
+	if (!theStorage.mRegistered)
+		RegisterModVal(theStorage, theFileName);
+	return theStorage.mValue;
+}
+
+inline int ModVal(ModStorage& theStorage, const char* theFileName, int theInt)
+{
+	const ModValue* aValue = GetModValue(theStorage, theFileName);
+	return (aValue != NULL) ? aValue->mInt : theInt;
+}
+
+inline double ModVal(ModStorage& theStorage, const char* theFileName, double theDouble)
+{
+	const ModValue* aValue = GetModValue(theStorage, theFileName);
+	return (aValue != NULL) ? aValue->mDouble : theDouble;
+}
+
+inline float ModVal(ModStorage& theStorage, const char* theFileName, float theFloat)
+{
+	const ModValue* aValue = GetModValue(theStorage, theFileName);
+	return (aValue != NULL) ? (float) aValue->mDouble : theFloat;
+}
+
+inline const char* ModVal(ModStorage& theStorage, const char* theFileName, const char *theStr)
+{
+	const ModValue* aValue = GetModValue(theStorage, theFileName);
+	return (aValue != NULL) ? aValue->mString.c_str() : theStr;
+}
+
 bool			ReparseModValues();
 void			AddModValEnum(const std::string &theEnumName, int theVal);
 
+// The watcher starts by itself when the first M() registers
+void			StartModValWatcher();
+void			StopModValWatcher();
+
 }
 
 #endif //__MODVAL_H__
\ No newline at end of file
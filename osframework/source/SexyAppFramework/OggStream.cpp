@@ -0,0 +1,130 @@
+#include "OggStream.h"
+#include "..\PakLib\PakInterface.h"
+
+#include "ogg/ivorbiscodec.h"
+#include "ogg/ivorbisfile.h"
+
+using namespace Sexy;
+
+static int p_fseek64_wrap(PFILE *f,ogg_int64_t off,int whence){
+	if(f==NULL)return(-1);
+	return p_fseek(f,(long)off,whence);
+}
+
+int ov_pak_open(PFILE *f,OggVorbis_File *vf,char *initial,long ibytes){
+	ov_callbacks callbacks = {
+		(size_t (*)(void *, size_t, size_t, void *))  p_fread,
+		(int (*)(void *, ogg_int64_t, int))             p_fseek64_wrap,
+		(int (*)(void *))                             p_fclose,
+		(long (*)(void *))                            p_ftell
+	};
+
+	return ov_open_callbacks((void *)f, vf, initial, ibytes, callbacks);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+OggStream::OggStream()
+{
+	mVorbisFile = NULL;
+	mChannels = 0;
+	mSampleRate = 0;
+	mBlockAlign = 0;
+	mTotalBytes = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+OggStream::~OggStream()
+{
+	Close();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool OggStream::Open(const std::string& theFilename)
+{
+	Close();
+
+	PFILE *aFile = p_fopen(theFilename.c_str(),"rb");
+	if (aFile==NULL)
+		return false;
+
+	OggVorbis_File* aVorbisFile = new OggVorbis_File;
+	if (ov_pak_open(aFile, aVorbisFile, NULL, 0) < 0)
+	{
+		p_fclose(aFile);
+		delete aVorbisFile;
+		return false;
+	}
+
+	vorbis_info *anInfo = ov_info(aVorbisFile,-1);
+	mChannels = anInfo->channels;
+	mSampleRate = anInfo->rate;
+	mBlockAlign = mChannels*2;
+	mTotalBytes = (int) (ov_pcm_total(aVorbisFile,-1) * mBlockAlign);
+
+	mVorbisFile = aVorbisFile;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void OggStream::Close()
+{
+	if (mVorbisFile == NULL)
+		return;
+
+	OggVorbis_File* aVorbisFile = (OggVorbis_File*) mVorbisFile;
+	ov_clear(aVorbisFile); // also closes the file
+	delete aVorbisFile;
+
+	mVorbisFile = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool OggStream::Rewind()
+{
+	if (mVorbisFile == NULL)
+		return false;
+
+	return ov_pcm_seek((OggVorbis_File*) mVorbisFile, 0) == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int OggStream::Read(void* theBuffer, int theBytes, bool looping)
+{
+	if (mVorbisFile == NULL)
+		return 0;
+
+	OggVorbis_File* aVorbisFile = (OggVorbis_File*) mVorbisFile;
+
+	char* aPtr = (char*) theBuffer;
+	int aNumBytes = theBytes;
+	bool justRewound = false;
+
+	while (aNumBytes > 0)
+	{
+		int current_section;
+		long ret = ov_read(aVorbisFile,aPtr,aNumBytes,&current_section);
+		if (ret > 0)
+		{
+			aPtr += ret;
+			aNumBytes -= ret;
+			justRewound = false;
+		}
+		else if ((ret == 0) && (looping) && (!justRewound))
+		{
+			// Don't spin forever on a stream with no samples in it
+			if (!Rewind())
+				break;
+			justRewound = true;
+		}
+		else
+			break;
+	}
+
+	return theBytes - aNumBytes;
+}
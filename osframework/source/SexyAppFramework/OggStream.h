@@ -0,0 +1,42 @@
+#ifndef __OGGSTREAM_H__
+#define __OGGSTREAM_H__
+
+#include "Common.h"
+
+namespace Sexy
+{
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Incremental 16-bit PCM decoder for OGG files (through PakInterface), not
+//  tied to any audio output
+class OggStream
+{
+protected:
+	void*					mVorbisFile;
+
+public:
+	int						mChannels;
+	int						mSampleRate;
+	int						mBlockAlign;
+	int						mTotalBytes;	// decoded size of the whole file
+
+public:
+	OggStream();
+	virtual ~OggStream();
+
+	bool					Open(const std::string& theFilename);
+	void					Close();
+	bool					IsOpen()	{ return mVorbisFile != NULL; }
+
+	bool					Rewind();
+
+	// Decodes up to theBytes, wrapping around to the start if looping.
+	//  Returns the number of bytes written, less than theBytes only at the end
+	//  of a non-looping stream or on a decode error.
+	int						Read(void* theBuffer, int theBytes, bool looping);
+};
+
+}
+
+#endif //__OGGSTREAM_H__
@@ -0,0 +1,273 @@
+#include "ParticleSystem.h"
+#include "Graphics.h"
+#include "Image.h"
+#include <math.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define PARTICLE_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace Sexy;
+
+static float RandRange(float theMin, float theMax)
+{
+	if (theMax <= theMin)
+		return theMin;
+
+	return theMin + Rand(theMax - theMin);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+ParticleEmitterDef::ParticleEmitterDef()
+{
+	mImage = NULL;
+	mEmitRate = 1;
+	mMaxParticles = 1000;
+	mLifeMin = 50;
+	mLifeMax = 50;
+	mSpeedMin = 1;
+	mSpeedMax = 1;
+	mAngleMin = 0;
+	mAngleMax = 360;
+	mSpawnWidth = 0;
+	mSpawnHeight = 0;
+	mGravityX = 0;
+	mGravityY = 0;
+	mDrag = 1;
+	mScaleStart = 1;
+	mScaleEnd = 1;
+	mColorStart = Color::White;
+	mColorEnd = Color::White;
+	mAdditive = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+ParticleSystem::ParticleSystem(const ParticleEmitterDef* theDef)
+{
+	mDef = theDef;
+	mX = 0;
+	mY = 0;
+	mEmitting = true;
+	mEmitAccum = 0;
+	mCount = 0;
+	mCapacity = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+ParticleSystem::~ParticleSystem()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ParticleSystem::SetDef(const ParticleEmitterDef* theDef)
+{
+	mDef = theDef;
+	Clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ParticleSystem::Grow(int theCapacity)
+{
+	mCapacity = (theCapacity + 3) & ~3;
+
+	mPosX.resize(mCapacity);
+	mPosY.resize(mCapacity);
+	mVelX.resize(mCapacity);
+	mVelY.resize(mCapacity);
+	mAge.resize(mCapacity);
+	mLife.resize(mCapacity);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ParticleSystem::Spawn(float theX, float theY)
+{
+	if ((mDef == NULL) || (mCount >= mDef->mMaxParticles))
+		return;
+
+	if (mCount == mCapacity)
+		Grow(min(max(mCapacity*2, 64), mDef->mMaxParticles));
+
+	float anAngle = RandRange(mDef->mAngleMin, mDef->mAngleMax) * (float) (3.14159265358979 / 180);
+	float aSpeed = RandRange(mDef->mSpeedMin, mDef->mSpeedMax);
+
+	int i = mCount++;
+	mPosX[i] = theX + RandRange(-mDef->mSpawnWidth/2, mDef->mSpawnWidth/2);
+	mPosY[i] = theY + RandRange(-mDef->mSpawnHeight/2, mDef->mSpawnHeight/2);
+	mVelX[i] = (float) cos(anAngle) * aSpeed;
+	mVelY[i] = (float) -sin(anAngle) * aSpeed;
+	mAge[i] = 0;
+	mLife[i] = max(1.0f, RandRange(mDef->mLifeMin, mDef->mLifeMax));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ParticleSystem::Burst(int theCount)
+{
+	for (int i = 0; i < theCount; i++)
+		Spawn(mX, mY);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ParticleSystem::Integrate()
+{
+	float aGravityX = mDef->mGravityX;
+	float aGravityY = mDef->mGravityY;
+	float aDrag = mDef->mDrag;
+
+	int i = 0;
+
+#ifdef PARTICLE_SSE
+	// mCapacity is a multiple of 4, so the last group can safely run over the
+	//  dead slots past mCount
+	__m128 aGravityX4 = _mm_set1_ps(aGravityX);
+	__m128 aGravityY4 = _mm_set1_ps(aGravityY);
+	__m128 aDrag4 = _mm_set1_ps(aDrag);
+	__m128 anOne4 = _mm_set1_ps(1.0f);
+
+	int aCount4 = (mCount + 3) & ~3;
+	for (; i < aCount4; i += 4)
+	{
+		__m128 aVelX = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&mVelX[i]), aGravityX4), aDrag4);
+		__m128 aVelY = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&mVelY[i]), aGravityY4), aDrag4);
+		_mm_storeu_ps(&mVelX[i], aVelX);
+		_mm_storeu_ps(&mVelY[i], aVelY);
+		_mm_storeu_ps(&mPosX[i], _mm_add_ps(_mm_loadu_ps(&mPosX[i]), aVelX));
+		_mm_storeu_ps(&mPosY[i], _mm_add_ps(_mm_loadu_ps(&mPosY[i]), aVelY));
+		_mm_storeu_ps(&mAge[i], _mm_add_ps(_mm_loadu_ps(&mAge[i]), anOne4));
+	}
+#endif
+
+	for (; i < mCount; i++)
+	{
+		mVelX[i] = (mVelX[i] + aGravityX) * aDrag;
+		mVelY[i] = (mVelY[i] + aGravityY) * aDrag;
+		mPosX[i] += mVelX[i];
+		mPosY[i] += mVelY[i];
+		mAge[i] += 1.0f;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ParticleSystem::RemoveDead()
+{
+	int i = 0;
+	while (i < mCount)
+	{
+		if (mAge[i] < mLife[i])
+		{
+			i++;
+			continue;
+		}
+
+		// Order doesn't matter, so fill the hole with the last particle
+		int aLast = --mCount;
+		mPosX[i] = mPosX[aLast];
+		mPosY[i] = mPosY[aLast];
+		mVelX[i] = mVelX[aLast];
+		mVelY[i] = mVelY[aLast];
+		mAge[i] = mAge[aLast];
+		mLife[i] = mLife[aLast];
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ParticleSystem::Update()
+{
+	if (mDef == NULL)
+		return;
+
+	if (mCount > 0)
+	{
+		Integrate();
+		RemoveDead();
+	}
+
+	if (mEmitting)
+	{
+		mEmitAccum += mDef->mEmitRate;
+		while (mEmitAccum >= 1.0f)
+		{
+			Spawn(mX, mY);
+			mEmitAccum -= 1.0f;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ParticleSystem::Draw(Graphics* g)
+{
+	if ((mDef == NULL) || (mDef->mImage == NULL) || (mCount == 0))
+		return;
+
+	Image* anImage = mDef->mImage;
+	float aHalfWidth = anImage->GetWidth() * 0.5f;
+	float aHalfHeight = anImage->GetHeight() * 0.5f;
+
+	const Color& aColorStart = mDef->mColorStart;
+	const Color& aColorEnd = mDef->mColorEnd;
+	int aDeltaRed = aColorEnd.mRed - aColorStart.mRed;
+	int aDeltaGreen = aColorEnd.mGreen - aColorStart.mGreen;
+	int aDeltaBlue = aColorEnd.mBlue - aColorStart.mBlue;
+	int aDeltaAlpha = aColorEnd.mAlpha - aColorStart.mAlpha;
+	float aDeltaScale = mDef->mScaleEnd - mDef->mScaleStart;
+
+	// Two triangles per particle, all handed to the image in one call
+	if ((int) mVertices.size() < mCount*6)
+		mVertices.resize(mCount*6);
+
+	TriVertex* aVertex = &mVertices[0];
+	int aNumTriangles = 0;
+
+	for (int i = 0; i < mCount; i++)
+	{
+		float aTime = mAge[i] / mLife[i];
+
+		int anAlpha = aColorStart.mAlpha + (int) (aDeltaAlpha * aTime);
+		if (anAlpha <= 0)
+			continue;
+
+		// A vertex color of 0 means "use the Graphics color", but alpha is never 0 here
+		DWORD aColor = (anAlpha << 24) |
+			((aColorStart.mRed + (int) (aDeltaRed * aTime)) << 16) |
+			((aColorStart.mGreen + (int) (aDeltaGreen * aTime)) << 8) |
+			(aColorStart.mBlue + (int) (aDeltaBlue * aTime));
+
+		float aScale = mDef->mScaleStart + aDeltaScale * aTime;
+		float aLeft = mPosX[i] - aHalfWidth * aScale;
+		float aRight = mPosX[i] + aHalfWidth * aScale;
+		float aTop = mPosY[i] - aHalfHeight * aScale;
+		float aBottom = mPosY[i] + aHalfHeight * aScale;
+
+		aVertex[0] = TriVertex(aLeft, aTop, 0, 0, aColor);
+		aVertex[1] = TriVertex(aRight, aTop, 1, 0, aColor);
+		aVertex[2] = TriVertex(aLeft, aBottom, 0, 1, aColor);
+		aVertex[3] = TriVertex(aRight, aTop, 1, 0, aColor);
+		aVertex[4] = TriVertex(aRight, aBottom, 1, 1, aColor);
+		aVertex[5] = TriVertex(aLeft, aBottom, 0, 1, aColor);
+		aVertex += 6;
+		aNumTriangles += 2;
+	}
+
+	if (aNumTriangles == 0)
+		return;
+
+	int anOldDrawMode = g->GetDrawMode();
+	if (mDef->mAdditive)
+		g->SetDrawMode(Graphics::DRAWMODE_ADDITIVE);
+
+	typedef TriVertex TriVertexTriple[3];
+	g->DrawTrianglesTex(anImage, (TriVertexTriple*) &mVertices[0], aNumTriangles);
+
+	g->SetDrawMode(anOldDrawMode);
+}
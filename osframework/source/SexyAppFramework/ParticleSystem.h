@@ -0,0 +1,87 @@
+#ifndef __PARTICLESYSTEM_H__
+#define __PARTICLESYSTEM_H__
+
+#include "Common.h"
+#include "Color.h"
+#include "TriVertex.h"
+
+namespace Sexy
+{
+
+class Graphics;
+class Image;
+
+typedef std::vector<float> FloatVector;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Describes how an emitter spawns and animates its particles.  Times are in
+//  updates and distances in pixels per update, like everything else driven
+//  from Widget::Update.  Usually loaded from a <Particle> resource.
+class ParticleEmitterDef
+{
+public:
+	Image*					mImage;
+	float					mEmitRate;			// particles per update while emitting
+	int						mMaxParticles;
+	float					mLifeMin, mLifeMax;
+	float					mSpeedMin, mSpeedMax;
+	float					mAngleMin, mAngleMax;	// degrees, 0 is to the right and 90 is up
+	float					mSpawnWidth, mSpawnHeight;	// particles start anywhere in this box around the emitter
+	float					mGravityX, mGravityY;	// added to the velocity every update
+	float					mDrag;				// velocity is multiplied by this every update
+	float					mScaleStart, mScaleEnd;
+	Color					mColorStart, mColorEnd;
+	bool					mAdditive;
+
+public:
+	ParticleEmitterDef();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Particles are kept as structure-of-arrays so the per update integration
+//  runs four at a time with SSE.  Dead particles are swap-removed with the
+//  last live one, so the live particles are always [0, mCount) and nothing
+//  is allocated once the arrays have grown to mDef->mMaxParticles.  Draw
+//  submits every particle as a single textured triangle list.
+class ParticleSystem
+{
+public:
+	const ParticleEmitterDef* mDef;
+	float					mX, mY;				// emitter position
+	bool					mEmitting;
+	float					mEmitAccum;
+
+	int						mCount;
+	int						mCapacity;			// always a multiple of 4 so the SSE loop can run past mCount
+	FloatVector				mPosX, mPosY;
+	FloatVector				mVelX, mVelY;
+	FloatVector				mAge, mLife;
+
+	std::vector<TriVertex>	mVertices;
+
+protected:
+	void					Grow(int theCapacity);
+	void					Integrate();
+	void					RemoveDead();
+
+public:
+	ParticleSystem(const ParticleEmitterDef* theDef = NULL);
+	virtual ~ParticleSystem();
+
+	void					SetDef(const ParticleEmitterDef* theDef);
+	void					SetPosition(float theX, float theY) { mX = theX; mY = theY; }
+	void					Spawn(float theX, float theY);
+	void					Burst(int theCount);
+	void					Clear() { mCount = 0; mEmitAccum = 0; }
+	int						GetCount() { return mCount; }
+	bool					IsDone() { return !mEmitting && mCount == 0; }
+
+	virtual void			Update();
+	virtual void			Draw(Graphics* g);
+};
+
+}
+
+#endif //__PARTICLESYSTEM_H__
@@ -130,6 +130,44 @@ int PerfTimer::GetCPUSpeedMHz()
 	return (int)(gCPUSpeed/1000000);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+__int64 PerfTimer::GetTimeNS()
+{
+	static LARGE_INTEGER aFreq = {0};
+	if (aFreq.QuadPart == 0)
+		QueryPerformanceFrequency(&aFreq);
+
+	LARGE_INTEGER aCount;
+	QueryPerformanceCounter(&aCount);
+
+	// Split so the multiply can't overflow however long the machine has been up
+	__int64 aSeconds = aCount.QuadPart / aFreq.QuadPart;
+	__int64 aRemainder = aCount.QuadPart % aFreq.QuadPart;
+	return aSeconds*1000000000 + (aRemainder*1000000000) / aFreq.QuadPart;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void PerfTimer::WaitUntilNS(__int64 theTimeNS, double theSpinMS)
+{
+	// Sleep() is only good to about a millisecond even with timeBeginPeriod(1),
+	//  so sleep most of the way and spin the rest
+	__int64 aSpinNS = (__int64) (theSpinMS * 1000000);
+	for (;;)
+	{
+		__int64 aLeftNS = theTimeNS - GetTimeNS();
+		if (aLeftNS <= 0)
+			break;
+
+		int aSleepMS = (int) ((aLeftNS - aSpinNS) / 1000000);
+		if (aSleepMS > 0)
+			Sleep(aSleepMS);
+		else
+			Sleep(0);
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 struct PerfInfo
@@ -26,6 +26,9 @@ public:
 
 	static __int64 GetCPUSpeed(); // in Hz
 	static int GetCPUSpeedMHz(); 
+
+	static __int64 GetTimeNS(); // monotonic, from the performance counter
+	static void WaitUntilNS(__int64 theTimeNS, double theSpinMS = 1.5); // sleeps, then spins the last theSpinMS
 };
 
 ///////////////////////////////////////////////////////////////////////////////
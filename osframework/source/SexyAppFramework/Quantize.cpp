@@ -4,75 +4,348 @@
 
 using namespace Sexy;
 
+static inline ulong HashColor(ulong theColor, int theShift)
+{
+	return (ulong) (theColor * 0x9E3779B1UL) >> theShift;
+}
+
 bool Sexy::Quantize8Bit(const ulong* theSrcBits, int theWidth, int theHeight, uchar* theDestColorIndices, ulong* theDestColorTable)
 {
 	int aSize = theWidth*theHeight;
 
+	// Open addressed table of 512 slots, never more than half full
+	const int HASH_BITS = 9;
+	const int HASH_SIZE = 1 << HASH_BITS;
+
+	ulong aHashColors[HASH_SIZE];
+	short aHashIndices[HASH_SIZE];
+	memset(aHashIndices, -1, sizeof(aHashIndices));
+
 	int aColorTableSize = 0;
-		
-	ulong aSearchTable[256];
-	uchar aTranslationTable[256]; // From search table to color table
 
-	if (aSize > 0)
-	{
-		aSearchTable[0] = theSrcBits[0];
-		theDestColorTable[0] = theSrcBits[0];
-		aTranslationTable[0] = 0;
-		theDestColorIndices[0] = 0;
-		aColorTableSize++;
-	}
+	ulong aLastColor = 0;
+	uchar aLastIndex = 0;
 
-	for (int anIdx = 1; anIdx < aSize; anIdx++)
+	for (int anIdx = 0; anIdx < aSize; anIdx++)
 	{
-		ulong aColor = theSrcBits[anIdx];		
+		ulong aColor = theSrcBits[anIdx];
 
-		int aLeftPos = 0;
-		int aRightPos = aColorTableSize-1;
-		int aMiddlePos = (aLeftPos+aRightPos)/2;
+		// Runs of the same color are very common
+		if ((anIdx > 0) && (aColor == aLastColor))
+		{
+			theDestColorIndices[anIdx] = aLastIndex;
+			continue;
+		}
 
+		int aSlot = HashColor(aColor, 32 - HASH_BITS);
 		for (;;)
-		{	
-			ulong aCheckColor = aSearchTable[aMiddlePos];
-			
-			if (aColor < aCheckColor)
-				aRightPos = aMiddlePos - 1;
-			else if (aColor > aCheckColor)
-				aLeftPos = aMiddlePos + 1;			
-			else
+		{
+			if (aHashIndices[aSlot] == -1)
 			{
-				theDestColorIndices[anIdx] = aTranslationTable[aMiddlePos];
+				if (aColorTableSize >= 256)
+					return false;
+
+				aHashColors[aSlot] = aColor;
+				aHashIndices[aSlot] = aColorTableSize;
+				theDestColorTable[aColorTableSize] = aColor;
+				aColorTableSize++;
 				break;
 			}
 
-			if (aLeftPos > aRightPos)
-			{
-				if (aColorTableSize >= 256)
-					return false;
+			if (aHashColors[aSlot] == aColor)
+				break;
 
-				int anInsertPos = aLeftPos;
-				if ((anInsertPos < aColorTableSize) && (aColor > aSearchTable[anInsertPos]))
-					anInsertPos++;
+			aSlot = (aSlot + 1) & (HASH_SIZE - 1);
+		}
 
-				// Insert color into the table
-				memmove(aSearchTable+anInsertPos+1, aSearchTable+anInsertPos, (aColorTableSize-anInsertPos) * sizeof(ulong));
-				aSearchTable[anInsertPos] = aColor;
+		aLastColor = aColor;
+		aLastIndex = (uchar) aHashIndices[aSlot];
+		theDestColorIndices[anIdx] = aLastIndex;
+	}
 
-				memmove(aTranslationTable+anInsertPos+1, aTranslationTable+anInsertPos, (aColorTableSize-anInsertPos) * sizeof(uchar));
-				aTranslationTable[anInsertPos] = aColorTableSize;
+	return true;
+}
 
-				theDestColorTable[aColorTableSize] = aColor;
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+namespace
+{
 
-				theDestColorIndices[anIdx] = aColorTableSize;
+struct ColorCount
+{
+	ulong					mColor;
+	ulong					mCount;
+};
 
-				aColorTableSize++;
+struct ColorBox
+{
+	int						mStart;
+	int						mEnd;
+	int						mSplitChannel; // shift of the channel with the widest range
+	int						mRange;
+};
 
-				break;
+struct ChannelLess
+{
+	int mShift;
+
+	ChannelLess(int theShift) : mShift(theShift) {}
+	bool operator()(const ColorCount& a, const ColorCount& b) const { return ((a.mColor >> mShift) & 0xFF) < ((b.mColor >> mShift) & 0xFF); }
+};
+
+typedef std::vector<ColorCount> ColorCountVector;
+typedef std::vector<ColorBox> ColorBoxVector;
+
+}
+
+static void BuildHistogram(const ulong* theSrcBits, int theSize, ColorCountVector& theHistogram)
+{
+	int aHashBits = 10;
+	std::vector<int> aHash(1 << aHashBits, -1);
+
+	theHistogram.clear();
+
+	for (int i = 0; i < theSize; i++)
+	{
+		ulong aColor = theSrcBits[i];
+		if ((aColor & 0xFF000000) == 0)
+			aColor = 0; // all fully transparent pixels share one palette entry
+
+		int aMask = (1 << aHashBits) - 1;
+		int aSlot = HashColor(aColor, 32 - aHashBits);
+		while ((aHash[aSlot] != -1) && (theHistogram[aHash[aSlot]].mColor != aColor))
+			aSlot = (aSlot + 1) & aMask;
+
+		if (aHash[aSlot] != -1)
+		{
+			theHistogram[aHash[aSlot]].mCount++;
+			continue;
+		}
+
+		ColorCount anEntry;
+		anEntry.mColor = aColor;
+		anEntry.mCount = 1;
+		aHash[aSlot] = theHistogram.size();
+		theHistogram.push_back(anEntry);
+
+		if ((int) theHistogram.size() * 2 > (1 << aHashBits))
+		{
+			// Grow and rehash
+			aHashBits++;
+			aMask = (1 << aHashBits) - 1;
+			aHash.assign(1 << aHashBits, -1);
+
+			for (int j = 0; j < (int) theHistogram.size(); j++)
+			{
+				int aNewSlot = HashColor(theHistogram[j].mColor, 32 - aHashBits);
+				while (aHash[aNewSlot] != -1)
+					aNewSlot = (aNewSlot + 1) & aMask;
+				aHash[aNewSlot] = j;
 			}
+		}
+	}
+}
+
+static void CalcBoxRange(const ColorCountVector& theHistogram, ColorBox& theBox)
+{
+	int aMin[4] = { 255, 255, 255, 255 };
+	int aMax[4] = { 0, 0, 0, 0 };
 
-			aMiddlePos = (aLeftPos+aRightPos)/2;
+	for (int i = theBox.mStart; i < theBox.mEnd; i++)
+	{
+		ulong aColor = theHistogram[i].mColor;
+		for (int aChannel = 0; aChannel < 4; aChannel++)
+		{
+			int aVal = (aColor >> (aChannel*8)) & 0xFF;
+			aMin[aChannel] = min(aMin[aChannel], aVal);
+			aMax[aChannel] = max(aMax[aChannel], aVal);
 		}
 	}
 
-	return true;
+	theBox.mRange = -1;
+	for (int aChannel = 0; aChannel < 4; aChannel++)
+	{
+		if (aMax[aChannel] - aMin[aChannel] > theBox.mRange)
+		{
+			theBox.mRange = aMax[aChannel] - aMin[aChannel];
+			theBox.mSplitChannel = aChannel*8;
+		}
+	}
+
+	if (theBox.mEnd - theBox.mStart <= 1)
+		theBox.mRange = 0;
 }
 
+static int FindNearestColor(ulong theColor, const ulong* theColorTable, int theNumColors)
+{
+	int a = (theColor >> 24) & 0xFF;
+	int r = (theColor >> 16) & 0xFF;
+	int g = (theColor >> 8) & 0xFF;
+	int b = (theColor) & 0xFF;
+
+	int aBestIdx = 0;
+	int aBestDist = 0x7FFFFFFF;
+
+	for (int i = 0; i < theNumColors; i++)
+	{
+		ulong aCheckColor = theColorTable[i];
+		int da = (int) ((aCheckColor >> 24) & 0xFF) - a;
+		int dr = (int) ((aCheckColor >> 16) & 0xFF) - r;
+		int dg = (int) ((aCheckColor >> 8) & 0xFF) - g;
+		int db = (int) ((aCheckColor) & 0xFF) - b;
+
+		int aDist = da*da*2 + dr*dr + dg*dg + db*db;
+		if (aDist < aBestDist)
+		{
+			aBestDist = aDist;
+			aBestIdx = i;
+		}
+	}
+
+	return aBestIdx;
+}
+
+void Sexy::QuantizeMedianCut8Bit(const ulong* theSrcBits, int theWidth, int theHeight, uchar* theDestColorIndices, ulong* theDestColorTable, DWORD theFlags)
+{
+	int aSize = theWidth*theHeight;
+
+	memset(theDestColorTable, 0, 256*sizeof(ulong));
+	if (aSize <= 0)
+		return;
+
+	ColorCountVector aHistogram;
+	BuildHistogram(theSrcBits, aSize, aHistogram);
+
+	// Split the box with the widest channel range until we have 256 boxes
+	ColorBoxVector aBoxes;
+	aBoxes.reserve(256);
+
+	ColorBox aFirstBox;
+	aFirstBox.mStart = 0;
+	aFirstBox.mEnd = aHistogram.size();
+	CalcBoxRange(aHistogram, aFirstBox);
+	aBoxes.push_back(aFirstBox);
+
+	while (aBoxes.size() < 256)
+	{
+		int aSplitIdx = -1;
+		int aBestRange = 0;
+		for (int i = 0; i < (int) aBoxes.size(); i++)
+		{
+			if (aBoxes[i].mRange > aBestRange)
+			{
+				aBestRange = aBoxes[i].mRange;
+				aSplitIdx = i;
+			}
+		}
+
+		if (aSplitIdx == -1)
+			break;
+
+		ColorBox& aBox = aBoxes[aSplitIdx];
+		std::sort(aHistogram.begin() + aBox.mStart, aHistogram.begin() + aBox.mEnd, ChannelLess(aBox.mSplitChannel));
+
+		// Split at the pixel weighted median
+		ulong aTotal = 0;
+		for (int i = aBox.mStart; i < aBox.mEnd; i++)
+			aTotal += aHistogram[i].mCount;
+
+		ulong aRunning = 0;
+		int aMid = aBox.mStart;
+		while ((aMid < aBox.mEnd - 1) && (aRunning + aHistogram[aMid].mCount <= aTotal/2))
+			aRunning += aHistogram[aMid++].mCount;
+		if (aMid == aBox.mStart)
+			aMid++;
+
+		ColorBox aNewBox;
+		aNewBox.mStart = aMid;
+		aNewBox.mEnd = aBox.mEnd;
+		aBox.mEnd = aMid;
+
+		CalcBoxRange(aHistogram, aBox);
+		CalcBoxRange(aHistogram, aNewBox);
+		aBoxes.push_back(aNewBox);
+	}
+
+	// Palette entries are the weighted average of each box.  Remember which
+	//  box every histogram color ended up in for the undithered mapping.
+	int aNumColors = aBoxes.size();
+	std::vector<uchar> aHistogramIndex(aHistogram.size());
+
+	for (int aBoxIdx = 0; aBoxIdx < aNumColors; aBoxIdx++)
+	{
+		ColorBox& aBox = aBoxes[aBoxIdx];
+
+		double aSum[4] = { 0, 0, 0, 0 };
+		double aTotal = 0;
+		for (int i = aBox.mStart; i < aBox.mEnd; i++)
+		{
+			ulong aColor = aHistogram[i].mColor;
+			double aCount = aHistogram[i].mCount;
+			for (int aChannel = 0; aChannel < 4; aChannel++)
+				aSum[aChannel] += ((aColor >> (aChannel*8)) & 0xFF) * aCount;
+			aTotal += aCount;
+
+			aHistogramIndex[i] = aBoxIdx;
+		}
+
+		ulong aColor = 0;
+		for (int aChannel = 0; aChannel < 4; aChannel++)
+			aColor |= ((ulong) (aSum[aChannel] / aTotal + 0.5) & 0xFF) << (aChannel*8);
+		theDestColorTable[aBoxIdx] = aColor;
+	}
+
+	// Direct mapped cache of color -> palette index
+	const int CACHE_BITS = 12;
+	const int CACHE_SIZE = 1 << CACHE_BITS;
+	std::vector<ulong> aCacheColors(CACHE_SIZE);
+	std::vector<short> aCacheIndices(CACHE_SIZE, -1);
+
+	if ((theFlags & QuantizeFlag_Dither) == 0)
+	{
+		for (int i = 0; i < (int) aHistogram.size(); i++)
+		{
+			int aSlot = HashColor(aHistogram[i].mColor, 32 - CACHE_BITS);
+			aCacheColors[aSlot] = aHistogram[i].mColor;
+			aCacheIndices[aSlot] = aHistogramIndex[i];
+		}
+	}
+
+	static const int aBayer[4][4] =
+	{
+		{  0,  8,  2, 10 },
+		{ 12,  4, 14,  6 },
+		{  3, 11,  1,  9 },
+		{ 15,  7, 13,  5 }
+	};
+
+	int anIdx = 0;
+	for (int y = 0; y < theHeight; y++)
+	{
+		for (int x = 0; x < theWidth; x++, anIdx++)
+		{
+			ulong aColor = theSrcBits[anIdx];
+			if ((aColor & 0xFF000000) == 0)
+				aColor = 0;
+			else if (theFlags & QuantizeFlag_Dither)
+			{
+				int anOffset = aBayer[y & 3][x & 3] - 8;
+
+				int r = min(255, max(0, (int) ((aColor >> 16) & 0xFF) + anOffset));
+				int g = min(255, max(0, (int) ((aColor >> 8) & 0xFF) + anOffset));
+				int b = min(255, max(0, (int) ((aColor) & 0xFF) + anOffset));
+
+				aColor = (aColor & 0xFF000000) | (r << 16) | (g << 8) | b;
+			}
+
+			int aSlot = HashColor(aColor, 32 - CACHE_BITS);
+			if ((aCacheIndices[aSlot] == -1) || (aCacheColors[aSlot] != aColor))
+			{
+				aCacheColors[aSlot] = aColor;
+				aCacheIndices[aSlot] = FindNearestColor(aColor, theDestColorTable, aNumColors);
+			}
+
+			theDestColorIndices[anIdx] = (uchar) aCacheIndices[aSlot];
+		}
+	}
+}
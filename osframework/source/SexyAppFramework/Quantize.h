@@ -6,8 +6,18 @@
 namespace Sexy
 {
 
+enum QuantizeFlags
+{
+	QuantizeFlag_AllowLossy					=			0x0001,		// fall back to median cut when an image has more than 256 colors
+	QuantizeFlag_Dither						=			0x0002		// ordered dither the lossy result (implies AllowLossy)
+};
+
+// Exact palettization.  Fails if the image has more than 256 distinct colors.
 bool Quantize8Bit(const ulong* theSrcBits, int theWidth, int theHeight, uchar* theDestColorIndices, ulong* theDestColorTable);
 
+// Median cut palettization.  Always succeeds, theFlags is a combination of QuantizeFlags
+void QuantizeMedianCut8Bit(const ulong* theSrcBits, int theWidth, int theHeight, uchar* theDestColorIndices, ulong* theDestColorTable, DWORD theFlags);
+
 }
 
-#endif //__QUANTIZE_H__
\ No newline at end of file
+#endif //__QUANTIZE_H__
@@ -0,0 +1,145 @@
+#include "RenderPipeline.h"
+#include "DrawList.h"
+#include "DDImage.h"
+#include <process.h>
+
+using namespace Sexy;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+RenderPipeline::RenderPipeline()
+{
+	mDrawLists[0] = new DrawList();
+	mDrawLists[1] = new DrawList();
+	mDrawLists[1]->mListIdx = 1;
+	mRecordIdx = 0;
+	mPendingList = NULL;
+	mFrameCount = 0;
+	mTarget = NULL;
+
+	mKickEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+	mDoneEvent = ::CreateEvent(NULL, TRUE, TRUE, NULL); // manual reset, so waiting on an idle pipeline never blocks
+	mThreadId = 0;
+
+	mRunning = true;
+	mThreadRunning = true;
+	_beginthread(RenderThreadProcStub, 0, this);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+RenderPipeline::~RenderPipeline()
+{
+	WaitForFence();
+
+	mRunning = false;
+	::SetEvent(mKickEvent);
+	while (mThreadRunning)
+		Sleep(10);
+
+	::CloseHandle(mKickEvent);
+	::CloseHandle(mDoneEvent);
+
+	delete mDrawLists[0];
+	delete mDrawLists[1];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void RenderPipeline::RenderThreadProc()
+{
+	mThreadId = ::GetCurrentThreadId();
+
+	for (;;)
+	{
+		::WaitForSingleObject(mKickEvent, INFINITE);
+		if (!mRunning)
+			break;
+
+		DrawList* aList = mPendingList;
+		if (aList != NULL)
+		{
+			// Keep the screen surface locked for the whole frame rather than per call
+			DDImage* aDDImage = dynamic_cast<DDImage*>(mTarget);
+			bool surfaceLocked = false;
+			if (aDDImage != NULL)
+				surfaceLocked = aDDImage->LockSurface();
+
+			aList->Execute(mTarget);
+
+			if (surfaceLocked)
+				aDDImage->UnlockSurface();
+		}
+
+		mPendingList = NULL;
+		::SetEvent(mDoneEvent);
+	}
+
+	mThreadRunning = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void RenderPipeline::RenderThreadProcStub(void *theArg)
+{
+	RenderPipeline* aPipeline = (RenderPipeline*) theArg;
+	aPipeline->RenderThreadProc();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+DrawList* RenderPipeline::BeginFrame(Image* theTarget)
+{
+	// The record list was last executed two frames ago and that frame has been
+	//  fenced since, so it's safe to throw away here
+	DrawList* aList = mDrawLists[mRecordIdx];
+	aList->Reset(theTarget->mWidth, theTarget->mHeight);
+	aList->mFrameId = ++mFrameCount;
+	return aList;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool RenderPipeline::Kick(Image* theTarget)
+{
+	DrawList* aList = mDrawLists[mRecordIdx];
+	if (aList->IsEmpty())
+		return false;
+
+	WaitForFence();
+
+	::ResetEvent(mDoneEvent);
+	mTarget = theTarget;
+	mPendingList = aList;
+	mRecordIdx ^= 1;
+	::SetEvent(mKickEvent);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void RenderPipeline::WaitForFence()
+{
+	// Images can get BitsChanged from inside the render thread's own draws
+	if (::GetCurrentThreadId() == mThreadId)
+		return;
+
+	if (mPendingList != NULL)
+		::WaitForSingleObject(mDoneEvent, INFINITE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool RenderPipeline::IsImageInFlight(Image* theImage)
+{
+	DrawList* aList = mPendingList;
+	return (aList != NULL) && (theImage->mDrawListFrame[aList->mListIdx] == aList->mFrameId);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void RenderPipeline::WaitForImage(Image* theImage)
+{
+	if (IsImageInFlight(theImage))
+		WaitForFence();
+}
@@ -0,0 +1,56 @@
+#ifndef __RENDERPIPELINE_H__
+#define __RENDERPIPELINE_H__
+
+#include "Common.h"
+
+namespace Sexy
+{
+
+class DrawList;
+class Image;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Double buffered draw lists with a render thread behind them.  The main
+//  thread records frame N into one list while the render thread is still
+//  executing frame N-1 onto the screen image from the other.  WaitForFence
+//  blocks until the render thread is idle, after which the screen image can
+//  be presented or touched by the main thread again.  WaitForImage only
+//  blocks if the executing list draws that image, which is what MemoryImage
+//  and DDImage do before changing anything the render thread may be reading
+//  or lazily building.  Enabled with SexyAppBase::mPipelineDraw, software
+//  rendering only.
+class RenderPipeline
+{
+public:
+	DrawList*				mDrawLists[2];
+	int						mRecordIdx;			// list the main thread records into
+	DrawList* volatile		mPendingList;		// list the render thread is executing, NULL when idle
+	ulong					mFrameCount;
+	Image*					mTarget;
+
+	HANDLE					mKickEvent;
+	HANDLE					mDoneEvent;
+	volatile bool			mRunning;
+	volatile bool			mThreadRunning;
+	DWORD					mThreadId;
+
+protected:
+	void					RenderThreadProc();
+	static void				RenderThreadProcStub(void *theArg);
+
+public:
+	RenderPipeline();
+	virtual ~RenderPipeline();
+
+	DrawList*				BeginFrame(Image* theTarget);
+	bool					Kick(Image* theTarget);
+	void					WaitForFence();
+	bool					IsImageInFlight(Image* theImage);
+	void					WaitForImage(Image* theImage);
+	bool					IsBusy() { return mPendingList != NULL; }
+};
+
+}
+
+#endif //__RENDERPIPELINE_H__
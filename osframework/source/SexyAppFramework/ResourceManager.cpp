@@ -6,7 +6,11 @@
 #include "D3DInterface.h"
 #include "ImageFont.h"
 #include "SysFont.h"
+#include "Quantize.h"
+#include "TextureAtlas.h"
+#include "ParticleSystem.h"
 #include "../ImageLib/ImageLib.h"
+#include "../ImageLib/PixelConvert.h"
 
 //#define SEXY_PERF_ENABLED
 #include "PerfTimer.h"
@@ -41,6 +45,24 @@ void ResourceManager::FontRes::DeleteResource()
 	mImage = NULL;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+ResourceManager::ParticleRes::~ParticleRes()
+{
+	delete mDef;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::ParticleRes::DeleteResource()
+{
+	// The def itself stays around since ParticleSystems may still point at it
+	if (mOwnsImage)
+		delete mImage;
+	mImage = NULL;
+	mDef->mImage = NULL;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ResourceManager::ResourceManager(SexyAppBase *theApp) 
@@ -61,6 +83,8 @@ ResourceManager::~ResourceManager()
 	DeleteMap(mImageMap);
 	DeleteMap(mSoundMap);
 	DeleteMap(mFontMap);
+	DeleteMap(mParticleMap);
+	DeleteAtlases("");
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -94,6 +118,25 @@ void ResourceManager::DeleteResources(ResMap &theMap, const std::string &theGrou
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void ResourceManager::DeleteAtlases(const std::string &theGroup)
+{
+	// Images deleted before this have already removed themselves, any that
+	//  are still referenced get their own bits back
+	AtlasMap::iterator anItr = mAtlasMap.begin();
+	while (anItr != mAtlasMap.end())
+	{
+		if (theGroup.empty() || stricmp(anItr->first.c_str(), theGroup.c_str())==0)
+		{
+			delete anItr->second;
+			mAtlasMap.erase(anItr++);
+		}
+		else
+			++anItr;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 void ResourceManager::DeleteResources(const std::string &theGroup)
@@ -101,6 +144,8 @@ void ResourceManager::DeleteResources(const std::string &theGroup)
 	DeleteResources(mImageMap,theGroup);
 	DeleteResources(mSoundMap,theGroup);
 	DeleteResources(mFontMap,theGroup);
+	DeleteResources(mParticleMap,theGroup);
+	DeleteAtlases(theGroup);
 	mLoadedGroups.erase(theGroup);
 }
 
@@ -291,6 +336,11 @@ bool ResourceManager::ParseImageResource(XMLElement &theElement)
 	}
 	
 	aRes->mPalletize = theElement.mAttributes.find(_S("nopal")) == theElement.mAttributes.end();
+	aRes->mQuantizeFlags = 0;
+	if (theElement.mAttributes.find(_S("quantize")) != theElement.mAttributes.end())
+		aRes->mQuantizeFlags |= QuantizeFlag_AllowLossy;
+	if (theElement.mAttributes.find(_S("dither")) != theElement.mAttributes.end())
+		aRes->mQuantizeFlags |= QuantizeFlag_AllowLossy | QuantizeFlag_Dither;
 	aRes->mA4R4G4B4 = theElement.mAttributes.find(_S("a4r4g4b4")) != theElement.mAttributes.end();
 	aRes->mDDSurface = theElement.mAttributes.find(_S("ddsurface")) != theElement.mAttributes.end();
 	aRes->mPurgeBits = (theElement.mAttributes.find(_S("nobits")) != theElement.mAttributes.end()) ||
@@ -298,6 +348,9 @@ bool ResourceManager::ParseImageResource(XMLElement &theElement)
 		((!mApp->Is3DAccelerated()) && (theElement.mAttributes.find(_S("nobits2d")) != theElement.mAttributes.end()));
 	aRes->mA8R8G8B8 = theElement.mAttributes.find(_S("a8r8g8b8")) != theElement.mAttributes.end();
 	aRes->mMinimizeSubdivisions = theElement.mAttributes.find(_S("minsubdivide")) != theElement.mAttributes.end();
+	aRes->mAtlas = theElement.mAttributes.find(_S("atlas")) != theElement.mAttributes.end();
+	aRes->mPremultiplied = theElement.mAttributes.find(_S("premultiplied")) != theElement.mAttributes.end();
+	aRes->mTrim = theElement.mAttributes.find(_S("trim")) != theElement.mAttributes.end();
 	aRes->mAutoFindAlpha = theElement.mAttributes.find(_S("noalpha")) == theElement.mAttributes.end();	
 
 	XMLParamMap::iterator anItr;
@@ -440,6 +493,95 @@ bool ResourceManager::ParseFontResource(XMLElement &theElement)
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Reads "a,b" into the pair, or a single value into both
+static void ReadFloatPair(XMLElement &theElement, const SexyChar *theName, float *theFirst, float *theSecond)
+{
+	XMLParamMap::iterator anItr = theElement.mAttributes.find(theName);
+	if (anItr == theElement.mAttributes.end())
+		return;
+
+	if (sexysscanf(anItr->second.c_str(),_S("%f,%f"),theFirst,theSecond) == 1)
+		*theSecond = *theFirst;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::ParseParticleResource(XMLElement &theElement)
+{
+	ParticleRes *aRes = new ParticleRes;
+	aRes->mDef = new ParticleEmitterDef;
+	aRes->mImage = NULL;
+	aRes->mOwnsImage = false;
+
+	if (!ParseCommonResource(theElement, aRes, mParticleMap))
+	{
+		if (mHadAlreadyDefinedError && mAllowAlreadyDefinedResources)
+		{
+			mError = "";
+			mHasFailed = false;
+			ParticleRes *oldRes = aRes;
+			aRes = (ParticleRes*)mParticleMap[oldRes->mId];
+			aRes->mPath = oldRes->mPath;
+			aRes->mXMLAttributes = oldRes->mXMLAttributes;
+			delete oldRes;
+		}
+		else			
+		{
+			delete aRes;
+			return false;
+		}
+	}
+
+	ParticleEmitterDef *aDef = aRes->mDef;
+
+	XMLParamMap::iterator anItr;
+	anItr = theElement.mAttributes.find(_S("rate"));
+	if (anItr != theElement.mAttributes.end())
+		sexysscanf(anItr->second.c_str(),_S("%f"),&aDef->mEmitRate);
+
+	anItr = theElement.mAttributes.find(_S("max"));
+	if (anItr != theElement.mAttributes.end())
+		aDef->mMaxParticles = sexyatoi(anItr->second.c_str());
+
+	anItr = theElement.mAttributes.find(_S("drag"));
+	if (anItr != theElement.mAttributes.end())
+		sexysscanf(anItr->second.c_str(),_S("%f"),&aDef->mDrag);
+
+	ReadFloatPair(theElement, _S("life"), &aDef->mLifeMin, &aDef->mLifeMax);
+	ReadFloatPair(theElement, _S("speed"), &aDef->mSpeedMin, &aDef->mSpeedMax);
+	ReadFloatPair(theElement, _S("angle"), &aDef->mAngleMin, &aDef->mAngleMax);
+	ReadFloatPair(theElement, _S("spawn"), &aDef->mSpawnWidth, &aDef->mSpawnHeight);
+	ReadFloatPair(theElement, _S("gravity"), &aDef->mGravityX, &aDef->mGravityY);
+	ReadFloatPair(theElement, _S("scale"), &aDef->mScaleStart, &aDef->mScaleEnd);
+
+	DWORD aColor;
+	anItr = theElement.mAttributes.find(_S("color"));
+	if (anItr != theElement.mAttributes.end())
+	{
+		sexysscanf(anItr->second.c_str(),_S("%x"),&aColor);
+		aDef->mColorStart = Color((int) aColor);
+		aDef->mColorEnd = aDef->mColorStart;
+	}
+
+	anItr = theElement.mAttributes.find(_S("endcolor"));
+	if (anItr != theElement.mAttributes.end())
+	{
+		sexysscanf(anItr->second.c_str(),_S("%x"),&aColor);
+		aDef->mColorEnd = Color((int) aColor);
+	}
+
+	float anAlphaStart = 255, anAlphaEnd = 255;
+	ReadFloatPair(theElement, _S("alpha"), &anAlphaStart, &anAlphaEnd);
+	aDef->mColorStart.mAlpha = (int) anAlphaStart;
+	aDef->mColorEnd.mAlpha = (int) anAlphaEnd;
+
+	aDef->mAdditive = theElement.mAttributes.find(_S("additive"))!=theElement.mAttributes.end();
+
+	return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 bool ResourceManager::ParseSetDefaults(XMLElement &theElement)
@@ -501,6 +643,17 @@ bool ResourceManager::ParseResources()
 				if (aXMLElement.mType != XMLElement::TYPE_END)
 					return Fail("Unexpected element found.");
 			}
+			else if (aXMLElement.mValue == _S("Particle"))
+			{
+				if (!ParseParticleResource(aXMLElement))
+					return false;
+
+				if (!mXMLParser->NextElement(&aXMLElement))
+					return false;
+
+				if (aXMLElement.mType != XMLElement::TYPE_END)
+					return Fail("Unexpected element found.");
+			}
 			else if (aXMLElement.mValue == _S("SetDefaults"))
 			{
 				if (!ParseSetDefaults(aXMLElement))
@@ -653,13 +806,8 @@ bool ResourceManager::LoadAlphaGridImage(ImageRes *theRes, DDImage *theImage)
 			unsigned long* anAlphaBits = anAlphaImage->mBits;
 			for (int y=0; y<aCelHeight; y++)
 			{
-				unsigned long *aDestPtr = aRowPtr;
-				for (int x=0; x<aCelWidth; x++)
-				{
-					*aDestPtr = (*aDestPtr & 0x00FFFFFF) | ((*anAlphaBits & 0xFF) << 24);
-					++anAlphaBits;
-					++aDestPtr;
-				}
+				ImageLib::MergeAlphaChannel(aRowPtr, anAlphaBits, aCelWidth);
+				anAlphaBits += aCelWidth;
 				aRowPtr += theImage->mWidth;
 			}
 
@@ -688,16 +836,7 @@ bool ResourceManager::LoadAlphaImage(ImageRes *theRes, DDImage *theImage)
 	if (anAlphaImage->mWidth!=theImage->mWidth || anAlphaImage->mHeight!=theImage->mHeight)
 		return Fail(StrFormat("AlphaImage size mismatch between %s and %s",theRes->mPath.c_str(),theRes->mAlphaImage.c_str()));
 
-	unsigned long* aBits1 = theImage->mBits;
-	unsigned long* aBits2 = anAlphaImage->mBits;
-	int aSize = theImage->mWidth*theImage->mHeight;
-
-	for (int i = 0; i < aSize; i++)
-	{
-		*aBits1 = (*aBits1 & 0x00FFFFFF) | ((*aBits2 & 0xFF) << 24);
-		++aBits1;
-		++aBits2;
-	}
+	ImageLib::MergeAlphaChannel(theImage->mBits, anAlphaImage->mBits, theImage->mWidth*theImage->mHeight);
 
 	theImage->BitsChanged();
 	return true;
@@ -758,9 +897,18 @@ bool ResourceManager::DoLoadImage(ImageRes *theRes)
 		SEXY_PERF_END("ResourceManager:DDSurface");
 	}	
 
-	if (theRes->mPalletize)
+	// Before Palletize, so the palette gets built from the premultiplied colors
+	if ((theRes->mPremultiplied) && (aDDImage->mHasAlpha))
+		aDDImage->SetPremultipliedAlpha(true);
+
+	// Atlas images stay unpalettized since TextureAtlas only packs 32 bit bits, so
+	//  "atlas" implies "nopal" (except with "ddsurface", which is never packed)
+	bool wantAtlas = (theRes->mAtlas) && (!theRes->mDDSurface);
+
+	if ((theRes->mPalletize) && (!wantAtlas))
 	{
 		SEXY_PERF_BEGIN("ResourceManager:Palletize");
+		aDDImage->mQuantizeFlags = theRes->mQuantizeFlags;
 		if (aDDImage->mSurface==NULL)
 			aDDImage->Palletize();
 		else
@@ -783,8 +931,21 @@ bool ResourceManager::DoLoadImage(ImageRes *theRes)
 	aDDImage->mNumRows = theRes->mRows;
 	aDDImage->mNumCols = theRes->mCols;
 
+	// Needs the final cel grid and has to run before the bits get purged
+	SEXY_PERF_BEGIN("ResourceManager:AnalyzeCels");
+	aDDImage->AnalyzeCels();
+	SEXY_PERF_END("ResourceManager:AnalyzeCels");
+
+	// Atlased images get packed whole later on
+	if ((theRes->mTrim) && (!theRes->mAtlas) && (!theRes->mDDSurface) && (aDDImage->TrimCels()))
+		aDDImage->mTrimImage->mPurgeBits = aDDImage->mPurgeBits;
+
 	if (aDDImage->mPurgeBits)
+	{
 		aDDImage->PurgeBits();
+		if (aDDImage->mTrimImage != NULL)
+			aDDImage->mTrimImage->PurgeBits();
+	}
 
 	ResourceLoadedHook(theRes);
 	return true;
@@ -921,6 +1082,37 @@ bool ResourceManager::DoLoadFont(FontRes* theRes)
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::DoLoadParticle(ParticleRes* theRes)
+{
+	Image *anImage = NULL;
+
+	if (strncmp(theRes->mPath.c_str(),"!ref:",5)==0)
+	{
+		std::string aRefName = theRes->mPath.substr(5);
+		anImage = (Image*) GetImage(aRefName);
+		if (anImage==NULL)
+			return Fail("Ref image not found: " + aRefName);
+
+		theRes->mOwnsImage = false;
+	}
+	else
+	{
+		anImage = mApp->GetImage(theRes->mPath);
+		if (anImage==NULL)
+			return Fail(StrFormat("Failed to load image: %s",theRes->mPath.c_str()));
+
+		theRes->mOwnsImage = true;
+	}
+
+	theRes->mImage = anImage;
+	theRes->mDef->mImage = anImage;
+
+	ResourceLoadedHook(theRes);
+	return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 Font* ResourceManager::LoadFont(const std::string &theName)
@@ -993,12 +1185,81 @@ bool ResourceManager::LoadNextResource()
 
 				return DoLoadFont(aFontRes);
 			}
+
+			case ResType_Particle: 
+			{
+				ParticleRes *aParticleRes = (ParticleRes*)aRes;
+				if (aParticleRes->mImage!=NULL)
+					continue;
+
+				return DoLoadParticle(aParticleRes);
+			}
 		}
 	}
 
+	if (!HadError())
+		PackGroupAtlas(mCurResGroup);
+
 	return false;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool ResourceManager::PackGroupAtlas(const std::string &theGroup)
+{
+	if (mAtlasMap.find(theGroup) != mAtlasMap.end())
+		return true;
+
+	ResGroupMap::iterator aGroupItr = mResGroupMap.find(theGroup);
+	if (aGroupItr == mResGroupMap.end())
+		return false;
+
+	TextureAtlas* anAtlas = NULL;
+
+	ResList& aList = aGroupItr->second;
+	for (ResList::iterator anItr = aList.begin(); anItr != aList.end(); ++anItr)
+	{
+		if ((*anItr)->mType != ResType_Image)
+			continue;
+
+		ImageRes *aRes = (ImageRes*)*anItr;
+		if ((!aRes->mAtlas) || (aRes->mDDSurface))
+			continue;
+
+		DDImage* anImage = (DDImage*) aRes->mImage;
+		if (anImage == NULL)
+			continue;
+
+		if (anAtlas == NULL)
+			anAtlas = new TextureAtlas(mApp);
+		anAtlas->AddImage(anImage);
+	}
+
+	if (anAtlas == NULL)
+		return false;
+
+	if (anAtlas->GetNumImages() == 0)
+	{
+		delete anAtlas;
+		return false;
+	}
+
+	anAtlas->Build();
+	mAtlasMap[theGroup] = anAtlas;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+TextureAtlas* ResourceManager::GetGroupAtlas(const std::string &theGroup)
+{
+	AtlasMap::iterator anItr = mAtlasMap.find(theGroup);
+	if (anItr == mAtlasMap.end())
+		return NULL;
+
+	return anItr->second;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 void ResourceManager::ResourceLoadedHook(BaseRes *theRes)
@@ -1039,6 +1300,8 @@ void ResourceManager::DumpCurResGroup(std::string& theDestStr)
 			theDestStr += std::string("     res is a sound\r\n");
 		else if (br->mType == ResType_Font)
 			theDestStr += std::string("     res is a font\r\n");
+		else if (br->mType == ResType_Particle)
+			theDestStr += std::string("     res is a particle emitter\r\n");
 
 		if (it == mCurResGroupListItr)
 			theDestStr += std::string("iterator has reached mCurResGroupItr\r\n");
@@ -1107,11 +1370,18 @@ int ResourceManager::GetNumFonts(const std::string &theGroup)
 	return GetNumResources(theGroup, mFontMap);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int ResourceManager::GetNumParticles(const std::string &theGroup)
+{
+	return GetNumResources(theGroup, mParticleMap);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 int	ResourceManager::GetNumResources(const std::string &theGroup)
 {
-	return GetNumImages(theGroup) + GetNumSounds(theGroup) + GetNumFonts(theGroup);
+	return GetNumImages(theGroup) + GetNumSounds(theGroup) + GetNumFonts(theGroup) + GetNumParticles(theGroup);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1147,6 +1417,17 @@ Font* ResourceManager::GetFont(const std::string &theId)
 		return NULL;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+ParticleEmitterDef* ResourceManager::GetParticle(const std::string &theId)
+{
+	ResMap::iterator anItr = mParticleMap.find(theId);
+	if (anItr != mParticleMap.end() && ((ParticleRes*)anItr->second)->mImage != NULL)
+		return ((ParticleRes*)anItr->second)->mDef;
+	else
+		return NULL;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 SharedImageRef ResourceManager::GetImageThrow(const std::string &theId)
@@ -1206,6 +1487,25 @@ Font* ResourceManager::GetFontThrow(const std::string &theId)
 	throw ResourceManagerException(GetErrorText());
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+ParticleEmitterDef* ResourceManager::GetParticleThrow(const std::string &theId)
+{
+	ResMap::iterator anItr = mParticleMap.find(theId);
+	if (anItr != mParticleMap.end())
+	{
+		ParticleRes *aRes = (ParticleRes*)anItr->second;
+		if (aRes->mImage!=NULL)
+			return aRes->mDef;
+
+		if (mAllowMissingProgramResources && aRes->mFromProgram)
+			return NULL;
+	}
+
+	Fail(StrFormat("Particle resource not found: %s",theId.c_str()));
+	throw ResourceManagerException(GetErrorText());
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 void ResourceManager::SetAllowMissingProgramImages(bool allow)
@@ -21,6 +21,8 @@ class Image;
 class SoundInstance;
 class SexyAppBase;
 class Font;
+class TextureAtlas;
+class ParticleEmitterDef;
 
 typedef std::map<std::string, std::string>	StringToStringMap;
 typedef std::map<SexyString, SexyString>	XMLParamMap;
@@ -34,7 +36,8 @@ protected:
 	{
 		ResType_Image,
 		ResType_Sound,
-		ResType_Font
+		ResType_Font,
+		ResType_Particle
 	};
 
 
@@ -59,11 +62,15 @@ protected:
 		std::string mVariant;
 		bool mAutoFindAlpha;
 		bool mPalletize;
+		DWORD mQuantizeFlags;
 		bool mA4R4G4B4;
 		bool mA8R8G8B8;
 		bool mDDSurface;
 		bool mPurgeBits;
 		bool mMinimizeSubdivisions;
+		bool mAtlas;
+		bool mPremultiplied;
+		bool mTrim;
 		int mRows;
 		int mCols;	
 		DWORD mAlphaColor;
@@ -103,15 +110,28 @@ protected:
 		virtual void DeleteResource();
 	};
 
+	struct ParticleRes : public BaseRes
+	{
+		ParticleEmitterDef *mDef;
+		Image *mImage;
+		bool mOwnsImage;		// false for "!ref:" images, which belong to their own resource
+
+		ParticleRes() { mType = ResType_Particle; }
+		virtual ~ParticleRes();
+		virtual void DeleteResource();
+	};
+
 	typedef std::map<std::string,BaseRes*> ResMap;
 	typedef std::list<BaseRes*> ResList;
 	typedef std::map<std::string,ResList,StringLessNoCase> ResGroupMap;
+	typedef std::map<std::string,TextureAtlas*,StringLessNoCase> AtlasMap;
 
 	std::set<std::string,StringLessNoCase> mLoadedGroups;
 
 	ResMap					mImageMap;
 	ResMap					mSoundMap;
 	ResMap					mFontMap;
+	ResMap					mParticleMap;
 
 	XMLParser*				mXMLParser;
 	std::string				mError;
@@ -128,6 +148,8 @@ protected:
 	ResList*				mCurResGroupList;
 	ResList::iterator		mCurResGroupListItr;
 
+	AtlasMap				mAtlasMap;
+
 
 	bool					Fail(const std::string& theErrorText);
 
@@ -135,11 +157,13 @@ protected:
 	virtual bool			ParseSoundResource(XMLElement &theElement);
 	virtual bool			ParseImageResource(XMLElement &theElement);
 	virtual bool			ParseFontResource(XMLElement &theElement);
+	virtual bool			ParseParticleResource(XMLElement &theElement);
 	virtual bool			ParseSetDefaults(XMLElement &theElement);
 	virtual bool			ParseResources();
 
 	bool					DoParseResources();
 	void					DeleteMap(ResMap &theMap);
+	void					DeleteAtlases(const std::string &theGroup);
 	virtual void			DeleteResources(ResMap &theMap, const std::string &theGroup);
 
 	bool					LoadAlphaGridImage(ImageRes *theRes, DDImage *theImage);
@@ -147,6 +171,7 @@ protected:
 	virtual bool			DoLoadImage(ImageRes *theRes);
 	virtual bool			DoLoadFont(FontRes* theRes);
 	virtual bool			DoLoadSound(SoundRes* theRes);
+	virtual bool			DoLoadParticle(ParticleRes* theRes);
 
 	int						GetNumResources(const std::string &theGroup, ResMap &theMap);
 
@@ -164,6 +189,7 @@ public:
 	int						GetNumImages(const std::string &theGroup);
 	int						GetNumSounds(const std::string &theGroup);
 	int						GetNumFonts(const std::string &theGroup);
+	int						GetNumParticles(const std::string &theGroup);
 	int						GetNumResources(const std::string &theGroup);
 
 	virtual bool			LoadNextResource();
@@ -185,6 +211,7 @@ public:
 	SharedImageRef			GetImage(const std::string &theId);
 	int						GetSound(const std::string &theId);
 	Font*					GetFont(const std::string &theId);
+	ParticleEmitterDef*		GetParticle(const std::string &theId);
 	
 	// Returns all the XML attributes associated with the image
 	const XMLParamMap&		GetImageAttributes(const std::string &theId);
@@ -193,12 +220,19 @@ public:
 	virtual SharedImageRef	GetImageThrow(const std::string &theId);
 	virtual int				GetSoundThrow(const std::string &theId);
 	virtual Font*			GetFontThrow(const std::string &theId);
+	virtual ParticleEmitterDef* GetParticleThrow(const std::string &theId);
 
 	void					SetAllowMissingProgramImages(bool allow);
 
 	virtual void			DeleteResources(const std::string &theGroup);
 	void					DeleteExtraImageBuffers(const std::string &theGroup);
 
+	// Packs the group's images marked "atlas" into shared pages.  Called
+	//  automatically once a group has finished loading.  Atlas images are
+	//  never palletized, as if they were also marked "nopal".
+	virtual bool			PackGroupAtlas(const std::string &theGroup);
+	TextureAtlas*			GetGroupAtlas(const std::string &theGroup);
+
 	const ResList*			GetCurResGroupList()	{return mCurResGroupList;}
 	std::string				GetCurResGroup()		{return mCurResGroup;}
 	void					DumpCurResGroup(std::string& theDestStr);
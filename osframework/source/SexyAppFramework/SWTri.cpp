@@ -2,11 +2,19 @@
 
 #include "SWTri.h"
 #include "Debug.h"
+#include "Graphics.h"
+#include "../ImageLib/PixelConvert.h"
+#include <math.h>
 
 using namespace Sexy;
 
-static SWHelper::XYZStruct	vertexReservoir[64];
-static unsigned int			vertexReservoirUsed = 0;
+// The vertices clipping makes for one triangle.  Each SWDrawShape call keeps its own on
+//  the stack, since the render pipeline thread draws triangles alongside the main thread.
+struct ClipReservoir
+{
+	SWHelper::XYZStruct		mVerts[64];
+	unsigned int			mUsed;
+};
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -94,7 +102,17 @@ static inline void bClip(SWHelper::XYZStruct & dst, const SWHelper::XYZStruct &
 
 // --------------------------------------------------------------------------------------------------------------------------------
 
-static inline unsigned int leClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruct ** dst, const float edge)
+static inline SWHelper::XYZStruct * NewClipVertex(ClipReservoir & reservoir)
+{
+   if (reservoir.mUsed >= sizeof(reservoir.mVerts) / sizeof(reservoir.mVerts[0]))
+      return 0;
+
+   return &reservoir.mVerts[reservoir.mUsed++];
+}
+
+// --------------------------------------------------------------------------------------------------------------------------------
+
+static inline unsigned int leClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruct ** dst, const float edge, ClipReservoir & reservoir)
 {
    SWHelper::XYZStruct ** _dst = dst;
 
@@ -111,9 +129,10 @@ static inline unsigned int leClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
             break;
          case 1:
          {
-            SWHelper::XYZStruct &  tmp = vertexReservoir[vertexReservoirUsed++];
-            lClip(tmp, *nex, *cur, edge);
-            *dst = &tmp;
+            SWHelper::XYZStruct *  tmp = NewClipVertex(reservoir);
+            if (!tmp) return 0;
+            lClip(*tmp, *nex, *cur, edge);
+            *dst = tmp;
             ++dst;
             break;
          }
@@ -121,9 +140,10 @@ static inline unsigned int leClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
          {
             *dst = *v;
             ++dst;
-            SWHelper::XYZStruct &  tmp = vertexReservoir[vertexReservoirUsed++];
-            lClip(tmp, *cur, *nex, edge);
-            *dst = &tmp;
+            SWHelper::XYZStruct *  tmp = NewClipVertex(reservoir);
+            if (!tmp) return 0;
+            lClip(*tmp, *cur, *nex, edge);
+            *dst = tmp;
             ++dst;
             break;
          }
@@ -135,7 +155,7 @@ static inline unsigned int leClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
 
 // --------------------------------------------------------------------------------------------------------------------------------
 
-static inline unsigned int reClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruct ** dst, const float edge)
+static inline unsigned int reClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruct ** dst, const float edge, ClipReservoir & reservoir)
 {
    SWHelper::XYZStruct ** _dst = dst;
 
@@ -152,9 +172,10 @@ static inline unsigned int reClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
             break;
          case 1:
          {
-            SWHelper::XYZStruct &  tmp = vertexReservoir[vertexReservoirUsed++];
-            rClip(tmp, *nex, *cur, edge);
-            *dst = &tmp;
+            SWHelper::XYZStruct *  tmp = NewClipVertex(reservoir);
+            if (!tmp) return 0;
+            rClip(*tmp, *nex, *cur, edge);
+            *dst = tmp;
             ++dst;
             break;
          }
@@ -162,9 +183,10 @@ static inline unsigned int reClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
          {
             *dst = *v;
             ++dst;
-            SWHelper::XYZStruct &  tmp = vertexReservoir[vertexReservoirUsed++];
-            rClip(tmp, *cur, *nex, edge);
-            *dst = &tmp;
+            SWHelper::XYZStruct *  tmp = NewClipVertex(reservoir);
+            if (!tmp) return 0;
+            rClip(*tmp, *cur, *nex, edge);
+            *dst = tmp;
             ++dst;
             break;
          }
@@ -176,7 +198,7 @@ static inline unsigned int reClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
 
 // --------------------------------------------------------------------------------------------------------------------------------
 
-static inline unsigned int teClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruct ** dst, const float edge)
+static inline unsigned int teClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruct ** dst, const float edge, ClipReservoir & reservoir)
 {
    SWHelper::XYZStruct ** _dst = dst;
 
@@ -193,9 +215,10 @@ static inline unsigned int teClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
             break;
          case 1:
          {
-            SWHelper::XYZStruct &  tmp = vertexReservoir[vertexReservoirUsed++];
-            tClip(tmp, *nex, *cur, edge);
-            *dst = &tmp;
+            SWHelper::XYZStruct *  tmp = NewClipVertex(reservoir);
+            if (!tmp) return 0;
+            tClip(*tmp, *nex, *cur, edge);
+            *dst = tmp;
             ++dst;
             break;
          }
@@ -203,9 +226,10 @@ static inline unsigned int teClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
          {
             *dst = *v;
             ++dst;
-            SWHelper::XYZStruct &  tmp = vertexReservoir[vertexReservoirUsed++];
-            tClip(tmp, *cur, *nex, edge);
-            *dst = &tmp;
+            SWHelper::XYZStruct *  tmp = NewClipVertex(reservoir);
+            if (!tmp) return 0;
+            tClip(*tmp, *cur, *nex, edge);
+            *dst = tmp;
             ++dst;
             break;
          }
@@ -217,7 +241,7 @@ static inline unsigned int teClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
 
 // --------------------------------------------------------------------------------------------------------------------------------
 
-static inline unsigned int beClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruct ** dst, const float edge)
+static inline unsigned int beClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruct ** dst, const float edge, ClipReservoir & reservoir)
 {
    SWHelper::XYZStruct ** _dst = dst;
 
@@ -234,9 +258,10 @@ static inline unsigned int beClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
             break;
          case 1:
          {
-            SWHelper::XYZStruct &  tmp = vertexReservoir[vertexReservoirUsed++];
-            bClip(tmp, *nex, *cur, edge);
-            *dst = &tmp;
+            SWHelper::XYZStruct *  tmp = NewClipVertex(reservoir);
+            if (!tmp) return 0;
+            bClip(*tmp, *nex, *cur, edge);
+            *dst = tmp;
             ++dst;
             break;
          }
@@ -244,9 +269,10 @@ static inline unsigned int beClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
          {
             *dst = *v;
             ++dst;
-            SWHelper::XYZStruct &  tmp = vertexReservoir[vertexReservoirUsed++];
-            bClip(tmp, *cur, *nex, edge);
-            *dst = &tmp;
+            SWHelper::XYZStruct *  tmp = NewClipVertex(reservoir);
+            if (!tmp) return 0;
+            bClip(*tmp, *cur, *nex, edge);
+            *dst = tmp;
             ++dst;
             break;
          }
@@ -258,9 +284,9 @@ static inline unsigned int beClip(SWHelper::XYZStruct ** src, SWHelper::XYZStruc
 
 // --------------------------------------------------------------------------------------------------------------------------------
 
-static inline int	clipShape(SWHelper::XYZStruct ** dst, SWHelper::XYZStruct ** src, const float left, const float right, const float top, const float bottom)
+static inline int	clipShape(SWHelper::XYZStruct ** dst, SWHelper::XYZStruct ** src, const float left, const float right, const float top, const float bottom, ClipReservoir & reservoir)
 {
-   vertexReservoirUsed = 0;
+   reservoir.mUsed = 0;
 
    SWHelper::XYZStruct *  buf[64];
    SWHelper::XYZStruct *  ptr[4];
@@ -268,10 +294,10 @@ static inline int	clipShape(SWHelper::XYZStruct ** dst, SWHelper::XYZStruct ** s
    ptr[1] = src[1];
    ptr[2] = src[2];
    ptr[3] = 0;
-   if (leClip(ptr, buf, left) < 3) return 0;
-   if (reClip(buf, dst, right) < 3) return 0;
-   if (teClip(dst, buf, top) < 3) return 0;
-   return beClip(buf, dst, bottom);
+   if (leClip(ptr, buf, left, reservoir) < 3) return 0;
+   if (reClip(buf, dst, right, reservoir) < 3) return 0;
+   if (teClip(dst, buf, top, reservoir) < 3) return 0;
+   return beClip(buf, dst, bottom, reservoir);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -290,7 +316,50 @@ static inline int	clipShape(SWHelper::XYZStruct ** dst, SWHelper::XYZStruct ** s
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-void SWHelper::SWDrawShape(XYZStruct *theVerts, int theNumVerts, MemoryImage *theImage, const Color &theColor, int theDrawMode, const Rect &theClipRect, void *theSurface, int thePitch, int thePixelFormat, bool blend, bool vertexColor)
+// Off until SWTri_SetTiledTextureAngles is called, since the tiled copy doubles the texture's memory
+static float gTiledTextureMinTan = -1;
+static float gTiledTextureMaxTan = -1;
+static int gTiledTextureMinSize = 1024*1024;
+
+void Sexy::SWTri_SetTiledTextureAngles(float theMinDegrees, float theMaxDegrees, int theMinSize)
+{
+	if ((theMinDegrees <= theMaxDegrees) && (theMinDegrees < 90))
+	{
+		gTiledTextureMinTan = (float) tan(max(theMinDegrees, 0.0f) * 3.14159265358979 / 180);
+		gTiledTextureMaxTan = (theMaxDegrees < 90) ? (float) tan(theMaxDegrees * 3.14159265358979 / 180) : 1e30f;
+	}
+	else
+		gTiledTextureMinTan = -1;
+
+	gTiledTextureMinSize = theMinSize;
+}
+
+// Checks how far one pixel to the right on screen moves across texture rows compared to
+// along them.  The vertices all share one affine mapping, so the first triangle is enough.
+static bool WantTiledTexture(const SWHelper::XYZStruct *theVerts, MemoryImage *theImage)
+{
+	if ((gTiledTextureMinTan < 0) || (theImage->mWidth*theImage->mHeight < gTiledTextureMinSize))
+		return false;
+
+	float dy1 = theVerts[1].mY - theVerts[0].mY;
+	float dy2 = theVerts[2].mY - theVerts[0].mY;
+	float du1 = (theVerts[1].mU - theVerts[0].mU) * theImage->mWidth;
+	float du2 = (theVerts[2].mU - theVerts[0].mU) * theImage->mWidth;
+	float dv1 = (theVerts[1].mV - theVerts[0].mV) * theImage->mHeight;
+	float dv2 = (theVerts[2].mV - theVerts[0].mV) * theImage->mHeight;
+
+	// |du/dx| and |dv/dx|, both without the common 1/determinant
+	float aUStep = fabs(du1*dy2 - du2*dy1);
+	float aVStep = fabs(dv1*dy2 - dv2*dy1);
+
+	// No u step means a degenerate triangle (or a 90 degree one, outside any band)
+	if (aUStep <= 0)
+		return false;
+
+	return (aVStep >= aUStep * gTiledTextureMinTan) && (aVStep <= aUStep * gTiledTextureMaxTan);
+}
+
+void SWHelper::SWDrawShape(XYZStruct *theVerts, int theNumVerts, MemoryImage *theImage, const Color &theColor, int theDrawMode, const Rect &theClipRect, void *theSurface, int thePitch, int thePixelFormat, bool blend, bool vertexColor, bool premultiplied)
 {
 	float	tclx0 = theClipRect.mX;
 	float	tcly0 = theClipRect.mY;
@@ -382,6 +451,12 @@ void SWHelper::SWDrawShape(XYZStruct *theVerts, int theNumVerts, MemoryImage *th
 
 	bool	textured = theImage!=NULL;
 	bool	talpha = (textured && (theImage->mHasAlpha || theImage->mHasTrans || blend));
+	bool	additive = theDrawMode==Graphics::DRAWMODE_ADDITIVE;
+	bool	premultipliedTex = textured && theImage->mPremultipliedAlpha;
+
+	const unsigned int *	aTiledBits = NULL;
+	if (textured && !blend && theNumVerts >= 3 && WantTiledTexture(theVerts, theImage))
+		aTiledBits = reinterpret_cast<unsigned int *>(theImage->GetTiledBits());
 
 	for (;;)
 	{
@@ -412,13 +487,14 @@ void SWHelper::SWDrawShape(XYZStruct *theVerts, int theNumVerts, MemoryImage *th
 
 		// Clip
 
+		ClipReservoir	reservoir;
 		XYZStruct *	clipped[64];
 		float		clipX0 = tclx0;
 		float		clipY0 = tcly0;
 		float		clipX1 = tclx1;
 		float		clipY1 = tcly1;
 
-		unsigned int	vCount = clipShape(clipped, aTriRef, clipX0, clipX1, clipY0, clipY1);
+		unsigned int	vCount = clipShape(clipped, aTriRef, clipX0, clipX1, clipY0, clipY1, reservoir);
 
 		if (vCount)
 		{
@@ -440,10 +516,12 @@ void SWHelper::SWDrawShape(XYZStruct *theVerts, int theNumVerts, MemoryImage *th
 					pVerts[i].v = static_cast<int>(clipped[i]->mV * (float) theImage->mHeight * 65536.0f);
 				}
 
-				textureInfo.pTexture = reinterpret_cast<unsigned int *>(theImage->GetBits());
+				textureInfo.pTexture = reinterpret_cast<unsigned int *>(theImage->GetRawBits());
 				textureInfo.pitch = theImage->mWidth;
 				textureInfo.height = theImage->mHeight;
 				textureInfo.endpos = theImage->mWidth*theImage->mHeight;
+				textureInfo.pTiled = aTiledBits;
+				textureInfo.tiledPitch = theImage->GetTiledPitch();
 //				unsigned int	temp = static_cast<unsigned int>(mSWTexture->mTextureInfo.lPitch) / (mSWTexture->mTextureInfo.ddpfPixelFormat.dwRGBBitCount / 8);
 				unsigned int	temp = theImage->mWidth;
 				temp >>= 1;
@@ -466,7 +544,7 @@ void SWHelper::SWDrawShape(XYZStruct *theVerts, int theNumVerts, MemoryImage *th
 				}
 			}
 
-			SWDrawTriangle(textured, talpha, vertexColor, globalargb, pVerts, pFrameBuffer, thePitch, &textureInfo, globalDiffuse, thePixelFormat, blend);
+			SWDrawTriangle(textured, talpha, vertexColor, globalargb, pVerts, pFrameBuffer, thePitch, &textureInfo, globalDiffuse, thePixelFormat, blend, additive, premultipliedTex, premultiplied);
 
 			if (vCount > 3)
 			{
@@ -474,7 +552,7 @@ void SWHelper::SWDrawShape(XYZStruct *theVerts, int theNumVerts, MemoryImage *th
 				{
 					pVerts[1] = pVerts[extraVert];
 					pVerts[2] = pVerts[extraVert+1];
-					SWDrawTriangle(textured, talpha, vertexColor, globalargb, pVerts, pFrameBuffer, thePitch, &textureInfo, globalDiffuse, thePixelFormat, blend);
+					SWDrawTriangle(textured, talpha, vertexColor, globalargb, pVerts, pFrameBuffer, thePitch, &textureInfo, globalDiffuse, thePixelFormat, blend, additive, premultipliedTex, premultiplied);
 				}
 			}
 		}
@@ -486,173 +564,66 @@ void SWHelper::SWDrawShape(XYZStruct *theVerts, int theNumVerts, MemoryImage *th
 }
 
 
-static DrawTriFunc gDrawTriFunc[128] = {0};
-void Sexy::SWTri_AddDrawTriFunc(bool textured, bool talpha, bool mod_argb, bool global_argb, int thePixelFormat, bool blend, DrawTriFunc theFunc)
+#include "SWTri_DrawTriangle.cpp"
+
+static DrawTriFunc gDrawTriFunc[SWTRI_NUM_KERNELS] = {0};
+static int GetDrawTriType(bool textured, bool talpha, bool mod_argb, bool global_argb, int thePixelFormat, bool blend, bool additive, bool premultipliedTex = false, bool premultipliedDest = false)
 {
-	int aType = (blend?1:0) | (global_argb?2:0) | (mod_argb?4:0) | (talpha?8:0) | (textured?16:0);
+	int aType = (blend?SWTRI_LINEAR_BLEND:0) | (global_argb?SWTRI_GLOBAL_ARGB:0) | (mod_argb?SWTRI_MOD_ARGB:0) | (talpha?SWTRI_TEX_ALPHA:0) | (textured?SWTRI_TEXTURED:0) | (additive?SWTRI_ADDITIVE:0);
+	if (textured && premultipliedTex)
+		aType |= SWTRI_PREMULTIPLIED_TEX;
 	switch (thePixelFormat)
 	{
-		case 0x8888: aType |= 0<<5; break;
-		case 0x888: aType |= 1<<5; break;
-		case 0x565: aType |= 2<<5; break;
-		case 0x555: aType |= 3<<5; break;
+		case 0x8888: aType |= SWTRI_FORMAT_8888 | (premultipliedDest?SWTRI_PREMULTIPLIED_DEST:0); break;
+		case 0x888: aType |= SWTRI_FORMAT_888; break;
+		case 0x565: aType |= SWTRI_FORMAT_565; break;
+		case 0x555: aType |= SWTRI_FORMAT_555; break;
 	}
-	gDrawTriFunc[aType] = theFunc;
+	return aType;
+}
+
+void Sexy::SWTri_AddDrawTriFunc(bool textured, bool talpha, bool mod_argb, bool global_argb, int thePixelFormat, bool blend, DrawTriFunc theFunc)
+{
+	gDrawTriFunc[GetDrawTriType(textured, talpha, mod_argb, global_argb, thePixelFormat, blend, false)] = theFunc;
+}
+
+void Sexy::SWTri_AddDrawTriFunc(bool textured, bool talpha, bool mod_argb, bool global_argb, int thePixelFormat, bool blend, bool additive, DrawTriFunc theFunc)
+{
+	gDrawTriFunc[GetDrawTriType(textured, talpha, mod_argb, global_argb, thePixelFormat, blend, additive)] = theFunc;
 }
 
 void Sexy::SWTri_AddAllDrawTriFuncs()
 {
-	gDrawTriFunc[0] = DrawTriangle_8888_TEX0_TALPHA0_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[1] = DrawTriangle_8888_TEX0_TALPHA0_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[2] = DrawTriangle_8888_TEX0_TALPHA0_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[3] = DrawTriangle_8888_TEX0_TALPHA0_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[4] = DrawTriangle_8888_TEX0_TALPHA0_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[5] = DrawTriangle_8888_TEX0_TALPHA0_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[6] = DrawTriangle_8888_TEX0_TALPHA0_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[7] = DrawTriangle_8888_TEX0_TALPHA0_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[8] = DrawTriangle_8888_TEX0_TALPHA1_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[9] = DrawTriangle_8888_TEX0_TALPHA1_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[10] = DrawTriangle_8888_TEX0_TALPHA1_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[11] = DrawTriangle_8888_TEX0_TALPHA1_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[12] = DrawTriangle_8888_TEX0_TALPHA1_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[13] = DrawTriangle_8888_TEX0_TALPHA1_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[14] = DrawTriangle_8888_TEX0_TALPHA1_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[15] = DrawTriangle_8888_TEX0_TALPHA1_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[16] = DrawTriangle_8888_TEX1_TALPHA0_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[17] = DrawTriangle_8888_TEX1_TALPHA0_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[18] = DrawTriangle_8888_TEX1_TALPHA0_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[19] = DrawTriangle_8888_TEX1_TALPHA0_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[20] = DrawTriangle_8888_TEX1_TALPHA0_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[21] = DrawTriangle_8888_TEX1_TALPHA0_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[22] = DrawTriangle_8888_TEX1_TALPHA0_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[23] = DrawTriangle_8888_TEX1_TALPHA0_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[24] = DrawTriangle_8888_TEX1_TALPHA1_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[25] = DrawTriangle_8888_TEX1_TALPHA1_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[26] = DrawTriangle_8888_TEX1_TALPHA1_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[27] = DrawTriangle_8888_TEX1_TALPHA1_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[28] = DrawTriangle_8888_TEX1_TALPHA1_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[29] = DrawTriangle_8888_TEX1_TALPHA1_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[30] = DrawTriangle_8888_TEX1_TALPHA1_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[31] = DrawTriangle_8888_TEX1_TALPHA1_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[32] = DrawTriangle_0888_TEX0_TALPHA0_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[33] = DrawTriangle_0888_TEX0_TALPHA0_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[34] = DrawTriangle_0888_TEX0_TALPHA0_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[35] = DrawTriangle_0888_TEX0_TALPHA0_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[36] = DrawTriangle_0888_TEX0_TALPHA0_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[37] = DrawTriangle_0888_TEX0_TALPHA0_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[38] = DrawTriangle_0888_TEX0_TALPHA0_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[39] = DrawTriangle_0888_TEX0_TALPHA0_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[40] = DrawTriangle_0888_TEX0_TALPHA1_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[41] = DrawTriangle_0888_TEX0_TALPHA1_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[42] = DrawTriangle_0888_TEX0_TALPHA1_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[43] = DrawTriangle_0888_TEX0_TALPHA1_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[44] = DrawTriangle_0888_TEX0_TALPHA1_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[45] = DrawTriangle_0888_TEX0_TALPHA1_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[46] = DrawTriangle_0888_TEX0_TALPHA1_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[47] = DrawTriangle_0888_TEX0_TALPHA1_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[48] = DrawTriangle_0888_TEX1_TALPHA0_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[49] = DrawTriangle_0888_TEX1_TALPHA0_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[50] = DrawTriangle_0888_TEX1_TALPHA0_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[51] = DrawTriangle_0888_TEX1_TALPHA0_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[52] = DrawTriangle_0888_TEX1_TALPHA0_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[53] = DrawTriangle_0888_TEX1_TALPHA0_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[54] = DrawTriangle_0888_TEX1_TALPHA0_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[55] = DrawTriangle_0888_TEX1_TALPHA0_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[56] = DrawTriangle_0888_TEX1_TALPHA1_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[57] = DrawTriangle_0888_TEX1_TALPHA1_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[58] = DrawTriangle_0888_TEX1_TALPHA1_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[59] = DrawTriangle_0888_TEX1_TALPHA1_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[60] = DrawTriangle_0888_TEX1_TALPHA1_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[61] = DrawTriangle_0888_TEX1_TALPHA1_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[62] = DrawTriangle_0888_TEX1_TALPHA1_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[63] = DrawTriangle_0888_TEX1_TALPHA1_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[64] = DrawTriangle_0565_TEX0_TALPHA0_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[65] = DrawTriangle_0565_TEX0_TALPHA0_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[66] = DrawTriangle_0565_TEX0_TALPHA0_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[67] = DrawTriangle_0565_TEX0_TALPHA0_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[68] = DrawTriangle_0565_TEX0_TALPHA0_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[69] = DrawTriangle_0565_TEX0_TALPHA0_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[70] = DrawTriangle_0565_TEX0_TALPHA0_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[71] = DrawTriangle_0565_TEX0_TALPHA0_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[72] = DrawTriangle_0565_TEX0_TALPHA1_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[73] = DrawTriangle_0565_TEX0_TALPHA1_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[74] = DrawTriangle_0565_TEX0_TALPHA1_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[75] = DrawTriangle_0565_TEX0_TALPHA1_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[76] = DrawTriangle_0565_TEX0_TALPHA1_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[77] = DrawTriangle_0565_TEX0_TALPHA1_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[78] = DrawTriangle_0565_TEX0_TALPHA1_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[79] = DrawTriangle_0565_TEX0_TALPHA1_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[80] = DrawTriangle_0565_TEX1_TALPHA0_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[81] = DrawTriangle_0565_TEX1_TALPHA0_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[82] = DrawTriangle_0565_TEX1_TALPHA0_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[83] = DrawTriangle_0565_TEX1_TALPHA0_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[84] = DrawTriangle_0565_TEX1_TALPHA0_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[85] = DrawTriangle_0565_TEX1_TALPHA0_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[86] = DrawTriangle_0565_TEX1_TALPHA0_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[87] = DrawTriangle_0565_TEX1_TALPHA0_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[88] = DrawTriangle_0565_TEX1_TALPHA1_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[89] = DrawTriangle_0565_TEX1_TALPHA1_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[90] = DrawTriangle_0565_TEX1_TALPHA1_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[91] = DrawTriangle_0565_TEX1_TALPHA1_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[92] = DrawTriangle_0565_TEX1_TALPHA1_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[93] = DrawTriangle_0565_TEX1_TALPHA1_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[94] = DrawTriangle_0565_TEX1_TALPHA1_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[95] = DrawTriangle_0565_TEX1_TALPHA1_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[96] = DrawTriangle_0555_TEX0_TALPHA0_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[97] = DrawTriangle_0555_TEX0_TALPHA0_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[98] = DrawTriangle_0555_TEX0_TALPHA0_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[99] = DrawTriangle_0555_TEX0_TALPHA0_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[100] = DrawTriangle_0555_TEX0_TALPHA0_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[101] = DrawTriangle_0555_TEX0_TALPHA0_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[102] = DrawTriangle_0555_TEX0_TALPHA0_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[103] = DrawTriangle_0555_TEX0_TALPHA0_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[104] = DrawTriangle_0555_TEX0_TALPHA1_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[105] = DrawTriangle_0555_TEX0_TALPHA1_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[106] = DrawTriangle_0555_TEX0_TALPHA1_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[107] = DrawTriangle_0555_TEX0_TALPHA1_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[108] = DrawTriangle_0555_TEX0_TALPHA1_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[109] = DrawTriangle_0555_TEX0_TALPHA1_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[110] = DrawTriangle_0555_TEX0_TALPHA1_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[111] = DrawTriangle_0555_TEX0_TALPHA1_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[112] = DrawTriangle_0555_TEX1_TALPHA0_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[113] = DrawTriangle_0555_TEX1_TALPHA0_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[114] = DrawTriangle_0555_TEX1_TALPHA0_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[115] = DrawTriangle_0555_TEX1_TALPHA0_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[116] = DrawTriangle_0555_TEX1_TALPHA0_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[117] = DrawTriangle_0555_TEX1_TALPHA0_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[118] = DrawTriangle_0555_TEX1_TALPHA0_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[119] = DrawTriangle_0555_TEX1_TALPHA0_MOD1_GLOB1_BLEND1;
-	gDrawTriFunc[120] = DrawTriangle_0555_TEX1_TALPHA1_MOD0_GLOB0_BLEND0;
-	gDrawTriFunc[121] = DrawTriangle_0555_TEX1_TALPHA1_MOD0_GLOB0_BLEND1;
-	gDrawTriFunc[122] = DrawTriangle_0555_TEX1_TALPHA1_MOD0_GLOB1_BLEND0;
-	gDrawTriFunc[123] = DrawTriangle_0555_TEX1_TALPHA1_MOD0_GLOB1_BLEND1;
-	gDrawTriFunc[124] = DrawTriangle_0555_TEX1_TALPHA1_MOD1_GLOB0_BLEND0;
-	gDrawTriFunc[125] = DrawTriangle_0555_TEX1_TALPHA1_MOD1_GLOB0_BLEND1;
-	gDrawTriFunc[126] = DrawTriangle_0555_TEX1_TALPHA1_MOD1_GLOB1_BLEND0;
-	gDrawTriFunc[127] = DrawTriangle_0555_TEX1_TALPHA1_MOD1_GLOB1_BLEND1;
+	SWTriKernelList<0, SWTRI_NUM_KERNELS>::AddAll(gDrawTriFunc);
 }
 
-#include "SWTri_DrawTriangleInc1.cpp"
+#include "SWTri_HalfSpace.cpp"
 
-void	SWHelper::SWDrawTriangle(bool textured, bool talpha, bool mod_argb, bool global_argb, SWVertex * pVerts, unsigned int * pFrameBuffer, const unsigned int bytepitch, const SWTextureInfo * textureInfo, SWDiffuse & globalDiffuse, int thePixelFormat, bool blend)
+void	SWHelper::SWDrawTriangle(bool textured, bool talpha, bool mod_argb, bool global_argb, SWVertex * pVerts, unsigned int * pFrameBuffer, const unsigned int bytepitch, const SWTextureInfo * textureInfo, SWDiffuse & globalDiffuse, int thePixelFormat, bool blend, bool additive, bool premultipliedTex, bool premultipliedDest)
 {
-	int aType = (blend?1:0) | (global_argb?2:0) | (mod_argb?4:0) | (talpha?8:0) | (textured?16:0);
-	switch (thePixelFormat)
+	DrawTriFunc aFunc = gDrawTriFunc[GetDrawTriType(textured, talpha, mod_argb, global_argb, thePixelFormat, blend, additive, premultipliedTex, premultipliedDest)];
+	if ((premultipliedTex || premultipliedDest) && aFunc==NULL)
+	{
+		// Only the named (straight alpha) kernels were registered
+		premultipliedTex = false;
+		premultipliedDest = false;
+		aFunc = gDrawTriFunc[GetDrawTriType(textured, talpha, mod_argb, global_argb, thePixelFormat, blend, additive)];
+	}
+	if (additive && aFunc==NULL)
 	{
-		case 0x8888: aType |= 0<<5; break;
-		case 0x888: aType |= 1<<5; break;
-		case 0x565: aType |= 2<<5; break;
-		case 0x555: aType |= 3<<5; break;
+		// Only the normal kernels were registered, draw it blended as before
+		additive = false;
+		aFunc = gDrawTriFunc[GetDrawTriType(textured, talpha, mod_argb, global_argb, thePixelFormat, blend, false)];
 	}
-	DrawTriFunc aFunc = gDrawTriFunc[aType];
+
+	// The half-space rasterizer only knows straight alpha
+	if (gUseHalfSpace && !additive && !premultipliedTex && !premultipliedDest && HalfSpaceDrawTriangle(textured, talpha, mod_argb, global_argb, pVerts, pFrameBuffer, bytepitch, textureInfo, globalDiffuse, thePixelFormat, blend, aFunc!=NULL))
+		return;
+
 	if (aFunc==NULL)
 	{
 		DBG_ASSERT("You need to call SWTri_AddDrawTriFunc or SWTri_AddAllDrawTriFuncs"==NULL);
 	}
 	else
 		aFunc(pVerts, pFrameBuffer, bytepitch, textureInfo, globalDiffuse);
-
-//	#include "SWTri_DrawTriangleInc2.cpp"
 }
-
-
@@ -33,6 +33,8 @@ public:
 		int pitch;
 		unsigned int endpos;
 		int height;
+		const unsigned int *	pTiled;		// MemoryImage::GetTiledBits() or NULL
+		int tiledPitch;						// texels per row of tiles
 	};
 	struct	SWDiffuse
 	{
@@ -43,14 +45,33 @@ public:
 
 public:
 	// For drawing
-	static void						SWDrawShape(XYZStruct *theVerts, int theNumVerts, MemoryImage *theImage, const Color &theColor, int theDrawMode, const Rect &theClipRect, void *theSurface, int thePitch, int thePixelFormat, bool blend, bool vertexColor);
-	static void						SWDrawTriangle(bool textured, bool talpha, bool mod_argb, bool global_argb, SWVertex * pVerts, unsigned int * pFrameBuffer, const unsigned int pitch, const SWTextureInfo * textureInfo, SWDiffuse & globalDiffuse, int thePixelFormat, bool blend);
+	// premultiplied is for theSurface, the texture's own mode comes from theImage
+	static void						SWDrawShape(XYZStruct *theVerts, int theNumVerts, MemoryImage *theImage, const Color &theColor, int theDrawMode, const Rect &theClipRect, void *theSurface, int thePitch, int thePixelFormat, bool blend, bool vertexColor, bool premultiplied = false);
+	static void						SWDrawTriangle(bool textured, bool talpha, bool mod_argb, bool global_argb, SWVertex * pVerts, unsigned int * pFrameBuffer, const unsigned int pitch, const SWTextureInfo * textureInfo, SWDiffuse & globalDiffuse, int thePixelFormat, bool blend, bool additive = false, bool premultipliedTex = false, bool premultipliedDest = false);
 };
 
 typedef void(*DrawTriFunc)(SWHelper::SWVertex * pVerts, void * pFrameBuffer, const unsigned int bytepitch, const SWHelper::SWTextureInfo * textureInfo, SWHelper::SWDiffuse & globalDiffuse);
 void	SWTri_AddAllDrawTriFuncs();
 void	SWTri_AddDrawTriFunc(bool textured, bool talpha, bool mod_argb, bool global_argb, int thePixelFormat, bool blend, DrawTriFunc theFunc);
 
+// SWTri_AddAllDrawTriFuncs also adds kernels for Graphics::DRAWMODE_ADDITIVE.  Without one,
+// additive triangles are drawn with the normal kernel.
+void	SWTri_AddDrawTriFunc(bool textured, bool talpha, bool mod_argb, bool global_argb, int thePixelFormat, bool blend, bool additive, DrawTriFunc theFunc);
+
+// Draw 8888 triangles (without linear blend) with the tiled SSE2 half-space rasterizer where it
+// beats the scanline kernels (blended/modulated triangles bigger than a couple of tiles).  It
+// also works without any scanline kernels added for those formats.
+void	SWTri_SetUseHalfSpace(bool useHalfSpace);
+bool	SWTri_GetUseHalfSpace();
+
+// Point sampled textures drawn rotated between theMinDegrees and theMaxDegrees (measured from
+// the texture's own x axis to the screen x axis) are sampled from MemoryImage::GetTiledBits(),
+// so stepping across texture rows stays within a few cache lines.  Only done for textures of
+// at least theMinSize pixels, smaller ones stay in cache anyway.  The tiled copy is kept next
+// to the bits until BitsChanged or PurgeBits, so this is off until called (25 to 55 degrees is
+// a good range).  Pass theMinDegrees > theMaxDegrees to disable again.
+void	SWTri_SetTiledTextureAngles(float theMinDegrees, float theMaxDegrees, int theMinSize = 1024*1024);
+
 extern void DrawTriangle_8888_TEX0_TALPHA0_MOD0_GLOB0_BLEND0(SWHelper::SWVertex * pVerts, void * pFrameBuffer, const unsigned int bytepitch, const SWHelper::SWTextureInfo * textureInfo, SWHelper::SWDiffuse & globalDiffuse);
 extern void DrawTriangle_8888_TEX0_TALPHA0_MOD0_GLOB0_BLEND1(SWHelper::SWVertex * pVerts, void * pFrameBuffer, const unsigned int bytepitch, const SWHelper::SWTextureInfo * textureInfo, SWHelper::SWDiffuse & globalDiffuse);
 extern void DrawTriangle_8888_TEX0_TALPHA0_MOD0_GLOB1_BLEND0(SWHelper::SWVertex * pVerts, void * pFrameBuffer, const unsigned int bytepitch, const SWHelper::SWTextureInfo * textureInfo, SWHelper::SWDiffuse & globalDiffuse);
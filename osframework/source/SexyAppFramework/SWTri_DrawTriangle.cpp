@@ -1,278 +1,813 @@
 // This file is included by SWTri.cpp and should not be built directly by the project.
 
-#pragma warning(disable:4101)
-
-#if (TRI0==0) 
-	#define PTYPE unsigned long
-	#define PIXEL_INCLUDE "SWTri_Pixel8888.cpp"
-	#define NAME0 8888
-#elif (TRI0==1)
-	#define PTYPE unsigned long
-	#define PIXEL_INCLUDE "SWTri_Pixel888.cpp"
-	#define NAME0 0888
-#elif (TRI0==2)
-	#define PTYPE unsigned short
-	#define PIXEL_INCLUDE "SWTri_Pixel565.cpp"
-	#define NAME0 0565
-#elif (TRI0==3)
-	#define PTYPE unsigned short
-	#define PIXEL_INCLUDE "SWTri_Pixel555.cpp"
-	#define NAME0 0555
-#endif
-
-#if (TRI1==1)
-	#define TEXTURED
-	#define NAME1 TEX1
-#else
-	#define NAME1 TEX0
-#endif
-
-
-#if (TRI2==1)
-	#define TEX_ALPHA
-	#define NAME2 TALPHA1
-#else
-	#define NAME2 TALPHA0
-#endif
-
-#if (TRI3==1)
-	#define MOD_ARGB
-	#define NAME3 MOD1
-#else
-	#define NAME3 MOD0
-#endif
-
-#if (TRI4==1)
-	#define GLOBAL_ARGB
-	#define NAME4 GLOB1
-#else
-	#define NAME4 GLOB0
-#endif
-
-#if (TRI5==1)
-	#define LINEAR_BLEND
-	#define NAME5 BLEND1
-#else
-	#define NAME5 BLEND0
-#endif
-
-#define funcname2(t0,t1,t2,t3,t4,t5) DrawTriangle_##t0##_##t1##_##t2##_##t3##_##t4##_##t5
-#define funcname1(t0,t1,t2,t3,t4,t5) funcname2(t0,t1,t2,t3,t4,t5)
-#define funcname funcname1(NAME0,NAME1,NAME2,NAME3,NAME4,NAME5)
-void	Sexy::funcname(SWHelper::SWVertex * pVerts, void * pFrameBuffer, const unsigned int bytepitch, const SWHelper::SWTextureInfo * textureInfo, SWHelper::SWDiffuse & globalDiffuse)
+// Every scanline kernel is an instantiation of SWTriKernel<TYPE>, where TYPE is the same
+// set of flags that indexes gDrawTriFunc.  The flags are compile time constants, so each
+// instantiation only keeps the code its combination needs and the per pixel work inlines.
+// A new fast path is a new flag (or pixel format) here instead of another set of files.
+
+enum
+{
+	SWTRI_LINEAR_BLEND		= 0x01,
+	SWTRI_GLOBAL_ARGB		= 0x02,
+	SWTRI_MOD_ARGB			= 0x04,
+	SWTRI_TEX_ALPHA			= 0x08,
+	SWTRI_TEXTURED			= 0x10,
+
+	SWTRI_FORMAT_8888		= 0x00,
+	SWTRI_FORMAT_888		= 0x20,
+	SWTRI_FORMAT_565		= 0x40,
+	SWTRI_FORMAT_555		= 0x60,
+	SWTRI_FORMAT_MASK		= 0x60,
+
+	SWTRI_ADDITIVE			= 0x80,
+
+	// MemoryImage::mPremultipliedAlpha of the texture and of the 8888 frame buffer
+	SWTRI_PREMULTIPLIED_TEX	= 0x100,
+	SWTRI_PREMULTIPLIED_DEST= 0x200,
+
+	SWTRI_NUM_KERNELS		= 0x400,
+
+	// Not part of the gDrawTriFunc index, textured kernels switch to their SWTRI_TILED
+	// version when the texture info has tiled bits
+	SWTRI_TILED				= 0x400
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Frame buffer formats.  Colors come in as 0x00RRGGBB.
+//  Copy:		opaque write
+//  BlendTexel:	alpha blend a texel, premultiplied means tex is already scaled by alpha
+//  BlendColor:	alpha blend an untextured vertex color (8.16 fixed point channels)
+//  Add:		saturating add of an already alpha scaled color, destination alpha is kept
+template <int FORMAT> struct SWTriPixel;
+
+template <> struct SWTriPixel<SWTRI_FORMAT_8888>
 {
-	const int pitch = bytepitch/sizeof(PTYPE);
-	const int tex_pitch = textureInfo->pitch;
-	const int tex_height = textureInfo->height;
-	const unsigned int tex_endpos = textureInfo->endpos;
+	typedef unsigned int PType;
 
-	const SWHelper::signed64 bigOne = static_cast<SWHelper::signed64>(1) << 48;
-	#define  swap(a,b,type) {type tmp = a; a = b; b = tmp;}
+	static inline void Copy(PType * pix, unsigned int rgb)
+	{
+		*pix = rgb | 0xFF000000;
+	}
 
-	const unsigned int *	pTexture;
-	unsigned int		vShift, uMask, vMask;
-	
-	#if defined(TEXTURED)
+	static inline void BlendTexel(PType * pix, unsigned int tex, unsigned int alpha, bool premultiplied)
+	{
+		unsigned int p = *pix;
+		unsigned int da = p >> 24;
+
+		unsigned int tr,tg,tb;
+		if (!premultiplied)
+		{
+			tr = ((tex&0xFF0000)*alpha)&0xFF000000;
+			tg = ((tex&0x00FF00)*alpha)&0x00FF0000;
+			tb = ((tex&0x0000FF)*alpha)&0x0000FF00;
+		}
+		else
+		{
+			tr = (tex&0xFF0000)<<8;
+			tg = (tex&0x00FF00)<<8;
+			tb = (tex&0x0000FF)<<8;
+		}
+
+		unsigned int dr = (((p&0xFF0000)*da)>>8) & 0xFF0000;
+		unsigned int dg = (((p&0x00FF00)*da)>>8) & 0x00FF00;
+		unsigned int db = (((p&0x0000FF)*da)>>8) & 0x0000FF;
+
+		int finalAlpha = 256 - (((256 - alpha)*(256 - da))>>8);
+		tr = ((tr + (256-alpha)*dr)/finalAlpha) & 0xFF0000;
+		tg = ((tg + (256-alpha)*dg)/finalAlpha) & 0x00FF00;
+		tb = ((tb + (256-alpha)*db)/finalAlpha) & 0x0000FF;
+
+		*pix = ((finalAlpha-1)<<24) | tr | tg | tb;
+	}
+
+	static inline void BlendColor(PType * pix, unsigned int r, unsigned int g, unsigned int b, unsigned int alpha)
+	{
+		unsigned int p = *pix;
+		unsigned int da = p >> 24;
+
+		unsigned int tr = ((r)*(alpha))&0xFF000000;
+		unsigned int tg = ((g>>8)*(alpha))&0x00FF0000;
+		unsigned int tb = ((b>>16)*(alpha))&0x0000FF00;
+
+		unsigned int dr = (((p&0xFF0000)*da)>>8) & 0xFF0000;
+		unsigned int dg = (((p&0x00FF00)*da)>>8) & 0x00FF00;
+		unsigned int db = (((p&0x0000FF)*da)>>8) & 0x0000FF;
+
+		int finalAlpha = 256 - (((256 - alpha)*(256 - da))>>8);
+		tr = ((tr + (256-alpha)*dr)/finalAlpha) & 0xFF0000;
+		tg = ((tg + (256-alpha)*dg)/finalAlpha) & 0x00FF00;
+		tb = ((tb + (256-alpha)*db)/finalAlpha) & 0x0000FF;
+
+		*pix = ((finalAlpha-1)<<24) | tr | tg | tb;
+	}
+
+	static inline void Add(PType * pix, unsigned int rgb)
+	{
+		unsigned int p = *pix;
+		unsigned int rb = (p&0xff00ff) + (rgb&0xff00ff);
+		unsigned int g = (p&0x00ff00) + (rgb&0x00ff00);
+		rb = (rb | (((rb>>8)&0x010001)*0xff)) & 0xff00ff;
+		g = (g | (((g>>8)&0x000100)*0xff)) & 0x00ff00;
+		*pix = (p&0xFF000000) | rb | g;
+	}
+};
+
+template <> struct SWTriPixel<SWTRI_FORMAT_888>
+{
+	typedef unsigned int PType;
+
+	static inline void Copy(PType * pix, unsigned int rgb)
+	{
+		*pix = 0xFF000000 | rgb;
+	}
+
+	static inline void BlendTexel(PType * pix, unsigned int tex, unsigned int alpha, bool premultiplied)
+	{
+		unsigned int trb, tg;
+		if (!premultiplied)
+		{
+			trb = (((tex&0xff00ff) * alpha) >> 8) & 0xff00ff;
+			tg  = (((tex&0x00ff00) * alpha) >> 8) & 0x00ff00;
+		}
+		else
+		{
+			trb = tex&0xff00ff;
+			tg = tex&0x00ff00;
+		}
+
+		unsigned int	p = *pix;
+		alpha = 0xff - alpha;
+		unsigned int	prb = (((p&0xff00ff) * alpha) >> 8) & 0xff00ff;
+		unsigned int	pg  = (((p&0x00ff00) * alpha) >> 8) & 0x00ff00;
+		*pix = 0xFF000000 | ((trb|tg) + (prb|pg));
+	}
+
+	static inline void BlendColor(PType * pix, unsigned int r, unsigned int g, unsigned int b, unsigned int alpha)
+	{
+		unsigned int	_rb = ((((r&0xff0000) | (b>>16)) * alpha)>> 8)&0xff00ff;
+		unsigned int	_g  =  (((g&0xff0000)            * alpha)>>16)&0x00ff00;
+		unsigned int	p = *pix;
+		alpha = 0xff - alpha;
+		unsigned int	prb = (((p&0xff00ff) * alpha) >> 8) & 0xff00ff;
+		unsigned int	pg  = (((p&0x00ff00) * alpha) >> 8) & 0x00ff00;
+		*pix = 0xFF000000 | ((_rb|_g)+(prb|pg));
+	}
+
+	static inline void Add(PType * pix, unsigned int rgb)
+	{
+		unsigned int p = *pix;
+		unsigned int rb = (p&0xff00ff) + (rgb&0xff00ff);
+		unsigned int g = (p&0x00ff00) + (rgb&0x00ff00);
+		rb = (rb | (((rb>>8)&0x010001)*0xff)) & 0xff00ff;
+		g = (g | (((g>>8)&0x000100)*0xff)) & 0x00ff00;
+		*pix = 0xFF000000 | rb | g;
+	}
+};
+
+template <> struct SWTriPixel<SWTRI_FORMAT_565>
+{
+	typedef unsigned short PType;
+
+	static inline void Copy(PType * pix, unsigned int rgb)
+	{
+		*pix = ((rgb>>8)&0xf800)|((rgb>>5)&0x07e0)|((rgb>>3)&0x001f);
+	}
+
+	static inline void BlendTexel(PType * pix, unsigned int tex, unsigned int alpha, bool premultiplied)
+	{
+		unsigned int trb, tg;
+		if (!premultiplied)
+		{
+			trb = (((tex&0xff00ff) * alpha) >> 8) & 0xff00ff;
+			tg  = (((tex&0x00ff00) * alpha) >> 8) & 0x00ff00;
+		}
+		else
+		{
+			trb = tex&0xff00ff;
+			tg = tex&0x00ff00;
+		}
+
+		trb = ((trb>>8)&0xf800)|((trb>>3)&0x001f);
+		tg = ((tg>>5)&0x07e0);
+		unsigned int	p = *pix;
+		alpha = (0xff - alpha)>>3;
+		unsigned int	prb = (((p&0xf81f) * alpha) >> 5) & 0xf81f;
+		unsigned int	pg  = (((p&0x07e0) * alpha) >> 5) & 0x07e0;
+		*pix = (trb|tg) + (prb|pg);
+	}
+
+	static inline void BlendColor(PType * pix, unsigned int r, unsigned int g, unsigned int b, unsigned int alpha)
+	{
+		unsigned int	_rb = ((((r&0xff0000) | (b>>16)) * alpha)>> 8)&0xff00ff;
+		unsigned int	_g  =  (((g&0xff0000)            * alpha)>>16)&0x00ff00;
+				_rb = ((_rb>>8)&0xf800)|((_rb>>3)&0x001f);
+				_g = ((_g>>5)&0x07e0);
+		unsigned int	p = *pix;
+				alpha = (0xff - alpha)>>3;
+		unsigned int	prb = (((p&0xf81f) * alpha) >> 5) & 0xf81f;
+		unsigned int	pg  = (((p&0x07e0) * alpha) >> 5) & 0x07e0;
+		*pix = (_rb|_g)+(prb|pg);
+	}
+
+	static inline void Add(PType * pix, unsigned int rgb)
+	{
+		unsigned int p = *pix;
+		unsigned int r = (p&0xf800) + ((rgb>>8)&0xf800);
+		unsigned int g = (p&0x07e0) + ((rgb>>5)&0x07e0);
+		unsigned int b = (p&0x001f) + ((rgb>>3)&0x001f);
+		if (r > 0xf800) r = 0xf800;
+		if (g > 0x07e0) g = 0x07e0;
+		if (b > 0x001f) b = 0x001f;
+		*pix = r | g | b;
+	}
+};
+
+template <> struct SWTriPixel<SWTRI_FORMAT_555>
+{
+	typedef unsigned short PType;
+
+	static inline void Copy(PType * pix, unsigned int rgb)
+	{
+		*pix = ((rgb>>9)&0x7c00)|((rgb>>6)&0x03e0)|((rgb>>3)&0x001f);
+	}
+
+	static inline void BlendTexel(PType * pix, unsigned int tex, unsigned int alpha, bool premultiplied)
+	{
+		unsigned int trb, tg;
+		if (!premultiplied)
+		{
+			trb = (((tex&0xff00ff) * alpha) >> 8) & 0xff00ff;
+			tg  = (((tex&0x00ff00) * alpha) >> 8) & 0x00ff00;
+		}
+		else
+		{
+			trb = tex&0xff00ff;
+			tg = tex&0x00ff00;
+		}
+
+		trb = ((trb>>9)&0x7c00)|((trb>>3)&0x001f);
+		tg = ((tg>>6)&0x03e0);
+		unsigned int	p = *pix;
+		alpha = (0xff - alpha)>>3;
+		unsigned int	prb = (((p&0x7c1f) * alpha) >> 5) & 0x7c1f;
+		unsigned int	pg  = (((p&0x03e0) * alpha) >> 5) & 0x03e0;
+		*pix = (trb|tg) + (prb|pg);
+	}
+
+	static inline void BlendColor(PType * pix, unsigned int r, unsigned int g, unsigned int b, unsigned int alpha)
+	{
+		unsigned int	_rb = ((((r&0xff0000) | (b>>16)) * alpha)>> 8)&0xff00ff;
+		unsigned int	_g  =  (((g&0xff0000)            * alpha)>>16)&0x00ff00;
+				_rb = ((_rb>>9)&0x7c00)|((_rb>>3)&0x001f);
+				_g = ((_g>>6)&0x03e0);
+		unsigned int	p = *pix;
+				alpha = (0xff - alpha)>>3;
+		unsigned int	prb = (((p&0x7c1f) * alpha) >> 5) & 0x7c1f;
+		unsigned int	pg  = (((p&0x03e0) * alpha) >> 5) & 0x03e0;
+		*pix = (_rb|_g)+(prb|pg);
+	}
+
+	static inline void Add(PType * pix, unsigned int rgb)
+	{
+		unsigned int p = *pix;
+		unsigned int r = (p&0x7c00) + ((rgb>>9)&0x7c00);
+		unsigned int g = (p&0x03e0) + ((rgb>>6)&0x03e0);
+		unsigned int b = (p&0x001f) + ((rgb>>3)&0x001f);
+		if (r > 0x7c00) r = 0x7c00;
+		if (g > 0x03e0) g = 0x03e0;
+		if (b > 0x001f) b = 0x001f;
+		*pix = r | g | b;
+	}
+};
+
+// A premultiplied 8888 frame buffer, where blending is dest*(1-alpha) + src on all four channels
+template <> struct SWTriPixel<SWTRI_FORMAT_8888 | SWTRI_PREMULTIPLIED_DEST> : SWTriPixel<SWTRI_FORMAT_8888>
+{
+	static inline unsigned int BlendOver(unsigned int p, unsigned int src, unsigned int alpha)
 	{
-		pTexture = textureInfo->pTexture;
-		vShift = textureInfo->vShift;
-		vMask = textureInfo->vMask;
-		uMask = textureInfo->uMask;
+		unsigned int oma = 256 - alpha;
+		return src + ((((p&0xff00ff) * oma) >> 8) & 0xff00ff) + ((((p>>8)&0xff00ff) * oma) & 0xff00ff00);
+	}
+
+	static inline void BlendTexel(PType * pix, unsigned int tex, unsigned int alpha, bool premultiplied)
+	{
+		unsigned int trgb;
+		if (!premultiplied)
+			trgb = ((((tex&0xff00ff) * alpha) >> 8) & 0xff00ff) | ((((tex&0x00ff00) * alpha) >> 8) & 0x00ff00);
+		else
+			trgb = tex&0xffffff;
+
+		*pix = BlendOver(*pix, (alpha<<24) | trgb, alpha);
 	}
-	#endif
 
-	// Sort vertices by Y component
+	static inline void BlendColor(PType * pix, unsigned int r, unsigned int g, unsigned int b, unsigned int alpha)
+	{
+		unsigned int rgb = (r&0xff0000) | ((g>>8)&0x00ff00) | ((b>>16)&0x0000ff);
+		unsigned int trgb = ((((rgb&0xff00ff) * alpha) >> 8) & 0xff00ff) | ((((rgb&0x00ff00) * alpha) >> 8) & 0x00ff00);
 
-	SWHelper::SWVertex *	v0 = pVerts+0;
-	SWHelper::SWVertex *	v1 = pVerts+1;
-	SWHelper::SWVertex *	v2 = pVerts+2;
+		*pix = BlendOver(*pix, (alpha<<24) | trgb, alpha);
+	}
+};
 
-	if (v0->y > v1->y) swap(v0,v1,SWHelper::SWVertex *);
-	if (v1->y > v2->y) swap(v1,v2,SWHelper::SWVertex *);
-	if (v0->y > v1->y) swap(v0,v1,SWHelper::SWVertex *);
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Interpolated values, all 16.16 fixed point.  The color channels are only used by the
+// MOD_ARGB kernels and u/v only by the textured ones.
+struct SWTriAttribs
+{
+	int		a, r, g, b;
+	int		u, v;
+};
 
-	#if defined(MOD_ARGB) && defined(GLOBAL_ARGB)
+struct SWTriTexture
+{
+	const unsigned int *	pTexture;
+	int						pitch;
+	unsigned int			endpos;
+	const unsigned int *	pTiled;
+	int						tiledPitch;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <int TYPE>
+struct SWTriKernel
+{
+	enum
+	{
+		TEXTURED		= (TYPE & SWTRI_TEXTURED) != 0,
+		TEX_ALPHA		= (TYPE & SWTRI_TEX_ALPHA) != 0,
+		MOD_ARGB		= (TYPE & SWTRI_MOD_ARGB) != 0,
+		GLOBAL_ARGB		= (TYPE & SWTRI_GLOBAL_ARGB) != 0,
+		LINEAR_BLEND	= (TYPE & SWTRI_LINEAR_BLEND) != 0,
+		ADDITIVE		= (TYPE & SWTRI_ADDITIVE) != 0,
+		PREMULTIPLIED_TEX = (TYPE & SWTRI_PREMULTIPLIED_TEX) != 0,
+		TILED			= (TYPE & SWTRI_TILED) != 0,
+
+		// Whether the texel that reaches the frame buffer is already scaled by its alpha
+		PREMUL_TEXEL	= LINEAR_BLEND || PREMULTIPLIED_TEX
+	};
+
+	typedef SWTriPixel<TYPE & (SWTRI_FORMAT_MASK | SWTRI_PREMULTIPLIED_DEST)> Pixel;
+	typedef typename Pixel::PType PType;
+
+	// Texel x,y at row major position t_pos.  Positions past the end of a row (which
+	// read the next row in mBits) aren't in the tiled copy, so those still use pTexture.
+	static inline unsigned int FetchTexel(const SWTriTexture & theTex, unsigned int t_pos, unsigned int x, unsigned int y)
 	{
-		v0->a = (v0->a * globalDiffuse.a) >> 8;
-		v0->r = (v0->r * globalDiffuse.r) >> 8;
-		v0->g = (v0->g * globalDiffuse.g) >> 8;
-		v0->b = (v0->b * globalDiffuse.b) >> 8;
-		v1->a = (v1->a * globalDiffuse.a) >> 8;
-		v1->r = (v1->r * globalDiffuse.r) >> 8;
-		v1->g = (v1->g * globalDiffuse.g) >> 8;
-		v1->b = (v1->b * globalDiffuse.b) >> 8;
-		v2->a = (v2->a * globalDiffuse.a) >> 8;
-		v2->r = (v2->r * globalDiffuse.r) >> 8;
-		v2->g = (v2->g * globalDiffuse.g) >> 8;
-		v2->b = (v2->b * globalDiffuse.b) >> 8;
+		if (t_pos >= theTex.endpos)
+			return 0;
+
+		if (TILED && x < (unsigned int) theTex.pitch)
+			return theTex.pTiled[(y>>2)*theTex.tiledPitch + ((x>>2)<<4) + ((y&3)<<2) + (x&3)];
+
+		return theTex.pTexture[t_pos];
 	}
-	#endif
-
-	// Integer Y values (using a quick form of ceil() for positive values)
-
-	int	y0 = (v0->y + 0xffff) >> 16;
-	int	y2 = (v2->y + 0xffff) >> 16;
-	if (y0 == y2) return;   // Null polygon (no height)?
-	int	y1 = (v1->y + 0xffff) >> 16;
-
-	// Calculate long-edge deltas
-
-	SWHelper::signed64	oneOverHeight = bigOne / (v2->y - v0->y);
-	int		ldx, ldr, ldg, ldb, lda, ldu, ldv;
-			ldx = static_cast<int>(((v2->x - v0->x) * oneOverHeight) >> 32);
-
-	#if defined(MOD_ARGB)		
-		lda = static_cast<int>(((v2->a - v0->a) * oneOverHeight) >> 32);
-		ldr = static_cast<int>(((v2->r - v0->r) * oneOverHeight) >> 32);
-		ldg = static_cast<int>(((v2->g - v0->g) * oneOverHeight) >> 32);
-		ldb = static_cast<int>(((v2->b - v0->b) * oneOverHeight) >> 32);
-	#endif
-	
-	#if defined(TEXTURED)
-		ldu = static_cast<int>(((v2->u - v0->u) * oneOverHeight) >> 32);
-		ldv = static_cast<int>(((v2->v - v0->v) * oneOverHeight) >> 32);
-	#endif
-
-	// Long-edge midpoint
-
-	SWHelper::signed64	topHeight = v1->y - v0->y;
-	int		mid = v0->x + static_cast<int>((topHeight * ldx)>>16);
-
-	if (v1->x == mid) return;   // Null polygon (no width)?
-
-	// Edge variables (long)
-
-	SWHelper::signed64	subPix = (y0<<16) - v0->y;
-	int		lx, lr, lg, lb, la, lu, lv;
-			lx = v0->x + static_cast<int>((ldx * subPix)>>16);
-
-	#if defined(MOD_ARGB)
-		la = v0->a + static_cast<int>((lda * subPix)>>16);
-		lr = v0->r + static_cast<int>((ldr * subPix)>>16);
-		lg = v0->g + static_cast<int>((ldg * subPix)>>16);
-		lb = v0->b + static_cast<int>((ldb * subPix)>>16);
-	#endif
-	
-	#if defined(TEXTURED)
-		lu = v0->u + static_cast<int>((ldu * subPix)>>16);
-		lv = v0->v + static_cast<int>((ldv * subPix)>>16);
-	#endif
-
-	// Scanline deltas
-
-	SWHelper::signed64	oneOverWidth;
-	int		dr, dg, db, da, du, dv;
-	#if defined(TEXTURED) || defined(MOD_ARGB)	
-		oneOverWidth = bigOne / (v1->x - mid);
-	#endif
-	
-	#if defined (MOD_ARGB)
-		da = static_cast<int>(((v1->a - (v0->a + ((topHeight * lda)>>16))) * oneOverWidth)>>32);
-		dr = static_cast<int>(((v1->r - (v0->r + ((topHeight * ldr)>>16))) * oneOverWidth)>>32);
-		dg = static_cast<int>(((v1->g - (v0->g + ((topHeight * ldg)>>16))) * oneOverWidth)>>32);
-		db = static_cast<int>(((v1->b - (v0->b + ((topHeight * ldb)>>16))) * oneOverWidth)>>32);
-	#endif
-	
-	#if defined (TEXTURED)
-		du = static_cast<int>(((v1->u - (v0->u + ((topHeight * ldu)>>16))) * oneOverWidth)>>32);
-		dv = static_cast<int>(((v1->v - (v0->v + ((topHeight * ldv)>>16))) * oneOverWidth)>>32);
-	#endif
-
-	// Screen info
-
-	unsigned int	offset = y0 * pitch;
-	PTYPE *		fb = reinterpret_cast<PTYPE *>(pFrameBuffer) + offset;
-	int		iHeight = y1 - y0;
-
-	if (iHeight)
+
+	static inline unsigned int GetTexel(const SWTriTexture & theTex, unsigned int u, unsigned int v)
 	{
-		// Short edge delta X
+		const int tex_pitch = theTex.pitch;
 
-		oneOverHeight = bigOne / topHeight;
-		int	sdx = static_cast<int>(((v1->x - v0->x) * oneOverHeight) >> 32);
+		if (!LINEAR_BLEND)
+		{
+			unsigned int	t_pos = ((v)>>16)*tex_pitch + ((u)>>16);
+			return FetchTexel(theTex, t_pos, u>>16, v>>16);
+		}
+
+		int umid = u-0x8000;
+		int vmid = v-0x8000;
+		int umidfloor = FixedFloor(umid);
+		int vmidfloor = FixedFloor(vmid);
 
-		// Edge variables (short)
+		unsigned int	x = umidfloor>>16;
+		unsigned int	y = vmidfloor>>16;
+		unsigned int	t_pos = y*tex_pitch + x;
 
-		int	sx = v0->x + static_cast<int>((sdx * subPix)>>16);
+		unsigned int	t00 = FetchTexel(theTex, t_pos, x, y);
+		unsigned int	t10 = FetchTexel(theTex, t_pos+1, x+1, y);
+		unsigned int	t01 = FetchTexel(theTex, t_pos+tex_pitch, x, y+1);
+		unsigned int	t11 = FetchTexel(theTex, t_pos+tex_pitch+1, x+1, y+1);
 
-		// Scan-convert the top half
+		int aUFactor = ((umid-umidfloor) & 0xFFFE) + 1; // aUFactor needs to be between 1 and 0xFFFF to avoid overflow
+		int aVFactor = ((vmid-vmidfloor) & 0xFFFE) + 1; // ditto for aVFactor
 
-		if (mid < v1->x)
+		if (PREMULTIPLIED_TEX)
 		{
-			while(iHeight-- > 0)
+			// Already weighted by alpha, so every channel filters the same way
+			unsigned int w00 = ((ulong) ((0x10000  - aUFactor) * (0x10000  - aVFactor))) >> 16;
+			unsigned int w10 = ((ulong) ((           aUFactor) * (0x10000  - aVFactor))) >> 16;
+			unsigned int w01 = ((ulong) ((0x10000  - aUFactor) * (           aVFactor))) >> 16;
+			unsigned int w11 = ((ulong) ((           aUFactor) * (           aVFactor))) >> 16;
+
+			unsigned int aResult = 0;
+			for (int aShift = 0; aShift < 32; aShift += 8)
 			{
-				// Integer (ceil()) left and right X components
+				unsigned int c = (((t00>>aShift)&0xFF)*w00 + ((t10>>aShift)&0xFF)*w10 + ((t01>>aShift)&0xFF)*w01 + ((t11>>aShift)&0xFF)*w11) >> 16;
+				aResult |= c << aShift;
+			}
+			return aResult;
+		}
+
+		int a00 = ((t00 >> 24) * ((ulong) ((0x10000  - aUFactor) * (0x10000  - aVFactor)) >> 16)) >> 16;
+		int a10 = ((t10 >> 24) * ((ulong) ((           aUFactor) * (0x10000  - aVFactor)) >> 16)) >> 16;
+		int a01 = ((t01 >> 24) * ((ulong) ((0x10000  - aUFactor) * (           aVFactor)) >> 16)) >> 16;
+		int a11 = ((t11 >> 24) * ((ulong) ((           aUFactor) * (           aVFactor)) >> 16)) >> 16;
+		unsigned int r = (((t00&0x00FF0000)*a00 + (t10&0x00FF0000)*a10 + (t01&0x00FF0000)*a01 + (t11&0x00FF0000)*a11)>>8)&0xFF0000;
+		unsigned int g = (((t00&0x0000FF00)*a00 + (t10&0x0000FF00)*a10 + (t01&0x0000FF00)*a01 + (t11&0x0000FF00)*a11)>>8)&0x00FF00;
+		unsigned int b = (((t00&0x000000FF)*a00 + (t10&0x000000FF)*a10 + (t01&0x000000FF)*a01 + (t11&0x000000FF)*a11)>>8)&0x0000FF;
+		unsigned int a = ((a00 + a10 + a01 + a11)<<24)&0xFF000000;
+
+		return a|r|g|b;
+	}
+
+	// Applies the vertex and global colors to the texel and its alpha
+	static inline void ModulateTexel(unsigned int & tex, unsigned int & alpha, const SWTriAttribs & c, const SWHelper::SWDiffuse & globalDiffuse)
+	{
+		if (!MOD_ARGB && !GLOBAL_ARGB)
+			return;
 
-				int		x0 = (lx + 0xffff) & 0xffff0000;
-				int		x1 = (sx + 0xffff) & 0xffff0000;
-				#include "SWTri_Loop.cpp"
+		unsigned int r = c.r, g = c.g, b = c.b;
+		int premult;
+		if (MOD_ARGB && GLOBAL_ARGB)
+		{
+			premult = ((globalDiffuse.a*c.a)>>24);
+			alpha = (alpha * premult) >> 8;
+			tex =	((((tex&0xff0000)*((globalDiffuse.r*r)>>24))>>8)&0xff0000)|
+				((((tex&0x00ff00)*((globalDiffuse.g*g)>>24))>>8)&0x00ff00)|
+				((((tex&0x0000ff)*((globalDiffuse.b*b)>>24))>>8)&0x0000ff);
+		}
+		else if (GLOBAL_ARGB)
+		{
+			premult = globalDiffuse.a;
+			alpha = (alpha * premult) >> 8;
+			tex =	((((tex&0xff0000)*globalDiffuse.r)>>8)&0xff0000)|
+				((((tex&0x00ff00)*globalDiffuse.g)>>8)&0x00ff00)|
+				((((tex&0x0000ff)*globalDiffuse.b)>>8)&0x0000ff);
+		}
+		else
+		{
+			premult = c.a>>16;
+			alpha = (alpha * premult) >> 8;
+			tex =	((((tex&0xff0000)*(r>>16))>>8)&0xff0000)|
+				((((tex&0x00ff00)*(g>>16))>>8)&0x00ff00)|
+				((((tex&0x0000ff)*(b>>16))>>8)&0x0000ff);
+		}
+
+		// linear blend expects pixel to already be premultiplied by alpha, and a premultiplied
+		//  texel has to pick up the extra alpha too
+		if (PREMUL_TEXEL)
+		{
+			unsigned int pr = (((tex&0xff0000)*premult)>>8)&0xff0000;
+			unsigned int pg = (((tex&0x00ff00)*premult)>>8)&0x00ff00;
+			unsigned int pb = (((tex&0x0000ff)*premult)>>8)&0x0000ff;
+			tex = pr|pg|pb;
+		}
+	}
+
+	static inline unsigned int ScaleRGB(unsigned int rgb, unsigned int alpha)
+	{
+		return ((((rgb&0xff00ff) * alpha) >> 8) & 0xff00ff) | ((((rgb&0x00ff00) * alpha) >> 8) & 0x00ff00);
+	}
+
+	static inline void DrawPixel(PType * pix, const SWTriAttribs & c, const SWTriTexture & theTex, const SWHelper::SWDiffuse & globalDiffuse)
+	{
+		if (TEXTURED)
+		{
+			unsigned int tex = GetTexel(theTex, c.u, c.v);
+			unsigned int alpha = TEX_ALPHA ? tex>>24 : 0xFF;
+			if (alpha <= 0x08)
+				return;
+
+			ModulateTexel(tex, alpha, c, globalDiffuse);
+
+			if (ADDITIVE)
+			{
+				if (PREMUL_TEXEL)
+					Pixel::Add(pix, tex&0xffffff);
+				else if (alpha < 0xf0)
+					Pixel::Add(pix, ScaleRGB(tex, alpha));
+				else
+					Pixel::Add(pix, tex&0xffffff);
 			}
+			else if ((GLOBAL_ARGB || TEX_ALPHA || MOD_ARGB) && alpha < 0xf0)
+				Pixel::BlendTexel(pix, tex, alpha, PREMUL_TEXEL != 0);
+			else
+				Pixel::Copy(pix, tex);
 		}
-		else if (mid > v1->x)
+		else if (MOD_ARGB)
 		{
-			while(iHeight-- > 0)
+			unsigned int r = c.r, g = c.g, b = c.b, a = c.a;
+			if (ADDITIVE)
 			{
-				// Integer (ceil()) left and right X components
-
-				int	x0 = (sx + 0xffff) & 0xffff0000;
-				int	x1 = (lx + 0xffff) & 0xffff0000;
-				#include "SWTri_Loop.cpp"
+				if (a > 0x080000)
+					Pixel::Add(pix, ScaleRGB((r&0xff0000)|((g>>8)&0xff00)|((b>>16)&0xff), a>>16));
 			}
+			else if (a > 0xf00000)
+				Pixel::Copy(pix, (r&0xff0000)|((g>>8)&0xff00)|((b>>16)&0xff));
+			else if (a > 0x080000)
+				Pixel::BlendColor(pix, r, g, b, a>>16);
 		}
 	}
 
-	// Done?
+	static inline void DrawSpan(PType * fb, int x0, int x1, int lx, const SWTriAttribs & theLeft, const SWTriAttribs & theStep, const SWTriTexture & theTex, const SWHelper::SWDiffuse & globalDiffuse)
+	{
+		SWHelper::signed64	subTex = x0 - lx;
+		SWTriAttribs c = theLeft;
 
-	iHeight = y2 - y1;
-	if (!iHeight) return;
+		if (MOD_ARGB)
+		{
+			c.a += static_cast<int>((theStep.a * subTex)>>16);
+			c.r += static_cast<int>((theStep.r * subTex)>>16);
+			c.g += static_cast<int>((theStep.g * subTex)>>16);
+			c.b += static_cast<int>((theStep.b * subTex)>>16);
+		}
+
+		if (TEXTURED)
+		{
+			c.u += static_cast<int>((theStep.u * subTex)>>16);
+			c.v += static_cast<int>((theStep.v * subTex)>>16);
+		}
 
-	// Short edge along bottom half
+		PType *		pix = fb + (x0>>16);
+		int		width = ((x1-x0)>>16);
 
-	oneOverHeight = bigOne / (v2->y - v1->y);
-	int	sdx = static_cast<int>(((v2->x - v1->x) * oneOverHeight) >> 32);
+		while(width-- > 0)
+		{
+			DrawPixel(pix, c, theTex, globalDiffuse);
+			++pix;
 
-	subPix = (y1<<16) - v1->y;
-	int	sx = v1->x + static_cast<int>((sdx * subPix)>>16);
+			if (MOD_ARGB)
+			{
+				c.a += theStep.a;
+				c.r += theStep.r;
+				c.g += theStep.g;
+				c.b += theStep.b;
+			}
 
-	// Scan-convert the bottom half
+			if (TEXTURED)
+			{
+				c.u += theStep.u;
+				c.v += theStep.v;
+			}
+		}
+	}
 
-	if (mid < v1->x)
+	// Scan converts iHeight lines between the long edge (lx) and a short edge (sx)
+	static inline void DrawSpans(PType *& fb, int pitch, int iHeight, bool longEdgeIsLeft, int & lx, int ldx, int sx, int sdx, SWTriAttribs & theLeft, const SWTriAttribs & theLeftStep, const SWTriAttribs & theStep, const SWTriTexture & theTex, const SWHelper::SWDiffuse & globalDiffuse)
 	{
 		while(iHeight-- > 0)
 		{
 			// Integer (ceil()) left and right X components
 
-			int	x0 = (lx + 0xffff) & 0xffff0000;
-			int	x1 = (sx + 0xffff) & 0xffff0000;
-			#include "SWTri_Loop.cpp"
+			int		lceil = (lx + 0xffff) & 0xffff0000;
+			int		sceil = (sx + 0xffff) & 0xffff0000;
+			if (longEdgeIsLeft)
+				DrawSpan(fb, lceil, sceil, lx, theLeft, theStep, theTex, globalDiffuse);
+			else
+				DrawSpan(fb, sceil, lceil, lx, theLeft, theStep, theTex, globalDiffuse);
+
+			lx += ldx;
+			sx += sdx;
+			fb += pitch;
+
+			if (MOD_ARGB)
+			{
+				theLeft.a += theLeftStep.a;
+				theLeft.r += theLeftStep.r;
+				theLeft.g += theLeftStep.g;
+				theLeft.b += theLeftStep.b;
+			}
+
+			if (TEXTURED)
+			{
+				theLeft.u += theLeftStep.u;
+				theLeft.v += theLeftStep.v;
+			}
 		}
 	}
-	else if (mid > v1->x)
+
+	static void DrawTriangle(SWHelper::SWVertex * pVerts, void * pFrameBuffer, const unsigned int bytepitch, const SWHelper::SWTextureInfo * textureInfo, SWHelper::SWDiffuse & globalDiffuse)
 	{
-		while(iHeight-- > 0)
+		if (TEXTURED && !TILED && textureInfo->pTiled != NULL)
 		{
-			// Integer (ceil()) left and right X components
+			SWTriKernel<TYPE | (TEXTURED ? SWTRI_TILED : 0)>::DrawTriangle(pVerts, pFrameBuffer, bytepitch, textureInfo, globalDiffuse);
+			return;
+		}
+
+		const int pitch = bytepitch/sizeof(PType);
+		const SWHelper::signed64 bigOne = static_cast<SWHelper::signed64>(1) << 48;
+
+		SWTriTexture	aTex = {NULL, 0, 0, NULL, 0};
+		if (TEXTURED)
+		{
+			aTex.pTexture = textureInfo->pTexture;
+			aTex.pitch = textureInfo->pitch;
+			aTex.endpos = textureInfo->endpos;
+			if (TILED)
+			{
+				aTex.pTiled = textureInfo->pTiled;
+				aTex.tiledPitch = textureInfo->tiledPitch;
+			}
+		}
+
+		// Sort vertices by Y component
+
+		SWHelper::SWVertex *	v0 = pVerts+0;
+		SWHelper::SWVertex *	v1 = pVerts+1;
+		SWHelper::SWVertex *	v2 = pVerts+2;
+		SWHelper::SWVertex *	tmp;
+
+		if (v0->y > v1->y) { tmp = v0; v0 = v1; v1 = tmp; }
+		if (v1->y > v2->y) { tmp = v1; v1 = v2; v2 = tmp; }
+		if (v0->y > v1->y) { tmp = v0; v0 = v1; v1 = tmp; }
+
+		if (MOD_ARGB && GLOBAL_ARGB)
+		{
+			v0->a = (v0->a * globalDiffuse.a) >> 8;
+			v0->r = (v0->r * globalDiffuse.r) >> 8;
+			v0->g = (v0->g * globalDiffuse.g) >> 8;
+			v0->b = (v0->b * globalDiffuse.b) >> 8;
+			v1->a = (v1->a * globalDiffuse.a) >> 8;
+			v1->r = (v1->r * globalDiffuse.r) >> 8;
+			v1->g = (v1->g * globalDiffuse.g) >> 8;
+			v1->b = (v1->b * globalDiffuse.b) >> 8;
+			v2->a = (v2->a * globalDiffuse.a) >> 8;
+			v2->r = (v2->r * globalDiffuse.r) >> 8;
+			v2->g = (v2->g * globalDiffuse.g) >> 8;
+			v2->b = (v2->b * globalDiffuse.b) >> 8;
+		}
+
+		// Integer Y values (using a quick form of ceil() for positive values)
+
+		int	y0 = (v0->y + 0xffff) >> 16;
+		int	y2 = (v2->y + 0xffff) >> 16;
+		if (y0 == y2) return;   // Null polygon (no height)?
+		int	y1 = (v1->y + 0xffff) >> 16;
+
+		// Calculate long-edge deltas
+
+		SWHelper::signed64	oneOverHeight = bigOne / (v2->y - v0->y);
+		int		ldx = static_cast<int>(((v2->x - v0->x) * oneOverHeight) >> 32);
+		SWTriAttribs	aLeftStep = {0, 0, 0, 0, 0, 0};
+
+		if (MOD_ARGB)
+		{
+			aLeftStep.a = static_cast<int>(((v2->a - v0->a) * oneOverHeight) >> 32);
+			aLeftStep.r = static_cast<int>(((v2->r - v0->r) * oneOverHeight) >> 32);
+			aLeftStep.g = static_cast<int>(((v2->g - v0->g) * oneOverHeight) >> 32);
+			aLeftStep.b = static_cast<int>(((v2->b - v0->b) * oneOverHeight) >> 32);
+		}
+
+		if (TEXTURED)
+		{
+			aLeftStep.u = static_cast<int>(((v2->u - v0->u) * oneOverHeight) >> 32);
+			aLeftStep.v = static_cast<int>(((v2->v - v0->v) * oneOverHeight) >> 32);
+		}
+
+		// Long-edge midpoint
+
+		SWHelper::signed64	topHeight = v1->y - v0->y;
+		int		mid = v0->x + static_cast<int>((topHeight * ldx)>>16);
+
+		if (v1->x == mid) return;   // Null polygon (no width)?
+		bool	longEdgeIsLeft = mid < v1->x;
+
+		// Edge variables (long)
+
+		SWHelper::signed64	subPix = (y0<<16) - v0->y;
+		int		lx = v0->x + static_cast<int>((ldx * subPix)>>16);
+		SWTriAttribs	aLeft = {0, 0, 0, 0, 0, 0};
+
+		if (MOD_ARGB)
+		{
+			aLeft.a = v0->a + static_cast<int>((aLeftStep.a * subPix)>>16);
+			aLeft.r = v0->r + static_cast<int>((aLeftStep.r * subPix)>>16);
+			aLeft.g = v0->g + static_cast<int>((aLeftStep.g * subPix)>>16);
+			aLeft.b = v0->b + static_cast<int>((aLeftStep.b * subPix)>>16);
+		}
+
+		if (TEXTURED)
+		{
+			aLeft.u = v0->u + static_cast<int>((aLeftStep.u * subPix)>>16);
+			aLeft.v = v0->v + static_cast<int>((aLeftStep.v * subPix)>>16);
+		}
+
+		// Scanline deltas
+
+		SWTriAttribs	aStep = {0, 0, 0, 0, 0, 0};
+		if (TEXTURED || MOD_ARGB)
+		{
+			SWHelper::signed64	oneOverWidth = bigOne / (v1->x - mid);
+
+			if (MOD_ARGB)
+			{
+				aStep.a = static_cast<int>(((v1->a - (v0->a + ((topHeight * aLeftStep.a)>>16))) * oneOverWidth)>>32);
+				aStep.r = static_cast<int>(((v1->r - (v0->r + ((topHeight * aLeftStep.r)>>16))) * oneOverWidth)>>32);
+				aStep.g = static_cast<int>(((v1->g - (v0->g + ((topHeight * aLeftStep.g)>>16))) * oneOverWidth)>>32);
+				aStep.b = static_cast<int>(((v1->b - (v0->b + ((topHeight * aLeftStep.b)>>16))) * oneOverWidth)>>32);
+			}
+
+			if (TEXTURED)
+			{
+				aStep.u = static_cast<int>(((v1->u - (v0->u + ((topHeight * aLeftStep.u)>>16))) * oneOverWidth)>>32);
+				aStep.v = static_cast<int>(((v1->v - (v0->v + ((topHeight * aLeftStep.v)>>16))) * oneOverWidth)>>32);
+			}
+		}
+
+		// Screen info
 
-			int	x0 = (sx + 0xffff) & 0xffff0000;
-			int	x1 = (lx + 0xffff) & 0xffff0000;
-			#include "SWTri_Loop.cpp"
+		unsigned int	offset = y0 * pitch;
+		PType *		fb = reinterpret_cast<PType *>(pFrameBuffer) + offset;
+		int		iHeight = y1 - y0;
+
+		if (iHeight)
+		{
+			// Short edge along top half
+
+			oneOverHeight = bigOne / topHeight;
+			int	sdx = static_cast<int>(((v1->x - v0->x) * oneOverHeight) >> 32);
+			int	sx = v0->x + static_cast<int>((sdx * subPix)>>16);
+
+			DrawSpans(fb, pitch, iHeight, longEdgeIsLeft, lx, ldx, sx, sdx, aLeft, aLeftStep, aStep, aTex, globalDiffuse);
 		}
+
+		// Done?
+
+		iHeight = y2 - y1;
+		if (!iHeight) return;
+
+		// Short edge along bottom half
+
+		oneOverHeight = bigOne / (v2->y - v1->y);
+		int	sdx = static_cast<int>(((v2->x - v1->x) * oneOverHeight) >> 32);
+
+		subPix = (y1<<16) - v1->y;
+		int	sx = v1->x + static_cast<int>((sdx * subPix)>>16);
+
+		DrawSpans(fb, pitch, iHeight, longEdgeIsLeft, lx, ldx, sx, sdx, aLeft, aLeftStep, aStep, aTex, globalDiffuse);
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Flag combinations GetDrawTriType never produces (premultiplied 16/24 bit frame buffers,
+// premultiplied untextured triangles) share the plain kernel instead of instantiating
+template <int TYPE>
+struct SWTriCanonicalType
+{
+	enum
+	{
+		DEST_OK	= (TYPE & SWTRI_FORMAT_MASK) == SWTRI_FORMAT_8888,
+		TEX_OK	= (TYPE & SWTRI_TEXTURED) != 0,
+		VALUE	= TYPE & ~((DEST_OK ? 0 : SWTRI_PREMULTIPLIED_DEST) | (TEX_OK ? 0 : SWTRI_PREMULTIPLIED_TEX))
+	};
+};
+
+// Fills theTable[FIRST..FIRST+COUNT-1] with the matching kernels.  Splits the range in
+// halves so the instantiation depth stays at log2 of the kernel count.
+template <int FIRST, int COUNT>
+struct SWTriKernelList
+{
+	static void AddAll(DrawTriFunc * theTable)
+	{
+		SWTriKernelList<FIRST, COUNT/2>::AddAll(theTable);
+		SWTriKernelList<FIRST + COUNT/2, COUNT - COUNT/2>::AddAll(theTable);
+	}
+};
+
+template <int FIRST>
+struct SWTriKernelList<FIRST, 1>
+{
+	static void AddAll(DrawTriFunc * theTable)
+	{
+		theTable[FIRST] = &SWTriKernel<SWTriCanonicalType<FIRST>::VALUE>::DrawTriangle;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// The named kernels declared in SWTri.h, for applications that only register the ones they use
+#define SWTRI_NAMED_KERNEL(theFormatName, theFormat, tex, talpha, mod, glob, blend) \
+	void Sexy::DrawTriangle_##theFormatName##_TEX##tex##_TALPHA##talpha##_MOD##mod##_GLOB##glob##_BLEND##blend(SWHelper::SWVertex * pVerts, void * pFrameBuffer, const unsigned int bytepitch, const SWHelper::SWTextureInfo * textureInfo, SWHelper::SWDiffuse & globalDiffuse) \
+	{ \
+		SWTriKernel<theFormat | (tex*SWTRI_TEXTURED) | (talpha*SWTRI_TEX_ALPHA) | (mod*SWTRI_MOD_ARGB) | (glob*SWTRI_GLOBAL_ARGB) | (blend*SWTRI_LINEAR_BLEND)>::DrawTriangle(pVerts, pFrameBuffer, bytepitch, textureInfo, globalDiffuse); \
 	}
-}
-#undef funcname2
-#undef funcname1
-#undef funcname
-#undef PTYPE
-#undef PIXEL_INCLUDE
-#undef TEXTURED
-#undef TEX_ALPHA
-#undef MOD_ARGB
-#undef GLOBAL_ARGB
-#undef LINEAR_BLEND
-#undef NAME0
-#undef NAME1
-#undef NAME2
-#undef NAME3
-#undef NAME4
-#undef NAME5
 
+#define SWTRI_NAMED_KERNELS_GLOB(f, fmt, tex, talpha, mod, glob)	SWTRI_NAMED_KERNEL(f, fmt, tex, talpha, mod, glob, 0) SWTRI_NAMED_KERNEL(f, fmt, tex, talpha, mod, glob, 1)
+#define SWTRI_NAMED_KERNELS_MOD(f, fmt, tex, talpha, mod)			SWTRI_NAMED_KERNELS_GLOB(f, fmt, tex, talpha, mod, 0) SWTRI_NAMED_KERNELS_GLOB(f, fmt, tex, talpha, mod, 1)
+#define SWTRI_NAMED_KERNELS_TALPHA(f, fmt, tex, talpha)				SWTRI_NAMED_KERNELS_MOD(f, fmt, tex, talpha, 0) SWTRI_NAMED_KERNELS_MOD(f, fmt, tex, talpha, 1)
+#define SWTRI_NAMED_KERNELS_TEX(f, fmt, tex)						SWTRI_NAMED_KERNELS_TALPHA(f, fmt, tex, 0) SWTRI_NAMED_KERNELS_TALPHA(f, fmt, tex, 1)
+#define SWTRI_NAMED_KERNELS(f, fmt)									SWTRI_NAMED_KERNELS_TEX(f, fmt, 0) SWTRI_NAMED_KERNELS_TEX(f, fmt, 1)
+
+SWTRI_NAMED_KERNELS(8888, SWTRI_FORMAT_8888)
+SWTRI_NAMED_KERNELS(0888, SWTRI_FORMAT_888)
+SWTRI_NAMED_KERNELS(0565, SWTRI_FORMAT_565)
+SWTRI_NAMED_KERNELS(0555, SWTRI_FORMAT_555)
+
+#undef SWTRI_NAMED_KERNELS
+#undef SWTRI_NAMED_KERNELS_TEX
+#undef SWTRI_NAMED_KERNELS_TALPHA
+#undef SWTRI_NAMED_KERNELS_MOD
+#undef SWTRI_NAMED_KERNELS_GLOB
+#undef SWTRI_NAMED_KERNEL
@@ -0,0 +1,579 @@
+// This file is included by SWTri.cpp and should not be built directly by the project.
+
+// Half-space triangle rasterizer.  Coverage is decided per 8x8 tile from the three
+// edge functions (tiles completely inside or outside never test single pixels) and
+// pixels are shaded four at a time with SSE2.  Only the 8888 point-sampled kernels
+// are handled here; everything else still goes through gDrawTriFunc.
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define SWTRI_SSE2
+#include <emmintrin.h>
+#endif
+
+static bool gUseHalfSpace = false;
+
+void Sexy::SWTri_SetUseHalfSpace(bool useHalfSpace)
+{
+	gUseHalfSpace = useHalfSpace;
+}
+
+bool Sexy::SWTri_GetUseHalfSpace()
+{
+	return gUseHalfSpace;
+}
+
+#ifdef SWTRI_SSE2
+
+typedef SWHelper::signed64 HSInt64;
+
+enum
+{
+	HS_TILE_SHIFT = 3,
+	HS_TILE_SIZE = 1<<HS_TILE_SHIFT,
+	HS_SUBPIXEL_SHIFT = 8
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Edge function in 24.8 subpixels, divided down by one pixel so the per pixel steps are
+// just the edge deltas.  Inside means mC + x*mStepX + y*mStepY >= 0 (the fill rule bias
+// is already folded into mC).
+struct HSEdge
+{
+	HSInt64	mC;
+	int		mStepX;
+	int		mStepY;
+	__m128i	mLaneOffsets;	// 0, 1, 2, 3 times mStepX
+
+	void	Setup(int ax, int ay, int bx, int by)
+	{
+		int dx = bx - ax;
+		int dy = by - ay;
+
+		// Left and top edges own the pixels lying exactly on them, same as the scanline
+		// kernels' ceil() on the left/top and exclusive right/bottom.
+		bool topLeft = (dy < 0) || (dy == 0 && dx > 0);
+
+		HSInt64 aC = (HSInt64)ax*dy - (HSInt64)ay*dx;
+		if (!topLeft)
+			aC -= 1;
+
+		// floor division (the steps are multiples of a whole pixel so this is exact)
+		mC = aC >= 0 ? aC>>HS_SUBPIXEL_SHIFT : -((-aC + (1<<HS_SUBPIXEL_SHIFT) - 1)>>HS_SUBPIXEL_SHIFT);
+		mStepX = -dy;
+		mStepY = dx;
+		mLaneOffsets = _mm_set_epi32(mStepX*3, mStepX*2, mStepX, 0);
+	}
+
+	HSInt64	Eval(int x, int y) const
+	{
+		return mC + (HSInt64)x*mStepX + (HSInt64)y*mStepY;
+	}
+
+	// Smallest and largest value over a tile whose top left pixel has value theValue
+	HSInt64	TileMin(HSInt64 theValue) const
+	{
+		return theValue + (mStepX < 0 ? (HSInt64)mStepX*(HS_TILE_SIZE-1) : 0) + (mStepY < 0 ? (HSInt64)mStepY*(HS_TILE_SIZE-1) : 0);
+	}
+
+	HSInt64	TileMax(HSInt64 theValue) const
+	{
+		return theValue + (mStepX > 0 ? (HSInt64)mStepX*(HS_TILE_SIZE-1) : 0) + (mStepY > 0 ? (HSInt64)mStepY*(HS_TILE_SIZE-1) : 0);
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Vertex positions relative to the first vertex, shared by all the HSPlanes of a triangle
+struct HSTriangle
+{
+	double	mX0, mY0;
+	double	mX1, mY1, mX2, mY2;
+	double	mOneOverArea;
+
+	void	Setup(const SWHelper::SWVertex * v0, const SWHelper::SWVertex * v1, const SWHelper::SWVertex * v2)
+	{
+		mX0 = v0->x/65536.0;
+		mY0 = v0->y/65536.0;
+		mX1 = v1->x/65536.0 - mX0;
+		mY1 = v1->y/65536.0 - mY0;
+		mX2 = v2->x/65536.0 - mX0;
+		mY2 = v2->y/65536.0 - mY0;
+		mOneOverArea = 1.0 / (mX1*mY2 - mX2*mY1);
+	}
+};
+
+// An interpolated 16.16 vertex attribute, evaluated at whole pixel positions like the
+// scanline kernels do.  Values are stepped in integers from the first tile's top left.
+struct HSPlane
+{
+	int		mOrigin;
+	int		mStepX, mStepY;
+	__m128i	mLaneOffsets;	// 0, 1, 2, 3 times mStepX
+
+	void	Setup(const HSTriangle &theTriangle, int c0, int c1, int c2, int theOriginX, int theOriginY)
+	{
+		double d1 = (double) c1 - c0;
+		double d2 = (double) c2 - c0;
+		double aDx = (d1*theTriangle.mY2 - d2*theTriangle.mY1) * theTriangle.mOneOverArea;
+		double aDy = (d2*theTriangle.mX1 - d1*theTriangle.mX2) * theTriangle.mOneOverArea;
+
+		mOrigin = (int) floor(c0 + aDx*(theOriginX - theTriangle.mX0) + aDy*(theOriginY - theTriangle.mY0));
+		mStepX = (int) floor(aDx + 0.5);
+		mStepY = (int) floor(aDy + 0.5);
+		mLaneOffsets = _mm_set_epi32(mStepX*3, mStepX*2, mStepX, 0);
+	}
+
+	// Four pixels starting theX, theY pixels away from the origin
+	__m128i	Eval(int theX, int theY) const
+	{
+		return _mm_add_epi32(_mm_set1_epi32(mOrigin + theX*mStepX + theY*mStepY), mLaneOffsets);
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Low 32 bits of an unsigned 32x32 multiply (SSE2 only has the 16 bit one)
+static inline __m128i HSMulLo32(const __m128i &a, const __m128i &b)
+{
+	__m128i anEven = _mm_mul_epu32(a, b);
+	__m128i anOdd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(anEven, _MM_SHUFFLE(0,0,2,0)), _mm_shuffle_epi32(anOdd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+// a*b for values whose product fits in 16 bits
+static inline __m128i HSMulSmall(const __m128i &a, const __m128i &b)
+{
+	return _mm_mullo_epi16(a, b);
+}
+
+static inline __m128i HSSelect(const __m128i &theMask, const __m128i &a, const __m128i &b)
+{
+	return _mm_or_si128(_mm_and_si128(theMask, a), _mm_andnot_si128(theMask, b));
+}
+
+static inline __m128i HSClamp(const __m128i &theValue, const __m128i &theMax)
+{
+	__m128i aValue = _mm_andnot_si128(_mm_srai_epi32(theValue, 31), theValue);
+	return HSSelect(_mm_cmpgt_epi32(aValue, theMax), theMax, aValue);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Blends the 8 bit channels theR/G/B (already scaled by alpha the way the 8888 BlendTexel
+// does) with 4 destination pixels, including the destination alpha.  The divide is done in
+// float; numerators stay below 2^17 so the truncated quotient is exact.
+static inline __m128i HSBlend(const __m128i &theDest, const __m128i &theAlpha, const __m128i &theR, const __m128i &theG, const __m128i &theB)
+{
+	const __m128i aMask = _mm_set1_epi32(0xFF);
+	const __m128i a256 = _mm_set1_epi32(256);
+	const __m128i anOne = _mm_set1_epi32(1);
+
+	__m128i aDestA = _mm_srli_epi32(theDest, 24);
+	__m128i aDestR = _mm_srli_epi32(HSMulSmall(_mm_and_si128(_mm_srli_epi32(theDest, 16), aMask), aDestA), 8);
+	__m128i aDestG = _mm_srli_epi32(HSMulSmall(_mm_and_si128(_mm_srli_epi32(theDest, 8), aMask), aDestA), 8);
+	__m128i aDestB = _mm_srli_epi32(HSMulSmall(_mm_and_si128(theDest, aMask), aDestA), 8);
+
+	__m128i anInvAlpha = _mm_sub_epi32(a256, theAlpha);
+	__m128i aFinalAlpha = _mm_sub_epi32(a256, _mm_srli_epi32(HSMulSmall(anInvAlpha, _mm_sub_epi32(a256, aDestA)), 8));
+	aFinalAlpha = _mm_max_epi16(aFinalAlpha, anOne);
+	__m128 aDivisor = _mm_cvtepi32_ps(aFinalAlpha);
+
+	__m128i aR = _mm_add_epi32(_mm_slli_epi32(theR, 8), HSMulSmall(anInvAlpha, aDestR));
+	__m128i aG = _mm_add_epi32(_mm_slli_epi32(theG, 8), HSMulSmall(anInvAlpha, aDestG));
+	__m128i aB = _mm_add_epi32(_mm_slli_epi32(theB, 8), HSMulSmall(anInvAlpha, aDestB));
+	aR = _mm_and_si128(_mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(aR), aDivisor)), aMask);
+	aG = _mm_and_si128(_mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(aG), aDivisor)), aMask);
+	aB = _mm_and_si128(_mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(aB), aDivisor)), aMask);
+
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_sub_epi32(aFinalAlpha, anOne), 24), _mm_slli_epi32(aR, 16)),
+		_mm_or_si128(_mm_slli_epi32(aG, 8), aB));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct HSQuad
+{
+	__m128i	mU, mV;
+	__m128i	mA, mR, mG, mB;
+};
+
+struct HSState
+{
+	const unsigned int *	mTexture;
+	__m128i					mTexPosScale;	// (pitch<<16)|1 per lane, for _mm_madd_epi16
+	__m128i					mTexEndPos;
+	__m128i					mGlobalA, mGlobalR, mGlobalG, mGlobalB;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Per pixel work of SWTriKernel<SWTRI_FORMAT_8888 | ...>::DrawPixel, for
+// four pixels.  Returns the new pixels; lanes that shouldn't be touched keep theDest.
+template <bool TEXTURED, bool TALPHA, bool MOD_ARGB, bool GLOBAL_ARGB>
+struct HSShader
+{
+	enum { NEEDS_DEST = !TEXTURED || TALPHA || MOD_ARGB || GLOBAL_ARGB };
+
+	static inline __m128i Shade(const __m128i &theDest, const HSQuad &theQuad, const HSState &theState)
+	{
+		const __m128i aMask = _mm_set1_epi32(0xFF);
+		const __m128i anOpaque = _mm_set1_epi32(0xFF000000);
+
+		if (TEXTURED)
+		{
+			// t_pos = (v>>16)*pitch + (u>>16) on 16 bit pairs; negative coordinates wrap to
+			// huge unsigned positions in the scanline kernels so they fail the end check too.
+			__m128i aValid = _mm_cmpgt_epi32(_mm_or_si128(theQuad.mU, theQuad.mV), _mm_set1_epi32(-1));
+			__m128i aPos = _mm_or_si128(_mm_srli_epi32(theQuad.mU, 16), _mm_and_si128(theQuad.mV, _mm_set1_epi32(0xFFFF0000)));
+			aPos = _mm_madd_epi16(aPos, theState.mTexPosScale);
+			aValid = _mm_and_si128(aValid, _mm_cmpgt_epi32(theState.mTexEndPos, aPos));
+			aPos = _mm_and_si128(aPos, aValid);
+
+			const unsigned int * aTexture = theState.mTexture;
+			__m128i aTexel = _mm_set_epi32(
+				aTexture[_mm_cvtsi128_si32(_mm_shuffle_epi32(aPos, _MM_SHUFFLE(3,3,3,3)))],
+				aTexture[_mm_cvtsi128_si32(_mm_shuffle_epi32(aPos, _MM_SHUFFLE(2,2,2,2)))],
+				aTexture[_mm_cvtsi128_si32(_mm_shuffle_epi32(aPos, _MM_SHUFFLE(1,1,1,1)))],
+				aTexture[_mm_cvtsi128_si32(aPos)]);
+			aTexel = _mm_and_si128(aTexel, aValid);
+
+			if (!TALPHA && !MOD_ARGB && !GLOBAL_ARGB)
+				return _mm_or_si128(aTexel, anOpaque);
+
+			__m128i anAlpha = TALPHA ? _mm_srli_epi32(aTexel, 24) : aMask;
+			__m128i aWrite = _mm_cmpgt_epi32(anAlpha, _mm_set1_epi32(0x08));
+			__m128i aR = _mm_and_si128(_mm_srli_epi32(aTexel, 16), aMask);
+			__m128i aG = _mm_and_si128(_mm_srli_epi32(aTexel, 8), aMask);
+			__m128i aB = _mm_and_si128(aTexel, aMask);
+
+			if (MOD_ARGB && GLOBAL_ARGB)
+			{
+				anAlpha = _mm_srli_epi32(HSMulSmall(anAlpha, _mm_srli_epi32(HSMulLo32(theState.mGlobalA, theQuad.mA), 24)), 8);
+				aR = _mm_srli_epi32(HSMulSmall(aR, _mm_srli_epi32(HSMulLo32(theState.mGlobalR, theQuad.mR), 24)), 8);
+				aG = _mm_srli_epi32(HSMulSmall(aG, _mm_srli_epi32(HSMulLo32(theState.mGlobalG, theQuad.mG), 24)), 8);
+				aB = _mm_srli_epi32(HSMulSmall(aB, _mm_srli_epi32(HSMulLo32(theState.mGlobalB, theQuad.mB), 24)), 8);
+			}
+			else if (GLOBAL_ARGB)
+			{
+				anAlpha = _mm_srli_epi32(HSMulSmall(anAlpha, theState.mGlobalA), 8);
+				aR = _mm_srli_epi32(HSMulSmall(aR, theState.mGlobalR), 8);
+				aG = _mm_srli_epi32(HSMulSmall(aG, theState.mGlobalG), 8);
+				aB = _mm_srli_epi32(HSMulSmall(aB, theState.mGlobalB), 8);
+			}
+			else if (MOD_ARGB)
+			{
+				anAlpha = _mm_srli_epi32(HSMulSmall(anAlpha, _mm_srli_epi32(theQuad.mA, 16)), 8);
+				aR = _mm_srli_epi32(HSMulSmall(aR, _mm_srli_epi32(theQuad.mR, 16)), 8);
+				aG = _mm_srli_epi32(HSMulSmall(aG, _mm_srli_epi32(theQuad.mG, 16)), 8);
+				aB = _mm_srli_epi32(HSMulSmall(aB, _mm_srli_epi32(theQuad.mB, 16)), 8);
+			}
+
+			__m128i aPixel = _mm_or_si128(_mm_or_si128(anOpaque, _mm_slli_epi32(aR, 16)), _mm_or_si128(_mm_slli_epi32(aG, 8), aB));
+			if (TALPHA || MOD_ARGB || GLOBAL_ARGB)
+			{
+				__m128i aBlended = HSBlend(theDest, anAlpha,
+					_mm_srli_epi32(HSMulSmall(aR, anAlpha), 8),
+					_mm_srli_epi32(HSMulSmall(aG, anAlpha), 8),
+					_mm_srli_epi32(HSMulSmall(aB, anAlpha), 8));
+				aPixel = HSSelect(_mm_cmplt_epi32(anAlpha, _mm_set1_epi32(0xf0)), aBlended, aPixel);
+			}
+
+			return HSSelect(aWrite, aPixel, theDest);
+		}
+		else
+		{
+			// Untextured, only drawn with vertex colors (same as the scanline kernels)
+			__m128i aPixel = _mm_or_si128(_mm_or_si128(anOpaque, _mm_and_si128(theQuad.mR, _mm_set1_epi32(0xff0000))),
+				_mm_or_si128(_mm_and_si128(_mm_srli_epi32(theQuad.mG, 8), _mm_set1_epi32(0xff00)), _mm_srli_epi32(theQuad.mB, 16)));
+
+			__m128i anAlpha = _mm_srli_epi32(theQuad.mA, 16);
+			__m128i aBlended = HSBlend(theDest, anAlpha,
+				_mm_srli_epi32(HSMulLo32(theQuad.mR, anAlpha), 24),
+				_mm_srli_epi32(HSMulLo32(_mm_srli_epi32(theQuad.mG, 8), anAlpha), 16),
+				_mm_srli_epi32(HSMulSmall(_mm_srli_epi32(theQuad.mB, 16), anAlpha), 8));
+
+			aPixel = HSSelect(_mm_cmpgt_epi32(theQuad.mA, _mm_set1_epi32(0xf00000)), aPixel, aBlended);
+			return HSSelect(_mm_cmpgt_epi32(theQuad.mA, _mm_set1_epi32(0x080000)), aPixel, theDest);
+		}
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template <bool TEXTURED, bool TALPHA, bool MOD_ARGB, bool GLOBAL_ARGB>
+struct HSRasterizer
+{
+	typedef HSShader<TEXTURED, TALPHA, MOD_ARGB, GLOBAL_ARGB> Shader;
+
+	static void Draw(SWHelper::SWVertex * pVerts, void * pFrameBuffer, const unsigned int bytepitch, const SWHelper::SWTextureInfo * textureInfo, SWHelper::SWDiffuse & globalDiffuse)
+	{
+		SWHelper::SWVertex		aVerts[3] = { pVerts[0], pVerts[1], pVerts[2] };
+
+		// Same vertex color premultiply as SWTri_DrawTriangle.cpp (on a copy, though)
+		if (MOD_ARGB && GLOBAL_ARGB)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				aVerts[i].a = (aVerts[i].a * globalDiffuse.a) >> 8;
+				aVerts[i].r = (aVerts[i].r * globalDiffuse.r) >> 8;
+				aVerts[i].g = (aVerts[i].g * globalDiffuse.g) >> 8;
+				aVerts[i].b = (aVerts[i].b * globalDiffuse.b) >> 8;
+			}
+		}
+
+		// Snap to 24.8 and make the winding counter-clockwise
+		const SWHelper::SWVertex * v0 = aVerts+0;
+		const SWHelper::SWVertex * v1 = aVerts+1;
+		const SWHelper::SWVertex * v2 = aVerts+2;
+
+		int x0 = v0->x >> HS_SUBPIXEL_SHIFT, y0 = v0->y >> HS_SUBPIXEL_SHIFT;
+		int x1 = v1->x >> HS_SUBPIXEL_SHIFT, y1 = v1->y >> HS_SUBPIXEL_SHIFT;
+		int x2 = v2->x >> HS_SUBPIXEL_SHIFT, y2 = v2->y >> HS_SUBPIXEL_SHIFT;
+
+		HSInt64 anArea = (HSInt64)(x1-x0)*(y2-y0) - (HSInt64)(x2-x0)*(y1-y0);
+		if (anArea == 0)
+			return;
+		if (anArea < 0)
+		{
+			const SWHelper::SWVertex * aTemp = v1; v1 = v2; v2 = aTemp;
+			int aTempX = x1; x1 = x2; x2 = aTempX;
+			int aTempY = y1; y1 = y2; y2 = aTempY;
+		}
+
+		// Pixel bounds, [min, max)
+		const int aSubMask = (1<<HS_SUBPIXEL_SHIFT) - 1;
+		int aMinX = (min(x0, min(x1, x2)) + aSubMask) >> HS_SUBPIXEL_SHIFT;
+		int aMinY = (min(y0, min(y1, y2)) + aSubMask) >> HS_SUBPIXEL_SHIFT;
+		int aMaxX = (max(x0, max(x1, x2)) + aSubMask) >> HS_SUBPIXEL_SHIFT;
+		int aMaxY = (max(y0, max(y1, y2)) + aSubMask) >> HS_SUBPIXEL_SHIFT;
+		if (aMinX >= aMaxX || aMinY >= aMaxY)
+			return;
+
+		int aStartX = aMinX & ~(HS_TILE_SIZE-1);
+		int aStartY = aMinY & ~(HS_TILE_SIZE-1);
+
+		HSEdge anEdges[3];
+		anEdges[0].Setup(x1, y1, x2, y2);
+		anEdges[1].Setup(x2, y2, x0, y0);
+		anEdges[2].Setup(x0, y0, x1, y1);
+
+		HSTriangle aTriangle;
+		aTriangle.Setup(v0, v1, v2);
+
+		HSPlane aPlaneU, aPlaneV, aPlaneA, aPlaneR, aPlaneG, aPlaneB;
+		HSState aState;
+		if (TEXTURED)
+		{
+			aPlaneU.Setup(aTriangle, v0->u, v1->u, v2->u, aStartX, aStartY);
+			aPlaneV.Setup(aTriangle, v0->v, v1->v, v2->v, aStartX, aStartY);
+
+			aState.mTexture = textureInfo->pTexture;
+			aState.mTexPosScale = _mm_set1_epi32((textureInfo->pitch<<16) | 1);
+			aState.mTexEndPos = _mm_set1_epi32(textureInfo->endpos);
+		}
+		if (MOD_ARGB)
+		{
+			aPlaneA.Setup(aTriangle, v0->a, v1->a, v2->a, aStartX, aStartY);
+			aPlaneR.Setup(aTriangle, v0->r, v1->r, v2->r, aStartX, aStartY);
+			aPlaneG.Setup(aTriangle, v0->g, v1->g, v2->g, aStartX, aStartY);
+			aPlaneB.Setup(aTriangle, v0->b, v1->b, v2->b, aStartX, aStartY);
+		}
+		aState.mGlobalA = _mm_set1_epi32(globalDiffuse.a);
+		aState.mGlobalR = _mm_set1_epi32(globalDiffuse.r);
+		aState.mGlobalG = _mm_set1_epi32(globalDiffuse.g);
+		aState.mGlobalB = _mm_set1_epi32(globalDiffuse.b);
+
+		const __m128i aColorMax = _mm_set1_epi32(0xff0000);
+
+		for (int aTileY = aStartY; aTileY < aMaxY; aTileY += HS_TILE_SIZE)
+		{
+			for (int aTileX = aStartX; aTileX < aMaxX; aTileX += HS_TILE_SIZE)
+			{
+				// Classify the tile against each edge
+				HSInt64 anEdgeValue[3];
+				bool isPartial[3];
+				bool isOutside = false;
+				for (int e = 0; e < 3; e++)
+				{
+					anEdgeValue[e] = anEdges[e].Eval(aTileX, aTileY);
+					if (anEdges[e].TileMax(anEdgeValue[e]) < 0)
+					{
+						isOutside = true;
+						break;
+					}
+					isPartial[e] = anEdges[e].TileMin(anEdgeValue[e]) < 0;
+				}
+				if (isOutside)
+					continue;
+
+				bool isFull = !isPartial[0] && !isPartial[1] && !isPartial[2];
+
+				// Only edges crossing the tile need per pixel tests, and those stay small
+				// enough for 32 bits.  The others are replaced by an always-inside edge.
+				__m128i anEdgeRow[3], anEdgeStepX[3], anEdgeStepY[3];
+				for (int e = 0; e < 3; e++)
+				{
+					if (!isFull && isPartial[e])
+					{
+						anEdgeRow[e] = _mm_add_epi32(_mm_set1_epi32((int) anEdgeValue[e]), anEdges[e].mLaneOffsets);
+						anEdgeStepX[e] = _mm_set1_epi32(anEdges[e].mStepX*4);
+						anEdgeStepY[e] = _mm_set1_epi32(anEdges[e].mStepY);
+					}
+					else
+					{
+						anEdgeRow[e] = _mm_setzero_si128();
+						anEdgeStepX[e] = _mm_setzero_si128();
+						anEdgeStepY[e] = _mm_setzero_si128();
+					}
+				}
+
+				unsigned int * aLine = reinterpret_cast<unsigned int *>(reinterpret_cast<unsigned char *>(pFrameBuffer) + aTileY*bytepitch) + aTileX;
+				int aRowStart = max(aTileY, aMinY) - aTileY;
+				int aRowEnd = min(aTileY + HS_TILE_SIZE, aMaxY) - aTileY;
+				for (int aRow = 0; aRow < aRowEnd; aRow++)
+				{
+					if (aRow >= aRowStart)
+					{
+						int aPlaneX = aTileX - aStartX;
+						int aPlaneY = aTileY + aRow - aStartY;
+						__m128i anEdge0 = anEdgeRow[0];
+						__m128i anEdge1 = anEdgeRow[1];
+						__m128i anEdge2 = anEdgeRow[2];
+
+						for (int aGroup = 0; aGroup < HS_TILE_SIZE; aGroup += 4)
+						{
+							int aCoverage = 0xFFFF;
+							if (!isFull)
+							{
+								aCoverage = ~_mm_movemask_epi8(_mm_srai_epi32(_mm_or_si128(_mm_or_si128(anEdge0, anEdge1), anEdge2), 31)) & 0xFFFF;
+								anEdge0 = _mm_add_epi32(anEdge0, anEdgeStepX[0]);
+								anEdge1 = _mm_add_epi32(anEdge1, anEdgeStepX[1]);
+								anEdge2 = _mm_add_epi32(anEdge2, anEdgeStepX[2]);
+							}
+							if (aCoverage == 0)
+								continue;
+
+							HSQuad aQuad;
+							if (TEXTURED)
+							{
+								aQuad.mU = aPlaneU.Eval(aPlaneX + aGroup, aPlaneY);
+								aQuad.mV = aPlaneV.Eval(aPlaneX + aGroup, aPlaneY);
+							}
+							if (MOD_ARGB)
+							{
+								aQuad.mA = HSClamp(aPlaneA.Eval(aPlaneX + aGroup, aPlaneY), aColorMax);
+								aQuad.mR = HSClamp(aPlaneR.Eval(aPlaneX + aGroup, aPlaneY), aColorMax);
+								aQuad.mG = HSClamp(aPlaneG.Eval(aPlaneX + aGroup, aPlaneY), aColorMax);
+								aQuad.mB = HSClamp(aPlaneB.Eval(aPlaneX + aGroup, aPlaneY), aColorMax);
+							}
+
+							// Groups straddling the bounding box only read and write their
+							// covered lanes, since the rest may be outside the surface.
+							unsigned int * aPix = aLine + aGroup;
+							int x = aTileX + aGroup;
+							bool isSafe = isFull || (x >= aMinX && x+4 <= aMaxX);
+							unsigned int aTemp[4];
+
+							__m128i aDest;
+							if (isSafe)
+								aDest = (Shader::NEEDS_DEST || aCoverage != 0xFFFF) ? _mm_loadu_si128((const __m128i*) aPix) : _mm_setzero_si128();
+							else
+							{
+								for (int i = 0; i < 4; i++)
+									aTemp[i] = (aCoverage & (0xF << (i*4))) ? aPix[i] : 0;
+								aDest = _mm_loadu_si128((const __m128i*) aTemp);
+							}
+
+							__m128i aResult = Shader::Shade(aDest, aQuad, aState);
+
+							if (isSafe)
+							{
+								if (aCoverage != 0xFFFF)
+								{
+									__m128i aCoverMask = _mm_set_epi32(-((aCoverage>>12)&1), -((aCoverage>>8)&1), -((aCoverage>>4)&1), -(aCoverage&1));
+									aResult = HSSelect(aCoverMask, aResult, aDest);
+								}
+								_mm_storeu_si128((__m128i*) aPix, aResult);
+							}
+							else
+							{
+								_mm_storeu_si128((__m128i*) aTemp, aResult);
+								for (int i = 0; i < 4; i++)
+								{
+									if (aCoverage & (0xF << (i*4)))
+										aPix[i] = aTemp[i];
+								}
+							}
+						}
+					}
+
+					anEdgeRow[0] = _mm_add_epi32(anEdgeRow[0], anEdgeStepY[0]);
+					anEdgeRow[1] = _mm_add_epi32(anEdgeRow[1], anEdgeStepY[1]);
+					anEdgeRow[2] = _mm_add_epi32(anEdgeRow[2], anEdgeStepY[2]);
+					aLine = reinterpret_cast<unsigned int *>(reinterpret_cast<unsigned char *>(aLine) + bytepitch);
+				}
+			}
+		}
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Indexed by (global_argb?1:0) | (mod_argb?2:0) | (talpha?4:0) | (textured?8:0)
+static DrawTriFunc gHalfSpaceFunc[16] =
+{
+	NULL,
+	NULL,
+	&HSRasterizer<false, false, true, false>::Draw,
+	&HSRasterizer<false, false, true, true>::Draw,
+	NULL,
+	NULL,
+	&HSRasterizer<false, false, true, false>::Draw,
+	&HSRasterizer<false, false, true, true>::Draw,
+	&HSRasterizer<true, false, false, false>::Draw,
+	&HSRasterizer<true, false, false, true>::Draw,
+	&HSRasterizer<true, false, true, false>::Draw,
+	&HSRasterizer<true, false, true, true>::Draw,
+	&HSRasterizer<true, true, false, false>::Draw,
+	&HSRasterizer<true, true, false, true>::Draw,
+	&HSRasterizer<true, true, true, false>::Draw,
+	&HSRasterizer<true, true, true, true>::Draw
+};
+
+#endif // SWTRI_SSE2
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Returns false if the triangle should go through gDrawTriFunc instead.  When a scanline
+// kernel is available it is preferred for plain copies and triangles too small to fill a
+// few tiles, where it is faster.
+static bool HalfSpaceDrawTriangle(bool textured, bool talpha, bool mod_argb, bool global_argb, SWHelper::SWVertex * pVerts, unsigned int * pFrameBuffer, const unsigned int bytepitch, const SWHelper::SWTextureInfo * textureInfo, SWHelper::SWDiffuse & globalDiffuse, int thePixelFormat, bool blend, bool hasScanlineFunc)
+{
+#ifdef SWTRI_SSE2
+	if (thePixelFormat != 0x8888 || blend || !ImageLib::CPUHasSSE2())
+		return false;
+	if (textured && (textureInfo->pitch > 0x7FFF || textureInfo->endpos > 0x7FFFFFFF))
+		return false;
+
+	DrawTriFunc aFunc = gHalfSpaceFunc[(global_argb?1:0) | (mod_argb?2:0) | (talpha?4:0) | (textured?8:0)];
+	if (aFunc == NULL)
+		return false;
+
+	if (hasScanlineFunc)
+	{
+		if (textured && !talpha && !mod_argb && !global_argb)
+			return false;
+
+		int aWidth = max(pVerts[0].x, max(pVerts[1].x, pVerts[2].x)) - min(pVerts[0].x, min(pVerts[1].x, pVerts[2].x));
+		int aHeight = max(pVerts[0].y, max(pVerts[1].y, pVerts[2].y)) - min(pVerts[0].y, min(pVerts[1].y, pVerts[2].y));
+		if (aWidth < (HS_TILE_SIZE*2)<<16 || aHeight < (HS_TILE_SIZE*2)<<16)
+			return false;
+	}
+
+	aFunc(pVerts, pFrameBuffer, bytepitch, textureInfo, globalDiffuse);
+	return true;
+#else
+	return false;
+#endif
+}
@@ -14,10 +14,18 @@
 #include "DDImage.h"
 #include "MemoryImage.h"
 #include "HTTPTransfer.h"
+#include "HTTPClient.h"
 #include "Dialog.h"
 #include "..\ImageLib\ImageLib.h"
+#include "..\ImageLib\PixelConvert.h"
 #include "DSoundManager.h"
 #include "DSoundInstance.h"
+#include "MixerSoundManager.h"
+#include "MixerOutput.h"
+#include "DemoReplayer.h"
+#include "RenderPipeline.h"
+#include "DrawList.h"
+#include "..\ImageLib\zlib\zlib.h"
 #include "Rect.h"
 #include "FModMusicInterface.h"
 #include "PropertiesParser.h"
@@ -44,7 +52,7 @@
 using namespace Sexy;
 
 const int DEMO_FILE_ID = 0x42BEEF78;
-const int DEMO_VERSION = 2;
+const int DEMO_VERSION = 5;
 
 SexyAppBase* Sexy::gSexyAppBase = NULL;
 
@@ -196,6 +204,7 @@ SexyAppBase::SexyAppBase()
 	mIsDrawing = false;
 	mLastDrawWasEmpty = false;	
 	mLastTimeCheck = 0;
+	mPacingSpinTime = 1.5;
 	mUpdateMultiplier = 1;
 	mPaused = false;
 	mFastForwardToUpdateNum = 0;
@@ -273,6 +282,9 @@ SexyAppBase::SexyAppBase()
 	mVSyncBrokenTestUpdates = 0;
 	mWaitForVSync = false;
 	mSoftVSyncWait = true;
+	mPipelineDraw = false;
+	mRenderPipeline = NULL;
+	mPipelineUnpresented = false;
 	mUserChanged3DSetting = false;
 	mAutoEnable3D = false;
 	mTest3D = false;
@@ -319,6 +331,9 @@ SexyAppBase::SexyAppBase()
 	mDemoNeedsCommand = true;
 	mDemoLoadingComplete = false;
 	mDemoLength = 0;
+	mDemoReplayer = NULL;
+	mDemoSnapshotInterval = 6000;
+	mDemoChunkSize = 64*1024;
 	mDemoCmdNum = 0;
 	mDemoCmdOrder = -1; // Means we haven't processed any demo commands yet
 	mDemoCmdBitPos = 0;
@@ -429,6 +444,14 @@ SexyAppBase::~SexyAppBase()
 	}
 	mDialogMap.clear();
 	mDialogList.clear();
+
+	// Cleared first so images deleted along with it don't wait on it
+	RenderPipeline* aRenderPipeline = mRenderPipeline;
+	mRenderPipeline = NULL;
+	delete aRenderPipeline;
+
+	delete mDemoReplayer;
+	mDemoReplayer = NULL;
 	
 	if (mInvisHWnd != NULL)
 	{
@@ -440,6 +463,14 @@ SexyAppBase::~SexyAppBase()
 	
 	delete mWidgetManager;	
 	delete mResourceManager;
+
+	// Any transfers still in flight are aborted along with the I/O thread
+	HTTPClient::Shutdown();
+
+#ifndef RELEASEFINAL
+	StopModValWatcher();
+#endif
+
 	delete gFPSImage;
 	gFPSImage = NULL;
 	
@@ -522,7 +553,7 @@ static BOOL CALLBACK ChangeDisplayWindowEnumProc(HWND hwnd, LPARAM lParam)
 
 void SexyAppBase::ClearUpdateBacklog(bool relaxForASecond)
 {
-	mLastTimeCheck = timeGetTime();
+	mLastTimeCheck = PerfTimer::GetTimeNS();
 	mUpdateFTimeAcc = 0.0;
 
 	if (relaxForASecond)
@@ -631,6 +662,68 @@ bool SexyAppBase::ReadDemoBuffer(std::string &theError)
 		delete [] aBuffer;			
 	}
 
+	// read snapshots
+	if (aVersion >= 3)
+	{
+		int aSize;
+		fread(&aSize, 4, 1, aFP);
+		aBytesLeft -= 4;
+
+		if ((aSize < 0) || (aSize >= aBytesLeft))
+		{
+			theError = "Invalid demo file.";
+			return false;
+		}
+
+		Buffer aSnapshotBuffer;
+
+		aBuffer = new uchar[aSize];
+		fread(aBuffer, 1, aSize, aFP);
+		aSnapshotBuffer.WriteBytes(aBuffer, aSize);
+		aSnapshotBuffer.SeekFront();
+		delete [] aBuffer;
+
+		int aNumItems = aSnapshotBuffer.ReadLong();
+		int i;
+		for (i=0; i<aNumItems && !aSnapshotBuffer.AtEnd(); i++)
+		{
+			mDemoSnapshotList.push_back(DemoSnapshot());
+			DemoSnapshot &aSnapshot = mDemoSnapshotList.back();
+			aSnapshot.mUpdateCount = aSnapshotBuffer.ReadLong();
+			aSnapshot.mBitPos = aSnapshotBuffer.ReadLong();
+			aSnapshot.mLastDemoUpdateCnt = aSnapshotBuffer.ReadLong();
+			aSnapshot.mLastDemoMouseX = aSnapshotBuffer.ReadLong();
+			aSnapshot.mLastDemoMouseY = aSnapshotBuffer.ReadLong();
+			aSnapshot.mDemoCmdOrder = aSnapshotBuffer.ReadLong();
+			if (aVersion >= 5)
+			{
+				aSnapshotBuffer.ReadBytes((uchar*) &aSnapshot.mPendingUpdatesAcc, sizeof(double));
+				aSnapshotBuffer.ReadBytes((uchar*) &aSnapshot.mUpdateFTimeAcc, sizeof(double));
+			}
+
+			int aDataLen = aSnapshotBuffer.ReadLong();
+			if ((aDataLen < 0) || (aDataLen > aSize - aSnapshotBuffer.mReadBitPos/8))
+				break;
+
+			std::vector<uchar> aData(aDataLen + 1);
+			aSnapshotBuffer.ReadBytes(&aData[0], aDataLen);
+			aSnapshot.mData.WriteBytes(&aData[0], aDataLen);
+		}
+
+		if ((i!=aNumItems) || (aSnapshotBuffer.PastEnd()))
+		{
+			theError = "Invalid demo file.";
+			return false;
+		}
+
+		// Older snapshots were taken partway through an update step, seeking to them
+		//  would put playback out of step with the recording
+		if (aVersion < 5)
+			mDemoSnapshotList.clear();
+
+		aBytesLeft -= aSize;
+	}
+
 	// Read demo commands
 	fread(&mDemoLength, 4, 1, aFP);
 	aBytesLeft -= 4;
@@ -641,6 +734,62 @@ bool SexyAppBase::ReadDemoBuffer(std::string &theError)
 		return false;
 	}
 
+	if (aVersion >= 4)
+	{
+		// Only the chunk index and compressed data are read here, DemoLoadChunk
+		//  inflates each chunk into mDemoBuffer when playback reaches it
+		int aDataLen = 0;
+		int aNumChunks = 0;
+		fread(&aDataLen, 4, 1, aFP);
+		fread(&aNumChunks, 4, 1, aFP);
+		aBytesLeft -= 8;
+
+		if ((aDataLen < 0) || (aNumChunks < 0) || (aNumChunks*12 > aBytesLeft))
+		{
+			theError = "Invalid demo file.";
+			return false;
+		}
+
+		int aDataPos = 0;
+		mDemoChunks.resize(aNumChunks);
+		for (int i = 0; i < aNumChunks; i++)
+		{
+			DemoChunk& aChunk = mDemoChunks[i];
+			fread(&aChunk.mUpdateCount, 4, 1, aFP);
+			fread(&aChunk.mBitPos, 4, 1, aFP);
+			fread(&aChunk.mDataSize, 4, 1, aFP);
+			aChunk.mDataPos = aDataPos;
+			aChunk.mLoaded = false;
+
+			if ((aChunk.mDataSize < 0) || (aChunk.mBitPos < 0) || (aChunk.mBitPos >= aDataLen*8) ||
+				((i > 0) && (aChunk.mBitPos <= mDemoChunks[i-1].mBitPos)))
+			{
+				mDemoChunks.clear();
+				theError = "Invalid demo file.";
+				return false;
+			}
+
+			aDataPos += aChunk.mDataSize;
+		}
+		aBytesLeft -= aNumChunks*12;
+
+		if ((aDataPos != aBytesLeft) || ((aNumChunks > 0) && (mDemoChunks[0].mBitPos != 0)))
+		{
+			mDemoChunks.clear();
+			theError = "Invalid demo file.";
+			return false;
+		}
+
+		mDemoChunkData.resize(aDataPos + 1);
+		fread(&mDemoChunkData[0], 1, aDataPos, aFP);
+
+		mDemoBuffer.Clear();
+		mDemoBuffer.mData.resize(aDataLen);
+		mDemoBuffer.mDataBitSize = aDataLen*8;
+		mDemoBuffer.SeekFront();
+		return true;
+	}
+
 
 	aBuffer = new uchar[aBytesLeft];
 	fread(aBuffer, 1, aBytesLeft, aFP);		
@@ -683,10 +832,60 @@ void SexyAppBase::WriteDemoBuffer()
 			fwrite(&aMarkerBufferSize, 4, 1, aFP);
 			fwrite(aMarkerBuffer.GetDataPtr(), aMarkerBufferSize, 1, aFP);
 
+			Buffer aSnapshotBuffer;
+			aSnapshotBuffer.WriteLong(mDemoSnapshotList.size());
+			for (DemoSnapshotList::iterator aSnapshotItr = mDemoSnapshotList.begin(); aSnapshotItr != mDemoSnapshotList.end(); ++aSnapshotItr)
+			{
+				aSnapshotBuffer.WriteLong(aSnapshotItr->mUpdateCount);
+				aSnapshotBuffer.WriteLong(aSnapshotItr->mBitPos);
+				aSnapshotBuffer.WriteLong(aSnapshotItr->mLastDemoUpdateCnt);
+				aSnapshotBuffer.WriteLong(aSnapshotItr->mLastDemoMouseX);
+				aSnapshotBuffer.WriteLong(aSnapshotItr->mLastDemoMouseY);
+				aSnapshotBuffer.WriteLong(aSnapshotItr->mDemoCmdOrder);
+				aSnapshotBuffer.WriteBytes((uchar*) &aSnapshotItr->mPendingUpdatesAcc, sizeof(double));
+				aSnapshotBuffer.WriteBytes((uchar*) &aSnapshotItr->mUpdateFTimeAcc, sizeof(double));
+				aSnapshotBuffer.WriteLong(aSnapshotItr->mData.GetDataLen());
+				aSnapshotBuffer.WriteBytes(aSnapshotItr->mData.GetDataPtr(), aSnapshotItr->mData.GetDataLen());
+			}
+			int aSnapshotBufferSize = aSnapshotBuffer.GetDataLen();
+			fwrite(&aSnapshotBufferSize, 4, 1, aFP);
+			fwrite(aSnapshotBuffer.GetDataPtr(), aSnapshotBufferSize, 1, aFP);
+
 			ulong aDemoLength = mUpdateCount;
 			fwrite(&aDemoLength, 4, 1, aFP);
 
-			fwrite(mDemoBuffer.GetDataPtr(), 1, mDemoBuffer.GetDataLen(), aFP);
+			// Commands are compressed a chunk at a time, with the index up front
+			int aDataLen = mDemoBuffer.GetDataLen();
+			const uchar* aData = (const uchar*) mDemoBuffer.GetDataPtr();
+			int aNumChunks = mDemoChunks.size();
+			fwrite(&aDataLen, 4, 1, aFP);
+			fwrite(&aNumChunks, 4, 1, aFP);
+
+			ByteVector aCompressedData;
+			int i;
+			for (i = 0; i < aNumChunks; i++)
+			{
+				DemoChunk& aChunk = mDemoChunks[i];
+
+				// Chunks can share the byte where one ends and the next begins
+				int aStart = aChunk.mBitPos/8;
+				int anEnd = (i + 1 < aNumChunks) ? (mDemoChunks[i+1].mBitPos + 7)/8 : aDataLen;
+
+				uLongf aDestLen = (anEnd - aStart) + (anEnd - aStart)/1000 + 16;
+				aChunk.mDataPos = aCompressedData.size();
+				aCompressedData.resize(aChunk.mDataPos + aDestLen);
+				if (compress2(&aCompressedData[aChunk.mDataPos], &aDestLen, aData + aStart, anEnd - aStart, Z_BEST_COMPRESSION) != Z_OK)
+					aDestLen = 0;
+				aChunk.mDataSize = aDestLen;
+				aCompressedData.resize(aChunk.mDataPos + aDestLen);
+
+				fwrite(&aChunk.mUpdateCount, 4, 1, aFP);
+				fwrite(&aChunk.mBitPos, 4, 1, aFP);
+				fwrite(&aChunk.mDataSize, 4, 1, aFP);
+			}
+
+			if (!aCompressedData.empty())
+				fwrite(&aCompressedData[0], 1, aCompressedData.size(), aFP);
 			fclose(aFP);
 		}		
 	}
@@ -775,6 +974,8 @@ void SexyAppBase::DemoAddMarker(const std::string& theString)
 	if (mPlayingDemoBuffer)
 	{
 		mFastForwardToMarker = false;
+		if (mDemoReplayer != NULL)
+			mDemoReplayer->AddMarker(theString);
 	}
 	else if (mRecordingDemoBuffer)
 	{
@@ -898,6 +1099,76 @@ void SexyAppBase::DemoAssertIntEqual(int theInt)
 	}
 }
 
+bool SexyAppBase::DemoSaveSnapshot(Buffer* theBuffer)
+{
+	return false;
+}
+
+bool SexyAppBase::DemoLoadSnapshot(Buffer* theBuffer)
+{
+	return false;
+}
+
+void SexyAppBase::DemoTakeSnapshot()
+{
+	// Called once Process has finished a whole update step, UpdateF included, before
+	//  any commands for the next update are written, so playback can resume reading at mBitPos
+	mDemoSnapshotList.push_back(DemoSnapshot());
+	DemoSnapshot& aSnapshot = mDemoSnapshotList.back();
+	aSnapshot.mUpdateCount = mUpdateCount;
+	aSnapshot.mBitPos = mDemoBuffer.mWriteBitPos;
+	aSnapshot.mLastDemoUpdateCnt = mLastDemoUpdateCnt;
+	aSnapshot.mLastDemoMouseX = mLastDemoMouseX;
+	aSnapshot.mLastDemoMouseY = mLastDemoMouseY;
+	aSnapshot.mDemoCmdOrder = mDemoCmdOrder;
+	aSnapshot.mPendingUpdatesAcc = mPendingUpdatesAcc;
+	aSnapshot.mUpdateFTimeAcc = mUpdateFTimeAcc;
+	aSnapshot.mData.WriteString(SerializeRand());
+
+	MTAutoDisallowRand aDisallowRand;
+	if (!DemoSaveSnapshot(&aSnapshot.mData))
+	{
+		// App doesn't do snapshots, don't keep asking
+		mDemoSnapshotList.pop_back();
+		mDemoSnapshotInterval = 0;
+	}
+}
+
+bool SexyAppBase::DemoSeekSnapshot(int theUpdateNum)
+{
+	if ((!mPlayingDemoBuffer) || (!mLoaded))
+		return false;
+
+	// Latest snapshot that's still ahead of us
+	DemoSnapshot* aSnapshot = NULL;
+	for (DemoSnapshotList::iterator anItr = mDemoSnapshotList.begin(); anItr != mDemoSnapshotList.end(); ++anItr)
+	{
+		if ((anItr->mUpdateCount > mUpdateCount) && (anItr->mUpdateCount <= theUpdateNum))
+			aSnapshot = &*anItr;
+	}
+
+	if (aSnapshot == NULL)
+		return false;
+
+	aSnapshot->mData.SeekFront();
+	std::string aRandState = aSnapshot->mData.ReadString();
+	if (!DemoLoadSnapshot(&aSnapshot->mData))
+		return false;
+
+	SRand(aRandState);
+
+	mUpdateCount = aSnapshot->mUpdateCount;
+	mLastDemoUpdateCnt = aSnapshot->mLastDemoUpdateCnt;
+	mLastDemoMouseX = aSnapshot->mLastDemoMouseX;
+	mLastDemoMouseY = aSnapshot->mLastDemoMouseY;
+	mDemoCmdOrder = aSnapshot->mDemoCmdOrder;
+	mPendingUpdatesAcc = aSnapshot->mPendingUpdatesAcc;
+	mUpdateFTimeAcc = aSnapshot->mUpdateFTimeAcc;
+	mDemoBuffer.mReadBitPos = aSnapshot->mBitPos;
+	mDemoNeedsCommand = true;
+	return true;
+}
+
 Dialog* SexyAppBase::NewDialog(int theDialogId, bool isModal, const SexyString& theDialogHeader, const SexyString& theDialogLines, const SexyString& theDialogFooter, int theButtonMode)
 {	
 	Dialog* aDialog = new Dialog(NULL, NULL, theDialogId, isModal, theDialogHeader,	theDialogLines, theDialogFooter, theButtonMode);		
@@ -2200,6 +2471,7 @@ void SexyAppBase::DoExit(int theCode)
 
 void SexyAppBase::UpdateFrames()
 {
+	__int64 aStartTime = PerfTimer::GetTimeNS();
 	mUpdateCount++;	
 
 	if (!mMinimized)
@@ -2209,7 +2481,11 @@ void SexyAppBase::UpdateFrames()
 	}
 
 	mMusicInterface->Update();	
+	if (mSoundManager != NULL)
+		mSoundManager->Update();
 	CleanSharedImages();
+
+	mFrameStats.AddUpdate((PerfTimer::GetTimeNS() - aStartTime) / 1000000.0);
 }
 
 void SexyAppBase::DoUpdateFramesF(float theFrac)
@@ -2280,6 +2556,8 @@ void SexyAppBase::Redraw(Rect* theClipRect)
 	if (gScreenSaverActive)
 		return;
 
+	WaitForRenderThread();
+
 	static DWORD aRetryTick = 0;
 	if (!mDDInterface->Redraw(theClipRect))
 	{
@@ -2577,6 +2855,7 @@ bool SexyAppBase::DrawDirtyStuff()
 	}
 
 	DWORD aStartTime = timeGetTime();
+	__int64 aStartTimeNS = PerfTimer::GetTimeNS();
 
 	// Update user input and screen saver info
 	static DWORD aPeriodicTick = 0;
@@ -2593,9 +2872,42 @@ bool SexyAppBase::DrawDirtyStuff()
 		return false;
 	}
 
-	mIsDrawing = true;
-	bool drewScreen = mWidgetManager->DrawScreen();
-	mIsDrawing = false;
+	if ((mPipelineDraw) && (mRenderPipeline == NULL) && (!Is3DAccelerated()))
+	{
+		// Only worth it with a spare processor for the render thread
+		SYSTEM_INFO aSystemInfo;
+		GetSystemInfo(&aSystemInfo);
+		if (aSystemInfo.dwNumberOfProcessors > 1)
+			mRenderPipeline = new RenderPipeline();
+		else
+			mPipelineDraw = false;
+	}
+
+	MemoryImage* aScreenImage = mWidgetManager->mImage;
+	DrawList* aDrawList = NULL;
+	bool drewScreen;
+
+	if ((mRenderPipeline != NULL) && (mPipelineDraw) && (!Is3DAccelerated()) && (aScreenImage != NULL))
+	{
+		// Record this frame, then present the previous one which the render
+		//  thread has been executing while we were updating and recording
+		aDrawList = mRenderPipeline->BeginFrame(aScreenImage);
+
+		mIsDrawing = true;
+		mWidgetManager->mImage = aDrawList;
+		mWidgetManager->DrawScreen();
+		mWidgetManager->mImage = aScreenImage;
+		mIsDrawing = false;
+
+		mRenderPipeline->WaitForFence();
+		drewScreen = mPipelineUnpresented;
+	}
+	else
+	{
+		mIsDrawing = true;
+		drewScreen = mWidgetManager->DrawScreen();
+		mIsDrawing = false;
+	}
 
 	if ((drewScreen || (aStartTime - mLastDrawTick >= 1000) || (mCustomCursorDirty)) &&
 		((int) (aStartTime - mNextDrawTick) >= 0))
@@ -2605,6 +2917,7 @@ bool SexyAppBase::DrawDirtyStuff()
 		mDrawCount++;		
 
 		DWORD aMidTime = timeGetTime();
+		mFrameStats.AddDraw((PerfTimer::GetTimeNS() - aStartTimeNS) / 1000000.0);
 
 		mFPSCount++;
 		mFPSTime += aMidTime - aStartTime;
@@ -2631,6 +2944,8 @@ bool SexyAppBase::DrawDirtyStuff()
 		mLastDrawTick = aPreScreenBltTime;
 
 		Redraw(NULL);		
+		mPipelineUnpresented = false;
+		mFrameStats.EndFrame();
 
 		// This is our one UpdateFTimeAcc if we are vsynched
 		UpdateFTimeAcc(); 
@@ -2675,16 +2990,44 @@ bool SexyAppBase::DrawDirtyStuff()
 		mHasPendingDraw = false;		
 		mCustomCursorDirty = false;
 
+		if (aDrawList != NULL)
+			KickRenderPipeline(aScreenImage);
+
 		return true;
 	}
 	else
 	{		
 		mHasPendingDraw = false;
 		mLastDrawWasEmpty = true;		
+		mFrameStats.AddDraw((PerfTimer::GetTimeNS() - aStartTimeNS) / 1000000.0);
+
+		if (aDrawList != NULL)
+			KickRenderPipeline(aScreenImage);
+
 		return false;
 	}
 }
 
+void SexyAppBase::KickRenderPipeline(MemoryImage* theScreenImage)
+{
+	// DrawScreen can return false and still have drawn overlays, so anything
+	//  recorded gets executed rather than dropped by the next BeginFrame
+	if (mRenderPipeline->Kick(theScreenImage))
+		mPipelineUnpresented = true;
+}
+
+void SexyAppBase::WaitForRenderThread()
+{
+	if (mRenderPipeline != NULL)
+		mRenderPipeline->WaitForFence();
+}
+
+void SexyAppBase::WaitForRenderThread(Image* theImage)
+{
+	if (mRenderPipeline != NULL)
+		mRenderPipeline->WaitForImage(theImage);
+}
+
 void SexyAppBase::LogScreenSaverError(const std::string &theError)
 {
 	static bool firstTime = true;
@@ -3477,7 +3820,7 @@ LRESULT CALLBACK SexyAppBase::WindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LP
 						case 'p':
 						case 'P':
 							aSexyApp->mPaused = !aSexyApp->mPaused;
-							aSexyApp->mLastTimeCheck = timeGetTime();
+							aSexyApp->mLastTimeCheck = PerfTimer::GetTimeNS();
 							aSexyApp->mUpdateFTimeAcc = 0.0;
 							break;
 
@@ -3765,6 +4108,18 @@ void SexyAppBase::WriteDemoTimingBlock()
 	// Demo writing functions can only be called from the main thread and after SexyAppBase::Init
 	DBG_ASSERTE(GetCurrentThreadId() == mPrimaryThreadId);
 
+	// Every command starts here, so it's where a new chunk can begin
+	if ((mDemoChunks.empty()) || (mDemoBuffer.mWriteBitPos - mDemoChunks.back().mBitPos >= mDemoChunkSize*8))
+	{
+		DemoChunk aChunk;
+		aChunk.mUpdateCount = mUpdateCount;
+		aChunk.mBitPos = mDemoChunks.empty() ? 0 : mDemoBuffer.mWriteBitPos;
+		aChunk.mDataPos = 0;
+		aChunk.mDataSize = 0;
+		aChunk.mLoaded = true;
+		mDemoChunks.push_back(aChunk);
+	}
+
 	while (mUpdateCount - mLastDemoUpdateCnt > 15)
 	{
 		mDemoBuffer.WriteNumBits(15, 4);
@@ -3788,6 +4143,7 @@ bool SexyAppBase::PrepareDemoCommand(bool required)
 {
 	if (mDemoNeedsCommand)
 	{
+		DemoLoadChunk(mDemoBuffer.mReadBitPos);
 		mDemoCmdBitPos = mDemoBuffer.mReadBitPos;
 
 		mLastDemoUpdateCnt += mDemoBuffer.ReadNumBits(4, false);
@@ -3809,6 +4165,46 @@ bool SexyAppBase::PrepareDemoCommand(bool required)
 	return mUpdateCount == mLastDemoUpdateCnt;
 }
 
+void SexyAppBase::DemoLoadChunk(int theBitPos)
+{
+	if (mDemoChunks.empty())
+		return;
+
+	// Find the last chunk starting at or before theBitPos
+	int aLow = 0;
+	int aHigh = mDemoChunks.size() - 1;
+	while (aLow < aHigh)
+	{
+		int aMid = (aLow + aHigh + 1) / 2;
+		if (mDemoChunks[aMid].mBitPos <= theBitPos)
+			aLow = aMid;
+		else
+			aHigh = aMid - 1;
+	}
+
+	DemoChunk& aChunk = mDemoChunks[aLow];
+	if (aChunk.mLoaded)
+		return;
+	aChunk.mLoaded = true;
+
+	// A command never spans chunks, so inflating the one it starts in is enough
+	int aStart = aChunk.mBitPos/8;
+	int anEnd = (aLow + 1 < (int) mDemoChunks.size()) ? (mDemoChunks[aLow+1].mBitPos + 7)/8 : mDemoBuffer.mData.size();
+	if (anEnd <= aStart)
+		return;
+
+	uLongf aDestLen = anEnd - aStart;
+	int aResult = uncompress(&mDemoBuffer.mData[aStart], &aDestLen, &mDemoChunkData[aChunk.mDataPos], aChunk.mDataSize);
+	if ((aResult != Z_OK) || (aDestLen != (uLongf) (anEnd - aStart)))
+	{
+		// A corrupt or truncated chunk, handled like a demo file that fails to load
+		//  rather than playing back whatever ended up in the buffer
+		mPlayingDemoBuffer = false;
+		Popup("Invalid demo file.");
+		DoExit(0);
+	}
+}
+
 void SexyAppBase::ProcessDemo()
 {
 	if (mPlayingDemoBuffer)
@@ -4042,6 +4438,14 @@ bool SexyAppBase::DebugKeyDown(int theKey)
 		}
 #endif
 	}
+	else if ((theKey == VK_F3) && (mWidgetManager->mKeyDown[KEYCODE_CONTROL]))
+	{
+		std::string aReport = mFrameStats.GetReport();
+		OutputDebugStringA(aReport.c_str());
+		MsgBox(aReport, "Frame Timing", MB_OK);
+		mFrameStats.Clear();
+		ClearUpdateBacklog();
+	}
 	else if (theKey == VK_F3)
 	{
 		if(mWidgetManager->mKeyDown[KEYCODE_SHIFT])
@@ -4860,6 +5264,7 @@ void SexyAppBase::DeleteNativeImageData()
 
 void SexyAppBase::DeleteExtraImageData()
 {
+	WaitForRenderThread(); // before the lock, the render thread may need it to finish
 	AutoCrit anAutoCrit(mDDInterface->mCritSect);
 	MemoryImageSet::iterator anItr = mMemoryImageSet.begin();
 	while (anItr != mMemoryImageSet.end())
@@ -5046,6 +5451,7 @@ void SexyAppBase::SetAlphaDisabled(bool isDisabled)
 	if (mAlphaDisabled != isDisabled)
 	{
 		mAlphaDisabled = isDisabled;
+		WaitForRenderThread();
 		mDDInterface->SetVideoOnlyDraw(mAlphaDisabled);		
 		mWidgetManager->mImage = mDDInterface->GetScreenImage();
 		mWidgetManager->MarkAllDirty();
@@ -5171,16 +5577,17 @@ void SexyAppBase::ProcessSafeDeleteList()
 
 void SexyAppBase::UpdateFTimeAcc()
 {
-	DWORD aCurTime = timeGetTime();
+	__int64 aCurTime = PerfTimer::GetTimeNS();
 
 	if (mLastTimeCheck != 0)
 	{				
-		int aDeltaTime = aCurTime - mLastTimeCheck;		
+		// Keep the fraction, whole milliseconds make 60Hz alternate 16 and 17ms updates
+		double aDeltaTime = (aCurTime - mLastTimeCheck) / 1000000.0;
 
 		mUpdateFTimeAcc = min(mUpdateFTimeAcc + aDeltaTime, 200.0);
 
 		if (mRelaxUpdateBacklogCount > 0)				
-			mRelaxUpdateBacklogCount = max(mRelaxUpdateBacklogCount - aDeltaTime, 0);				
+			mRelaxUpdateBacklogCount = max(mRelaxUpdateBacklogCount - aDeltaTime, 0.0);				
 	}
 
 	mLastTimeCheck = aCurTime;
@@ -5229,6 +5636,23 @@ bool SexyAppBase::Process(bool allowSleep)
 				Mute(true);
 			}
 
+			// Jump to the last snapshot before where we're going rather than replaying up to it
+			int aSeekUpdateNum = mFastForwardToUpdateNum;
+			if (mFastForwardToMarker)
+			{
+				aSeekUpdateNum = mUpdateCount;
+				for (DemoMarkerList::iterator anItr = mDemoMarkerList.begin(); anItr != mDemoMarkerList.end(); ++anItr)
+				{
+					// The marker is added during update anItr->second, so stop just before it
+					if (anItr->second > mUpdateCount + 1)
+					{
+						aSeekUpdateNum = anItr->second - 1;
+						break;
+					}
+				}
+			}
+			DemoSeekSnapshot(aSeekUpdateNum);
+
 			static DWORD aTick = GetTickCount();
 			while (mUpdateCount < mFastForwardToUpdateNum || mFastForwardToMarker)
 			{
@@ -5404,6 +5828,11 @@ bool SexyAppBase::Process(bool allowSleep)
 			if (mRelaxUpdateBacklogCount > 0)
 				mUpdateFTimeAcc = 0;
 
+			// The step is complete now, so a seek to here picks up with the next one
+			if ((mRecordingDemoBuffer) && (mLoaded) && (mDemoSnapshotInterval > 0) &&
+				(mUpdateCount - (mDemoSnapshotList.empty() ? 0 : mDemoSnapshotList.back().mUpdateCount) >= mDemoSnapshotInterval))
+				DemoTakeSnapshot();
+
 			didUpdate = true;
 		}
 		
@@ -5420,17 +5849,21 @@ bool SexyAppBase::Process(bool allowSleep)
 			else
 			{
 				// Let us take into account the time it took to draw dirty stuff			
-				int aTimeToNextFrame = (int) (aFrameFTime - mUpdateFTimeAcc);
+				double aTimeToNextFrame = aFrameFTime - mUpdateFTimeAcc;
 				if (aTimeToNextFrame > 0)
 				{
 					if (!allowSleep)
 						return false;
 
-					// Wait till next processing cycle
+					// Wait till next processing cycle.  mUpdateFTimeAcc was measured at
+					//  mLastTimeCheck, so wait relative to that rather than to now
 					++mSleepCount;
-					Sleep(aTimeToNextFrame);
+					__int64 aSleepStart = PerfTimer::GetTimeNS();
+					PerfTimer::WaitUntilNS(mLastTimeCheck + (__int64) (aTimeToNextFrame * 1000000), mPacingSpinTime);
+					double aSleepTime = (PerfTimer::GetTimeNS() - aSleepStart) / 1000000.0;
 
-					aCumSleepTime += aTimeToNextFrame;					
+					mFrameStats.AddSleep(aSleepTime);
+					aCumSleepTime += (int) aSleepTime;
 				}
 			}
 		}
@@ -5502,6 +5935,50 @@ void SexyAppBase::DoMainLoop()
 	}
 }
 
+void SexyAppBase::DoReplayLoop()
+{
+	if (mDemoReplayer->mReportFileName.empty())
+		mDemoReplayer->mReportFileName = mDemoFileName + ".txt";
+
+	mUpdateAppDepth++;
+	mDemoReplayer->Start();
+
+	while (!mShutdown)
+	{
+		if ((mDemoLoadingComplete) && (!mLoaded) && (!mLoadingThreadCompleted))
+		{
+			// The recording had finished loading by now, wait for our loading thread to catch up
+			PerfTimer aTimer;
+			aTimer.Start();
+			Sleep(1);
+			mDemoReplayer->AddLoadWait(aTimer.GetDuration());
+			continue;
+		}
+
+		if ((mDemoBuffer.AtEnd()) && (mUpdateCount == mLastDemoUpdateCnt))
+			break;
+
+		// Same as a fast forward step in Process, one update per pass
+		mDemoReplayer->BeginUpdate();
+
+		if (!mDemoBuffer.AtEnd())
+			ProcessDemo();
+
+		if (DoUpdateFrames())
+		{
+			ProcessSafeDeleteList();
+			DoUpdateFramesF(1.0f);
+			ProcessSafeDeleteList();
+			mDemoReplayer->EndUpdate();
+		}
+	}
+
+	mUpdateAppDepth--;
+
+	mDemoReplayer->WriteReport();
+	Shutdown();
+}
+
 bool SexyAppBase::UpdateAppStep(bool* updated)
 {
 	if (updated != NULL)
@@ -5578,6 +6055,7 @@ bool SexyAppBase::UpdateApp()
 
 int SexyAppBase::InitDDInterface()
 {
+	WaitForRenderThread();
 	PreDDInterfaceInitHook();
 	DeleteNativeImageData();
 	int aResult = mDDInterface->Init(mHWnd, mIsPhysWindowed);
@@ -5603,13 +6081,17 @@ void SexyAppBase::Start()
 	if (mShutdown)
 		return;
 
-	StartCursorThread();
+	if (mDemoReplayer == NULL)
+		StartCursorThread();
 
 	if (mAutoStartLoadingThread)
 		StartLoadingThread();
 
-	::ShowWindow(mHWnd, SW_SHOW);	
-	::SetFocus(mHWnd);
+	if (mDemoReplayer == NULL)
+	{
+		::ShowWindow(mHWnd, SW_SHOW);	
+		::SetFocus(mHWnd);
+	}
 
 	timeBeginPeriod(1);
 
@@ -5623,7 +6105,10 @@ void SexyAppBase::Start()
 	mLastUserInputTick = aStartTime;
 	mLastTimerTime = aStartTime;
 
-	DoMainLoop();
+	if (mDemoReplayer != NULL)
+		DoReplayLoop();
+	else
+		DoMainLoop();
 	ProcessSafeDeleteList();
 
 	mRunning = false;
@@ -5983,6 +6468,23 @@ void SexyAppBase::HandleCmdLineParam(const std::string& theParamName, const std:
 			mDemoFileName = GetAppDataFolder() + mDemoFileName;
 		}
 	}	
+	else if ((theParamName == "-replay") || (theParamName == "-replaydraw") || 
+		(theParamName == "-replaychecksum") || (theParamName == "-replayreport"))
+	{
+		// Play the demo with no window as fast as possible, for example:
+		//  -replay -demofile=bug.dmo -replaychecksum -replayreport=bug.txt
+		mRecordingDemoBuffer = false;
+		mPlayingDemoBuffer = true;
+		if (mDemoReplayer == NULL)
+			mDemoReplayer = new DemoReplayer(this);
+
+		if (theParamName == "-replaydraw")
+			mDemoReplayer->mDrawInterval = max(atoi(theParamValue.c_str()), 1);
+		else if (theParamName == "-replaychecksum")
+			mDemoReplayer->mChecksumMarkers = true;
+		else if (theParamName == "-replayreport")
+			mDemoReplayer->mReportFileName = theParamValue;
+	}
 	else if (theParamName == "-crash")
 	{
 		// Try to access NULL
@@ -6086,7 +6588,7 @@ void SexyAppBase::Init()
 	if (!mCmdLineParsed)
 		DoParseCmdLine();
 
-	if (IsScreenSaver())	
+	if ((IsScreenSaver()) || (mDemoReplayer != NULL))
 		mOnlyAllowOneCopyToRun = false;	
 
 
@@ -6229,8 +6731,16 @@ void SexyAppBase::Init()
 
 	mWidgetManager->Resize(Rect(0, 0, mWidth, mHeight), Rect(0, 0, mWidth, mHeight));
 
+	if (mDemoReplayer != NULL)
+	{
+		// No window or DirectDraw, images just keep their bits
+		mIsWindowed = true;
+		mFullScreenWindow = false;
+		mIsPhysWindowed = true;
+		mDDInterface = new DDInterface(this);
+	}
 	// Check to see if we CAN run windowed or not...
-	if (mIsWindowed && !mFullScreenWindow)
+	else if (mIsWindowed && !mFullScreenWindow)
 	{
 		// How can we be windowed if our screen isn't even big enough?
 		if ((mWidth >= GetSystemMetrics(SM_CXFULLSCREEN)) ||
@@ -6241,7 +6751,7 @@ void SexyAppBase::Init()
 		}
 	}
 
-	if (mFullScreenWindow) // change resoultion using ChangeDisplaySettings
+	if ((mFullScreenWindow) && (mDemoReplayer == NULL)) // change resoultion using ChangeDisplaySettings
 	{
 		EnumWindows(ChangeDisplayWindowEnumProc,0); // record window pos
 		DEVMODE dm;
@@ -6268,7 +6778,8 @@ void SexyAppBase::Init()
 		}
 	}
 
-	MakeWindow();
+	if (mDemoReplayer == NULL)
+		MakeWindow();
 		
 	if (mPlayingDemoBuffer)
 	{
@@ -6284,12 +6795,17 @@ void SexyAppBase::Init()
 		mSyncRefreshRate = mDemoBuffer.ReadByte();
 	}
 
-	if (mSoundManager == NULL)		
+	if ((mSoundManager == NULL) && (mDemoReplayer != NULL))
+		mSoundManager = new MixerSoundManager(new NullMixerOutput());
+	else if (mSoundManager == NULL)		
 		mSoundManager = new DSoundManager(mNoSoundNeeded?NULL:mHWnd, mWantFMod);
 
 	SetSfxVolume(mSfxVolume);
 	
-	mMusicInterface = CreateMusicInterface(mInvisHWnd);	
+	if (mDemoReplayer != NULL)
+		mMusicInterface = new MusicInterface;
+	else
+		mMusicInterface = CreateMusicInterface(mInvisHWnd);	
 
 	SetMusicVolume(mMusicVolume);	
 
@@ -6441,14 +6957,18 @@ Sexy::DDImage* SexyAppBase::CreateCrossfadeImage(Sexy::Image* theImage1, const R
 	anImage->Create(aWidth, aHeight);
 
 	ulong* aDestBits = anImage->GetBits();
-	ulong* aSrcBits1 = aMemoryImage1->GetBits();
-	ulong* aSrcBits2 = aMemoryImage2->GetBits();
+	ulong* aSrcBits1 = aMemoryImage1->GetRawBits();
+	ulong* aSrcBits2 = aMemoryImage2->GetRawBits();
 
 	int aSrc1Width = aMemoryImage1->GetWidth();
 	int aSrc2Width = aMemoryImage2->GetWidth();
 	ulong aMult = (int) (theFadeFactor*256);
 	ulong aOMM = (256 - aMult);
 
+	// The sources are read as stored, the result is straight alpha
+	bool aPremultiplied1 = aMemoryImage1->mPremultipliedAlpha;
+	bool aPremultiplied2 = aMemoryImage2->mPremultipliedAlpha;
+
 	for (int y = 0; y < aHeight; y++)
 	{
 		ulong* s1 = &aSrcBits1[(y+theRect1.mY)*aSrc1Width+theRect1.mX];
@@ -6460,6 +6980,11 @@ Sexy::DDImage* SexyAppBase::CreateCrossfadeImage(Sexy::Image* theImage1, const R
 			ulong p1 = *s1++;
 			ulong p2 = *s2++;
 
+			if (aPremultiplied1)
+				p1 = ImageLib::UnpremultiplyPixel(p1);
+			if (aPremultiplied2)
+				p2 = ImageLib::UnpremultiplyPixel(p2);
+
 			//p1 = 0;
 			//p2 = 0xFFFFFFFF;
 
@@ -6483,6 +7008,11 @@ void SexyAppBase::ColorizeImage(Image* theImage, const Color& theColor)
 	if (aSrcMemoryImage == NULL)
 		return;
 
+	// The color math below is for straight alpha
+	bool aPremultiplied = aSrcMemoryImage->mPremultipliedAlpha;
+	if (aPremultiplied)
+		aSrcMemoryImage->SetPremultipliedAlpha(false);
+
 	ulong* aBits;	
 	int aNumColors;
 
@@ -6536,6 +7066,9 @@ void SexyAppBase::ColorizeImage(Image* theImage, const Color& theColor)
 	}	
 
 	aSrcMemoryImage->BitsChanged();
+
+	if (aPremultiplied)
+		aSrcMemoryImage->SetPremultipliedAlpha(true);
 }
 
 DDImage* SexyAppBase::CreateColorizedImage(Image* theImage, const Color& theColor)
@@ -6549,13 +7082,16 @@ DDImage* SexyAppBase::CreateColorizedImage(Image* theImage, const Color& theColo
 	
 	anImage->Create(theImage->GetWidth(), theImage->GetHeight());
 	
+	// Colorized as straight alpha, the copy gets the source's mode back at the end
+	bool aPremultiplied = aSrcMemoryImage->mPremultipliedAlpha;
+
 	ulong* aSrcBits;
 	ulong* aDestBits;
 	int aNumColors;
 
 	if (aSrcMemoryImage->mColorTable == NULL)
 	{
-		aSrcBits = aSrcMemoryImage->GetBits();
+		aSrcBits = aSrcMemoryImage->GetRawBits();
 		aDestBits = anImage->GetBits();
 		aNumColors = theImage->GetWidth()*theImage->GetHeight();				
 	}
@@ -6568,6 +7104,7 @@ DDImage* SexyAppBase::CreateColorizedImage(Image* theImage, const Color& theColo
 		anImage->mColorIndices = new uchar[anImage->mWidth*theImage->mHeight];
 		memcpy(anImage->mColorIndices, aSrcMemoryImage->mColorIndices, anImage->mWidth*theImage->mHeight);
 	}
+
 						
 	if ((theColor.mAlpha <= 255) && (theColor.mRed <= 255) && 
 		(theColor.mGreen <= 255) && (theColor.mBlue <= 255))
@@ -6575,6 +7112,8 @@ DDImage* SexyAppBase::CreateColorizedImage(Image* theImage, const Color& theColo
 		for (int i = 0; i < aNumColors; i++)
 		{
 			ulong aColor = aSrcBits[i];
+			if (aPremultiplied)
+				aColor = ImageLib::UnpremultiplyPixel(aColor);
 
 			aDestBits[i] = 
 				((((aColor & 0xFF000000) >> 8) * theColor.mAlpha) & 0xFF000000) |
@@ -6588,6 +7127,8 @@ DDImage* SexyAppBase::CreateColorizedImage(Image* theImage, const Color& theColo
 		for (int i = 0; i < aNumColors; i++)
 		{
 			ulong aColor = aSrcBits[i];
+			if (aPremultiplied)
+				aColor = ImageLib::UnpremultiplyPixel(aColor);
 
 			int aAlpha = ((aColor >> 24) * theColor.mAlpha) / 255;
 			int aRed = (((aColor >> 16) & 0xFF) * theColor.mRed) / 255;
@@ -6609,6 +7150,9 @@ DDImage* SexyAppBase::CreateColorizedImage(Image* theImage, const Color& theColo
 
 	anImage->BitsChanged();
 
+	if (aPremultiplied)
+		anImage->SetPremultipliedAlpha(true);
+
 	return anImage;
 }
 
@@ -6635,7 +7179,8 @@ void SexyAppBase::MirrorImage(Image* theImage)
 {
 	MemoryImage* aSrcMemoryImage = dynamic_cast<MemoryImage*>(theImage);	
 
-	ulong* aSrcBits = aSrcMemoryImage->GetBits();
+	// Only moves pixels around, so either alpha mode will do
+	ulong* aSrcBits = aSrcMemoryImage->GetRawBits();
 
 	int aPhysSrcWidth = aSrcMemoryImage->mWidth;
 	for (int y = 0; y < aSrcMemoryImage->mHeight; y++)
@@ -6659,7 +7204,8 @@ void SexyAppBase::FlipImage(Image* theImage)
 {
 	MemoryImage* aSrcMemoryImage = dynamic_cast<MemoryImage*>(theImage);
 
-	ulong* aSrcBits = aSrcMemoryImage->GetBits();
+	// Only moves pixels around, so either alpha mode will do
+	ulong* aSrcBits = aSrcMemoryImage->GetRawBits();
 
 	int aPhysSrcHeight = aSrcMemoryImage->mHeight;
 	int aPhysSrcWidth = aSrcMemoryImage->mWidth;
@@ -6687,6 +7233,11 @@ void SexyAppBase::RotateImageHue(Sexy::MemoryImage *theImage, int theDelta)
 	while (theDelta < 0)
 		theDelta += 256;
 
+	// The hue is worked out from straight colors
+	bool aPremultiplied = theImage->mPremultipliedAlpha;
+	if (aPremultiplied)
+		theImage->SetPremultipliedAlpha(false);
+
 	int aSize = theImage->mWidth * theImage->mHeight;
 	DWORD *aPtr = theImage->GetBits();
 	for (int i=0; i<aSize; i++)
@@ -6752,6 +7303,9 @@ void SexyAppBase::RotateImageHue(Sexy::MemoryImage *theImage, int theDelta)
 	}
 
 	theImage->BitsChanged();
+
+	if (aPremultiplied)
+		theImage->SetPremultipliedAlpha(true);
 }
 
 ulong SexyAppBase::HSLToRGB(int h, int s, int l)
@@ -7060,6 +7614,7 @@ SharedImageRef SexyAppBase::GetSharedImage(const std::string& theFileName, const
 
 void SexyAppBase::CleanSharedImages()
 {
+	WaitForRenderThread(); // before the lock, the render thread may need it to finish
 	AutoCrit anAutoCrit(mDDInterface->mCritSect);	
 
 	if (mCleanupSharedImages)
@@ -143,11 +143,31 @@ SOURCE=.\MemoryImage.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\DrawList.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
+SOURCE=.\ParticleSystem.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
+SOURCE=.\RenderPipeline.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
 SOURCE=.\Quantize.cpp
 # PROP Exclude_From_Build 1
 # End Source File
 # Begin Source File
 
+SOURCE=.\TextureAtlas.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
 SOURCE=.\SWTri.cpp
 # End Source File
 # Begin Source File
@@ -201,10 +221,26 @@ SOURCE=.\MemoryImage.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\DrawList.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\ParticleSystem.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\RenderPipeline.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\Quantize.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\TextureAtlas.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\SWTri.h
 # End Source File
 # Begin Source File
@@ -708,6 +744,14 @@ SOURCE=..\ImageLib\ImageLib.cpp
 
 SOURCE=..\ImageLib\ImageLib.h
 # End Source File
+# Begin Source File
+
+SOURCE=..\ImageLib\PixelConvert.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\ImageLib\PixelConvert.h
+# End Source File
 # End Group
 # Begin Group "Misc"
 
@@ -757,6 +801,11 @@ SOURCE=.\HTTPTransfer.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\HTTPClient.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
 SOURCE=.\KeyCodes.cpp
 # PROP Exclude_From_Build 1
 # End Source File
@@ -776,6 +825,16 @@ SOURCE=.\PerfTimer.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\FrameStats.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
+SOURCE=.\DemoReplayer.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
 SOURCE=.\PropertiesParser.cpp
 # PROP Exclude_From_Build 1
 # End Source File
@@ -832,6 +891,10 @@ SOURCE=.\HTTPTransfer.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\HTTPClient.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\KeyCodes.h
 # End Source File
 # Begin Source File
@@ -844,6 +907,14 @@ SOURCE=.\PerfTimer.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\FrameStats.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\DemoReplayer.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\Point.h
 # End Source File
 # Begin Source File
@@ -895,6 +966,31 @@ SOURCE=.\DSoundInstance.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\MixerSoundManager.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
+SOURCE=.\MixerSoundInstance.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
+SOURCE=.\MixerOutput.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
+SOURCE=.\OggStream.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
+SOURCE=.\DSoundStreamInstance.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
 SOURCE=.\DSoundManager.cpp
 # PROP Exclude_From_Build 1
 # End Source File
@@ -945,6 +1041,26 @@ SOURCE=.\DSoundInstance.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\MixerSoundManager.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\MixerSoundInstance.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\MixerOutput.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\OggStream.h
+# End Source File
+# Begin Source File
+
+SOURCE=.\DSoundStreamInstance.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\DSoundManager.h
 # End Source File
 # Begin Source File
@@ -1195,6 +1311,11 @@ SOURCE=.\WidgetContainer.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\WidgetSpatialIndex.cpp
+# PROP Exclude_From_Build 1
+# End Source File
+# Begin Source File
+
 SOURCE=.\WidgetManager.cpp
 # PROP Exclude_From_Build 1
 # End Source File
@@ -1288,6 +1409,10 @@ SOURCE=.\WidgetContainer.h
 # End Source File
 # Begin Source File
 
+SOURCE=.\WidgetSpatialIndex.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\WidgetManager.h
 # End Source File
 # End Group
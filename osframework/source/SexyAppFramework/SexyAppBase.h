@@ -10,6 +10,7 @@
 #include "CritSect.h"
 #include "SharedImage.h"
 #include "Ratio.h"
+#include "FrameStats.h"
 
 namespace ImageLib
 {
@@ -29,6 +30,8 @@ class MusicInterface;
 class MemoryImage;
 class HTTPTransfer;
 class Dialog;
+class DemoReplayer;
+class RenderPipeline;
 
 class ResourceManager;
 
@@ -40,7 +43,38 @@ public:
 };
 
 
+// Game state saved while recording a demo, so playback can jump straight to it
+class DemoSnapshot
+{
+public:
+	int						mUpdateCount;
+	int						mBitPos;			// where the next command starts in mDemoBuffer
+	int						mLastDemoUpdateCnt;
+	int						mLastDemoMouseX;
+	int						mLastDemoMouseY;
+	int						mDemoCmdOrder;
+	double					mPendingUpdatesAcc;
+	double					mUpdateFTimeAcc;
+	Buffer					mData;				// Rand state followed by DemoSaveSnapshot's data
+};
+
+
+// A piece of the demo command stream, compressed on its own so playback only
+//  has to inflate the part it's about to read.  Chunks start on a command.
+class DemoChunk
+{
+public:
+	int						mUpdateCount;		// update the first command is tagged with
+	int						mBitPos;			// where the first command starts in mDemoBuffer
+	int						mDataPos;			// compressed data in mDemoChunkData
+	int						mDataSize;
+	bool					mLoaded;
+};
+
+
 typedef std::list<WidgetSafeDeleteInfo> WidgetSafeDeleteList;
+typedef std::list<DemoSnapshot> DemoSnapshotList;
+typedef std::vector<DemoChunk> DemoChunkVector;
 typedef std::set<MemoryImage*> MemoryImageSet;
 typedef std::map<int, Dialog*> DialogMap;
 typedef std::list<Dialog*> DialogList;
@@ -132,7 +166,7 @@ public:
 	std::string				mRegKey;
 	std::string				mChangeDirTo;
 	
-	int						mRelaxUpdateBacklogCount; // app doesn't try to catch up for this many frames
+	double					mRelaxUpdateBacklogCount; // app doesn't try to catch up for this many ms
 	int						mPreferredX;
 	int						mPreferredY;
 	int						mWidth;
@@ -210,7 +244,9 @@ public:
 	bool					mHasPendingDraw;
 	double					mPendingUpdatesAcc;
 	double					mUpdateFTimeAcc;
-	DWORD					mLastTimeCheck;
+	__int64					mLastTimeCheck;		// ns, from PerfTimer::GetTimeNS
+	double					mPacingSpinTime;	// ms at the end of a frame wait that are spun instead of slept
+	FrameStats				mFrameStats;
 	DWORD					mLastTime;
 	DWORD					mLastUserInputTick;
 
@@ -288,6 +324,12 @@ public:
 	typedef std::pair<std::string, int> DemoMarker;
 	typedef std::list<DemoMarker> DemoMarkerList;
 	DemoMarkerList			mDemoMarkerList;
+	DemoReplayer*			mDemoReplayer;	// set by -replay, plays the demo with no window
+	DemoSnapshotList		mDemoSnapshotList;
+	int						mDemoSnapshotInterval;	// updates between snapshots while recording, 0 for none
+	DemoChunkVector			mDemoChunks;
+	ByteVector				mDemoChunkData;
+	int						mDemoChunkSize;		// bytes of commands per chunk while recording
 
 	bool					mDebugKeysEnabled;
 	bool					mEnableMaximizeButton;
@@ -302,6 +344,9 @@ public:
 	DWORD					mVSyncBrokenTestUpdates;
 	bool					mWaitForVSync;
 	bool					mSoftVSyncWait;
+	bool					mPipelineDraw;			// software only: draw into a list and execute it on a render thread
+	RenderPipeline*			mRenderPipeline;
+	bool					mPipelineUnpresented;	// executed by the render thread but not Redraw()n yet
 	bool					mUserChanged3DSetting;
 	bool					mAutoEnable3D;
 	bool					mTest3D;
@@ -496,6 +541,9 @@ public:
 	virtual bool			CheckSignature(const Buffer& theBuffer, const std::string& theFileName);
 	virtual bool			DrawDirtyStuff();
 	virtual void			Redraw(Rect* theClipRect);
+	void					KickRenderPipeline(MemoryImage* theScreenImage);
+	void					WaitForRenderThread();
+	void					WaitForRenderThread(Image* theImage);	// only if the frame in flight draws theImage
 
 	// Properties access methods
 	bool					LoadProperties(const std::string& theFileName, bool required, bool checkSig);
@@ -537,6 +585,15 @@ public:
 	void					DemoRegisterHandle(HANDLE theHandle);
 	void					DemoWaitForHandle(HANDLE theHandle);
 	bool					DemoCheckHandle(HANDLE theHandle);
+	void					DemoTakeSnapshot();
+	bool					DemoSeekSnapshot(int theUpdateNum);
+	void					DemoLoadChunk(int theBitPos);
+
+	// Override both to let demo playback seek without replaying from the start.
+	//  Save everything that affects future updates, Load must restore it exactly.
+	//  Return false if there's nothing to save or it can't be loaded right now.
+	virtual bool			DemoSaveSnapshot(Buffer* theBuffer);
+	virtual bool			DemoLoadSnapshot(Buffer* theBuffer);
 	
 
 	// Registry access methods
@@ -561,6 +618,7 @@ public:
 
 	// Misc methods
 	virtual void			DoMainLoop();
+	virtual void			DoReplayLoop();
 	virtual bool			UpdateAppStep(bool* updated);
 	virtual bool			UpdateApp();
 	int						InitDDInterface();
@@ -1,6 +1,11 @@
 #include "DSoundManager.cpp" // build first because this defines DIRECTSOUND_VERSION to 0x0600
 
 #include "DSoundInstance.cpp"
+#include "DSoundStreamInstance.cpp"
+#include "OggStream.cpp"
+#include "MixerOutput.cpp"
+#include "MixerSoundInstance.cpp"
+#include "MixerSoundManager.cpp"
 #include "BassLoader.cpp"
 #include "BassMusicInterface.cpp"
 #include "FModLoader.cpp"
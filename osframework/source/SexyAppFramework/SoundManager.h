@@ -42,6 +42,9 @@ public:
 	virtual int				GetFreeSoundId() = NULL;
 	virtual int				GetNumSounds() = NULL;
 
+	// Called once per app update, for managers that do their own mixing
+	virtual void			Update() {}
+
 };
 
 
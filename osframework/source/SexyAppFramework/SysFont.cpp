@@ -6,6 +6,7 @@
 #include "MemoryImage.h"
 #include "D3DInterface.h"
 #include "WidgetManager.h"
+#include "DrawList.h"
 #include <stdlib.h>
 
 using namespace Sexy;
@@ -276,8 +277,8 @@ void SysFont::DrawString(Graphics* g, int theX, int theY, const SexyString& theS
 
 		SelectObject(aDC, anOldFont);
 
-		MemoryImage aTempImage;
-		aTempImage.Create(aWidth, aHeight);
+		MemoryImage* aTempImage = new MemoryImage();
+		aTempImage->Create(aWidth, aHeight);
 
 		int aCount = aHeight*aWidth;
 		ulong* ptr1 = whiteBits, *ptr2 = blackBits;
@@ -303,8 +304,15 @@ void SysFont::DrawString(Graphics* g, int theX, int theY, const SexyString& theS
 			--aCount;
 		}
 
-		memcpy(aTempImage.GetBits(), whiteBits, aWidth*aHeight*sizeof(ulong));
-		g->DrawImage(&aTempImage, theX, theY - mAscent);
+		memcpy(aTempImage->GetBits(), whiteBits, aWidth*aHeight*sizeof(ulong));
+		g->DrawImage(aTempImage, theX, theY - mAscent);
+
+		// A draw list only references the image, so it has to outlive the list
+		DrawList* aDrawList = dynamic_cast<DrawList*>(g->mDestImage);
+		if (aDrawList != NULL)
+			aDrawList->AdoptImage(aTempImage);
+		else
+			delete aTempImage;
 
 		DeleteObject(whiteBitmap);
 		DeleteObject(blackBitmap);
@@ -6,9 +6,21 @@
 
 using namespace Sexy;
 
+SexyString TextChunk::GetLine(int theIdx) const
+{
+	int aStart = mLineStarts[theIdx];
+	int anEnd = (theIdx + 1 < (int) mLineStarts.size()) ? mLineStarts[theIdx + 1] : (int) mText.length();
+	return mText.substr(aStart, anEnd - aStart);
+}
+
 TextWidget::TextWidget()
 {
 	mFont = NULL;
+	mNumLogical = 0;
+	mNumPhysical = 0;
+	mRewrapChunk = 0;
+	mRewrapLine = 0;
+	mWrapChanged = false;
 	mPosition = 0;
 	mPageSize = 0;
 	mStickToBottom = true;
@@ -16,20 +28,45 @@ TextWidget::TextWidget()
 	mScrollbar = NULL;
 }
 
+TextWidget::~TextWidget()
+{
+	for (int i = 0; i < (int)mChunks.size(); i++)
+		delete mChunks[i];
+}
+
 SexyStringVector TextWidget::GetLines()
 {
-	return mLogicalLines;
+	SexyStringVector aLines;
+	aLines.reserve(mNumLogical);
+
+	for (int aChunkIdx = 0; aChunkIdx < (int)mChunks.size(); aChunkIdx++)
+	{
+		TextChunk* aChunk = mChunks[aChunkIdx];
+		for (int aLineIdx = 0; aLineIdx < aChunk->GetNumLines(); aLineIdx++)
+			aLines.push_back(aChunk->GetLine(aLineIdx));
+	}
+
+	return aLines;
 }
 
 void TextWidget::SetLines(SexyStringVector theNewLines)
 {
-	mLogicalLines = theNewLines;
+	Clear();
+
+	for (int i = 0; i < (int)theNewLines.size(); i++)
+		AddLine(theNewLines[i]);
 }
 
 void TextWidget::Clear()
 {
-	mLogicalLines.clear();	
-	mPhysicalLines.clear();
+	for (int i = 0; i < (int)mChunks.size(); i++)
+		delete mChunks[i];
+	mChunks.clear();
+
+	mNumLogical = 0;
+	mNumPhysical = 0;
+	mRewrapChunk = 0;
+	mRewrapLine = 0;
 	mPosition = 0.0;
 	mScrollbar->SetMaxValue(0.0);
 	MarkDirty();
@@ -128,38 +165,36 @@ int TextWidget::GetColorStringWidth(const SexyString& theString)
 
 void TextWidget::Resize(int theX, int theY, int theWidth, int theHeight)
 {
+	bool widthChanged = theWidth != mWidth;
+
+	int aTopChunk = 0;
+	int aTopLine = 0;
+	int aTopSubLine = 0;
+	bool hasLines = FindPhysicalLine((int) mScrollbar->mValue, &aTopChunk, &aTopLine, &aTopSubLine);
+
 	Widget::Resize(theX, theY, theWidth, theHeight);				
 		
 	double aPageSize = 1;
 	if (mHeight > mFont->GetHeight()+16)
 		aPageSize = (mHeight - 8.0) / mFont->GetHeight();
-	
-	int aLogValue = 0;		
-	if (mLineMap.size() > 0)
-	{
-		//IntIntMap::iterator anItr = mLineMap.find(mScrollbar->mValue);
-
-		aLogValue = mLineMap[(int) mScrollbar->mValue];
-	}
 
-	int aNewPhysValue = 0;
-	
-	mLineMap.clear();
-	mPhysicalLines.clear();
-	for (int i = 0; i < (int)mLogicalLines.size(); i++)
+	// Wraps are keyed by width so nothing is thrown away here, the lines in
+	//  view are re-wrapped now and Update gets to the rest
+	if (widthChanged)
 	{
-		if (i == aLogValue)
-			aNewPhysValue = mPhysicalLines.size();
-		
-		AddToPhysicalLines(i, mLogicalLines[i]);
+		mRewrapChunk = 0;
+		mRewrapLine = 0;
 	}
+
+	mPageSize = aPageSize;
+	if (hasLines)
+		WrapVisibleLines(aTopChunk, aTopLine);
 	
 	bool atBottom = mScrollbar->AtBottom();
 	
-	mPageSize = aPageSize;
-	mScrollbar->SetMaxValue(mPhysicalLines.size());
+	mScrollbar->SetMaxValue(mNumPhysical);
 	mScrollbar->SetPageSize((int) aPageSize);
-	mScrollbar->SetValue(aNewPhysValue);
+	mScrollbar->SetValue(hasLines ? GetPhysicalIndex(aTopChunk, aTopLine) : 0);
 	
 	if ((mStickToBottom) && (atBottom))			
 		mScrollbar->GoToBottom();		
@@ -176,92 +211,258 @@ Color TextWidget::GetLastColor(const SexyString& theString)
 }
 
 //UNICODE
-void TextWidget::AddToPhysicalLines(int theIdx, const SexyString& theLine)
-{		
-	SexyString aCurString = _S("");
-		
-	if (GetColorStringWidth(theLine) <= mWidth - 8)
-	{
-		aCurString = theLine;
-	}
-	else
+void TextWidget::WrapLine(TextChunk* theChunk, int theLine)
+{
+	TextWrap& aWrap = theChunk->mWraps[theLine];
+	int anOldNumLines = aWrap.GetNumLines();
+
+	SexyString aLine = theChunk->GetLine(theLine);
+	int aMaxWidth = mWidth - 8;
+
+	aWrap.mWidth = mWidth;
+	aWrap.mBreaks.clear();
+
+	if (GetColorStringWidth(aLine) > aMaxWidth)
 	{
-		int aCurPos = 0;										
-		while (aCurPos < (int)theLine.length())
+		// Word widths are summed rather than measuring the whole line so far
+		//  each time.  Continuation lines start with a two space indent.
+		int anIndentWidth = mFont->StringWidth(_S("  "));
+		int aCurWidth = 0;
+		int aLineStart = 0;
+		int aCurPos = 0;
+		while (aCurPos < (int)aLine.length())
 		{
 			int aNextCheckPos = aCurPos;
-			while ((aNextCheckPos < (int)theLine.length()) && (theLine[aNextCheckPos] == ' '))
+			while ((aNextCheckPos < (int)aLine.length()) && (aLine[aNextCheckPos] == ' '))
 				aNextCheckPos++;
 			
-			int aSpacePos = theLine.find(_S(" "), aNextCheckPos);
+			int aSpacePos = aLine.find(_S(" "), aNextCheckPos);
 			if (aSpacePos == -1)
-				aSpacePos = theLine.length();
+				aSpacePos = aLine.length();
 			
-			SexyString aNewString = aCurString + theLine.substr(aCurPos, aSpacePos - aCurPos);
-			if (GetColorStringWidth(aNewString) > mWidth-8)
+			int aWordWidth = GetColorStringWidth(aLine.substr(aCurPos, aSpacePos - aCurPos));
+			if ((aCurPos > aLineStart) && (aCurWidth + aWordWidth > aMaxWidth))
 			{
-				mPhysicalLines.push_back(aCurString);					
-				mLineMap.push_back(theIdx);
-				Color aColor = GetLastColor(aCurString);
-				aCurString = _S("  ") + SexyChar(0xFF) + (SexyChar) aColor.mRed + (SexyChar) aColor.mGreen + (SexyChar) aColor.mBlue +
-					theLine.substr(aNextCheckPos, aSpacePos - aNextCheckPos);
+				aWrap.mBreaks.push_back(aNextCheckPos);
+				aLineStart = aNextCheckPos;
+				aCurWidth = anIndentWidth + GetColorStringWidth(aLine.substr(aNextCheckPos, aSpacePos - aNextCheckPos));
 			}
 			else
-				aCurString = aNewString;
+				aCurWidth += aWordWidth;
 			
 			aCurPos = aSpacePos;
 		}
-	}	
-	
-	if ((aCurString.compare(_S("")) != 0) || (theLine.compare(_S("")) == 0))
+	}
+
+	int aDelta = aWrap.GetNumLines() - anOldNumLines;
+	if (aDelta != 0)
 	{
-		mPhysicalLines.push_back(aCurString);
-		mLineMap.push_back(theIdx);
+		theChunk->mNumPhysical += aDelta;
+		mNumPhysical += aDelta;
+		mWrapChanged = true;
 	}
 }
 
+const TextWrap& TextWidget::GetWrap(TextChunk* theChunk, int theLine)
+{
+	if (theChunk->mWraps[theLine].mWidth != mWidth)
+		WrapLine(theChunk, theLine);
+
+	return theChunk->mWraps[theLine];
+}
+
+bool TextWidget::FindPhysicalLine(int thePhysIdx, int* theChunk, int* theLine, int* theSubLine)
+{
+	if ((thePhysIdx < 0) || (thePhysIdx >= mNumPhysical))
+		return false;
+
+	int aChunkIdx = 0;
+	while (thePhysIdx >= mChunks[aChunkIdx]->mNumPhysical)
+	{
+		thePhysIdx -= mChunks[aChunkIdx]->mNumPhysical;
+		aChunkIdx++;
+	}
+
+	TextChunk* aChunk = mChunks[aChunkIdx];
+	int aLineIdx = 0;
+	while (thePhysIdx >= aChunk->mWraps[aLineIdx].GetNumLines())
+	{
+		thePhysIdx -= aChunk->mWraps[aLineIdx].GetNumLines();
+		aLineIdx++;
+	}
+
+	*theChunk = aChunkIdx;
+	*theLine = aLineIdx;
+	*theSubLine = thePhysIdx;
+	return true;
+}
+
+int TextWidget::GetPhysicalIndex(int theChunk, int theLine)
+{
+	int anIdx = 0;
+	for (int aChunkIdx = 0; aChunkIdx < theChunk; aChunkIdx++)
+		anIdx += mChunks[aChunkIdx]->mNumPhysical;
+
+	TextChunk* aChunk = mChunks[theChunk];
+	for (int aLineIdx = 0; aLineIdx < theLine; aLineIdx++)
+		anIdx += aChunk->mWraps[aLineIdx].GetNumLines();
+
+	return anIdx;
+}
+
+bool TextWidget::NextPhysicalLine(int* theChunk, int* theLine, int* theSubLine)
+{
+	TextChunk* aChunk = mChunks[*theChunk];
+	if (*theSubLine + 1 < GetWrap(aChunk, *theLine).GetNumLines())
+	{
+		(*theSubLine)++;
+		return true;
+	}
+
+	*theSubLine = 0;
+	if (*theLine + 1 < aChunk->GetNumLines())
+	{
+		(*theLine)++;
+		return true;
+	}
+
+	if (*theChunk + 1 < (int)mChunks.size())
+	{
+		(*theChunk)++;
+		*theLine = 0;
+		return true;
+	}
+
+	return false;
+}
+
 //UNICODE
-void TextWidget::AddLine(const SexyString& theLine)
+SexyString TextWidget::GetPhysicalLine(TextChunk* theChunk, int theLine, int theSubLine)
 {
-	SexyString aLine = theLine;
+	const TextWrap& aWrap = GetWrap(theChunk, theLine);
+	SexyString aLine = theChunk->GetLine(theLine);
 
-	if (aLine.compare(_S("")) == 0)
-		aLine = _S(" ");
-	
-	bool atBottom = mScrollbar->AtBottom();
-	
-	mLogicalLines.push_back(aLine);
-	
-	if ((int)mLogicalLines.size() > mMaxLines)
+	int aNumBreaks = aWrap.mBreaks.size();
+	theSubLine = min(theSubLine, aNumBreaks);
+
+	int aStart = (theSubLine > 0) ? aWrap.mBreaks[theSubLine - 1] : 0;
+	int anEnd = aLine.length();
+	if (theSubLine < aNumBreaks)
 	{
-		// Remove an extra 10 lines, for safty
-		int aNumLinesToRemove = mLogicalLines.size() - mMaxLines + 10;
-				
-		mLogicalLines.erase(mLogicalLines.begin(), mLogicalLines.begin() + aNumLinesToRemove);
-		
-		int aPhysLineRemoveCount = 0;
+		anEnd = aWrap.mBreaks[theSubLine];
+		while ((anEnd > aStart) && (aLine[anEnd - 1] == ' '))
+			anEnd--;
+	}
+
+	if (theSubLine == 0)
+		return aLine.substr(aStart, anEnd - aStart);
+
+	Color aColor = GetLastColor(aLine.substr(0, aStart));
+	return _S("  ") + SexyChar(0xFF) + (SexyChar) aColor.mRed + (SexyChar) aColor.mGreen + (SexyChar) aColor.mBlue +
+		aLine.substr(aStart, anEnd - aStart);
+}
+
+SexyString TextWidget::GetPhysicalLine(int theIdx)
+{
+	int aChunkIdx, aLineIdx, aSubLine;
+	if (!FindPhysicalLine(theIdx, &aChunkIdx, &aLineIdx, &aSubLine))
+		return _S("");
+
+	return GetPhysicalLine(mChunks[aChunkIdx], aLineIdx, aSubLine);
+}
 
-		// Remove all physical lines and linemap entries relating to deleted logical lines
-		while (mLineMap[aPhysLineRemoveCount] < aNumLinesToRemove)
+void TextWidget::WrapVisibleLines(int theChunk, int theLine)
+{
+	// A few lines back from the top...
+	int aChunkIdx = theChunk;
+	int aLineIdx = theLine;
+	for (int i = 0; i < WRAP_MARGIN; i++)
+	{
+		if (aLineIdx > 0)
+			aLineIdx--;
+		else if (aChunkIdx > 0)
 		{
-			aPhysLineRemoveCount++;			
+			aChunkIdx--;
+			aLineIdx = mChunks[aChunkIdx]->GetNumLines() - 1;
 		}
+		else
+			break;
 
-		mLineMap.erase(mLineMap.begin(), mLineMap.begin() + aPhysLineRemoveCount);
-		mPhysicalLines.erase(mPhysicalLines.begin(), mPhysicalLines.begin() + aPhysLineRemoveCount);
-		
-		// Offset the line map numbers
-		int i;
-		for (i = 0; i < (int)mLineMap.size(); i++)
+		GetWrap(mChunks[aChunkIdx], aLineIdx);
+	}
+
+	// ...and a page plus a few lines down
+	int aNumPhysical = 0;
+	int aNumMargin = 0;
+	aChunkIdx = theChunk;
+	aLineIdx = theLine;
+	while (aNumMargin < WRAP_MARGIN)
+	{
+		aNumPhysical += GetWrap(mChunks[aChunkIdx], aLineIdx).GetNumLines();
+		if (aNumPhysical > mPageSize)
+			aNumMargin++;
+
+		if (aLineIdx + 1 < mChunks[aChunkIdx]->GetNumLines())
+			aLineIdx++;
+		else if (aChunkIdx + 1 < (int)mChunks.size())
 		{
-			mLineMap[i] -= aNumLinesToRemove;
+			aChunkIdx++;
+			aLineIdx = 0;
 		}
-			//mLineMap.setElementAt(new Integer(((Integer) mLineMap.elementAt(i)).intValue() - aNumLinesToRemove), i);
-		
+		else
+			break;
+	}
+}
+
+void TextWidget::RewrapLines(int theCount)
+{
+	while ((theCount > 0) && (mRewrapChunk < (int)mChunks.size()))
+	{
+		TextChunk* aChunk = mChunks[mRewrapChunk];
+		if (aChunk->mWraps[mRewrapLine].mWidth != mWidth)
+		{
+			WrapLine(aChunk, mRewrapLine);
+			theCount--;
+		}
+
+		if (++mRewrapLine >= aChunk->GetNumLines())
+		{
+			// A partly filled last chunk gets picked up again as lines are added
+			if (mRewrapChunk + 1 == (int)mChunks.size())
+			{
+				mRewrapLine--;
+				break;
+			}
+
+			mRewrapChunk++;
+			mRewrapLine = 0;
+		}
+	}
+}
+
+void TextWidget::TrimLines()
+{
+	// Old lines are dropped a whole chunk at a time, so up to LINES_PER_CHUNK
+	//  more than mMaxLines can be kept
+	while ((mChunks.size() > 1) && (mNumLogical - mChunks.front()->GetNumLines() >= mMaxLines))
+	{
+		TextChunk* aChunk = mChunks.front();
+		int aNumPhysical = aChunk->mNumPhysical;
+
+		mNumLogical -= aChunk->GetNumLines();
+		mNumPhysical -= aNumPhysical;
+		mChunks.pop_front();
+		delete aChunk;
+
+		if (mRewrapChunk > 0)
+			mRewrapChunk--;
+		else
+			mRewrapLine = 0;
+
 		// Move the hilited area
-		for (i = 0; i < 2; i++)
+		for (int i = 0; i < 2; i++)
 		{
-			mHiliteArea[i][1] -= aNumLinesToRemove;
+			mHiliteArea[i][1] -= aNumPhysical;
 			if (mHiliteArea[i][1] < 0)
 			{
 				mHiliteArea[i][0] = 0;
@@ -269,12 +470,36 @@ void TextWidget::AddLine(const SexyString& theLine)
 			}
 		}
 		
-		mScrollbar->SetValue(mScrollbar->mValue - aNumLinesToRemove);
+		mScrollbar->SetValue(mScrollbar->mValue - aNumPhysical);
 	}
+}
+
+//UNICODE
+void TextWidget::AddLine(const SexyString& theLine)
+{
+	SexyString aLine = theLine;
+
+	if (aLine.compare(_S("")) == 0)
+		aLine = _S(" ");
 	
-	AddToPhysicalLines(mLogicalLines.size()-1, aLine);
+	bool atBottom = mScrollbar->AtBottom();
+
+	if ((mChunks.empty()) || (mChunks.back()->GetNumLines() >= LINES_PER_CHUNK))
+		mChunks.push_back(new TextChunk());
+
+	// Not wrapped yet, it counts as one physical line until it's in view or
+	//  Update gets to it
+	TextChunk* aChunk = mChunks.back();
+	aChunk->mLineStarts.push_back(aChunk->mText.length());
+	aChunk->mText += aLine;
+	aChunk->mWraps.push_back(TextWrap());
+	aChunk->mNumPhysical++;
+	mNumLogical++;
+	mNumPhysical++;
+
+	TrimLines();
 	
-	mScrollbar->SetMaxValue(mPhysicalLines.size());
+	mScrollbar->SetMaxValue(mNumPhysical);
 	
 	if (atBottom)
 		mScrollbar->GoToBottom();
@@ -290,6 +515,11 @@ bool TextWidget::SelectionReversed()
 }
 
 void TextWidget::GetSelectedIndices(int theLineIdx, int* theIndices)
+{
+	GetSelectedIndices(theLineIdx, GetPhysicalLine(theLineIdx), theIndices);
+}
+
+void TextWidget::GetSelectedIndices(int theLineIdx, const SexyString& theLine, int* theIndices)
 {
 	int aXor = SelectionReversed() ? 1 : 0;
 	for (int aPosIdx = 0; aPosIdx < 2; aPosIdx++)
@@ -301,12 +531,39 @@ void TextWidget::GetSelectedIndices(int theLineIdx, int* theIndices)
 		else if (mHiliteArea[aPosIdx][1] == theLineIdx)
 			aVal = mHiliteArea[aPosIdx][0];
 		else 
-			aVal = mPhysicalLines[theLineIdx].length();
+			aVal = theLine.length();
 					
 		theIndices[aPosIdx ^ aXor] = aVal;			
 	}			
 }
 
+void TextWidget::Update()
+{
+	Widget::Update();
+
+	int aTopChunk, aTopLine, aTopSubLine;
+	double aTopFrac = mScrollbar->mValue - (int) mScrollbar->mValue;
+	if (!FindPhysicalLine((int) mScrollbar->mValue, &aTopChunk, &aTopLine, &aTopSubLine))
+		return;
+
+	bool atBottom = mScrollbar->AtBottom();
+
+	mWrapChanged = false;
+	WrapVisibleLines(aTopChunk, aTopLine);
+	RewrapLines(REWRAP_PER_UPDATE);
+
+	if (mWrapChanged)
+	{
+		// Lines above the view may have changed height, keep the same text at the top
+		mScrollbar->SetMaxValue(mNumPhysical);
+		if ((mStickToBottom) && (atBottom))
+			mScrollbar->GoToBottom();
+		else
+			mScrollbar->SetValue(GetPhysicalIndex(aTopChunk, aTopLine) + aTopSubLine + aTopFrac);
+		MarkDirty();
+	}
+}
+
 void TextWidget::Draw(Graphics* g)
 {
 	g->SetColor(Color(255, 255, 255));
@@ -319,16 +576,22 @@ void TextWidget::Draw(Graphics* g)
 	aClipG.SetFont(mFont);		
 	
 	int aFirstLine = (int) mPosition;
-	int aLastLine = min((int) mPhysicalLines.size()-1, (int) mPosition + (int) mPageSize + 1);
-	
+	int aChunkIdx, aLineIdx, aSubLine;
+	if (!FindPhysicalLine(aFirstLine, &aChunkIdx, &aLineIdx, &aSubLine))
+		return;
+
+	int aLastLine = (int) mPosition + (int) mPageSize + 1;	
 	for (int i = aFirstLine; i <= aLastLine; i++)
 	{
 		int aYPos = 4 + (int) ((i - (int) mPosition)*mFont->GetHeight()) + mFont->GetAscent();
-		SexyString aString = mPhysicalLines[i];
+		SexyString aString = GetPhysicalLine(mChunks[aChunkIdx], aLineIdx, aSubLine);
 		
 		int aHilitePos[2];
-		GetSelectedIndices(i, aHilitePos);
+		GetSelectedIndices(i, aString, aHilitePos);
 		DrawColorStringHilited(&aClipG, aString, 4, aYPos, aHilitePos[0], aHilitePos[1]);
+
+		if (!NextPhysicalLine(&aChunkIdx, &aLineIdx, &aSubLine))
+			break;
 	}				
 }
 
@@ -346,17 +609,17 @@ void TextWidget::GetTextIndexAt(int x, int y, int* thePosArray)
 		thePosArray[0] = 0;
 		thePosArray[1] = 0;
 	}
-	else if (aLineNum < (int)mPhysicalLines.size())
+	else if (aLineNum < mNumPhysical)
 	{
-		thePosArray[0] = GetStringIndex(mPhysicalLines[aLineNum], x);
+		thePosArray[0] = GetStringIndex(GetPhysicalLine(aLineNum), x);
 		thePosArray[1] = aLineNum;						
 	}
 	else
 	{
-		if (mPhysicalLines.size() > 0)
+		if (mNumPhysical > 0)
 		{		
-			thePosArray[0] = mPhysicalLines[mPhysicalLines.size()-1].length();
-			thePosArray[1] = mPhysicalLines.size() - 1;				
+			thePosArray[0] = GetPhysicalLine(mNumPhysical - 1).length();
+			thePosArray[1] = mNumPhysical - 1;				
 		}
 	}
 }
@@ -386,11 +649,17 @@ SexyString TextWidget::GetSelection()
 	bool first = true;
 	
 	bool reverse = SelectionReversed();
-	for (int aLineNum = mHiliteArea[reverse ? 1 : 0][1]; aLineNum <= mHiliteArea[reverse ? 0 : 1][1]; aLineNum++)
+	int aFirstLine = mHiliteArea[reverse ? 1 : 0][1];
+	int aChunkIdx, aLineIdx, aSubLine;
+	if (!FindPhysicalLine(aFirstLine, &aChunkIdx, &aLineIdx, &aSubLine))
+		return aSelString;
+
+	// Walk forward rather than looking every line up from the start
+	for (int aLineNum = aFirstLine; aLineNum <= mHiliteArea[reverse ? 0 : 1][1]; aLineNum++)
 	{
-		SexyString aString = mPhysicalLines[aLineNum];
+		SexyString aString = GetPhysicalLine(mChunks[aChunkIdx], aLineIdx, aSubLine);
 		
-		GetSelectedIndices(aLineNum, aSelIndices);
+		GetSelectedIndices(aLineNum, aString, aSelIndices);
 		
 		if (!first)
 			aSelString += _S("\r\n");
@@ -405,6 +674,9 @@ SexyString TextWidget::GetSelection()
 		}
 		
 		first = false;
+
+		if (!NextPhysicalLine(&aChunkIdx, &aLineIdx, &aSubLine))
+			break;
 	}
 	
 	return aSelString;
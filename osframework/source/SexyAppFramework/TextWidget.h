@@ -3,6 +3,7 @@
 
 #include "Widget.h"
 #include "ScrollListener.h"
+#include <deque>
 
 namespace Sexy
 {
@@ -13,23 +14,82 @@ class Font;
 typedef std::vector<SexyString> SexyStringVector;
 typedef std::vector<int> IntVector;
 
+// Where a logical line breaks into physical lines.  Only recomputed when the
+//  line is needed at a different widget width.
+struct TextWrap
+{
+	int					mWidth;			// widget width the breaks were made for, 0 if never wrapped
+	IntVector			mBreaks;		// start of each continuation line, empty if the line fits
+
+	TextWrap() : mWidth(0) {}
+	int					GetNumLines() const { return mBreaks.size() + 1; }
+};
+
+typedef std::vector<TextWrap> TextWrapVector;
+
+// A run of logical lines stored back to back in one string, so appending
+//  doesn't allocate per line and old lines are trimmed a chunk at a time.
+//  mNumPhysical is the sum of the chunk's wrap counts, which lets a physical
+//  line be found without visiting every logical line.
+struct TextChunk
+{
+	SexyString			mText;
+	IntVector			mLineStarts;
+	TextWrapVector		mWraps;
+	int					mNumPhysical;
+
+	TextChunk() : mNumPhysical(0) {}
+	int					GetNumLines() const { return mLineStarts.size(); }
+	SexyString			GetLine(int theIdx) const;
+};
+
+typedef std::deque<TextChunk*> TextChunkDeque;
+
+// Lines are wrapped lazily: the visible lines (plus a margin) are wrapped
+//  when they come into view, and after a resize Update re-wraps a bounded
+//  number of the rest each frame.  Until then a line counts as however many
+//  physical lines it had at the old width, so the scrollbar range settles
+//  over a few frames rather than costing a full re-wrap up front.
 class TextWidget : public Widget, public ScrollListener
 {
 public:
+	enum
+	{
+		LINES_PER_CHUNK		= 256,
+		WRAP_MARGIN			= 16,		// logical lines wrapped on either side of the visible ones
+		REWRAP_PER_UPDATE	= 64
+	};
+
 	Font*				mFont;
 	ScrollbarWidget*	mScrollbar;		
 	
-	SexyStringVector	mLogicalLines;
-	SexyStringVector	mPhysicalLines;	
-	IntVector			mLineMap;
+	TextChunkDeque		mChunks;
+	int					mNumLogical;
+	int					mNumPhysical;
+	int					mRewrapChunk;	// lines before this point are wrapped at the current width
+	int					mRewrapLine;
+	bool				mWrapChanged;	// physical line counts changed since the scrollbar was synced
 	double				mPosition;
 	double				mPageSize;	
 	bool				mStickToBottom;	
 	int					mHiliteArea[2][2];
 	int					mMaxLines;
 	
+protected:
+	void				WrapLine(TextChunk* theChunk, int theLine);
+	const TextWrap&		GetWrap(TextChunk* theChunk, int theLine);
+	bool				FindPhysicalLine(int thePhysIdx, int* theChunk, int* theLine, int* theSubLine);
+	int					GetPhysicalIndex(int theChunk, int theLine);
+	bool				NextPhysicalLine(int* theChunk, int* theLine, int* theSubLine);
+	SexyString			GetPhysicalLine(TextChunk* theChunk, int theLine, int theSubLine);
+	void				GetSelectedIndices(int theLineIdx, const SexyString& theLine, int* theIndices);
+	void				WrapVisibleLines(int theChunk, int theLine);
+	void				RewrapLines(int theCount);
+	void				TrimLines();
+
 public:
 	TextWidget();
+	virtual ~TextWidget();
 
 	virtual SexyStringVector GetLines();
 	virtual void SetLines(SexyStringVector theNewLines);	
@@ -41,11 +101,13 @@ public:
 	virtual int GetColorStringWidth(const SexyString& theString);
 	virtual void Resize(int theX, int theY, int theWidth, int theHeight);		
 	virtual Color GetLastColor(const SexyString& theString);		
-	virtual void AddToPhysicalLines(int theIdx, const SexyString& theLine);
+	virtual int GetNumPhysicalLines() { return mNumPhysical; }
+	virtual SexyString GetPhysicalLine(int theIdx);
 	
 	virtual void AddLine(const SexyString& theString);
 	virtual bool SelectionReversed();		
 	virtual void GetSelectedIndices(int theLineIdx, int* theIndices);		
+	virtual void Update();
 	virtual void Draw(Graphics* g);
 	virtual void ScrollPosition(int theId, double thePosition);		
 	virtual void GetTextIndexAt(int x, int y, int* thePosArray);
@@ -0,0 +1,450 @@
+#include "TextureAtlas.h"
+#include "MemoryImage.h"
+#include "SexyAppBase.h"
+#include "Debug.h"
+
+//#define SEXY_PERF_ENABLED
+#include "PerfTimer.h"
+
+using namespace Sexy;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+SkylinePacker::SkylinePacker(int theWidth, int theHeight)
+{
+	mWidth = theWidth;
+	mHeight = theHeight;
+	mUsedArea = 0;
+	mUsedHeight = 0;
+
+	SkylineNode aNode;
+	aNode.mX = 0;
+	aNode.mY = 0;
+	aNode.mWidth = theWidth;
+	mSkyline.push_back(aNode);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+int SkylinePacker::Fit(int theIndex, int theWidth, int theHeight)
+{
+	int x = mSkyline[theIndex].mX;
+	if (x + theWidth > mWidth)
+		return -1;
+
+	int aWidthLeft = theWidth;
+	int y = mSkyline[theIndex].mY;
+	int i = theIndex;
+
+	while (aWidthLeft > 0)
+	{
+		y = max(y, mSkyline[i].mY);
+		if (y + theHeight > mHeight)
+			return -1;
+
+		aWidthLeft -= mSkyline[i].mWidth;
+		i++;
+	}
+
+	return y;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void SkylinePacker::AddLevel(int theIndex, int theX, int theY, int theWidth, int theHeight)
+{
+	SkylineNode aNode;
+	aNode.mX = theX;
+	aNode.mY = theY + theHeight;
+	aNode.mWidth = theWidth;
+	mSkyline.insert(mSkyline.begin() + theIndex, aNode);
+
+	// Shrink or remove the nodes the new one now covers
+	for (int i = theIndex + 1; i < (int) mSkyline.size(); )
+	{
+		SkylineNode& aPrev = mSkyline[i-1];
+		SkylineNode& aCur = mSkyline[i];
+
+		if (aCur.mX >= aPrev.mX + aPrev.mWidth)
+			break;
+
+		int aShrink = aPrev.mX + aPrev.mWidth - aCur.mX;
+		aCur.mX += aShrink;
+		aCur.mWidth -= aShrink;
+
+		if (aCur.mWidth > 0)
+			break;
+
+		mSkyline.erase(mSkyline.begin() + i);
+	}
+
+	// Merge neighbours at the same height
+	for (int j = 0; j < (int) mSkyline.size() - 1; )
+	{
+		if (mSkyline[j].mY == mSkyline[j+1].mY)
+		{
+			mSkyline[j].mWidth += mSkyline[j+1].mWidth;
+			mSkyline.erase(mSkyline.begin() + j + 1);
+		}
+		else
+			j++;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool SkylinePacker::Insert(int theWidth, int theHeight, int* theX, int* theY)
+{
+	int aBestIndex = -1;
+	int aBestBottom = 0x7FFFFFFF;
+	int aBestWidth = 0x7FFFFFFF;
+	int aBestX = 0;
+	int aBestY = 0;
+
+	for (int i = 0; i < (int) mSkyline.size(); i++)
+	{
+		int y = Fit(i, theWidth, theHeight);
+		if (y < 0)
+			continue;
+
+		if ((y + theHeight < aBestBottom) || ((y + theHeight == aBestBottom) && (mSkyline[i].mWidth < aBestWidth)))
+		{
+			aBestIndex = i;
+			aBestBottom = y + theHeight;
+			aBestWidth = mSkyline[i].mWidth;
+			aBestX = mSkyline[i].mX;
+			aBestY = y;
+		}
+	}
+
+	if (aBestIndex == -1)
+		return false;
+
+	AddLevel(aBestIndex, aBestX, aBestY, theWidth, theHeight);
+
+	mUsedArea += theWidth*theHeight;
+	mUsedHeight = max(mUsedHeight, aBestBottom);
+
+	*theX = aBestX;
+	*theY = aBestY;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+TextureAtlas::TextureAtlas(SexyAppBase* theApp, int thePageWidth, int thePageHeight)
+{
+	mApp = theApp;
+	mPageWidth = thePageWidth;
+	mPageHeight = thePageHeight;
+	mPadding = 1;
+	mMaxImageSize = 128;
+	mBuilt = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+TextureAtlas::~TextureAtlas()
+{
+	Unpack();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+MemoryImage* TextureAtlas::CreatePage(int theWidth, int theHeight)
+{
+	MemoryImage* aPage = new MemoryImage(mApp);
+	aPage->Create(theWidth, theHeight);
+	aPage->GetRawBits();
+	return aPage;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool TextureAtlas::CanPack(MemoryImage* theImage)
+{
+	if ((theImage == NULL) || (theImage->mAtlas != NULL))
+		return false;
+
+	// Palletized, volatile, premultiplied and surface-only images stay as they are
+	if ((theImage->mColorTable != NULL) || (theImage->mIsVolatile) || (theImage->mPremultipliedAlpha))
+		return false;
+
+	if ((theImage->mBits == NULL) && (theImage->mNativeAlphaData == NULL))
+		return false;
+
+	if ((theImage->mWidth <= 0) || (theImage->mHeight <= 0) ||
+		(theImage->mWidth > mMaxImageSize) || (theImage->mHeight > mMaxImageSize))
+		return false;
+
+	return (theImage->mWidth + mPadding*2 <= mPageWidth) && (theImage->mHeight + mPadding*2 <= mPageHeight);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+bool TextureAtlas::AddImage(MemoryImage* theImage)
+{
+	if (mBuilt || !CanPack(theImage))
+		return false;
+
+	for (int i = 0; i < (int) mEntries.size(); i++)
+	{
+		if (mEntries[i].mImage == theImage)
+			return true;
+	}
+
+	AtlasEntry anEntry;
+	anEntry.mImage = theImage;
+	anEntry.mPage = -1;
+	anEntry.mX = 0;
+	anEntry.mY = 0;
+	mEntries.push_back(anEntry);
+
+	return true;
+}
+
+namespace
+{
+struct EntryHeightGreater
+{
+	const std::vector<MemoryImage*>* mImages;
+
+	EntryHeightGreater(const std::vector<MemoryImage*>* theImages) : mImages(theImages) {}
+	bool operator()(int a, int b) const
+	{
+		MemoryImage* anImageA = (*mImages)[a];
+		MemoryImage* anImageB = (*mImages)[b];
+		if (anImageA->mHeight != anImageB->mHeight)
+			return anImageA->mHeight > anImageB->mHeight;
+		return anImageA->mWidth > anImageB->mWidth;
+	}
+};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void TextureAtlas::PackEntries(std::vector<int>& theEntries, bool hasTrans, bool hasAlpha)
+{
+	if (theEntries.empty())
+		return;
+
+	std::vector<MemoryImage*> anImages;
+	for (int i = 0; i < (int) mEntries.size(); i++)
+		anImages.push_back(mEntries[i].mImage);
+
+	std::sort(theEntries.begin(), theEntries.end(), EntryHeightGreater(&anImages));
+
+	std::vector<SkylinePacker> aPackers;
+
+	for (int i = 0; i < (int) theEntries.size(); i++)
+	{
+		AtlasEntry& anEntry = mEntries[theEntries[i]];
+		int aWidth = anEntry.mImage->mWidth + mPadding*2;
+		int aHeight = anEntry.mImage->mHeight + mPadding*2;
+
+		int aPackerIdx;
+		for (aPackerIdx = 0; aPackerIdx < (int) aPackers.size(); aPackerIdx++)
+		{
+			if (aPackers[aPackerIdx].Insert(aWidth, aHeight, &anEntry.mX, &anEntry.mY))
+				break;
+		}
+
+		if (aPackerIdx == (int) aPackers.size())
+		{
+			aPackers.push_back(SkylinePacker(mPageWidth, mPageHeight));
+			aPackers.back().Insert(aWidth, aHeight, &anEntry.mX, &anEntry.mY);
+		}
+
+		anEntry.mPage = aPackerIdx;
+	}
+
+	// Create the pages, trimming unused rows down to the next power of two
+	int aFirstPage = mPages.size();
+	for (int aPackerIdx = 0; aPackerIdx < (int) aPackers.size(); aPackerIdx++)
+	{
+		int aPageHeight = 1;
+		while (aPageHeight < aPackers[aPackerIdx].GetUsedHeight())
+			aPageHeight <<= 1;
+		aPageHeight = min(aPageHeight, mPageHeight);
+
+		mPages.push_back(CreatePage(mPageWidth, aPageHeight));
+	}
+
+	for (int i = 0; i < (int) theEntries.size(); i++)
+	{
+		AtlasEntry& anEntry = mEntries[theEntries[i]];
+		anEntry.mPage += aFirstPage;
+
+		MemoryImage* aPage = mPages[anEntry.mPage];
+		MemoryImage* anImage = anEntry.mImage;
+
+		CopyIntoPage(aPage, anImage, anEntry.mX, anEntry.mY);
+
+		anImage->mAtlas = this;
+		anImage->mAtlasImage = aPage;
+		anImage->mAtlasX = anEntry.mX + mPadding;
+		anImage->mAtlasY = anEntry.mY + mPadding;
+
+		// The page holds the pixels now
+		anImage->DeleteExtraBuffers();
+		delete [] anImage->mBits;
+		anImage->mBits = NULL;
+	}
+
+	for (int aPageIdx = aFirstPage; aPageIdx < (int) mPages.size(); aPageIdx++)
+	{
+		mPages[aPageIdx]->BitsChanged();
+		mPages[aPageIdx]->SetImageMode(hasTrans, hasAlpha);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void TextureAtlas::CopyIntoPage(MemoryImage* thePage, MemoryImage* theImage, int theX, int theY)
+{
+	ulong* aSrcBits = theImage->GetRawBits();
+	ulong* aDestBits = thePage->GetRawBits();
+
+	int aWidth = theImage->mWidth;
+	int aHeight = theImage->mHeight;
+	int aPageWidth = thePage->mWidth;
+
+	for (int y = -mPadding; y < aHeight + mPadding; y++)
+	{
+		ulong* aSrcRow = aSrcBits + min(max(y, 0), aHeight-1)*aWidth;
+		ulong* aDestRow = aDestBits + (theY + mPadding + y)*aPageWidth + theX + mPadding;
+
+		for (int x = 1; x <= mPadding; x++)
+		{
+			aDestRow[-x] = aSrcRow[0];
+			aDestRow[aWidth-1+x] = aSrcRow[aWidth-1];
+		}
+
+		memcpy(aDestRow, aSrcRow, aWidth*sizeof(ulong));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void TextureAtlas::Build()
+{
+	if (mBuilt)
+		return;
+
+	SEXY_PERF_BEGIN("TextureAtlas::Build");
+
+	// Opaque and translucent images go on separate pages so the opaque ones
+	//  keep their fast blit paths
+	std::vector<int> anOpaqueEntries;
+	std::vector<int> aTransEntries;
+	bool anyTrans = false;
+	bool anyAlpha = false;
+
+	for (int i = 0; i < (int) mEntries.size(); i++)
+	{
+		MemoryImage* anImage = mEntries[i].mImage;
+		anImage->CommitBits();
+
+		if (anImage->mHasTrans || anImage->mHasAlpha)
+		{
+			aTransEntries.push_back(i);
+			anyTrans |= anImage->mHasTrans;
+			anyAlpha |= anImage->mHasAlpha;
+		}
+		else
+			anOpaqueEntries.push_back(i);
+	}
+
+	PackEntries(anOpaqueEntries, false, false);
+	PackEntries(aTransEntries, anyTrans, anyAlpha);
+
+	mBuilt = true;
+
+	SEXY_PERF_END("TextureAtlas::Build");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void TextureAtlas::RestoreBits(MemoryImage* theImage)
+{
+	if ((theImage->mAtlas != this) || (theImage->mBits != NULL))
+		return;
+
+	MemoryImage* aPage = (MemoryImage*) theImage->mAtlasImage;
+	ulong* aPageBits = aPage->GetRawBits();
+
+	int aSize = theImage->mWidth*theImage->mHeight;
+	theImage->mBits = new ulong[aSize+1];
+	theImage->mBits[aSize] = MEMORYCHECK_ID;
+
+	for (int y = 0; y < theImage->mHeight; y++)
+	{
+		memcpy(theImage->mBits + y*theImage->mWidth,
+			aPageBits + (theImage->mAtlasY + y)*aPage->mWidth + theImage->mAtlasX,
+			theImage->mWidth*sizeof(ulong));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void TextureAtlas::RemoveImage(Image* theImage)
+{
+	for (EntryVector::iterator anItr = mEntries.begin(); anItr != mEntries.end(); ++anItr)
+	{
+		if (anItr->mImage == theImage)
+		{
+			mEntries.erase(anItr);
+			break;
+		}
+	}
+
+	theImage->mAtlas = NULL;
+	theImage->mAtlasImage = NULL;
+	theImage->mAtlasX = 0;
+	theImage->mAtlasY = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+void TextureAtlas::Unpack()
+{
+	for (int i = 0; i < (int) mEntries.size(); i++)
+	{
+		MemoryImage* anImage = mEntries[i].mImage;
+		if (anImage->mAtlas == this)
+		{
+			RestoreBits(anImage);
+
+			anImage->mAtlas = NULL;
+			anImage->mAtlasImage = NULL;
+			anImage->mAtlasX = 0;
+			anImage->mAtlasY = 0;
+		}
+	}
+	mEntries.clear();
+
+	for (int aPageIdx = 0; aPageIdx < (int) mPages.size(); aPageIdx++)
+		delete mPages[aPageIdx];
+	mPages.clear();
+
+	mBuilt = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+double TextureAtlas::GetPackingEfficiency()
+{
+	double anImageArea = 0;
+	double aPageArea = 0;
+
+	for (int i = 0; i < (int) mEntries.size(); i++)
+		anImageArea += (double) mEntries[i].mImage->mWidth * mEntries[i].mImage->mHeight;
+
+	for (int aPageIdx = 0; aPageIdx < (int) mPages.size(); aPageIdx++)
+		aPageArea += (double) mPages[aPageIdx]->mWidth * mPages[aPageIdx]->mHeight;
+
+	if (aPageArea == 0)
+		return 0;
+
+	return anImageArea / aPageArea;
+}
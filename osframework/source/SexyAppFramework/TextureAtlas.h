@@ -0,0 +1,99 @@
+#ifndef __TEXTUREATLAS_H__
+#define __TEXTUREATLAS_H__
+
+#include "Common.h"
+
+namespace Sexy
+{
+
+class Image;
+class MemoryImage;
+class SexyAppBase;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Skyline bottom-left rectangle packer
+class SkylinePacker
+{
+protected:
+	struct SkylineNode
+	{
+		int					mX;
+		int					mY;
+		int					mWidth;
+	};
+	typedef std::vector<SkylineNode> SkylineVector;
+
+	int						mWidth;
+	int						mHeight;
+	int						mUsedArea;
+	int						mUsedHeight;
+	SkylineVector			mSkyline;
+
+	int						Fit(int theIndex, int theWidth, int theHeight);
+	void					AddLevel(int theIndex, int theX, int theY, int theWidth, int theHeight);
+
+public:
+	SkylinePacker(int theWidth, int theHeight);
+
+	bool					Insert(int theWidth, int theHeight, int* theX, int* theY);
+
+	int						GetUsedArea()	{ return mUsedArea; }
+	int						GetUsedHeight()	{ return mUsedHeight; }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// Packs many small MemoryImages into a few shared page images.  Packed images
+//  keep their size, strip layout and identity, but Graphics redirects their
+//  draws to the page (see Image::mAtlasImage) and their own bits are freed
+//  until someone asks for them again.
+class TextureAtlas
+{
+protected:
+	struct AtlasEntry
+	{
+		MemoryImage*		mImage;
+		int					mPage;
+		int					mX;
+		int					mY;
+	};
+	typedef std::vector<AtlasEntry> EntryVector;
+	typedef std::vector<MemoryImage*> PageVector;
+
+	SexyAppBase*			mApp;
+	EntryVector				mEntries;
+	PageVector				mPages;
+	bool					mBuilt;
+
+	void					PackEntries(std::vector<int>& theEntries, bool hasTrans, bool hasAlpha);
+	void					CopyIntoPage(MemoryImage* thePage, MemoryImage* theImage, int theX, int theY);
+	virtual MemoryImage*	CreatePage(int theWidth, int theHeight);
+
+public:
+	int						mPageWidth;
+	int						mPageHeight;
+	int						mPadding;		// border around each image, filled by extruding its edge pixels
+	int						mMaxImageSize;	// images larger than this in either dimension are not packed
+
+public:
+	TextureAtlas(SexyAppBase* theApp, int thePageWidth = 512, int thePageHeight = 512);
+	virtual ~TextureAtlas();
+
+	bool					CanPack(MemoryImage* theImage);
+	bool					AddImage(MemoryImage* theImage);
+	void					Build();
+	void					Unpack();
+
+	void					RemoveImage(Image* theImage);
+	void					RestoreBits(MemoryImage* theImage);
+
+	int						GetNumImages()				{ return mEntries.size(); }
+	int						GetNumPages()				{ return mPages.size(); }
+	MemoryImage*			GetPage(int theIndex)		{ return mPages[theIndex]; }
+	double					GetPackingEfficiency();
+};
+
+}
+
+#endif //__TEXTUREATLAS_H__
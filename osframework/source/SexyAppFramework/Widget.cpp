@@ -155,6 +155,9 @@ void Widget::Resize(int theX, int theY, int theWidth, int theHeight)
 	mY = theY;
 	mWidth = theWidth;
 	mHeight = theHeight;
+
+	if (mParent != NULL)
+		mParent->UpdateSpatialIndex(this);
 		
 	// Mark things dirty that are over the new position
 	MarkDirty();
@@ -14,3 +14,4 @@
 #include "DialogButton.cpp"
 #include "FlashWidget.cpp"
 #include "WidgetContainer.cpp"
+#include "WidgetSpatialIndex.cpp"
@@ -1,6 +1,7 @@
 #include "WidgetContainer.h"
 #include "WidgetManager.h"
 #include "Widget.h"
+#include "WidgetSpatialIndex.h"
 #include "Debug.h"
 #include <algorithm>
 
@@ -14,8 +15,8 @@ WidgetContainer::WidgetContainer()
 	mHeight = 0;
 	mParent = NULL;
 	mWidgetManager = NULL;
-	mUpdateIteratorModified = false;
-	mUpdateIterator = mWidgets.end();
+	mWidgetOrderDirty = false;
+	mParentOrderIdx = -1;
 	mLastWMUpdateCount = 0;
 	mUpdateCnt = 0;
 	mDirty = false;	
@@ -23,6 +24,7 @@ WidgetContainer::WidgetContainer()
 	mClip = true;
 	mPriority = 0;
 	mZOrder = 0;
+	mSpatialIndex = NULL;
 }
 
 WidgetContainer::~WidgetContainer()
@@ -30,6 +32,8 @@ WidgetContainer::~WidgetContainer()
 	// call RemoveWidget before you delete it!	
 	DBG_ASSERT(mParent == NULL);
 	DBG_ASSERT(mWidgets.empty());
+
+	delete mSpatialIndex;
 }
 
 void WidgetContainer::RemoveAllWidgets(bool doDelete, bool recursive)
@@ -56,13 +60,85 @@ bool WidgetContainer::Intersects(WidgetContainer* theWidget)
 	return GetRect().Intersects(theWidget->GetRect());
 }
 
+void WidgetContainer::EnableSpatialIndex(int theCellSize)
+{
+	delete mSpatialIndex;
+	mSpatialIndex = new WidgetSpatialIndex(this, theCellSize);
+}
+
+void WidgetContainer::DisableSpatialIndex()
+{
+	delete mSpatialIndex;
+	mSpatialIndex = NULL;
+}
+
+void WidgetContainer::UpdateSpatialIndex(Widget* theWidget)
+{
+	if (mSpatialIndex == NULL)
+		return;
+
+	// NULL means the order changed
+	if (theWidget == NULL)
+		mSpatialIndex->Invalidate();
+	else
+		mSpatialIndex->WidgetMoved(theWidget);
+}
+
+void WidgetContainer::WidgetOrderChanged()
+{
+	mWidgetOrderDirty = true;
+	UpdateSpatialIndex(NULL);
+}
+
+void WidgetContainer::WidgetListChanged()
+{
+	WidgetOrderChanged();
+
+	// Whether we have children decides how our parent's index treats us
+	if (mParent != NULL)
+		mParent->UpdateSpatialIndex((Widget*) this);
+}
+
+WidgetList::iterator WidgetContainer::FindWidget(WidgetContainer* theWidget)
+{
+	// Each widget remembers its own node, so there's no need to search
+	if ((theWidget == NULL) || (theWidget->mParent != this))
+		return mWidgets.end();
+
+	return theWidget->mParentItr;
+}
+
+const WidgetVector& WidgetContainer::GetWidgetOrder()
+{
+	// Only rebuilt after the list changes, so traversal is a walk over a
+	//  vector that is never reallocated from frame to frame
+	if (mWidgetOrderDirty)
+	{
+		mWidgetOrder.resize(0);
+
+		WidgetList::iterator anItr = mWidgets.begin();
+		while (anItr != mWidgets.end())
+		{
+			Widget* aWidget = *anItr;
+			aWidget->mParentOrderIdx = mWidgetOrder.size();
+			mWidgetOrder.push_back(aWidget);
+			++anItr;
+		}
+
+		mWidgetOrderDirty = false;
+	}
+
+	return mWidgetOrder;
+}
+
 void WidgetContainer::AddWidget(Widget* theWidget)
 {
-	if (std::find(mWidgets.begin(), mWidgets.end(), theWidget) == mWidgets.end())
+	if (FindWidget(theWidget) == mWidgets.end())
 	{
 		InsertWidgetHelper(mWidgets.end(),theWidget);
 		theWidget->mWidgetManager = mWidgetManager;
 		theWidget->mParent = this;		
+		WidgetListChanged();
 
 		if (mWidgetManager != NULL)
 		{
@@ -77,25 +153,63 @@ void WidgetContainer::AddWidget(Widget* theWidget)
 
 bool WidgetContainer::HasWidget(Widget* theWidget)
 {
-	return std::find(mWidgets.begin(), mWidgets.end(), theWidget) != mWidgets.end();
+	return FindWidget(theWidget) != mWidgets.end();
 }
 
 void WidgetContainer::RemoveWidget(Widget* theWidget)
 {
-	WidgetList::iterator anItr = std::find(mWidgets.begin(), mWidgets.end(), theWidget);
+	WidgetList::iterator anItr = FindWidget(theWidget);
 	if (anItr != mWidgets.end())
 	{								
 		theWidget->WidgetRemovedHelper();
 		theWidget->mParent = NULL;
 
-		bool erasedCur = (anItr == mUpdateIterator);				
-		mWidgets.erase(anItr++);
-		if (erasedCur)
+		mWidgets.erase(anItr);
+
+		// Leave a hole so a traversal in progress skips it without losing its place
+		int anOrderIdx = theWidget->mParentOrderIdx;
+		if ((anOrderIdx >= 0) && (anOrderIdx < (int) mWidgetOrder.size()) && (mWidgetOrder[anOrderIdx] == theWidget))
+			mWidgetOrder[anOrderIdx] = NULL;
+		theWidget->mParentOrderIdx = -1;
+
+		WidgetListChanged();
+	}
+}
+
+bool WidgetContainer::GetWidgetAtChild(Widget* theWidget, int x, int y, int theFlags, bool belowModal, Widget** theResult, int* theWidgetX, int* theWidgetY)
+{
+	int aCurFlags = theFlags;
+	ModFlags(aCurFlags, theWidget->mWidgetFlagsMod);
+	if (belowModal) ModFlags(aCurFlags, mWidgetManager->mBelowModalFlagsMod);
+
+	if (aCurFlags & WIDGETFLAGS_ALLOW_MOUSE)
+	{
+		if (theWidget->mVisible)
 		{
-			mUpdateIterator = anItr;
-			mUpdateIteratorModified = true;
+			bool childFound;
+			Widget* aCheckWidget = theWidget->GetWidgetAtHelper(x - theWidget->mX, y - theWidget->mY, aCurFlags, &childFound, theWidgetX, theWidgetY);
+			if ((aCheckWidget != NULL) || (childFound))
+			{
+				*theResult = aCheckWidget;
+				return true;
+			}
+
+			if ((theWidget->mMouseVisible) && (theWidget->GetInsetRect().Contains(x, y)))
+			{
+				if (theWidget->IsPointVisible(x-theWidget->mX,y-theWidget->mY))
+				{
+					if (theWidgetX)
+						*theWidgetX = x - theWidget->mX;
+					if (theWidgetY)
+						*theWidgetY = y - theWidget->mY;
+					*theResult = theWidget;
+					return true;
+				}
+			}
 		}
 	}
+
+	return false;
 }
 
 Widget* WidgetContainer::GetWidgetAtHelper(int x, int y, int theFlags, bool* found, int* theWidgetX, int* theWidgetY)
@@ -104,41 +218,38 @@ Widget* WidgetContainer::GetWidgetAtHelper(int x, int y, int theFlags, bool* fou
 
 	ModFlags(theFlags, mWidgetFlagsMod);
 
+	Widget* aResult = NULL;
+
+	if (mSpatialIndex != NULL)
+	{
+		// Only the children under the point, front to back
+		WidgetSpatialEntryVector anEntries;
+		mSpatialIndex->GetWidgetsAt(x, y, anEntries);
+		int aModalOrder = mSpatialIndex->GetOrder(mWidgetManager->mBaseModalWidget);
+
+		for (int i = (int) anEntries.size() - 1; i >= 0; i--)
+		{
+			belowModal = (aModalOrder != -1) && (anEntries[i].mOrder < aModalOrder);
+			if (GetWidgetAtChild(anEntries[i].mWidget, x, y, theFlags, belowModal, &aResult, theWidgetX, theWidgetY))
+			{
+				*found = true;
+				return aResult;
+			}
+		}
+
+		*found = false;
+		return NULL;
+	}
+
 	WidgetList::reverse_iterator anItr = mWidgets.rbegin();
 	while (anItr != mWidgets.rend())
 	{	
 		Widget* aWidget = *anItr;
 
-		int aCurFlags = theFlags;
-		ModFlags(aCurFlags, aWidget->mWidgetFlagsMod);
-		if (belowModal) ModFlags(aCurFlags, mWidgetManager->mBelowModalFlagsMod);
-
-		if (aCurFlags & WIDGETFLAGS_ALLOW_MOUSE)
+		if (GetWidgetAtChild(aWidget, x, y, theFlags, belowModal, &aResult, theWidgetX, theWidgetY))
 		{
-			if (aWidget->mVisible)
-			{
-				bool childFound;
-				Widget* aCheckWidget = aWidget->GetWidgetAtHelper(x - aWidget->mX, y - aWidget->mY, aCurFlags, &childFound, theWidgetX, theWidgetY);
-				if ((aCheckWidget != NULL) || (childFound))
-				{									
-					*found = true;					
-					return aCheckWidget;
-				}
-
-				if ((aWidget->mMouseVisible) && (aWidget->GetInsetRect().Contains(x, y)))
-				{
-					*found = true;
-					
-					if (aWidget->IsPointVisible(x-aWidget->mX,y-aWidget->mY))
-					{
-						if (theWidgetX)
-							*theWidgetX = x - aWidget->mX;
-						if (theWidgetY)
-							*theWidgetY = y - aWidget->mY;
-						return aWidget;
-					}					
-				}
-			}
+			*found = true;
+			return aResult;
 		}
 		
 		belowModal |= aWidget == mWidgetManager->mBaseModalWidget;
@@ -215,7 +326,7 @@ void WidgetContainer::InsertWidgetHelper(const WidgetList::iterator &where, Widg
 					break;
 			}
 					
-			mWidgets.insert(anItr,theWidget);
+			theWidget->mParentItr = mWidgets.insert(anItr,theWidget);
 			return;
 		}
 		++anItr;
@@ -228,87 +339,68 @@ void WidgetContainer::InsertWidgetHelper(const WidgetList::iterator &where, Widg
 		Widget *aWidget = *anItr;
 		if (aWidget->mZOrder <= theWidget->mZOrder)
 		{
-			mWidgets.insert(++anItr,theWidget);
+			theWidget->mParentItr = mWidgets.insert(++anItr,theWidget);
 			return;
 		}
 	}
 
 	// It goes at the beginning
 	mWidgets.push_front(theWidget);
+	theWidget->mParentItr = mWidgets.begin();
 }
 
 void WidgetContainer::BringToFront(Widget* theWidget)
 {
-	WidgetList::iterator anItr = std::find(mWidgets.begin(), mWidgets.end(), theWidget);
+	WidgetList::iterator anItr = FindWidget(theWidget);
 	if (anItr != mWidgets.end())
 	{
-		if (anItr == mUpdateIterator)
-		{
-			mUpdateIterator++;
-			mUpdateIteratorModified = true;
-		}
-
 		mWidgets.erase(anItr);
 		InsertWidgetHelper(mWidgets.end(),theWidget);
 
+		WidgetOrderChanged();
 		theWidget->OrderInManagerChanged();
 	}	
 }
 
 void WidgetContainer::BringToBack(Widget* theWidget)
 {
-	WidgetList::iterator anItr = std::find(mWidgets.begin(), mWidgets.end(), theWidget);
+	WidgetList::iterator anItr = FindWidget(theWidget);
 	if (anItr != mWidgets.end())
 	{
-		if (anItr == mUpdateIterator)
-		{
-			mUpdateIterator++;
-			mUpdateIteratorModified = true;
-		}
-
 		mWidgets.erase(anItr);
 		InsertWidgetHelper(mWidgets.begin(),theWidget);
 
+		WidgetOrderChanged();
 		theWidget->OrderInManagerChanged();
 	}
 }
 
 void WidgetContainer::PutBehind(Widget* theWidget, Widget* theRefWidget)
 {
-	WidgetList::iterator anItr = std::find(mWidgets.begin(), mWidgets.end(), theWidget);
+	WidgetList::iterator anItr = FindWidget(theWidget);
 	if (anItr != mWidgets.end())
 	{
-		if (anItr == mUpdateIterator)
-		{
-			mUpdateIterator++;
-			mUpdateIteratorModified = true;
-		}
-
 		mWidgets.erase(anItr);
-		anItr = std::find(mWidgets.begin(), mWidgets.end(), theRefWidget);
+		anItr = (theRefWidget != theWidget) ? FindWidget(theRefWidget) : mWidgets.end();
 		InsertWidgetHelper(anItr, theWidget);
 
+		WidgetOrderChanged();
 		theWidget->OrderInManagerChanged();
 	}
 }
 
 void WidgetContainer::PutInfront(Widget* theWidget, Widget* theRefWidget)
 {
-	WidgetList::iterator anItr = std::find(mWidgets.begin(), mWidgets.end(), theWidget);
+	WidgetList::iterator anItr = FindWidget(theWidget);
 	if (anItr != mWidgets.end())
 	{
-		if (anItr == mUpdateIterator)
-		{
-			mUpdateIterator++;
-			mUpdateIteratorModified = true;
-		}
-
 		mWidgets.erase(anItr);
-		anItr = std::find(mWidgets.begin(), mWidgets.end(), theRefWidget);
+		anItr = (theRefWidget != theWidget) ? FindWidget(theRefWidget) : mWidgets.end();
 		if (anItr != mWidgets.end())
 			anItr++;
 		InsertWidgetHelper(anItr, theWidget);
 
+		WidgetOrderChanged();
 		theWidget->OrderInManagerChanged();
 	}
 }
@@ -380,8 +472,14 @@ void WidgetContainer::MarkDirtyFull(WidgetContainer* theWidget)
 	//  causes a parent redraw which always causes all children to redraw
 	if (mParent != NULL)
 		return;
+
+	if (mSpatialIndex != NULL)
+	{
+		MarkDirtyFullIndexed(theWidget);
+		return;
+	}
 	
-	WidgetList::iterator aFoundWidgetItr = std::find(mWidgets.begin(), mWidgets.end(), theWidget);
+	WidgetList::iterator aFoundWidgetItr = FindWidget(theWidget);
 	if (aFoundWidgetItr == mWidgets.end())
 		return;
 	
@@ -433,6 +531,46 @@ void WidgetContainer::MarkDirtyFull(WidgetContainer* theWidget)
 	}
 }
 
+void WidgetContainer::MarkDirtyFullIndexed(WidgetContainer* theWidget)
+{
+	// Same as the list walk in MarkDirtyFull, but only over the siblings
+	//  sharing a grid cell with theWidget
+	WidgetSpatialEntryVector anEntries;
+	mSpatialIndex->GetWidgetsIn(theWidget->GetRect(), anEntries);
+	int anOrder = mSpatialIndex->GetOrder((Widget*) theWidget);
+	if (anOrder == -1)
+		return;
+
+	Rect aRect = Rect(theWidget->mX,theWidget->mY,theWidget->mWidth,theWidget->mHeight).Intersection(Rect(0,0,mWidth,mHeight)); 
+
+	for (int i = (int) anEntries.size() - 1; i >= 0; i--)
+	{
+		Widget* aWidget = anEntries[i].mWidget;
+		if ((anEntries[i].mOrder >= anOrder) || (!aWidget->mVisible))
+			continue;
+
+		if ((!aWidget->mHasTransparencies) && (!aWidget->mHasAlpha))
+		{
+			if ((aWidget->Contains(aRect.mX, aRect.mY) && 
+				(aWidget->Contains(aRect.mX + aRect.mWidth - 1, aRect.mY + aRect.mHeight - 1))))
+			{
+				aWidget->MarkDirty();
+				break;
+			}
+		}
+
+		if (aWidget->Intersects(theWidget))
+			MarkDirty(aWidget);
+	}
+
+	for (int i = 0; i < (int) anEntries.size(); i++)
+	{
+		Widget* aWidget = anEntries[i].mWidget;
+		if ((anEntries[i].mOrder >= anOrder) && (aWidget->mVisible) && (aWidget->Intersects(theWidget)))
+			MarkDirty(aWidget);
+	}
+}
+
 void WidgetContainer::MarkDirty(WidgetContainer* theWidget)
 {
 	if (theWidget->mDirty)
@@ -451,6 +589,22 @@ void WidgetContainer::MarkDirty(WidgetContainer* theWidget)
 
 	if (theWidget->mHasAlpha)
 		MarkDirtyFull(theWidget);
+	else if (mSpatialIndex != NULL)
+	{
+		// Only the siblings sharing a cell can overlap it
+		WidgetSpatialEntryVector anEntries;
+		mSpatialIndex->GetWidgetsIn(theWidget->GetRect(), anEntries);
+		int anOrder = mSpatialIndex->GetOrder((Widget*) theWidget);
+		if (anOrder == -1)
+			return;
+
+		for (int i = 0; i < (int) anEntries.size(); i++)
+		{
+			Widget* aWidget = anEntries[i].mWidget;
+			if ((anEntries[i].mOrder > anOrder) && (aWidget->mVisible) && (aWidget->Intersects(theWidget)))
+				MarkDirty(aWidget);
+		}
+	}
 	else
 	{
 		bool found = false;
@@ -497,23 +651,20 @@ void WidgetContainer::UpdateAll(ModalFlags* theFlags)
 		}
 	}
 	
-	mUpdateIterator = mWidgets.begin();
-
-	while (mUpdateIterator != mWidgets.end())
+	// Widgets added during the loop wait for the next update, removed ones
+	//  leave a NULL behind
+	const WidgetVector& aWidgets = GetWidgetOrder();
+	for (int i = 0; i < (int) aWidgets.size(); i++)
 	{
-		mUpdateIteratorModified = false;
+		Widget* aWidget = aWidgets[i];
+		if (aWidget == NULL)
+			continue;
 
-		Widget* aWidget = *mUpdateIterator;
 		if (aWidget == aWidgetManager->mBaseModalWidget)
 			theFlags->mIsOver = true;
 
 		aWidget->UpdateAll(theFlags);
-
-		if (!mUpdateIteratorModified)
-			++mUpdateIterator;
 	}
-
-	mUpdateIteratorModified = true; // prevent incrementing iterator off the end of the list
 }
 
 void WidgetContainer::UpdateF(float theFrac)
@@ -530,22 +681,18 @@ void WidgetContainer::UpdateFAll(ModalFlags* theFlags, float theFrac)
 		UpdateF(theFrac);		
 	}
 	
-	mUpdateIterator = mWidgets.begin();
-	while (mUpdateIterator != mWidgets.end())
+	const WidgetVector& aWidgets = GetWidgetOrder();
+	for (int i = 0; i < (int) aWidgets.size(); i++)
 	{
-		mUpdateIteratorModified = false;
+		Widget* aWidget = aWidgets[i];
+		if (aWidget == NULL)
+			continue;
 
-		Widget* aWidget = *mUpdateIterator;
 		if (aWidget == mWidgetManager->mBaseModalWidget)
 			theFlags->mIsOver = true;
 
 		aWidget->UpdateFAll(theFlags, theFrac);
-
-		if (!mUpdateIteratorModified)
-			++mUpdateIterator;
 	}
-
-	mUpdateIteratorModified = true; // prevent incrementing iterator off the end of the list
 }
 
 void WidgetContainer::Draw(Graphics* g)
@@ -576,12 +723,12 @@ void WidgetContainer::DrawAll(ModalFlags* theFlags, Graphics* g)
 		g->PopState();
 	}
 
-	WidgetList::iterator anItr = mWidgets.begin();
-	while (anItr != mWidgets.end())
+	const WidgetVector& aWidgets = GetWidgetOrder();
+	for (int i = 0; i < (int) aWidgets.size(); i++)
 	{
-		Widget* aWidget = *anItr;
+		Widget* aWidget = aWidgets[i];
 		
-		if (aWidget->mVisible)
+		if ((aWidget != NULL) && (aWidget->mVisible))
 		{
 			if (aWidget == mWidgetManager->mBaseModalWidget)
 				theFlags->mIsOver = true;
@@ -591,8 +738,6 @@ void WidgetContainer::DrawAll(ModalFlags* theFlags, Graphics* g)
 			aWidget->DrawAll(theFlags, &aClipG);
 			aWidget->mDirty = false;
 		}
-
-		++anItr;
 	}
 }
 
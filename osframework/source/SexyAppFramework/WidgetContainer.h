@@ -11,8 +11,10 @@ namespace Sexy
 class Graphics;
 class Widget;
 class WidgetManager;
+class WidgetSpatialIndex;
 
 typedef std::list<Widget*> WidgetList;
+typedef std::vector<Widget*> WidgetVector;
 
 
 class WidgetContainer
@@ -22,8 +24,10 @@ public:
 	WidgetManager*			mWidgetManager;
 	WidgetContainer*		mParent;
 
-	bool					mUpdateIteratorModified;
-	WidgetList::iterator	mUpdateIterator;
+	WidgetVector			mWidgetOrder;		// mWidgets flattened for traversal, NULL where a widget was removed since
+	bool					mWidgetOrderDirty;
+	WidgetList::iterator	mParentItr;			// our node in mParent->mWidgets
+	int						mParentOrderIdx;	// our slot in mParent->mWidgetOrder
 	ulong					mLastWMUpdateCount;
 	int						mUpdateCnt;
 	bool					mDirty;
@@ -36,11 +40,19 @@ public:
 	FlagsMod				mWidgetFlagsMod;
 	int						mPriority;
 	int						mZOrder;
+	WidgetSpatialIndex*		mSpatialIndex;		// optional, see EnableSpatialIndex
 
 public:	
 	Widget*					GetWidgetAtHelper(int x, int y, int theFlags, bool* found, int* theWidgetX, int* theWidgetY);
 	bool					IsBelowHelper(Widget* theWidget1, Widget* theWidget2, bool* found);
 	void					InsertWidgetHelper(const WidgetList::iterator &where, Widget *theWidget);
+	bool					GetWidgetAtChild(Widget* theWidget, int x, int y, int theFlags, bool belowModal, Widget** theResult, int* theWidgetX, int* theWidgetY);
+	void					UpdateSpatialIndex(Widget* theWidget);
+	void					WidgetListChanged();
+	void					WidgetOrderChanged();
+	WidgetList::iterator	FindWidget(WidgetContainer* theWidget);
+	const WidgetVector&		GetWidgetOrder();
+	void					MarkDirtyFullIndexed(WidgetContainer* theWidget);
 
 public:	
 	WidgetContainer();
@@ -54,6 +66,12 @@ public:
 	virtual bool			HasWidget(Widget* theWidget);	
 	virtual void			DisableWidget(Widget* theWidget);
 	virtual void			RemoveAllWidgets(bool doDelete = false, bool recursive = false);
+
+	// Keeps the children in a grid so hit testing and dirty overlap checks
+	//  only look at the ones nearby.  Worth it for containers with many
+	//  children, which must then be positioned through Resize/Move.
+	virtual void			EnableSpatialIndex(int theCellSize = 64);
+	virtual void			DisableSpatialIndex();
 	
 	virtual void			SetFocus(Widget* theWidget);
 	virtual bool			IsBelow(Widget* theWidget1, Widget* theWidget2);			
@@ -376,20 +376,18 @@ void WidgetManager::DrawWidgetsTo(Graphics* g)
 	ModalFlags aModalFlags;
 	InitModalFlags(&aModalFlags);
 
-	WidgetList::iterator anItr = mWidgets.begin();
-	while (anItr != mWidgets.end())
+	const WidgetVector& aWidgets = GetWidgetOrder();
+	for (int i = 0; i < (int) aWidgets.size(); i++)
 	{
-		Widget* aWidget = *anItr;
+		Widget* aWidget = aWidgets[i];
 		
-		if (aWidget->mVisible)
+		if ((aWidget != NULL) && (aWidget->mVisible))
 		{
 			Graphics aClipG(*g);
 			aClipG.SetFastStretch(true);
 			aClipG.Translate(aWidget->mX, aWidget->mY);
 			aWidget->DrawAll(&aModalFlags, &aClipG);			
 		}
-
-		++anItr;
 	}
 
 	mCurG = NULL;
@@ -410,13 +408,12 @@ bool WidgetManager::DrawScreen()
 	bool hasDirtyTransients = false;
 
 	// Survey
-	WidgetList::iterator anItr = mWidgets.begin();
-	while (anItr != mWidgets.end())
+	const WidgetVector& aWidgets = GetWidgetOrder();
+	for (int i = 0; i < (int) aWidgets.size(); i++)
 	{
-		Widget* aWidget = *anItr;
-		if (aWidget->mDirty)
+		Widget* aWidget = aWidgets[i];
+		if ((aWidget != NULL) && (aWidget->mDirty))
 			aDirtyCount++;
-		++anItr;
 	}
 	
 	mMinDeferredOverlayPriority = 0x7FFFFFFF;
@@ -436,10 +433,11 @@ bool WidgetManager::DrawScreen()
 		g.Translate(-mMouseDestRect.mX, -mMouseDestRect.mY);
 		bool is3D = mApp->Is3DAccelerated();
 
-		WidgetList::iterator anItr = mWidgets.begin();
-		while (anItr != mWidgets.end())
+		for (int i = 0; i < (int) aWidgets.size(); i++)
 		{
-			Widget* aWidget = *anItr;
+			Widget* aWidget = aWidgets[i];
+			if (aWidget == NULL)
+				continue;
 			
 			if (aWidget == mWidgetManager->mBaseModalWidget)
 				aModalFlags.mIsOver = true;
@@ -456,8 +454,6 @@ bool WidgetManager::DrawScreen()
 				drewStuff = true;
 				aWidget->mDirty = false;
 			}
-
-			++anItr;
 		}
 	}
 	
@@ -0,0 +1,196 @@
+#include "WidgetSpatialIndex.h"
+#include "WidgetContainer.h"
+#include "Widget.h"
+#include <algorithm>
+
+using namespace Sexy;
+
+static bool SpatialEntryEqual(const WidgetSpatialEntry& theEntry1, const WidgetSpatialEntry& theEntry2)
+{
+	return theEntry1.mOrder == theEntry2.mOrder;
+}
+
+WidgetSpatialIndex::WidgetSpatialIndex(WidgetContainer* theContainer, int theCellSize)
+{
+	mContainer = theContainer;
+	mCellSize = max(theCellSize, 1);
+	mCellsX = 0;
+	mCellsY = 0;
+	mGridWidth = 0;
+	mGridHeight = 0;
+	mDirty = true;
+}
+
+void WidgetSpatialIndex::InsertSorted(WidgetSpatialEntryVector& theVector, const WidgetSpatialEntry& theEntry)
+{
+	theVector.insert(std::upper_bound(theVector.begin(), theVector.end(), theEntry), theEntry);
+}
+
+void WidgetSpatialIndex::RemoveSorted(WidgetSpatialEntryVector& theVector, const WidgetSpatialEntry& theEntry)
+{
+	WidgetSpatialEntryVector::iterator anItr = std::lower_bound(theVector.begin(), theVector.end(), theEntry);
+	if ((anItr != theVector.end()) && (anItr->mWidget == theEntry.mWidget))
+		theVector.erase(anItr);
+}
+
+void WidgetSpatialIndex::Insert(Widget* theWidget, WidgetSpatialInfo& theInfo)
+{
+	WidgetSpatialEntry anEntry;
+	anEntry.mOrder = theInfo.mOrder;
+	anEntry.mWidget = theWidget;
+
+	// Negative mouse insets can make the hit area bigger than the widget
+	Rect aRect = theWidget->GetRect();
+	Rect anInsetRect = theWidget->GetInsetRect();
+	int aLeft = min(aRect.mX, anInsetRect.mX);
+	int aTop = min(aRect.mY, anInsetRect.mY);
+	int aRight = max(aRect.mX + aRect.mWidth, anInsetRect.mX + anInsetRect.mWidth);
+	int aBottom = max(aRect.mY + aRect.mHeight, anInsetRect.mY + anInsetRect.mHeight);
+
+	// Rect::Intersects still counts an empty rect lying inside another one
+	aRight = max(aRight, aLeft + 1);
+	aBottom = max(aBottom, aTop + 1);
+
+	theInfo.mUnbounded = (!theWidget->mWidgets.empty()) || (aLeft < 0) || (aTop < 0) ||
+		(aRight > mCellsX*mCellSize) || (aBottom > mCellsY*mCellSize);
+
+	if (theInfo.mUnbounded)
+	{
+		InsertSorted(mUnbounded, anEntry);
+		return;
+	}
+
+	theInfo.mCellLeft = aLeft / mCellSize;
+	theInfo.mCellTop = aTop / mCellSize;
+	theInfo.mCellRight = (aRight - 1) / mCellSize;
+	theInfo.mCellBottom = (aBottom - 1) / mCellSize;
+
+	for (int aCellY = theInfo.mCellTop; aCellY <= theInfo.mCellBottom; aCellY++)
+		for (int aCellX = theInfo.mCellLeft; aCellX <= theInfo.mCellRight; aCellX++)
+			InsertSorted(mCells[aCellY*mCellsX + aCellX], anEntry);
+}
+
+void WidgetSpatialIndex::Remove(Widget* theWidget, const WidgetSpatialInfo& theInfo)
+{
+	WidgetSpatialEntry anEntry;
+	anEntry.mOrder = theInfo.mOrder;
+	anEntry.mWidget = theWidget;
+
+	if (theInfo.mUnbounded)
+	{
+		RemoveSorted(mUnbounded, anEntry);
+		return;
+	}
+
+	for (int aCellY = theInfo.mCellTop; aCellY <= theInfo.mCellBottom; aCellY++)
+		for (int aCellX = theInfo.mCellLeft; aCellX <= theInfo.mCellRight; aCellX++)
+			RemoveSorted(mCells[aCellY*mCellsX + aCellX], anEntry);
+}
+
+void WidgetSpatialIndex::Rebuild()
+{
+	mGridWidth = mContainer->mWidth;
+	mGridHeight = mContainer->mHeight;
+	mCellsX = max(0, (mGridWidth + mCellSize - 1) / mCellSize);
+	mCellsY = max(0, (mGridHeight + mCellSize - 1) / mCellSize);
+
+	mCells.clear();
+	mCells.resize(mCellsX*mCellsY);
+	mUnbounded.clear();
+	mInfoMap.clear();
+
+	int anOrder = 0;
+	WidgetList::iterator anItr = mContainer->mWidgets.begin();
+	while (anItr != mContainer->mWidgets.end())
+	{
+		Widget* aWidget = *anItr;
+
+		WidgetSpatialInfo& anInfo = mInfoMap[aWidget];
+		anInfo.mOrder = anOrder++;
+		Insert(aWidget, anInfo);
+
+		++anItr;
+	}
+
+	mDirty = false;
+}
+
+bool WidgetSpatialIndex::NeedsRebuild()
+{
+	return (mDirty) || (mGridWidth != mContainer->mWidth) || (mGridHeight != mContainer->mHeight);
+}
+
+void WidgetSpatialIndex::CheckRebuild()
+{
+	if (NeedsRebuild())
+		Rebuild();
+}
+
+void WidgetSpatialIndex::WidgetMoved(Widget* theWidget)
+{
+	// The whole grid gets built on the next query anyway
+	if (NeedsRebuild())
+		return;
+
+	WidgetSpatialInfoMap::iterator anItr = mInfoMap.find(theWidget);
+	if (anItr == mInfoMap.end())
+		return;
+
+	Remove(theWidget, anItr->second);
+	Insert(theWidget, anItr->second);
+}
+
+int WidgetSpatialIndex::GetOrder(Widget* theWidget)
+{
+	CheckRebuild();
+
+	WidgetSpatialInfoMap::iterator anItr = mInfoMap.find(theWidget);
+	if (anItr == mInfoMap.end())
+		return -1;
+
+	return anItr->second.mOrder;
+}
+
+void WidgetSpatialIndex::GetWidgetsAt(int x, int y, WidgetSpatialEntryVector& theEntries)
+{
+	CheckRebuild();
+
+	theEntries.clear();
+
+	// Anything reaching outside the grid is in mUnbounded
+	if ((x < 0) || (y < 0) || (x >= mCellsX*mCellSize) || (y >= mCellsY*mCellSize))
+	{
+		theEntries = mUnbounded;
+		return;
+	}
+
+	// A widget is either in the cells or in mUnbounded, never both
+	const WidgetSpatialEntryVector& aCell = mCells[(y / mCellSize)*mCellsX + (x / mCellSize)];
+	theEntries.resize(aCell.size() + mUnbounded.size());
+	std::merge(aCell.begin(), aCell.end(), mUnbounded.begin(), mUnbounded.end(), theEntries.begin());
+}
+
+void WidgetSpatialIndex::GetWidgetsIn(const Rect& theRect, WidgetSpatialEntryVector& theEntries)
+{
+	CheckRebuild();
+
+	theEntries = mUnbounded;
+
+	int aCellLeft = max(theRect.mX / mCellSize, 0);
+	int aCellTop = max(theRect.mY / mCellSize, 0);
+	int aCellRight = min((theRect.mX + max(theRect.mWidth, 1) - 1) / mCellSize, mCellsX - 1);
+	int aCellBottom = min((theRect.mY + max(theRect.mHeight, 1) - 1) / mCellSize, mCellsY - 1);
+
+	for (int aCellY = aCellTop; aCellY <= aCellBottom; aCellY++)
+	{
+		for (int aCellX = aCellLeft; aCellX <= aCellRight; aCellX++)
+		{
+			const WidgetSpatialEntryVector& aCell = mCells[aCellY*mCellsX + aCellX];
+			theEntries.insert(theEntries.end(), aCell.begin(), aCell.end());
+		}
+	}
+
+	// Widgets spanning several cells show up once per cell
+	std::sort(theEntries.begin(), theEntries.end());
+	theEntries.erase(std::unique(theEntries.begin(), theEntries.end(), SpatialEntryEqual), theEntries.end());
+}
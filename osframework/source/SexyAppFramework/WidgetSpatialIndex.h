@@ -0,0 +1,77 @@
+#ifndef __WIDGETSPATIALINDEX_H__
+#define __WIDGETSPATIALINDEX_H__
+
+#include "Common.h"
+#include "Rect.h"
+
+namespace Sexy
+{
+
+class Widget;
+class WidgetContainer;
+
+struct WidgetSpatialEntry
+{
+	int						mOrder;		// position in the container's mWidgets, back to front
+	Widget*					mWidget;
+
+	bool operator<(const WidgetSpatialEntry& theEntry) const { return mOrder < theEntry.mOrder; }
+};
+
+typedef std::vector<WidgetSpatialEntry> WidgetSpatialEntryVector;
+
+struct WidgetSpatialInfo
+{
+	int						mOrder;
+	bool					mUnbounded;
+	int						mCellLeft, mCellTop, mCellRight, mCellBottom;	// inclusive
+};
+
+typedef std::map<Widget*, WidgetSpatialInfo> WidgetSpatialInfoMap;
+
+// Uniform grid over a container's children, used for hit testing and for
+//  finding the siblings a dirty widget overlaps.  Each child is listed in
+//  every cell its rect touches, sorted back to front.  Children that have
+//  children of their own (which may reach outside the parent) or that
+//  stick out of the container are kept in mUnbounded and always returned.
+//  Moves and resizes update a single child, anything that changes the
+//  order just marks the grid to be rebuilt on the next query.
+class WidgetSpatialIndex
+{
+public:
+	WidgetContainer*		mContainer;
+	int						mCellSize;
+	int						mCellsX;
+	int						mCellsY;
+	int						mGridWidth;
+	int						mGridHeight;
+	bool					mDirty;
+
+	std::vector<WidgetSpatialEntryVector> mCells;
+	WidgetSpatialEntryVector mUnbounded;
+	WidgetSpatialInfoMap	mInfoMap;
+
+protected:
+	bool					NeedsRebuild();
+	void					CheckRebuild();
+	void					Rebuild();
+	void					Insert(Widget* theWidget, WidgetSpatialInfo& theInfo);
+	void					Remove(Widget* theWidget, const WidgetSpatialInfo& theInfo);
+	static void				InsertSorted(WidgetSpatialEntryVector& theVector, const WidgetSpatialEntry& theEntry);
+	static void				RemoveSorted(WidgetSpatialEntryVector& theVector, const WidgetSpatialEntry& theEntry);
+
+public:
+	WidgetSpatialIndex(WidgetContainer* theContainer, int theCellSize);
+
+	void					Invalidate() { mDirty = true; }
+	void					WidgetMoved(Widget* theWidget);
+	int						GetOrder(Widget* theWidget);
+
+	// Back to front, without duplicates
+	void					GetWidgetsAt(int x, int y, WidgetSpatialEntryVector& theEntries);
+	void					GetWidgetsIn(const Rect& theRect, WidgetSpatialEntryVector& theEntries);
+};
+
+}
+
+#endif //__WIDGETSPATIALINDEX_H__